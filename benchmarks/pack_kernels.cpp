@@ -0,0 +1,112 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+// micro-benchmark of the structured pack/unpack copy kernels: compares one memcpy per contiguous line
+// (previous pack_batch/unpack_batch implementation) with detail::strided_copy for typical halo shapes
+
+#include <mpi.h>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <ghex/common/timer.hpp>
+#include <ghex/structured/strided_copy.hpp>
+
+// reference kernel: one memcpy per line
+template<typename T>
+void line_copy(T* dst, std::ptrdiff_t dst_stride, const T* src, std::ptrdiff_t src_stride,
+    std::size_t len, std::size_t n)
+{
+    char* d = reinterpret_cast<char*>(dst);
+    const char* s = reinterpret_cast<const char*>(src);
+    for (std::size_t i=0; i<n; ++i, d+=dst_stride, s+=src_stride)
+        std::memcpy(d, s, len*sizeof(T));
+}
+
+// x-halo: lines of length width along the contiguous dimension, one line per (y,z)
+// y-halo: width lines of length n, one 2D slab per z
+// z-halo: n lines of length n, one 2D slab per z
+template<typename T>
+struct halo_shape
+{
+    const char* name;
+    std::size_t len;
+    std::size_t n_lines;
+    std::size_t n_slabs;
+    std::ptrdiff_t field_line_stride;
+    std::ptrdiff_t field_slab_stride;
+};
+
+template<typename T, typename Kernel>
+double run(const halo_shape<T>& h, Kernel&& k, T* field, T* buffer, int reps, bool pack)
+{
+    const std::ptrdiff_t buffer_line_stride = h.len*sizeof(T);
+    const std::ptrdiff_t buffer_slab_stride = h.len*h.n_lines*sizeof(T);
+    gridtools::ghex::timer t;
+    for (int r=0; r<reps; ++r)
+    {
+        t.tic();
+        for (std::size_t s=0; s<h.n_slabs; ++s)
+        {
+            T* f = reinterpret_cast<T*>(reinterpret_cast<char*>(field) + s*h.field_slab_stride);
+            T* b = reinterpret_cast<T*>(reinterpret_cast<char*>(buffer) + s*buffer_slab_stride);
+            if (pack) k(b, buffer_line_stride, f, h.field_line_stride, h.len, h.n_lines);
+            else      k(f, h.field_line_stride, b, buffer_line_stride, h.len, h.n_lines);
+        }
+        t.toc();
+    }
+    return t.mean();
+}
+
+template<typename T>
+void bench(const char* type_name, int n, int reps)
+{
+    const int max_width = 3;
+    const std::size_t nx = n+2*max_width, ny = n+2*max_width, nz = n+2*max_width;
+    std::vector<T> field(nx*ny*nz);
+    for (std::size_t i=0; i<field.size(); ++i) field[i] = (T)i;
+    std::vector<T> buffer(nx*ny*nz);
+
+    const std::ptrdiff_t sy = nx*sizeof(T);
+    const std::ptrdiff_t sz = nx*ny*sizeof(T);
+    for (int w=1; w<=max_width; ++w)
+    {
+        const halo_shape<T> shapes[] = {
+            {"x", (std::size_t)w, (std::size_t)n, (std::size_t)n, sy, sz},
+            {"y", (std::size_t)n, (std::size_t)w, (std::size_t)n, sy, sz},
+            {"z", (std::size_t)n, (std::size_t)n, (std::size_t)w, sy, sz}};
+        for (const auto& h : shapes)
+        {
+            T* f = field.data() + max_width*(1+nx+nx*ny);
+            const double t_line_pack   = run(h, line_copy<T>, f, buffer.data(), reps, true);
+            const double t_line_unpack = run(h, line_copy<T>, f, buffer.data(), reps, false);
+            const double t_simd_pack   = run(h, gridtools::ghex::structured::detail::strided_copy<T>,
+                f, buffer.data(), reps, true);
+            const double t_simd_unpack = run(h, gridtools::ghex::structured::detail::strided_copy<T>,
+                f, buffer.data(), reps, false);
+            std::cout << std::setw(7) << type_name << " halo " << h.name << " width " << w
+                << "  pack [us]: " << std::setw(10) << t_line_pack << " -> " << std::setw(10) << t_simd_pack
+                << "  unpack [us]: " << std::setw(10) << t_line_unpack << " -> " << std::setw(10) << t_simd_unpack
+                << "\n";
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int n    = argc > 1 ? std::atoi(argv[1]) : 128;
+    const int reps = argc > 2 ? std::atoi(argv[2]) : 100;
+    std::cout << "domain " << n << "^3, " << reps << " repetitions, times: memcpy per line -> strided_copy\n";
+    bench<float>("float", n, reps);
+    bench<double>("double", n, reps);
+    return 0;
+}
@@ -351,6 +351,19 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    int world_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD,&world_rank);
+    if (world_rank == 0)
+    {
+#if defined(GHEX_USE_XPMEM_ACCESS_GUARD) && defined(GHEX_USE_XPMEM)
+        std::cout << "process access guard: xpmem" << std::endl;
+#elif defined(GHEX_USE_ATOMIC_SHMEM_ACCESS_GUARD)
+        std::cout << "process access guard: atomic shmem" << std::endl;
+#else
+        std::cout << "process access guard: shmem" << std::endl;
+#endif
+    }
+
     {
         simulation sim(num_repetitions, domain_size, halo, num_fields, decomp);
 
@@ -96,14 +96,26 @@ int main(int argc, char *argv[])
 #endif
 
     {
+#if defined(GHEX_USE_UCP) && defined(GHEX_USE_THREAD_WORKERS)
+        // every thread owns a worker: lock-free receive path, threads only communicate with their peer thread
+        ghex::tl::ucx::context_options options;
+        options.m_num_thread_workers = num_threads;
+        options.m_yield = ghex::tl::ucx::yield_policy::idle;
+        auto context_ptr = ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD, options);
+#else
         auto context_ptr = ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
+#endif
         auto& context = *context_ptr;
 
 #ifdef GHEX_USE_OPENMP
 #pragma omp parallel
 #endif
         {
+#if defined(GHEX_USE_UCP) && defined(GHEX_USE_THREAD_WORKERS)
+            auto comm              = context.get_communicator(THREADID);
+#else
             auto comm              = context.get_communicator();
+#endif
             const auto rank        = comm.rank();
             const auto size        = comm.size();
             const auto thread_id   = THREADID;
@@ -0,0 +1,122 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#include <iostream>
+#include <vector>
+
+#include <ghex/common/timer.hpp>
+#include <ghex/arch_traits.hpp>
+
+namespace ghex = gridtools::ghex;
+
+#ifdef GHEX_USE_UCP
+// UCX backend
+#include <ghex/transport_layer/ucx/context.hpp>
+using transport    = ghex::tl::ucx_tag;
+#elif defined(GHEX_USE_SHM_TRANSPORT)
+// shared memory within the node, MPI across nodes
+#include <ghex/transport_layer/shm/context.hpp>
+using transport    = ghex::tl::shm_tag;
+#else
+// MPI backend
+#include <ghex/transport_layer/mpi/context.hpp>
+using transport    = ghex::tl::mpi_tag;
+#endif
+
+using context_type = typename ghex::tl::context_factory<transport>::context_type;
+using communicator_type = typename context_type::communicator_type;
+using traits = ghex::arch_traits<ghex::cpu>;
+using MsgType = traits::message_type;
+
+// Measures the bandwidth of bi-directional exchanges of large messages (halo sized and beyond) which are
+// allocated from the pool used by the communication objects. With GHEX_UCX_USE_REGISTRATION_CACHE, the pooled
+// memory is registered with ucx once and messages are transferred directly from/to it.
+// Ranks are paired (0-1, 2-3, ...); a single rank sends to itself. Message sizes are doubled from min_size to
+// max_size.
+int main(int argc, char *argv[])
+{
+    int niter, inflight;
+    std::size_t min_size, max_size;
+    int mode;
+
+    if(argc != 5)
+    {
+        std::cerr << "Usage: bench [niter] [inflight] [min_size] [max_size]" << "\n";
+        std::terminate();
+    }
+    niter = atoi(argv[1]);
+    inflight = atoi(argv[2]);
+    min_size = std::stoul(argv[3]);
+    max_size = std::stoul(argv[4]);
+
+    MPI_Init_thread(NULL, NULL, MPI_THREAD_SINGLE, &mode);
+
+    {
+        auto context_ptr = ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
+        auto& context = *context_ptr;
+        auto comm = context.get_communicator();
+        const auto rank = comm.rank();
+        const auto size = comm.size();
+        const auto peer_rank = (size == 1) ? rank : (rank^1) % size;
+
+        // the pool registers its memory with the context of the communicator
+        traits::pool_type pool{traits::make_basic_allocator(comm)};
+
+        if (rank == 0)
+            std::cout << "size (bytes)   time/iter (us)   bandwidth (MB/s)\n";
+
+        for (std::size_t buff_size = min_size; buff_size <= max_size; buff_size *= 2)
+        {
+            std::vector<MsgType> smsgs, rmsgs;
+            for (int j=0; j<inflight; ++j)
+            {
+                smsgs.push_back(traits::make_message(pool));
+                smsgs.back().resize(buff_size);
+                rmsgs.push_back(traits::make_message(pool));
+                rmsgs.back().resize(buff_size);
+            }
+
+            std::vector<communicator_type::future<void>> futs;
+            futs.reserve(2*inflight);
+            double t = 0;
+            for (int i=0; i<niter+1; ++i)
+            {
+                MPI_Barrier(MPI_COMM_WORLD);
+                ghex::timer timer;
+                timer.tic();
+                for (int j=0; j<inflight; ++j)
+                    futs.push_back(comm.recv(rmsgs[j], peer_rank, j));
+                for (int j=0; j<inflight; ++j)
+                    futs.push_back(comm.send(smsgs[j], peer_rank, j));
+                for (auto& f : futs) f.wait();
+                futs.clear();
+                // skip the warm-up iteration
+                if (i > 0) t += timer.stoc();
+            }
+
+            if (rank == 0)
+            {
+                const double t_iter = t/niter;
+                // bytes sent and received per iteration
+                const double bytes = 2.0*inflight*buff_size;
+                std::cout << buff_size << "   " << t_iter << "   " << bytes/t_iter << "\n";
+            }
+        }
+
+#if defined(GHEX_USE_UCP) && defined(GHEX_UCX_USE_REGISTRATION_CACHE)
+        const auto s = context.get_transport_context().get_registration_cache()->stats();
+        if (rank == 0)
+            std::cout << "registered regions: " << s.m_regions << ", bytes: " << s.m_bytes
+                      << ", lookup hits: " << s.m_hits << ", misses: " << s.m_misses << "\n";
+#endif
+    }
+
+    MPI_Finalize();
+}
@@ -0,0 +1,116 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#include <iostream>
+#include <vector>
+
+#include <ghex/common/timer.hpp>
+#include <ghex/transport_layer/message_buffer.hpp>
+
+namespace ghex = gridtools::ghex;
+
+#ifdef GHEX_USE_UCP
+// UCX backend
+#include <ghex/transport_layer/ucx/context.hpp>
+using transport    = ghex::tl::ucx_tag;
+#else
+// MPI backend
+#include <ghex/transport_layer/mpi/context.hpp>
+using transport    = ghex::tl::mpi_tag;
+#endif
+
+using context_type = typename ghex::tl::context_factory<transport>::context_type;
+using communicator_type = typename context_type::communicator_type;
+using MsgType = ghex::tl::message_buffer<>;
+
+// Measures the cost of progressing a communicator with many outstanding callback based receives:
+// - poll:  a progress call while none of the receives has completed
+// - drain: completing all receives after the matching messages have been sent
+// Ranks are paired (0-1, 2-3, ...); a single rank sends to itself.
+int main(int argc, char *argv[])
+{
+    int niter, outstanding, buff_size;
+    int mode;
+
+    if(argc != 4)
+    {
+        std::cerr << "Usage: bench [niter] [outstanding] [msg_size]" << "\n";
+        std::terminate();
+    }
+    niter = atoi(argv[1]);
+    outstanding = atoi(argv[2]);
+    buff_size = atoi(argv[3]);
+
+    MPI_Init_thread(NULL, NULL, MPI_THREAD_SINGLE, &mode);
+
+    {
+        auto context_ptr = ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
+        auto& context = *context_ptr;
+        auto comm = context.get_communicator();
+        const auto rank = comm.rank();
+        const auto size = comm.size();
+        const auto peer_rank = (size == 1) ? rank : (rank^1) % size;
+        const int num_polls = 100;
+
+        std::vector<MsgType> smsgs, rmsgs;
+        for (int j=0; j<outstanding; ++j)
+        {
+            smsgs.emplace_back(buff_size);
+            rmsgs.emplace_back(buff_size);
+        }
+
+        int received = 0;
+        auto recv_callback = [&received](communicator_type::message_type, int, int) { ++received; };
+
+        double t_poll = 0, t_drain = 0;
+        for (int i=0; i<niter+1; ++i)
+        {
+            received = 0;
+            for (int j=0; j<outstanding; ++j)
+                comm.recv(rmsgs[j], peer_rank, j, recv_callback);
+            MPI_Barrier(MPI_COMM_WORLD);
+
+            ghex::timer timer;
+            timer.tic();
+            for (int k=0; k<num_polls; ++k) comm.progress();
+            const double tp = timer.stoc()/num_polls;
+
+            std::vector<communicator_type::future<void>> sfuts;
+            sfuts.reserve(outstanding);
+            for (int j=0; j<outstanding; ++j)
+                sfuts.push_back(comm.send(smsgs[j], peer_rank, j));
+            // drive the sends to completion without testing the receives
+            for (auto& f : sfuts) f.wait();
+            MPI_Barrier(MPI_COMM_WORLD);
+
+            timer.tic();
+            while (received < outstanding) comm.progress();
+            const double td = timer.stoc();
+
+            // skip the warm-up iteration
+            if (i > 0)
+            {
+                t_poll += tp;
+                t_drain += td;
+            }
+            MPI_Barrier(MPI_COMM_WORLD);
+        }
+
+        if (rank == 0)
+        {
+            std::cout << "outstanding receives:  " << outstanding << "\n";
+            std::cout << "poll time (us):        " << t_poll/niter << "\n";
+            std::cout << "drain time (us):       " << t_drain/niter << "\n";
+            std::cout << "drain time / msg (us): " << t_drain/niter/outstanding << "\n";
+        }
+    }
+
+    MPI_Finalize();
+}
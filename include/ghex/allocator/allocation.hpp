@@ -60,7 +60,7 @@ namespace gridtools {
                 , m_capacity{other.m_capacity}
                 { }
 
-                allocation(allocation&& other)
+                allocation(allocation&& other) noexcept
                 : m_alloc{std::move(other.m_alloc)}
                 , m_pointer{other.m_pointer}
                 , m_capacity{other.m_capacity}
@@ -74,7 +74,10 @@ namespace gridtools {
                 }
             };
 
-            template<typename Allocator>
+            /** @brief allocator which obtains memory from a pool
+              * @tparam Allocator underlying allocator
+              * @tparam Impl pool implementation (template over a byte allocator) */
+            template<typename Allocator, template<typename> class Impl = pool_impl>
             struct pool_allocator_adaptor
             : public Allocator
             {
@@ -95,27 +98,28 @@ namespace gridtools {
                 using byte_base          = typename base_traits::template rebind_alloc<byte>;
                 using byte_base_traits   = std::allocator_traits<byte_base>;
                 using byte_pointer_traits     = std::pointer_traits<typename byte_base_traits::pointer>;
+                using impl_type          = Impl<byte_base>;
 
                 template<typename U>
                 struct rebind
                 {
-                    using other = pool_allocator_adaptor<typename base_traits::template rebind_alloc<U>>;
+                    using other = pool_allocator_adaptor<typename base_traits::template rebind_alloc<U>, Impl>;
                 };
 
             public: // members
 
-                pool_impl<byte_base>* m_pool;
+                impl_type* m_pool;
 
             public: // ctors
 
                 template<typename Alloc = Allocator, typename std::enable_if<std::is_default_constructible<Alloc>::value, int>::type=0>
-                pool_allocator_adaptor(pool_impl<byte_base>* p)
+                pool_allocator_adaptor(impl_type* p)
                 : base()
                 , m_pool{ p }
                 {
                     static_assert(std::is_same<Alloc, Allocator>::value, "this is not a function template");
                 }
-                pool_allocator_adaptor(pool_impl<byte_base>* p, Allocator alloc)
+                pool_allocator_adaptor(impl_type* p, Allocator alloc)
                 : base(alloc)
                 , m_pool{ p }
                 {}
@@ -0,0 +1,400 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_ALLOCATOR_SHM_ALLOCATOR_HPP
+#define INCLUDED_GHEX_ALLOCATOR_SHM_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+extern "C"{
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+}
+
+namespace gridtools {
+    namespace ghex {
+        namespace allocator {
+            namespace shm {
+
+                // maximum length of a segment name (including the terminating null character)
+                static constexpr std::size_t max_name_length = 48;
+
+                /** @brief location of a memory address within a shared memory segment */
+                struct segment_info
+                {
+                    char        m_name[max_name_length]; // shm object name, or file path if m_hugetlbfs is set
+                    bool        m_hugetlbfs;
+                    std::size_t m_size;
+                    std::size_t m_offset;
+                };
+
+                /** @brief open a segment created by another process
+                  * @param name shm object name or file path
+                  * @param hugetlbfs whether the segment is a file on a hugetlbfs mount
+                  * @return file descriptor or -1 on failure */
+                inline int open_segment(const char* name, bool hugetlbfs)
+                {
+                    return hugetlbfs ? open(name, O_RDWR) : shm_open(name, O_RDWR, 0600);
+                }
+
+                /** @brief shared memory segment created with shm_open, or as a file on a hugetlbfs mount, and
+                  * mapped into this process. Memory is handed out first fit from a list of free blocks. */
+                class segment
+                {
+                private: // members
+                    std::string                       m_name;
+                    bool                              m_hugetlbfs = false;
+                    unsigned char*                    m_base = nullptr;
+                    std::size_t                       m_size;
+                    std::map<std::size_t,std::size_t> m_free; // offset -> size
+                    std::size_t                       m_used = 0u;
+
+                public: // ctors
+                    /** @brief create and map a segment
+                      * @param name unique name
+                      * @param size size in bytes (multiple of the page size)
+                      * @param huge_page_dir hugetlbfs mount to create the segment in (huge pages), or empty for a
+                      * regular shm segment. Falls back to a regular segment if the file cannot be created or
+                      * mapped, e.g. because no huge pages are available.
+                      * @param first_touch touch all pages from the calling thread (NUMA-local placement) */
+                    segment(const std::string& name, std::size_t size, const std::string& huge_page_dir,
+                        bool first_touch)
+                    : m_size{size}
+                    {
+                        if (!(!huge_page_dir.empty() && create(huge_page_dir + name, true)) && !create(name, false))
+                            throw std::bad_alloc();
+                        if (first_touch)
+                        {
+                            const std::size_t page_size = sysconf(_SC_PAGESIZE);
+                            for (std::size_t i=0; i<m_size; i+=page_size) m_base[i] = 0;
+                        }
+                        m_free[0u] = m_size;
+                    }
+
+                    segment(const segment&) = delete;
+                    segment& operator=(const segment&) = delete;
+
+                    ~segment()
+                    {
+                        munmap(m_base, m_size);
+                        unlink_segment();
+                    }
+
+                public: // member functions
+                    const std::string& name() const noexcept { return m_name; }
+                    bool hugetlbfs() const noexcept { return m_hugetlbfs; }
+                    unsigned char* base() const noexcept { return m_base; }
+                    std::size_t size() const noexcept { return m_size; }
+                    std::size_t used() const noexcept { return m_used; }
+                    bool contains(const void* ptr) const noexcept
+                    {
+                        const auto p = static_cast<const unsigned char*>(ptr);
+                        return p >= m_base && p < m_base+m_size;
+                    }
+
+                    /** @brief allocate a block
+                      * @param n number of bytes (multiple of the alignment)
+                      * @param alignment alignment of the block (power of 2)
+                      * @return pointer to the block or nullptr if there is not enough space */
+                    void* allocate(std::size_t n, std::size_t alignment)
+                    {
+                        for (auto it = m_free.begin(); it != m_free.end(); ++it)
+                        {
+                            const std::size_t first = (it->first + alignment - 1) & ~(alignment - 1);
+                            const std::size_t end = it->first + it->second;
+                            if (first + n > end) continue;
+                            const std::size_t block_first = it->first;
+                            m_free.erase(it);
+                            if (first > block_first) m_free[block_first] = first - block_first;
+                            if (end > first + n) m_free[first + n] = end - first - n;
+                            m_used += n;
+                            return m_base + first;
+                        }
+                        return nullptr;
+                    }
+
+                    /** @brief return a block */
+                    void deallocate(void* ptr, std::size_t n)
+                    {
+                        std::size_t first = static_cast<unsigned char*>(ptr) - m_base;
+                        m_used -= n;
+                        // coalesce with neighboring free blocks
+                        auto next = m_free.lower_bound(first);
+                        if (next != m_free.end() && next->first == first + n)
+                        {
+                            n += next->second;
+                            next = m_free.erase(next);
+                        }
+                        if (next != m_free.begin())
+                        {
+                            auto prev = std::prev(next);
+                            if (prev->first + prev->second == first)
+                            {
+                                first = prev->first;
+                                n += prev->second;
+                                m_free.erase(prev);
+                            }
+                        }
+                        m_free[first] = n;
+                    }
+
+                private: // implementation
+                    bool create(std::string name, bool hugetlbfs)
+                    {
+                        // the name is exported to other processes
+                        if (name.size() >= max_name_length) return false;
+                        m_name = std::move(name);
+                        m_hugetlbfs = hugetlbfs;
+                        const int fd = hugetlbfs ? open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600)
+                                                 : shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+                        if (fd < 0) return false;
+                        // hugetlbfs reserves the huge pages when the file is mapped, so that a lack of huge pages
+                        // is detected here and not when the memory is touched
+                        void* ptr = ftruncate(fd, m_size) != 0 ? MAP_FAILED :
+                            mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                        close(fd);
+                        if (ptr == MAP_FAILED)
+                        {
+                            unlink_segment();
+                            return false;
+                        }
+                        m_base = static_cast<unsigned char*>(ptr);
+                        return true;
+                    }
+
+                    void unlink_segment()
+                    {
+                        if (m_hugetlbfs) unlink(m_name.c_str());
+                        else shm_unlink(m_name.c_str());
+                    }
+                };
+
+                /** @brief process wide registry of shared memory segments which is used to find the segment
+                  * containing a given address. */
+                class registry
+                {
+                private: // members
+                    std::mutex                         m_mutex;
+                    std::map<std::uintptr_t, segment*> m_segments; // base address -> segment
+
+                public: // static member functions
+                    static registry& instance()
+                    {
+                        static registry r;
+                        return r;
+                    }
+
+                public: // member functions
+                    void insert(segment* s)
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        m_segments[reinterpret_cast<std::uintptr_t>(s->base())] = s;
+                    }
+
+                    void erase(segment* s)
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        m_segments.erase(reinterpret_cast<std::uintptr_t>(s->base()));
+                    }
+
+                    /** @brief find the segment containing an address
+                      * @param ptr address
+                      * @param info_ segment name, size and offset of the address (output)
+                      * @return true if the address lies within a registered segment */
+                    bool find(const void* ptr, segment_info& info_)
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        auto it = m_segments.upper_bound(reinterpret_cast<std::uintptr_t>(ptr));
+                        if (it == m_segments.begin()) return false;
+                        --it;
+                        if (!it->second->contains(ptr)) return false;
+                        const auto& name = it->second->name();
+                        std::memset(info_.m_name, 0, max_name_length);
+                        std::memcpy(info_.m_name, name.c_str(), std::min(name.size(), max_name_length-1));
+                        info_.m_hugetlbfs = it->second->hugetlbfs();
+                        info_.m_size = it->second->size();
+                        info_.m_offset = static_cast<const unsigned char*>(ptr) - it->second->base();
+                        return true;
+                    }
+                };
+
+                /** @brief options of a shared memory arena */
+                struct arena_options
+                {
+                    // minimum size of a segment in bytes
+                    std::size_t m_segment_size = std::size_t(64) << 20;
+                    // back segments with huge pages by creating them on a hugetlbfs mount (falls back to regular
+                    // pages if the mount does not exist or has not enough huge pages reserved)
+                    bool m_huge_pages = false;
+                    // hugetlbfs mount point
+                    std::string m_huge_page_dir = "/dev/hugepages";
+                    // touch pages from the allocating thread so that they are placed on its NUMA node
+                    bool m_first_touch = true;
+                };
+
+                /** @brief thread safe arena which carves memory blocks out of shared memory segments. Segments
+                  * are created on demand, registered with the process wide registry and released once they are
+                  * empty (except for the most recent one). */
+                class arena
+                {
+                private: // members
+                    arena_options                         m_options;
+                    std::size_t                           m_page_size;
+                    std::mutex                            m_mutex;
+                    std::vector<std::unique_ptr<segment>> m_segments;
+
+                public: // ctors
+                    arena(arena_options options = {})
+                    : m_options{options}
+                    , m_page_size{(std::size_t)sysconf(_SC_PAGESIZE)}
+                    {
+                        // segments on hugetlbfs must be a multiple of its page size
+                        struct statfs fs;
+                        if (m_options.m_huge_pages && statfs(m_options.m_huge_page_dir.c_str(), &fs) == 0)
+                            m_page_size = std::max(m_page_size, (std::size_t)fs.f_bsize);
+                        // make sure the registry outlives static arenas
+                        registry::instance();
+                    }
+
+                    arena(const arena&) = delete;
+                    arena& operator=(const arena&) = delete;
+
+                    ~arena()
+                    {
+                        for (auto& s : m_segments) registry::instance().erase(s.get());
+                    }
+
+                public: // static member functions
+                    /** @brief arena used by default constructed shm allocators */
+                    static arena& default_arena()
+                    {
+                        static arena a;
+                        return a;
+                    }
+
+                public: // member functions
+                    const arena_options& options() const noexcept { return m_options; }
+
+                    /** @brief allocate a block of memory
+                      * @param n number of bytes
+                      * @param alignment alignment (power of 2)
+                      * @return pointer to the block */
+                    void* allocate(std::size_t n, std::size_t alignment = 64)
+                    {
+                        n = (std::max(n, std::size_t(1)) + alignment - 1) & ~(alignment - 1);
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        for (auto it = m_segments.rbegin(); it != m_segments.rend(); ++it)
+                            if (void* ptr = (*it)->allocate(n, alignment)) return ptr;
+                        // create new segment
+                        std::size_t size = std::max(n + alignment, m_options.m_segment_size);
+                        size = (size + m_page_size - 1) & ~(m_page_size - 1);
+                        m_segments.push_back(std::make_unique<segment>(make_name(), size,
+                            m_options.m_huge_pages ? m_options.m_huge_page_dir : std::string(),
+                            m_options.m_first_touch));
+                        registry::instance().insert(m_segments.back().get());
+                        return m_segments.back()->allocate(n, alignment);
+                    }
+
+                    /** @brief return a block of memory
+                      * @param ptr pointer to the block
+                      * @param n number of bytes (as passed to allocate)
+                      * @param alignment alignment (as passed to allocate) */
+                    void deallocate(void* ptr, std::size_t n, std::size_t alignment = 64)
+                    {
+                        n = (std::max(n, std::size_t(1)) + alignment - 1) & ~(alignment - 1);
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        for (auto it = m_segments.begin(); it != m_segments.end(); ++it)
+                        {
+                            if (!(*it)->contains(ptr)) continue;
+                            (*it)->deallocate(ptr, n);
+                            if ((*it)->used() == 0u && it+1 != m_segments.end())
+                            {
+                                registry::instance().erase(it->get());
+                                m_segments.erase(it);
+                            }
+                            return;
+                        }
+                    }
+
+                    /** @brief number of segments currently mapped */
+                    std::size_t num_segments()
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        return m_segments.size();
+                    }
+
+                private: // implementation
+                    static std::string make_name()
+                    {
+                        static std::atomic<unsigned long> counter{0ul};
+                        return "/ghex-shm-" + std::to_string(getpid()) + "-" + std::to_string(counter++);
+                    }
+                };
+
+                /** @brief allocator which places memory in shared memory segments. Memory obtained from this
+                  * allocator can be exported to other processes on the same node as (segment name, offset).
+                  * @tparam T value type */
+                template<typename T>
+                struct shm_allocator
+                {
+                    using value_type = T;
+
+                    arena* m_arena;
+
+                    shm_allocator() noexcept : m_arena{&arena::default_arena()} {}
+                    shm_allocator(arena& a) noexcept : m_arena{&a} {}
+                    template<typename U>
+                    shm_allocator(const shm_allocator<U>& other) noexcept : m_arena{other.m_arena} {}
+
+                    T* allocate(std::size_t n)
+                    {
+                        if (n > std::size_t(-1) / sizeof(T)) throw std::bad_alloc();
+                        return static_cast<T*>(m_arena->allocate(n*sizeof(T), alignment()));
+                    }
+
+                    void deallocate(T* p, std::size_t n) noexcept
+                    {
+                        m_arena->deallocate(p, n*sizeof(T), alignment());
+                    }
+
+                    static constexpr std::size_t alignment() noexcept
+                    {
+                        return alignof(T) > 64u ? alignof(T) : 64u;
+                    }
+                };
+
+                template<typename T, typename U>
+                bool operator==(const shm_allocator<T>& a, const shm_allocator<U>& b) { return a.m_arena == b.m_arena; }
+                template<typename T, typename U>
+                bool operator!=(const shm_allocator<T>& a, const shm_allocator<U>& b) { return a.m_arena != b.m_arena; }
+
+            } // namespace shm
+
+            using shm::shm_allocator;
+
+        } // namespace allocator
+    } // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_ALLOCATOR_SHM_ALLOCATOR_HPP */
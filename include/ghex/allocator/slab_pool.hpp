@@ -0,0 +1,501 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_ALLOCATOR_SLAB_POOL_HPP
+#define INCLUDED_GHEX_ALLOCATOR_SLAB_POOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "../common/to_address.hpp"
+#include "./pool_allocator_adaptor.hpp"
+
+namespace gridtools {
+    namespace ghex {
+        namespace allocator {
+            namespace slab {
+
+                // Blocks are binned into size classes with 4 classes per doubling of the size (at most 25%
+                // internal fragmentation), from 64 bytes up to 1 GiB. Larger requests bypass the pool.
+                static constexpr std::size_t classes_per_doubling_log2 = 2;
+                static constexpr std::size_t classes_per_doubling      = std::size_t(1) << classes_per_doubling_log2;
+                static constexpr std::size_t min_class_size_log2       = 6;
+                static constexpr std::size_t max_class_size_log2       = 30;
+                static constexpr std::size_t min_class_size            = std::size_t(1) << min_class_size_log2;
+                static constexpr std::size_t max_class_size            = std::size_t(1) << max_class_size_log2;
+                static constexpr std::size_t num_classes               =
+                    1 + (max_class_size_log2 - min_class_size_log2) * classes_per_doubling;
+                // number of blocks the shared depot can hold per size class
+                static constexpr std::size_t depot_slots               = 32;
+                // maximum number of blocks a thread cache holds per size class
+                static constexpr std::size_t max_thread_cache_count    = 32;
+
+                inline std::size_t log2_floor(std::size_t n) noexcept
+                {
+#if defined(__GNUC__)
+                    return sizeof(unsigned long long)*8 - 1 - __builtin_clzll(n);
+#else
+                    std::size_t r = 0;
+                    while (n >>= 1) ++r;
+                    return r;
+#endif
+                }
+
+                /** @brief size class of an allocation of n bytes (n must not exceed max_class_size) */
+                inline std::size_t size_class(std::size_t n) noexcept
+                {
+                    if (n <= min_class_size) return 0u;
+                    const std::size_t p = log2_floor(n-1);
+                    const std::size_t m = (n-1) >> (p - classes_per_doubling_log2);
+                    return 1 + (p - min_class_size_log2) * classes_per_doubling + (m - classes_per_doubling);
+                }
+
+                /** @brief block size of a size class */
+                inline std::size_t class_size(std::size_t c) noexcept
+                {
+                    if (c == 0u) return min_class_size;
+                    const std::size_t p = min_class_size_log2 + (c-1) / classes_per_doubling;
+                    const std::size_t m = classes_per_doubling + (c-1) % classes_per_doubling;
+                    return (m+1) << (p - classes_per_doubling_log2);
+                }
+
+                /** @brief tuning parameters of a slab pool */
+                struct pool_options
+                {
+                    // maximum number of bytes cached by a single thread
+                    std::size_t m_thread_cache_bytes = std::size_t(4) << 20;
+                    // high water mark of the shared depot: blocks which are returned while the depot holds
+                    // this many bytes are released to the underlying allocator
+                    std::size_t m_max_depot_bytes = std::size_t(256) << 20;
+                };
+
+                /** @brief pool statistics */
+                struct pool_stats
+                {
+                    // bytes handed out and not yet returned (rounded to size classes)
+                    std::size_t m_bytes_in_use;
+                    // bytes held in thread caches and in the depot
+                    std::size_t m_bytes_cached;
+                    // allocations served from a thread cache or the depot
+                    std::size_t m_hits;
+                    // allocations forwarded to the underlying allocator
+                    std::size_t m_misses;
+
+                    double hit_rate() const noexcept
+                    {
+                        const std::size_t n = m_hits + m_misses;
+                        return n == 0u ? 0.0 : static_cast<double>(m_hits) / n;
+                    }
+                };
+
+                struct thread_cache;
+
+                namespace detail {
+                    /** @brief link from the thread caches to their pool, which is cut when the pool is destroyed */
+                    struct pool_link
+                    {
+                        std::mutex m_mutex;
+                        void*      m_pool = nullptr;
+                        void     (*m_retire)(void*, thread_cache&) = nullptr;
+                    };
+                } // namespace detail
+
+                /** @brief blocks cached by one thread for one pool. Only the owning thread modifies it; the
+                  * counters are atomic so that statistics can be gathered from any thread. */
+                struct thread_cache
+                {
+                    std::shared_ptr<detail::pool_link> m_link;
+                    std::vector<unsigned char*> m_blocks[num_classes];
+                    std::atomic<std::size_t>    m_bytes{0u};
+                    std::atomic<std::int64_t>   m_in_use{0};
+                    std::atomic<std::size_t>    m_hits{0u};
+                    std::atomic<std::size_t>    m_misses{0u};
+
+                    template<typename T, typename U>
+                    static void add(std::atomic<T>& counter, U x) noexcept
+                    {
+                        counter.store(counter.load(std::memory_order_relaxed) + x, std::memory_order_relaxed);
+                    }
+                };
+
+                namespace detail {
+                    /** @brief per-thread list of the caches owned by live pools. When the thread exits, its caches
+                      * are handed back to the pools which are still alive. */
+                    struct cache_directory
+                    {
+                        std::uint64_t m_last_id = 0u;
+                        thread_cache* m_last    = nullptr;
+                        std::vector<std::pair<std::uint64_t, std::weak_ptr<thread_cache>>> m_entries;
+
+                        cache_directory() = default;
+                        cache_directory(const cache_directory&) = delete;
+                        cache_directory& operator=(const cache_directory&) = delete;
+
+                        ~cache_directory()
+                        {
+                            for (auto& e : m_entries)
+                            {
+                                if (auto c = e.second.lock())
+                                {
+                                    std::lock_guard<std::mutex> lock(c->m_link->m_mutex);
+                                    if (c->m_link->m_pool) c->m_link->m_retire(c->m_link->m_pool, *c);
+                                }
+                            }
+                        }
+                    };
+
+                    inline cache_directory& thread_caches()
+                    {
+                        static thread_local cache_directory d;
+                        return d;
+                    }
+
+                    inline std::uint64_t next_pool_id() noexcept
+                    {
+                        static std::atomic<std::uint64_t> id{0u};
+                        return ++id;
+                    }
+                } // namespace detail
+
+                /** @brief thread safe pool which bins blocks into size classes. Returned blocks are kept in a
+                  * cache private to the calling thread; when it overflows, the older half of a size class is
+                  * moved to a shared lock-free depot from which all threads can draw. The depot is bounded by
+                  * a high water mark, beyond which blocks are released to the underlying allocator, and can be
+                  * trimmed explicitly. When a thread exits, its cache is moved to the depot and its counters are
+                  * kept by the pool. The memory of the blocks is never accessed by the pool.
+                  * @tparam Allocator underlying byte allocator (must be thread safe) */
+                template<typename Allocator>
+                class pool_impl
+                {
+                public: // member types
+                    using byte               = unsigned char;
+                    using alloc_t            = typename std::allocator_traits<Allocator>::template rebind_alloc<byte>;
+                    using traits             = std::allocator_traits<alloc_t>;
+                    using pointer            = typename traits::pointer;
+                    using const_void_pointer = typename traits::const_void_pointer;
+                    using size_type          = typename traits::size_type;
+                    using pointer_traits     = std::pointer_traits<pointer>;
+
+                    static_assert(std::is_same<alloc_t, Allocator>::value, "must be a byte allocator");
+
+                private: // member types
+                    struct depot_class
+                    {
+                        std::atomic<int>   m_count{0};
+                        std::atomic<byte*> m_slots[depot_slots];
+
+                        depot_class() noexcept
+                        {
+                            for (auto& s : m_slots) s.store(nullptr, std::memory_order_relaxed);
+                        }
+                    };
+
+                private: // members
+                    alloc_t                                    m_alloc;
+                    pool_options                               m_options;
+                    const std::uint64_t                        m_id;
+                    std::unique_ptr<depot_class[]>             m_depot;
+                    std::atomic<std::size_t>                   m_depot_bytes{0u};
+                    std::mutex                                 m_mutex;
+                    std::vector<std::shared_ptr<thread_cache>> m_caches;
+                    std::shared_ptr<detail::pool_link>         m_link;
+                    // counters of the caches of threads which have exited
+                    std::int64_t                               m_retired_in_use = 0;
+                    std::size_t                                m_retired_hits = 0u;
+                    std::size_t                                m_retired_misses = 0u;
+
+                public: // ctors
+                    pool_impl(Allocator alloc, pool_options options = {})
+                    : m_alloc{alloc}
+                    , m_options{options}
+                    , m_id{detail::next_pool_id()}
+                    , m_depot{new depot_class[num_classes]}
+                    , m_link{std::make_shared<detail::pool_link>()}
+                    {
+                        m_link->m_pool = this;
+                        m_link->m_retire = [](void* pool, thread_cache& c) { static_cast<pool_impl*>(pool)->retire(c); };
+                    }
+
+                    pool_impl(const pool_impl&) = delete;
+                    pool_impl& operator=(const pool_impl&) = delete;
+
+                    ~pool_impl()
+                    {
+                        {
+                            // exiting threads do not hand back their caches any more
+                            std::lock_guard<std::mutex> lock(m_link->m_mutex);
+                            m_link->m_pool = nullptr;
+                        }
+                        for (auto& c : m_caches)
+                            for (std::size_t k=0; k<num_classes; ++k)
+                                for (auto ptr : c->m_blocks[k])
+                                    release(ptr, class_size(k));
+                        for (std::size_t k=0; k<num_classes; ++k)
+                            for (auto& s : m_depot[k].m_slots)
+                                if (byte* ptr = s.load(std::memory_order_relaxed))
+                                    release(ptr, class_size(k));
+                    }
+
+                public: // member functions
+                    const pool_options& options() const noexcept { return m_options; }
+
+                    pointer allocate(size_type n, const_void_pointer cvptr = nullptr)
+                    {
+                        auto& c = get_cache();
+                        if (n > max_class_size)
+                        {
+                            thread_cache::add(c.m_misses, 1u);
+                            thread_cache::add(c.m_in_use, n);
+                            return traits::allocate(m_alloc, n, cvptr);
+                        }
+                        const std::size_t k = size_class(n);
+                        const std::size_t size = class_size(k);
+                        thread_cache::add(c.m_in_use, size);
+                        byte* ptr = nullptr;
+                        auto& blocks = c.m_blocks[k];
+                        if (!blocks.empty())
+                        {
+                            ptr = blocks.back();
+                            blocks.pop_back();
+                            thread_cache::add(c.m_bytes, -size);
+                        }
+                        else
+                        {
+                            ptr = pop_depot(k);
+                        }
+                        if (ptr)
+                        {
+                            thread_cache::add(c.m_hits, 1u);
+                            return pointer_traits::pointer_to(*ptr);
+                        }
+                        thread_cache::add(c.m_misses, 1u);
+                        return traits::allocate(m_alloc, size, cvptr);
+                    }
+
+                    void deallocate(pointer ptr, size_type n)
+                    {
+                        auto& c = get_cache();
+                        byte* bptr = ::gridtools::ghex::to_address(ptr);
+                        if (n > max_class_size)
+                        {
+                            thread_cache::add(c.m_in_use, -static_cast<std::int64_t>(n));
+                            traits::deallocate(m_alloc, ptr, n);
+                            return;
+                        }
+                        const std::size_t k = size_class(n);
+                        const std::size_t size = class_size(k);
+                        thread_cache::add(c.m_in_use, -static_cast<std::int64_t>(size));
+                        auto& blocks = c.m_blocks[k];
+                        if (blocks.size() >= max_thread_cache_count ||
+                            c.m_bytes.load(std::memory_order_relaxed) + size > m_options.m_thread_cache_bytes)
+                        {
+                            // move the older half of this size class to the depot
+                            const std::size_t half = (blocks.size()+1)/2;
+                            for (std::size_t i=0; i<half; ++i) push_depot(k, blocks[i]);
+                            blocks.erase(blocks.begin(), blocks.begin()+half);
+                            thread_cache::add(c.m_bytes, -half*size);
+                            if (c.m_bytes.load(std::memory_order_relaxed) + size > m_options.m_thread_cache_bytes)
+                            {
+                                push_depot(k, bptr);
+                                return;
+                            }
+                        }
+                        blocks.push_back(bptr);
+                        thread_cache::add(c.m_bytes, size);
+                    }
+
+                    /** @brief release cached memory: the calling thread's cache is moved to the depot, and the
+                      * depot is then trimmed to the given number of bytes
+                      * @param max_depot_bytes number of bytes the depot may keep */
+                    void trim(std::size_t max_depot_bytes = 0u)
+                    {
+                        auto& c = get_cache();
+                        for (std::size_t k=0; k<num_classes; ++k)
+                        {
+                            for (auto ptr : c.m_blocks[k]) push_depot(k, ptr);
+                            c.m_blocks[k].clear();
+                        }
+                        c.m_bytes.store(0u, std::memory_order_relaxed);
+                        // release large blocks first
+                        for (std::size_t k=num_classes; k>0u; --k)
+                        {
+                            while (m_depot_bytes.load(std::memory_order_relaxed) > max_depot_bytes)
+                            {
+                                byte* ptr = pop_depot(k-1);
+                                if (!ptr) break;
+                                release(ptr, class_size(k-1));
+                            }
+                        }
+                    }
+
+                    /** @brief gather statistics over all threads (the values are a snapshot when other threads
+                      * use the pool concurrently) */
+                    pool_stats stats()
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        pool_stats s{0u, m_depot_bytes.load(std::memory_order_relaxed), m_retired_hits, m_retired_misses};
+                        std::int64_t in_use = m_retired_in_use;
+                        for (const auto& c : m_caches)
+                        {
+                            in_use           += c->m_in_use.load(std::memory_order_relaxed);
+                            s.m_bytes_cached += c->m_bytes.load(std::memory_order_relaxed);
+                            s.m_hits         += c->m_hits.load(std::memory_order_relaxed);
+                            s.m_misses       += c->m_misses.load(std::memory_order_relaxed);
+                        }
+                        s.m_bytes_in_use = in_use > 0 ? static_cast<std::size_t>(in_use) : 0u;
+                        return s;
+                    }
+
+                private: // implementation
+                    thread_cache& get_cache()
+                    {
+                        auto& d = detail::thread_caches();
+                        if (d.m_last_id == m_id) return *d.m_last;
+                        return get_cache(d);
+                    }
+
+                    thread_cache& get_cache(detail::cache_directory& d)
+                    {
+                        std::shared_ptr<thread_cache> c;
+                        for (auto it = d.m_entries.begin(); it != d.m_entries.end(); )
+                        {
+                            if (it->first == m_id) c = it->second.lock();
+                            // drop entries of pools which have been destroyed
+                            if (it->second.expired()) it = d.m_entries.erase(it);
+                            else ++it;
+                        }
+                        if (!c)
+                        {
+                            c = std::make_shared<thread_cache>();
+                            c->m_link = m_link;
+                            {
+                                std::lock_guard<std::mutex> lock(m_mutex);
+                                m_caches.push_back(c);
+                            }
+                            d.m_entries.emplace_back(m_id, c);
+                        }
+                        d.m_last_id = m_id;
+                        d.m_last = c.get();
+                        return *c;
+                    }
+
+                    // called on an exiting thread: move its cached blocks to the depot and keep its counters
+                    void retire(thread_cache& c)
+                    {
+                        for (std::size_t k=0; k<num_classes; ++k)
+                        {
+                            for (auto ptr : c.m_blocks[k]) push_depot(k, ptr);
+                            c.m_blocks[k].clear();
+                        }
+                        c.m_bytes.store(0u, std::memory_order_relaxed);
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        m_retired_in_use += c.m_in_use.load(std::memory_order_relaxed);
+                        m_retired_hits   += c.m_hits.load(std::memory_order_relaxed);
+                        m_retired_misses += c.m_misses.load(std::memory_order_relaxed);
+                        for (auto it = m_caches.begin(); it != m_caches.end(); ++it)
+                        {
+                            if (it->get() == &c)
+                            {
+                                m_caches.erase(it);
+                                break;
+                            }
+                        }
+                    }
+
+                    void push_depot(std::size_t k, byte* ptr)
+                    {
+                        const std::size_t size = class_size(k);
+                        if (m_depot_bytes.fetch_add(size, std::memory_order_relaxed) + size <= m_options.m_max_depot_bytes)
+                        {
+                            auto& d = m_depot[k];
+                            for (auto& s : d.m_slots)
+                            {
+                                byte* expected = nullptr;
+                                if (s.load(std::memory_order_relaxed) == nullptr &&
+                                    s.compare_exchange_strong(expected, ptr, std::memory_order_release, std::memory_order_relaxed))
+                                {
+                                    d.m_count.fetch_add(1, std::memory_order_relaxed);
+                                    return;
+                                }
+                            }
+                        }
+                        // above the high water mark or no free slot
+                        m_depot_bytes.fetch_sub(size, std::memory_order_relaxed);
+                        release(ptr, size);
+                    }
+
+                    byte* pop_depot(std::size_t k)
+                    {
+                        auto& d = m_depot[k];
+                        if (d.m_count.load(std::memory_order_relaxed) <= 0) return nullptr;
+                        for (auto& s : d.m_slots)
+                        {
+                            if (s.load(std::memory_order_relaxed) == nullptr) continue;
+                            if (byte* ptr = s.exchange(nullptr, std::memory_order_acquire))
+                            {
+                                d.m_count.fetch_sub(1, std::memory_order_relaxed);
+                                m_depot_bytes.fetch_sub(class_size(k), std::memory_order_relaxed);
+                                return ptr;
+                            }
+                        }
+                        return nullptr;
+                    }
+
+                    void release(byte* ptr, std::size_t size)
+                    {
+                        traits::deallocate(m_alloc, pointer_traits::pointer_to(*ptr), size);
+                    }
+                };
+
+            } // namespace slab
+
+            /** @brief owning handle of a thread safe size-class pool
+              * @tparam BasicAllocator underlying allocator */
+            template<typename BasicAllocator>
+            struct slab_pool
+            {
+                using allocator_type = pool_allocator_adaptor<BasicAllocator, slab::pool_impl>;
+                using byte_base      = typename allocator_type::byte_base;
+                using impl_type      = typename allocator_type::impl_type;
+
+                std::unique_ptr<impl_type> m_pool_impl;
+
+                slab_pool(BasicAllocator alloc, slab::pool_options options = {})
+                : m_pool_impl( new impl_type{alloc, options} )
+                {}
+
+                slab_pool(const slab_pool&) = delete;
+                slab_pool(slab_pool&&) = default;
+
+                allocator_type get_allocator() const
+                {
+                    return { m_pool_impl.get() };
+                }
+
+                slab::pool_stats stats() const
+                {
+                    return m_pool_impl->stats();
+                }
+
+                void trim(std::size_t max_depot_bytes = 0u)
+                {
+                    m_pool_impl->trim(max_depot_bytes);
+                }
+            };
+
+        } // namespace allocator
+    } // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_ALLOCATOR_SLAB_POOL_HPP */
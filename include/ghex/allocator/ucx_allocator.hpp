@@ -0,0 +1,122 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_ALLOCATOR_UCX_ALLOCATOR_HPP
+#define INCLUDED_GHEX_ALLOCATOR_UCX_ALLOCATOR_HPP
+
+#include <memory>
+#include "../transport_layer/ucx/registration_cache.hpp"
+
+namespace gridtools {
+    namespace ghex {
+        namespace allocator {
+
+            /** @brief allocator adaptor which registers every allocation with ucx. Used as the basic allocator of a
+              * pool, memory is registered once when the pool obtains it and the registration is reused whenever the
+              * pool recycles the memory. The memory is registered with the context owning the cache passed at
+              * construction (see make_ucx_registered_allocator); default constructed instances do not register.
+              * @tparam Allocator underlying allocator */
+            template<typename Allocator>
+            struct ucx_registered_allocator : public Allocator
+            {
+                using base            = Allocator;
+                using base_traits     = std::allocator_traits<base>;
+                using value_type      = typename base_traits::value_type;
+                using pointer         = typename base_traits::pointer;
+                using size_type       = typename base_traits::size_type;
+                using cache_type      = tl::ucx::registration_cache;
+
+                template<typename U>
+                struct rebind
+                {
+                    using other = ucx_registered_allocator<typename base_traits::template rebind_alloc<U>>;
+                };
+
+                std::shared_ptr<cache_type> m_cache;
+
+                ucx_registered_allocator()
+                : base()
+                {}
+
+                ucx_registered_allocator(std::shared_ptr<cache_type> cache, const base& alloc = base())
+                : base(alloc)
+                , m_cache{std::move(cache)}
+                {}
+
+                template<typename A>
+                ucx_registered_allocator(const ucx_registered_allocator<A>& other)
+                : base(other)
+                , m_cache{other.m_cache}
+                {}
+
+                pointer allocate(size_type n)
+                {
+                    base& b = *this;
+                    pointer ptr = base_traits::allocate(b, n);
+                    if (m_cache)
+                    {
+                        try { m_cache->map(std::addressof(*ptr), n*sizeof(value_type)); }
+                        catch (...) { base_traits::deallocate(b, ptr, n); throw; }
+                    }
+                    return ptr;
+                }
+
+                void deallocate(pointer ptr, size_type n)
+                {
+                    base& b = *this;
+                    if (m_cache) m_cache->unmap(std::addressof(*ptr));
+                    base_traits::deallocate(b, ptr, n);
+                }
+            };
+
+            namespace detail {
+                // communicators of the ucx transport hand out the registration cache of their context
+                template<typename Communicator>
+                auto registration_cache_of(const Communicator& comm, int) -> decltype(comm.get_registration_cache())
+                {
+                    return comm.get_registration_cache();
+                }
+
+                template<typename Communicator>
+                std::shared_ptr<tl::ucx::registration_cache> registration_cache_of(const Communicator&, long)
+                {
+                    return {};
+                }
+            } // namespace detail
+
+            /** @brief make an allocator which registers memory with the ucx context of a communicator. No memory is
+              * registered if the communicator belongs to another transport.
+              * @tparam Allocator underlying allocator
+              * @param comm communicator
+              * @param alloc underlying allocator instance */
+            template<typename Allocator, typename Communicator>
+            ucx_registered_allocator<Allocator> make_ucx_registered_allocator(const Communicator& comm,
+                const Allocator& alloc = Allocator())
+            {
+                return {detail::registration_cache_of(comm, 0), alloc};
+            }
+
+            template<typename A, typename B>
+            bool operator==(const ucx_registered_allocator<A>& a, const ucx_registered_allocator<B>& b)
+            {
+                return a.m_cache == b.m_cache;
+            }
+
+            template<typename A, typename B>
+            bool operator!=(const ucx_registered_allocator<A>& a, const ucx_registered_allocator<B>& b)
+            {
+                return a.m_cache != b.m_cache;
+            }
+
+        } // namespace allocator
+    } // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_ALLOCATOR_UCX_ALLOCATOR_HPP */
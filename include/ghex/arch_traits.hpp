@@ -12,8 +12,12 @@
 #define INCLUDED_GHEX_ARCH_TRAITS_HPP
 
 #include "./allocator/pool_allocator_adaptor.hpp"
+#include "./allocator/slab_pool.hpp"
 #include "./allocator/aligned_allocator_adaptor.hpp"
 #include "./allocator/cuda_allocator.hpp"
+#ifdef GHEX_UCX_USE_REGISTRATION_CACHE
+#include "./allocator/ucx_allocator.hpp"
+#endif
 #include "./transport_layer/message_buffer.hpp"
 #include "./arch_list.hpp"
 
@@ -29,8 +33,13 @@ namespace gridtools {
             static constexpr const char* name = "CPU";
 
             using device_id_type          = int;
+#ifdef GHEX_UCX_USE_REGISTRATION_CACHE
+            // pooled memory is registered with ucx once, when the pool obtains it
+            using basic_allocator_type    = allocator::ucx_registered_allocator<std::allocator<unsigned char>>;
+#else
             using basic_allocator_type    = std::allocator<unsigned char>;
-            using pool_type               = allocator::pool<basic_allocator_type>;
+#endif
+            using pool_type               = allocator::slab_pool<basic_allocator_type>;
             using pool_allocator_type     = typename pool_type::allocator_type;
             
             //using message_allocator_type  = allocator::aligned_allocator_adaptor<std::allocator<unsigned char>,64>;
@@ -39,6 +48,18 @@ namespace gridtools {
 
             static device_id_type default_id() { return 0; }
 
+            /** @brief make the basic allocator of a pool whose messages are exchanged through a communicator */
+            template<typename Communicator>
+#ifdef GHEX_UCX_USE_REGISTRATION_CACHE
+            static basic_allocator_type make_basic_allocator(const Communicator& comm)
+            {
+                // pooled memory is registered with the ucx context of the communicator
+                return allocator::make_ucx_registered_allocator<std::allocator<unsigned char>>(comm);
+            }
+#else
+            static basic_allocator_type make_basic_allocator(const Communicator&) { return {}; }
+#endif
+
             static message_type make_message(pool_type& pool, device_id_type index = default_id()) 
             { 
                 static_assert(std::is_same<decltype(index),device_id_type>::value, "trick to prevent warnings");
@@ -64,6 +85,10 @@ namespace gridtools {
 
             static device_id_type default_id() { return 0; }
 
+            /** @brief make the basic allocator of a pool whose messages are exchanged through a communicator */
+            template<typename Communicator>
+            static basic_allocator_type make_basic_allocator(const Communicator&) { return {}; }
+
             static message_type make_message(pool_type& pool, device_id_type index = default_id()) 
             { 
                 static_assert(std::is_same<decltype(index),device_id_type>::value, "trick to prevent warnings");
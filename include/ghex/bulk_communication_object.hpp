@@ -45,6 +45,12 @@ namespace ghex {
 // In the case of multi-processed applications, the xpmem kernel module must be available for the
 // transport to work.
 //
+// If GHEX_USE_MPI_RMA is defined, halos of (cpu) fields are also put directly to remote neighbors
+// using MPI one-sided communication, provided the communicator exposes an MPI window (MPI and shm
+// transports). The source packs a halo and puts it into a staging buffer of the target, which unpacks
+// it when it regains access. The synchronization follows the same access guard protocol, with the
+// access mode being updated through MPI atomic operations.
+//
 // The multi-threaded parts are built on top of standard thread synchronization mechanisms, whereas
 // the multi-processed parts use shmem for synchronization and xpmem for data exposure. GPUs are
 // managed with cuda IPC facilities.
@@ -118,7 +124,10 @@ public:
 /** @brief Communication object which enables registration of fields ahead of communication so that
   * halo exchange operation can be called repeatedly. This class also enables direct memory access
   * when possible to the neighboring fields (RMA). Current RMA is limited to in-node threads and
-  * processes. Inter-process RMA is only enabled when GHEX is built with xpmem support.
+  * processes. Inter-process RMA is only enabled when GHEX is built with xpmem support (or cross
+  * memory attach, shared memory fields). Remote neighbors are accessed with MPI one-sided
+  * communication if GHEX_USE_MPI_RMA is defined; otherwise they are served by a regular
+  * communication object.
   * @tparam RangeGen template template parameter which generates source and target ranges
   * @tparam Pattern the pattern type that can be used with the registered fields
   * @tparam Fields a list of field types that can be registered */
@@ -152,8 +161,9 @@ public: // member types
 
 private: // member types
     // this type holds the patterns used for remote and local exchanges
-    // map key is the pointer to the pattern that is used when the field is added
-    using pattern_map = std::map<const pattern_type*, pattern_type>;
+    // map key is the pointer to the pattern that is used when the field is added, and whether remote
+    // neighbors are accessed through rma (which depends on the field type)
+    using pattern_map = std::map<std::pair<const pattern_type*, bool>, pattern_type>;
 
     // a similar map that holds rma handles to each field that is added
     // map key is the pointer to the fields memory
@@ -228,8 +238,8 @@ private: // member types
             local_handle_map& l_handle_map, pattern_map& local_map, pattern_map& remote_map)
         : m_field{f}
         , m_local_handle(l_handle_map.insert(std::make_pair((void*)(f.data()),rma::local_handle{})).first->second)
-        , m_remote_pattern(remote_map.insert(std::make_pair(&pattern, pattern)).first->second)
-        , m_local_pattern(local_map.insert(std::make_pair(&pattern, pattern)).first->second)
+        , m_remote_pattern(remote_map.insert(std::make_pair(std::make_pair(&pattern, remote_rma(comm)), pattern)).first->second)
+        , m_local_pattern(local_map.insert(std::make_pair(std::make_pair(&pattern, remote_rma(comm)), pattern)).first->second)
         {
             // initialize the remote handle - this will effectively publish the rma pointers
             // will do nothing if already initialized
@@ -246,8 +256,7 @@ private: // member types
                 auto r_it = r_p.send_halos().begin();
                 while (r_it != r_p.send_halos().end())
                 {
-                    const auto local = rma::is_local(comm, r_it->first.mpi_rank);
-                    if (local != rma::locality::remote) r_it = r_p.send_halos().erase(r_it);
+                    if (use_rma(comm, r_it->first.mpi_rank)) r_it = r_p.send_halos().erase(r_it);
                     else ++r_it;
                 }
 
@@ -256,8 +265,7 @@ private: // member types
                 auto l_it = l_p.send_halos().begin();
                 while (l_it != l_p.send_halos().end())
                 {
-                    const auto local = rma::is_local(comm, l_it->first.mpi_rank);
-                    if (local != rma::locality::remote) ++l_it;
+                    if (use_rma(comm, l_it->first.mpi_rank)) ++l_it;
                     else l_it = l_p.send_halos().erase(l_it);
                 }
 
@@ -265,8 +273,7 @@ private: // member types
                 r_it = r_p.recv_halos().begin();
                 while (r_it != r_p.recv_halos().end())
                 {
-                    const auto local = rma::is_local(comm, r_it->first.mpi_rank);
-                    if (local != rma::locality::remote) r_it = r_p.recv_halos().erase(r_it);
+                    if (use_rma(comm, r_it->first.mpi_rank)) r_it = r_p.recv_halos().erase(r_it);
                     else ++r_it;
                 }
 
@@ -274,8 +281,7 @@ private: // member types
                 l_it = l_p.recv_halos().begin();
                 while (l_it != l_p.recv_halos().end())
                 {
-                    const auto local = rma::is_local(comm, l_it->first.mpi_rank);
-                    if (local != rma::locality::remote) ++l_it;
+                    if (use_rma(comm, l_it->first.mpi_rank)) ++l_it;
                     else l_it = l_p.recv_halos().erase(l_it);
                 }
             }
@@ -283,6 +289,24 @@ private: // member types
 
         field_container(const field_container&) = default;
         field_container(field_container&&) = default;
+
+        // whether remote neighbors are accessed through MPI one-sided communication
+        static bool remote_rma(communicator_type comm)
+        {
+#if defined(GHEX_USE_MPI_RMA) && !defined(GHEX_NO_RMA)
+            return std::is_same<typename Field::arch_type, cpu>::value && rma::mpi::get_window(comm);
+#else
+            (void)comm;
+            return false;
+#endif
+        }
+
+        // whether the halos exchanged with a neighbor are put directly or sent through the
+        // communication object
+        static bool use_rma(communicator_type comm, int rank)
+        {
+            return rma::is_local(comm, rank) != rma::locality::remote || remote_rma(comm);
+        }
     };
 
     template<typename Field>
@@ -0,0 +1,178 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_COMMON_MPI_DATATYPE_CACHE_HPP
+#define INCLUDED_GHEX_COMMON_MPI_DATATYPE_CACHE_HPP
+
+#include <map>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include "../transport_layer/mpi/error.hpp"
+
+namespace gridtools {
+
+    namespace ghex {
+
+        /** @brief caches MPI datatypes describing halo regions within field memory. Datatypes are keyed by the
+          * memory layout of the field and the halo region, and are freed on destruction. Datatypes combining the
+          * halo regions of several fields are cached as well, keyed by the fields' datatypes and the distances of
+          * their data pointers to the first field's data pointer. Since these distances change whenever fields
+          * are reallocated, the number of combined datatypes is bounded: when the bound is exceeded, the least
+          * recently used ones which were not used during the current epoch (see next_epoch()) are freed.
+          * The field type must provide the member functions
+          * - template<typename IndexContainer> std::vector<std::ptrdiff_t> mpi_datatype_key(const IndexContainer&) const
+          * - template<typename IndexContainer> MPI_Datatype make_mpi_datatype(const IndexContainer&) const */
+        class mpi_datatype_cache
+        {
+        private: // member types
+            using key_type = std::vector<std::ptrdiff_t>;
+            using region_type = std::pair<MPI_Datatype, void*>;
+            using struct_key_type = std::vector<std::pair<MPI_Datatype, MPI_Aint>>;
+            struct struct_entry
+            {
+                MPI_Datatype m_type;
+                std::uint64_t m_epoch;
+            };
+
+        private: // members
+            std::map<key_type, MPI_Datatype> m_types;
+            std::map<struct_key_type, struct_entry> m_struct_types;
+            std::size_t m_max_struct_types;
+            std::uint64_t m_epoch = 0u;
+
+        public: // ctors
+            /** @param max_struct_types number of combined datatypes above which unused ones are freed */
+            mpi_datatype_cache(std::size_t max_struct_types = 64u)
+            : m_max_struct_types{max_struct_types}
+            {}
+            mpi_datatype_cache(const mpi_datatype_cache&) = delete;
+            mpi_datatype_cache(mpi_datatype_cache&& other) noexcept
+            : m_types{std::move(other.m_types)}
+            , m_struct_types{std::move(other.m_struct_types)}
+            , m_max_struct_types{other.m_max_struct_types}
+            , m_epoch{other.m_epoch}
+            {
+                other.m_types.clear();
+                other.m_struct_types.clear();
+            }
+            mpi_datatype_cache& operator=(const mpi_datatype_cache&) = delete;
+            mpi_datatype_cache& operator=(mpi_datatype_cache&& other) noexcept
+            {
+                destroy();
+                m_types = std::move(other.m_types);
+                m_struct_types = std::move(other.m_struct_types);
+                m_max_struct_types = other.m_max_struct_types;
+                m_epoch = other.m_epoch;
+                other.m_types.clear();
+                other.m_struct_types.clear();
+                return *this;
+            }
+            ~mpi_datatype_cache() { destroy(); }
+
+        public: // member functions
+            /** @brief get the datatype for a field and a set of iteration spaces, create it if necessary
+              * @tparam Field field type
+              * @tparam IndexContainer iteration space container type
+              * @param f field instance
+              * @param c iteration spaces
+              * @return committed datatype relative to the field's data pointer (owned by the cache) */
+            template<typename Field, typename IndexContainer>
+            MPI_Datatype get(const Field& f, const IndexContainer& c)
+            {
+                key_type key = f.mpi_datatype_key(c);
+                auto it = m_types.find(key);
+                if (it == m_types.end())
+                    it = m_types.insert(std::make_pair(std::move(key), f.make_mpi_datatype(c))).first;
+                return it->second;
+            }
+
+            /** @brief get the datatype which combines the halo regions of several fields, create it if necessary
+              * @param regions datatypes obtained from get() and the data pointers of the corresponding fields
+              * @return committed datatype relative to the data pointer of the first region (owned by the cache,
+              * valid at least until the next epoch) */
+            MPI_Datatype get(const std::vector<region_type>& regions)
+            {
+                struct_key_type key(regions.size());
+                MPI_Aint base;
+                GHEX_CHECK_MPI_RESULT(MPI_Get_address(regions[0].second, &base));
+                for (std::size_t i=0; i<regions.size(); ++i)
+                {
+                    MPI_Aint address;
+                    GHEX_CHECK_MPI_RESULT(MPI_Get_address(regions[i].second, &address));
+                    key[i] = std::make_pair(regions[i].first, address - base);
+                }
+                auto it = m_struct_types.find(key);
+                if (it == m_struct_types.end())
+                {
+                    evict();
+                    std::vector<int> block_lengths(regions.size(), 1);
+                    std::vector<MPI_Aint> displacements(regions.size());
+                    std::vector<MPI_Datatype> types(regions.size());
+                    for (std::size_t i=0; i<regions.size(); ++i)
+                    {
+                        types[i] = key[i].first;
+                        displacements[i] = key[i].second;
+                    }
+                    MPI_Datatype t;
+                    GHEX_CHECK_MPI_RESULT(MPI_Type_create_struct(types.size(), block_lengths.data(),
+                        displacements.data(), types.data(), &t));
+                    GHEX_CHECK_MPI_RESULT(MPI_Type_commit(&t));
+                    it = m_struct_types.insert(std::make_pair(std::move(key), struct_entry{t, m_epoch})).first;
+                }
+                it->second.m_epoch = m_epoch;
+                return it->second.m_type;
+            }
+
+            /** @brief start a new epoch: combined datatypes which are not used anymore during the new epoch may be
+              * freed. Datatypes obtained during the current epoch must not be in use anymore afterwards. */
+            void next_epoch() noexcept { ++m_epoch; }
+
+            std::size_t size() const noexcept { return m_types.size() + m_struct_types.size(); }
+
+        private:
+            // free least recently used combined datatypes of past epochs while the bound is reached
+            void evict()
+            {
+                while (m_struct_types.size() >= m_max_struct_types)
+                {
+                    auto lru = m_struct_types.end();
+                    for (auto it = m_struct_types.begin(); it != m_struct_types.end(); ++it)
+                        if (it->second.m_epoch < m_epoch &&
+                            (lru == m_struct_types.end() || it->second.m_epoch < lru->second.m_epoch))
+                            lru = it;
+                    if (lru == m_struct_types.end()) return;
+                    GHEX_CHECK_MPI_RESULT(MPI_Type_free(&lru->second.m_type));
+                    m_struct_types.erase(lru);
+                }
+            }
+
+            void destroy() noexcept
+            {
+                int finalized = 0;
+                MPI_Finalized(&finalized);
+                if (!finalized)
+                {
+                    for (auto& p : m_struct_types)
+                        MPI_Type_free(&p.second.m_type);
+                    for (auto& p : m_types)
+                        MPI_Type_free(&p.second);
+                }
+                m_struct_types.clear();
+                m_types.clear();
+            }
+        };
+
+    } // namespace ghex
+
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_COMMON_MPI_DATATYPE_CACHE_HPP */
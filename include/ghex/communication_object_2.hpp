@@ -17,10 +17,21 @@
 #include "./common/test_eq.hpp"
 #include "./buffer_info.hpp"
 #include "./transport_layer/tags.hpp"
+#include "./transport_layer/callback_utils.hpp"
+#include "./transport_layer/progress_thread.hpp"
 #include "./arch_traits.hpp"
+#ifdef GHEX_COMM_OBJ_USE_MPI_DATATYPES
+#include "./common/mpi_datatype_cache.hpp"
+#endif
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <map>
+#include <memory>
 #include <stdio.h>
 #include <functional>
+#include <thread>
 
 namespace gridtools {
 
@@ -41,8 +52,117 @@ namespace gridtools {
             template<typename P, typename T, typename D, int... Order>
             struct is_regular_gpu<buffer_info<P,gpu,structured::regular::field_descriptor<T,gpu,D,::gridtools::layout_map<Order...>>>>
             : public std::true_type {};
+
+            // traits class for transports supporting persistent requests
+            struct no_persistent_request {};
+            template<typename Communicator, typename Enable = void>
+            struct persistent_request : public std::false_type
+            {
+                using type = no_persistent_request;
+            };
+            template<typename Communicator>
+            struct persistent_request<Communicator,
+                std::enable_if_t<std::is_class<typename Communicator::persistent_request_type>::value>>
+            : public std::true_type
+            {
+                using type = typename Communicator::persistent_request_type;
+            };
+
+            // fields which can tell whether a set of iteration spaces maps to one contiguous range of memory
+            template<typename Field, typename IndexContainer>
+            auto contiguous_range(const Field* f, const IndexContainer& c, int)
+            -> decltype(f->contiguous_range(c), (unsigned char*)nullptr)
+            {
+                return reinterpret_cast<unsigned char*>(f->contiguous_range(c));
+            }
+            template<typename Field, typename IndexContainer>
+            unsigned char* contiguous_range(const Field*, const IndexContainer&, long) { return nullptr; }
+
+            // zero-copy exchanges are restricted to host memory
+            template<typename Arch, typename Field, typename IndexContainer>
+            unsigned char* zero_copy_ptr(const Field* f, const IndexContainer& c)
+            {
+#ifdef GHEX_COMM_OBJ_USE_ZERO_COPY
+                return std::is_same<Arch,cpu>::value ? contiguous_range(f, c, 0) : nullptr;
+#else
+                (void)f; (void)c;
+                return nullptr;
+#endif
+            }
+
+#ifdef GHEX_COMM_OBJ_USE_MPI_DATATYPES
+            // region of memory described by an MPI datatype relative to a base address
+            struct mpi_datatype_region
+            {
+                MPI_Datatype type = MPI_DATATYPE_NULL;
+                void* base = nullptr;
+            };
+
+            // traits class for transports which can send/receive MPI datatypes
+            template<typename Communicator, typename Enable = void>
+            struct supports_mpi_datatypes : public std::false_type {};
+            template<typename Communicator>
+            struct supports_mpi_datatypes<Communicator, decltype((void)std::declval<Communicator&>().send_typed(
+                (const void*)nullptr, MPI_DATATYPE_NULL, 0, 0))>
+            : public std::true_type {};
+
+            // fields which can describe a set of iteration spaces by an MPI datatype (host memory only)
+            template<typename Arch, typename Field, typename IndexContainer>
+            auto mpi_datatype(mpi_datatype_cache& cache, Field* f, const IndexContainer& c, int)
+            -> decltype(f->make_mpi_datatype(c), mpi_datatype_region{})
+            {
+                if (!std::is_same<Arch,cpu>::value) return {};
+                return {cache.get(*f, c), f->data()};
+            }
+            template<typename Arch, typename Field, typename IndexContainer>
+            mpi_datatype_region mpi_datatype(mpi_datatype_cache&, Field*, const IndexContainer&, long) { return {}; }
+
+            // typed send/recv, only called if the transport supports MPI datatypes
+            template<typename Communicator, typename Rank, typename Tag>
+            auto send_typed(Communicator& comm, const mpi_datatype_region& r, Rank dst, Tag tag, int)
+            -> decltype(comm.send_typed(r.base, r.type, dst, tag))
+            {
+                return comm.send_typed(r.base, r.type, dst, tag);
+            }
+            template<typename Communicator, typename Rank, typename Tag>
+            typename Communicator::template future<void>
+            send_typed(Communicator&, const mpi_datatype_region&, Rank, Tag, long)
+            {
+                throw std::runtime_error("transport does not support MPI datatypes");
+            }
+            template<typename Communicator, typename Rank, typename Tag>
+            auto recv_typed(Communicator& comm, const mpi_datatype_region& r, Rank src, Tag tag, int)
+            -> decltype(comm.recv_typed(r.base, r.type, src, tag))
+            {
+                return comm.recv_typed(r.base, r.type, src, tag);
+            }
+            template<typename Communicator, typename Rank, typename Tag>
+            typename Communicator::template future<void>
+            recv_typed(Communicator&, const mpi_datatype_region&, Rank, Tag, long)
+            {
+                throw std::runtime_error("transport does not support MPI datatypes");
+            }
+#endif
+
+            /** @brief copyable atomic flag (copies take over the current value) which marks a receive buffer
+              * whose data has been written to the fields */
+            struct ready_flag
+            {
+                std::atomic<bool> m_value{false};
+
+                ready_flag() noexcept = default;
+                ready_flag(const ready_flag& other) noexcept : m_value{other.load()} {}
+                ready_flag& operator=(const ready_flag& other) noexcept { store(other.load()); return *this; }
+
+                bool load() const noexcept { return m_value.load(std::memory_order_acquire); }
+                void store(bool v) noexcept { m_value.store(v, std::memory_order_release); }
+            };
         } // namespace detail
 
+#if defined(GHEX_COMM_OBJ_USE_PERSISTENT_REQUESTS) && defined(GHEX_COMM_OBJ_USE_FAT_CALLBACKS)
+#error "persistent requests are not available together with fat callbacks"
+#endif
+
         // forward declaration
         struct generic_bulk_communication_object;
         template<template <typename> class RangeGen, typename Pattern, typename... Fields>
@@ -51,6 +171,29 @@ namespace gridtools {
         // forward declaration
         template<typename Communicator, typename GridType, typename DomainIdType>
         class communication_object;
+        template<typename Communicator, typename GridType, typename DomainIdType>
+        class exchange_plan;
+
+        /** @brief requests that an exchange plan aggregates the (cpu) messages for the same neighbor rank into a
+          * single message (see exchange_plan). Holds the setup communicator which is used to check that the
+          * neighbor ranks aggregate the same messages.
+          * @tparam SetupCommunicator setup communicator type */
+        template<typename SetupCommunicator>
+        struct aggregate_messages_t
+        {
+            SetupCommunicator m_setup_comm;
+        };
+
+        /** @brief request message aggregation for an exchange plan
+          * @tparam Context context type
+          * @param context context the patterns were made with
+          * @return aggregation request to be passed to the exchange plan */
+        template<typename Context>
+        auto aggregate_messages(const Context& context)
+        {
+            using setup_communicator_type = decltype(context.get_setup_communicator());
+            return aggregate_messages_t<setup_communicator_type>{context.get_setup_communicator()};
+        }
 
         /** @brief handle type for waiting on asynchronous communication processes.
           * The wait function is stored in a member.
@@ -67,10 +210,28 @@ namespace gridtools {
         private: // member types
             using co_t              = communication_object<Communicator,GridType,DomainIdType>;
             using communicator_type = Communicator;
+            using domain_id_type    = DomainIdType;
+            using index_container_type = typename pattern<Communicator,GridType,DomainIdType>::index_container_type;
+
+        public: // member types
+            /** @brief halos which a local domain receives from a neighboring domain in one message: corresponds
+              * to an entry in the receive halos of a pattern. The iteration spaces are taken from the pattern
+              * of the first field in the message (all fields of the same pattern share the iteration spaces).
+              * A default constructed region is empty. */
+            struct halo_region
+            {
+                domain_id_type local_id;
+                domain_id_type remote_id;
+                const index_container_type* iteration_spaces = nullptr;
+
+                explicit operator bool() const noexcept { return iteration_spaces != nullptr; }
+            };
 
         private: // members
             communicator_type m_comm;
             std::function<void()> m_wait_fct;
+            // set if the exchange can be completed in several phases
+            co_t* m_co = nullptr;
 
         public: // public constructor
             /** @brief construct a ready handle
@@ -87,6 +248,15 @@ namespace gridtools {
             communication_handle(const communicator_type& comm, Func&& wait_fct) 
             : m_comm{comm}, m_wait_fct(std::forward<Func>(wait_fct)) {}
 
+            /** @brief construct a handle to an exchange which supports split-phase completion
+              * @tparam Func function type with signature void()
+              * @param comm communicator
+              * @param co communication object
+              * @param wait_fct wait function */
+            template<typename Func>
+            communication_handle(const communicator_type& comm, co_t* co, Func&& wait_fct) 
+            : m_comm{comm}, m_wait_fct(std::forward<Func>(wait_fct)), m_co{co} {}
+
         public: // copy and move ctors
             communication_handle(communication_handle&&) = default;
             communication_handle(const communication_handle&) = delete;
@@ -96,7 +266,50 @@ namespace gridtools {
         public: // member functions
             /** @brief  wait for communication to be finished*/
             void wait() { if (m_wait_fct) m_wait_fct(); }
-            void progress() { m_comm.progress(); }
+
+            /** @brief progress the communication and unpack the halos which have arrived so far */
+            void progress()
+            {
+                if (m_co) m_co->progress_exchange();
+                else m_comm.progress();
+            }
+
+            /** @brief test for completion without blocking. Halos which have arrived are unpacked. Handles which
+              * do not support split-phase completion (e.g. the gpu vector interface) are waited on instead.
+              * @return true if the communication has finished */
+            bool test()
+            {
+                if (m_co) return m_co->test();
+                wait();
+                return true;
+            }
+
+            /** @brief whether the halos which the domain remote_id sends to the local domain local_id have been
+              * written to the fields. Does not progress the communication.
+              * @param local_id id of a local domain
+              * @param remote_id id of a neighboring domain
+              * @return true if the halos are valid (or if there are no such halos) */
+            bool is_ready(domain_id_type local_id, domain_id_type remote_id)
+            {
+                if (m_co) return m_co->is_ready(local_id, remote_id);
+                return !m_wait_fct;
+            }
+
+            /** @brief whether the halos of a region have been written to the fields */
+            bool is_ready(const halo_region& r) { return is_ready(r.local_id, r.remote_id); }
+
+            /** @brief progress the communication until the halos of one more region have been written to the
+              * fields. Each region is returned only once per exchange, so that e.g. the boundary next to a
+              * neighbor can be computed as soon as its halos have arrived:
+              * while (auto r = h.wait_any()) compute_boundary(r); h.wait();
+              * The sends may still be in flight when all regions have been returned.
+              * @return the region which became valid, or an empty region if all regions have been returned */
+            halo_region wait_any()
+            {
+                if (m_co) return m_co->wait_any();
+                wait();
+                return {};
+            }
         };
 
      
@@ -116,12 +329,18 @@ namespace gridtools {
             using pattern_type            = pattern<Communicator,GridType,DomainIdType>;
             using pattern_container_type  = pattern_container<Communicator,GridType,DomainIdType>;
             using this_type               = communication_object<Communicator,GridType,DomainIdType>;
+            using progress_thread_type    = tl::progress_thread<Communicator>;
 
             template<typename D, typename F>
             using buffer_info_type        = buffer_info<pattern_type,D,F>;
 
+        private: // constants
+            // tag of the setup communicator which is used to check aggregated messages
+            static constexpr int aggregation_check_tag = 97;
+
         private: // friend class
             friend class communication_handle<Communicator,GridType,DomainIdType>;
+            friend class exchange_plan<Communicator,GridType,DomainIdType>;
             template<template <typename> class RangeGen, typename Pattern, typename... Fields>
             friend class bulk_communication_object;
 
@@ -150,6 +369,10 @@ namespace gridtools {
               * which is used to store a field's pack or unpack member function. 
               * This class also stores the offset in the serialized buffer in bytes.
               * The type-erased field_ptr member is only used for the gpu-vector-interface.
+              * The zero_copy_ptr member points to the field's memory if the iteration spaces map to one contiguous
+              * range of memory (and zero-copy exchanges are enabled), and is nullptr otherwise.
+              * The datatype member describes the iteration spaces within the field's memory if MPI datatype
+              * exchanges are enabled and supported by the field.
               * @tparam Function Either pack or unpack function pointer type */
             template<typename Function>
             struct field_info
@@ -159,6 +382,10 @@ namespace gridtools {
                 const index_container_type* index_container;
                 std::size_t offset;
                 void* field_ptr;
+                unsigned char* zero_copy_ptr;
+#ifdef GHEX_COMM_OBJ_USE_MPI_DATATYPES
+                detail::mpi_datatype_region datatype;
+#endif
             };
 
             /** @brief Holds serial buffer memory and meta information associated with it
@@ -174,6 +401,26 @@ namespace gridtools {
                 std::size_t size;
                 std::vector<field_info_type> field_infos;
                 cuda::stream m_cuda_stream;
+                // set if the message is sent/received directly from/to the field's memory
+                unsigned char* zero_copy_ptr = nullptr;
+                // receive buffers: set once the received data has been written to the fields
+                detail::ready_flag ready;
+                // receive buffers: set once the buffer's halo region has been returned by wait_any
+                bool reported = false;
+                // set if the halos are carried by the message of another buffer (messages for the same remote
+                // address are aggregated)
+                typename communication_object::template buffer<Vector,Function>* aggregate = nullptr;
+                // the buffers whose halos are carried by this buffer's message (including this buffer)
+                std::vector<typename communication_object::template buffer<Vector,Function>*> parts;
+                // whether halo data is exchanged for this buffer
+                bool has_halos() const noexcept { return size > 0u || aggregate; }
+#ifdef GHEX_COMM_OBJ_USE_MPI_DATATYPES
+                // set if the message is sent/received directly from/to the fields' memory using an MPI datatype
+                detail::mpi_datatype_region datatype;
+                bool bypasses_packer() const noexcept { return zero_copy_ptr || datatype.type != MPI_DATATYPE_NULL; }
+#else
+                bool bypasses_packer() const noexcept { return zero_copy_ptr; }
+#endif
             };
 
             /** @brief Holds maps of buffers for send and recieve operations indexed by a domain_id_pair and a device id
@@ -193,12 +440,23 @@ namespace gridtools {
                 std::map<device_id_type, std::unique_ptr<typename arch_traits<Arch>::pool_type>> m_pools;
                 send_memory_type send_memory;
                 recv_memory_type recv_memory;
+                // messages received directly into the fields and the index of their future in m_zero_copy_futures
+                std::vector<std::pair<recv_buffer_type*, std::size_t>> m_zero_copy_recvs;
 
 #ifndef GHEX_COMM_OBJ_USE_FAT_CALLBACKS
                 // additional members needed for receive operations used for scheduling calls to unpack
                 using hook_type = recv_buffer_type*;
                 using hook_future_type = typename communicator_type::template future<hook_type>;
                 std::vector<hook_future_type> m_recv_futures;
+#endif
+#ifdef GHEX_COMM_OBJ_USE_PERSISTENT_REQUESTS
+                // persistent requests bound to the buffers of a planned exchange
+                using persistent_request_type = typename detail::persistent_request<communicator_type>::type;
+                std::vector<persistent_request_type> m_recv_preqs;
+                std::vector<hook_type> m_recv_hooks;
+                std::vector<hook_type> m_zero_copy_recv_hooks;
+                std::map<const vector_type*, persistent_request_type> m_send_preqs;
+                std::vector<persistent_request_type> m_zero_copy_preqs;
 #endif
             };
             
@@ -208,14 +466,78 @@ namespace gridtools {
             template<typename T, typename R>
             using disable_if_buffer_info = std::enable_if_t< !is_buffer_info<T>::value, R>;
 
+#ifdef GHEX_COMM_OBJ_USE_PERSISTENT_REQUESTS
+            /** @brief forwards the send operations issued by the packer to the persistent requests bound to the
+              * send buffers
+              * @tparam Memory buffer memory type */
+            template<typename Memory>
+            struct persistent_sender
+            {
+                Memory* m_mem;
+
+                template<typename Message>
+                future_type send(const Message& msg, address_type, int)
+                {
+                    auto& req = m_mem->m_send_preqs.find(&msg)->second;
+                    req.start();
+                    return req.get_future();
+                }
+            };
+#endif
+
+            /** @brief hands the send operations issued by the packer over to a progress thread. The sends are
+              * counted as pending operations until their callback has been invoked. */
+            struct progress_thread_sender
+            {
+                struct no_future {};
+                /** @brief the sends are tracked by the pending counter: the returned futures are discarded */
+                struct discard { void push_back(no_future) {} };
+
+                progress_thread_type* m_progress;
+                std::atomic<int>* m_pending;
+
+                template<typename Message>
+                no_future send(Message& msg, address_type dst, int tag)
+                {
+                    m_pending->fetch_add(1, std::memory_order_relaxed);
+                    auto msg_ptr = &msg;
+                    auto pending = m_pending;
+                    m_progress->submit([msg_ptr, dst, tag, pending](communicator_type& comm)
+                    {
+                        comm.send(*msg_ptr, dst, tag,
+                            [pending](typename communicator_type::message_type, 
+                               typename communicator_type::rank_type,
+                               typename communicator_type::tag_type)
+                            {
+                                pending->fetch_sub(1, std::memory_order_release);
+                            });
+                    });
+                    return {};
+                }
+            };
+
         private: // members
             bool m_valid;
+            bool m_planned = false;
+            bool m_persistent = false;
             communicator_type m_comm;
             memory_type m_mem;
             std::vector<future_type> m_send_futures;
+            std::vector<future_type> m_zero_copy_futures;
 #ifdef GHEX_COMM_OBJ_USE_FAT_CALLBACKS
             std::vector<request_cb_type> m_recv_reqs;
 #endif
+#ifdef GHEX_COMM_OBJ_USE_MPI_DATATYPES
+            mpi_datatype_cache m_datatypes;
+#endif
+            // aggregate the messages for the same neighbor rank (planned exchanges only)
+            bool m_aggregate = false;
+            // layouts of the aggregated messages for each neighbor rank
+            std::map<address_type, std::vector<std::uint64_t>> m_send_layouts;
+            std::map<address_type, std::vector<std::uint64_t>> m_recv_layouts;
+            progress_thread_type* m_progress = nullptr;
+            // number of operations handed over to the progress thread which have not completed yet
+            std::unique_ptr<std::atomic<int>> m_pending;
 
         public: // ctors
             communication_object(communicator_type comm) : m_valid(false) , m_comm(comm) {}
@@ -224,6 +546,29 @@ namespace gridtools {
 
             communicator_type communicator() const { return m_comm; }
 
+        public: // progress thread
+            /** @brief hand the buffered receives and sends of subsequent exchanges over to a progress thread.
+              * Received messages are then unpacked on the progress thread as soon as they arrive, and waiting
+              * on the returned handles does not progress the communicator. Messages which bypass the
+              * intermediate buffers are still sent and received through this object's communicator.
+              * The progress thread must outlive this object or be detached before it is destroyed.
+              * @param pt progress thread */
+            void attach_progress_thread(progress_thread_type& pt)
+            {
+                if (m_valid)
+                    throw std::runtime_error("earlier exchange operation was not finished");
+                m_progress = &pt;
+                if (!m_pending) m_pending.reset(new std::atomic<int>{0});
+            }
+
+            /** @brief return to exchanges which are progressed by the waiting thread */
+            void detach_progress_thread()
+            {
+                if (m_valid)
+                    throw std::runtime_error("earlier exchange operation was not finished");
+                m_progress = nullptr;
+            }
+
         public: // exchange arbitrary field-device-pattern combinations
             /** @brief blocking variant of halo exchange
               * @tparam Archs list of device types
@@ -244,9 +589,8 @@ namespace gridtools {
             [[nodiscard]] handle_type exchange(buffer_info_type<Archs,Fields>... buffer_infos)
             {
                 exchange_impl(buffer_infos...);
-                handle_type h(m_comm, [this](){this->wait();});
-                post_recvs();
-                pack();
+                handle_type h(m_comm, this, [this](){this->wait();});
+                post();
                 return h; 
             }
 
@@ -290,9 +634,8 @@ namespace gridtools {
             handle_type exchange(std::pair<Iterators,Iterators>... iter_pairs)
             {
                 exchange_impl(iter_pairs...);
-                post_recvs();
-                pack();
-                return handle_type(m_comm, [this](){this->wait();});
+                post();
+                return handle_type(m_comm, this, [this](){this->wait();});
             }
             
             // helper function to turn iterators into pairs of iterators
@@ -419,6 +762,8 @@ namespace gridtools {
                             it->device_id(), tag_offset);
                     }
                 });
+                mark_direct();
+                if (m_aggregate) aggregate();
             }
 
             // helper function to set up communicaton buffers (compile-time case)
@@ -462,6 +807,242 @@ namespace gridtools {
                     allocate<arch_type,value_type>(mem, bi->get_pattern(), field_ptr, my_dom_id, bi->device_id(), tag_offsets[i]);
                     ++i;
                 });
+                mark_direct();
+                if (m_aggregate) aggregate();
+            }
+
+            // a message can bypass the intermediate buffer if it holds a single field's contiguous halo region,
+            // or if its halo regions can be described by an MPI datatype
+            void mark_direct()
+            {
+#ifdef GHEX_COMM_OBJ_USE_MPI_DATATYPES
+                // the previous exchange is finished: its combined datatypes may be evicted from the cache
+                m_datatypes.next_epoch();
+#endif
+                detail::for_each(m_mem, [this](auto& m)
+                {
+                    for (auto& p0 : m.send_memory)
+                        for (auto& p1 : p0.second)
+                            mark_direct(p1.second);
+                    for (auto& p0 : m.recv_memory)
+                        for (auto& p1 : p0.second)
+                            mark_direct(p1.second);
+                });
+            }
+
+            template<typename Buffer>
+            void mark_direct(Buffer& b)
+            {
+                b.zero_copy_ptr = zero_copy_ptr(b);
+#ifdef GHEX_COMM_OBJ_USE_MPI_DATATYPES
+                reset_datatype(b);
+                if (!b.zero_copy_ptr && detail::supports_mpi_datatypes<communicator_type>::value)
+                    make_datatype(b);
+#endif
+            }
+
+            // coalesce the (cpu) messages for the same remote address into one message per exchange.
+            // Both sides must group the same messages, which is checked when a plan is built (see check_aggregation).
+            void aggregate()
+            {
+                m_send_layouts.clear();
+                m_recv_layouts.clear();
+                auto& m = std::get<buffer_memory<cpu>>(m_mem);
+                for (auto& p0 : m.send_memory)
+                    aggregate(p0.second, m_send_layouts);
+                for (auto& p0 : m.recv_memory)
+                    aggregate(p0.second, m_recv_layouts);
+            }
+
+            // The message of the first buffer in a group carries the halos of all buffers in the group, each
+            // section starting at a multiple of 64 bytes. The halos keep their layout, so that the field infos of
+            // the buffers can be merged (with shifted offsets) and unpacking demultiplexes the message. The layout
+            // of the message [n, tag_0, size_0, ..., tag_n-1, size_n-1] is appended to the layouts of its address.
+            template<typename Map>
+            void aggregate(Map& map, std::map<address_type, std::vector<std::uint64_t>>& layouts)
+            {
+                using buffer_type     = typename Map::mapped_type;
+                using field_info_type = typename buffer_type::field_info_type;
+                using part_type       = std::pair<const domain_id_pair*, buffer_type*>;
+                static constexpr std::size_t alignment = 64u;
+                const auto align = [](std::size_t n) { return ((n+alignment-1)/alignment)*alignment; };
+
+                std::map<address_type, std::vector<part_type>> groups;
+                for (auto& p : map)
+                    if (p.second.size > 0u)
+                        groups[p.second.address].push_back(part_type{&p.first, &p.second});
+                for (auto& g : groups)
+                {
+                    auto& parts = g.second;
+                    if (parts.size() < 2u) continue;
+                    // same order on both sides: by id of the sending domain, then by id of the receiving domain
+                    // (the receiving domain is the first id of a pair for both send and receive buffers)
+                    std::sort(parts.begin(), parts.end(), [](const part_type& a, const part_type& b)
+                    {
+                        return domain_id_pair{a.first->second_id, a.first->first_id} <
+                            domain_id_pair{b.first->second_id, b.first->first_id};
+                    });
+                    auto& layout = layouts[g.first];
+                    layout.push_back(parts.size());
+                    auto& b0 = *parts[0].second;
+                    std::vector<field_info_type> field_infos;
+                    std::size_t size = 0u;
+                    for (const auto& p : parts)
+                    {
+                        auto& b = *p.second;
+                        layout.push_back(static_cast<std::uint64_t>(b.tag));
+                        layout.push_back(b.size);
+                        for (const auto& fi : b.field_infos)
+                        {
+                            field_infos.push_back(fi);
+                            field_infos.back().offset += size;
+                        }
+                        size = align(size + b.size);
+                        // messages which bypass the buffer are not aggregated
+                        b.zero_copy_ptr = nullptr;
+#ifdef GHEX_COMM_OBJ_USE_MPI_DATATYPES
+                        reset_datatype(b);
+#endif
+                        b0.parts.push_back(&b);
+                        if (&b != &b0)
+                        {
+                            b.aggregate = &b0;
+                            b.size = 0u;
+                        }
+                    }
+                    b0.field_infos = std::move(field_infos);
+                    b0.size = size;
+                }
+            }
+
+            // Exchange the layouts of the aggregated messages with the neighbor ranks and compare them: the messages
+            // sent to a rank must be grouped the same way as the messages that rank receives, and vice versa.
+            // Collective over the setup communicator, throws on all ranks if the layouts of any pair of ranks
+            // differ (e.g. if the halos between two ranks are split across several plans on one of the ranks).
+            template<typename SetupCommunicator>
+            void check_aggregation(const SetupCommunicator& setup_comm)
+            {
+                using layout_type = std::vector<std::uint64_t>;
+                std::map<int, layout_type> messages;
+                detail::for_each(m_mem, [&messages](auto& m)
+                {
+                    for (auto& p0 : m.send_memory)
+                        for (auto& p1 : p0.second)
+                            if (p1.second.has_halos()) messages[p1.second.address];
+                    for (auto& p0 : m.recv_memory)
+                        for (auto& p1 : p0.second)
+                            if (p1.second.has_halos()) messages[p1.second.address];
+                });
+                // message to a neighbor: [size of send layout, send layout..., receive layout...]
+                const auto get_layout = [](const std::map<address_type, layout_type>& layouts, int rank)
+                {
+                    auto it = layouts.find(rank);
+                    return it == layouts.end() ? layout_type{} : it->second;
+                };
+                for (auto& msg : messages)
+                {
+                    const auto send_layout = get_layout(m_send_layouts, msg.first);
+                    const auto recv_layout = get_layout(m_recv_layouts, msg.first);
+                    msg.second.push_back(send_layout.size());
+                    msg.second.insert(msg.second.end(), send_layout.begin(), send_layout.end());
+                    msg.second.insert(msg.second.end(), recv_layout.begin(), recv_layout.end());
+                }
+                std::map<int, layout_type> received;
+                for (auto& msg : setup_comm.sparse_exchange(messages, aggregation_check_tag))
+                    received[msg.first] = std::move(msg.second);
+                int mismatch = 0;
+                const auto check = [this, &get_layout, &mismatch](int rank, const layout_type& msg)
+                {
+                    const std::size_t n = msg.empty() ? 0u : msg[0];
+                    const layout_type remote_send(msg.begin() + (msg.empty() ? 0 : 1), msg.begin() + (msg.empty() ? 0 : 1+n));
+                    const layout_type remote_recv(msg.begin() + (msg.empty() ? 0 : 1+n), msg.end());
+                    if (remote_send != get_layout(m_recv_layouts, rank) || remote_recv != get_layout(m_send_layouts, rank))
+                        mismatch = 1;
+                };
+                for (const auto& msg : messages)
+                    check(msg.first, received[msg.first]);
+                for (const auto& msg : received)
+                    if (messages.find(msg.first) == messages.end()) check(msg.first, msg.second);
+                // collective: all ranks throw, and no rank is still receiving when the next plan is built
+                for (auto x : setup_comm.all_gather(mismatch).get())
+                    if (x) throw std::runtime_error("aggregated messages do not match between neighbor ranks: all "
+                        "halos exchanged between two ranks must be passed to one exchange plan on both ranks");
+            }
+
+            template<typename Buffer>
+            static unsigned char* zero_copy_ptr(const Buffer& b)
+            {
+                return (b.size > 0u && b.field_infos.size() == 1u) ? b.field_infos[0].zero_copy_ptr : nullptr;
+            }
+
+            template<typename Buffer>
+            static tl::cb::ref_message<unsigned char> zero_copy_message(const Buffer& b)
+            {
+                return {b.zero_copy_ptr, b.size};
+            }
+
+#ifdef GHEX_COMM_OBJ_USE_MPI_DATATYPES
+            // the datatypes are taken from the cache: a single field's datatype, or a struct type combining the
+            // datatypes of several fields relative to the first field's data pointer
+            template<typename Buffer>
+            void make_datatype(Buffer& b)
+            {
+                if (b.size == 0u || b.field_infos.empty()) return;
+                std::size_t offset = 0u;
+                for (const auto& fi : b.field_infos)
+                {
+                    // the message must not contain the alignment padding of the serialized buffer
+                    if (fi.datatype.type == MPI_DATATYPE_NULL || fi.offset != offset) return;
+                    int size;
+                    GHEX_CHECK_MPI_RESULT(MPI_Type_size(fi.datatype.type, &size));
+                    offset += size;
+                }
+                if (b.field_infos.size() == 1u)
+                {
+                    b.datatype = b.field_infos[0].datatype;
+                    return;
+                }
+                std::vector<std::pair<MPI_Datatype, void*>> regions;
+                regions.reserve(b.field_infos.size());
+                for (const auto& fi : b.field_infos)
+                    regions.push_back(std::make_pair(fi.datatype.type, fi.datatype.base));
+                b.datatype = detail::mpi_datatype_region{m_datatypes.get(regions), regions[0].second};
+            }
+
+            template<typename Buffer>
+            static void reset_datatype(Buffer& b)
+            {
+                b.datatype = detail::mpi_datatype_region{};
+            }
+
+            void reset_datatypes()
+            {
+                detail::for_each(m_mem, [](auto& m)
+                {
+                    for (auto& p0 : m.send_memory)
+                        for (auto& p1 : p0.second)
+                            reset_datatype(p1.second);
+                    for (auto& p0 : m.recv_memory)
+                        for (auto& p1 : p0.second)
+                            reset_datatype(p1.second);
+                });
+            }
+#endif
+
+            // post receives and sends, either directly or through the progress thread
+            void post()
+            {
+                reset_ready();
+                if (m_progress)
+                {
+                    post_recvs_progress_thread();
+                    pack_progress_thread();
+                }
+                else
+                {
+                    post_recvs();
+                    pack();
+                }
             }
 
             void post_recvs()
@@ -474,7 +1055,21 @@ namespace gridtools {
                     {
                         for (auto& p1: p0.second)
                         {
-                            if (p1.second.size > 0u)
+                            if (p1.second.zero_copy_ptr)
+                            {
+                                auto msg = zero_copy_message(p1.second);
+                                m.m_zero_copy_recvs.emplace_back(&p1.second, m_zero_copy_futures.size());
+                                m_zero_copy_futures.push_back(m_comm.recv(msg, p1.second.address, p1.second.tag));
+                            }
+#ifdef GHEX_COMM_OBJ_USE_MPI_DATATYPES
+                            else if (p1.second.datatype.type != MPI_DATATYPE_NULL)
+                            {
+                                m.m_zero_copy_recvs.emplace_back(&p1.second, m_zero_copy_futures.size());
+                                m_zero_copy_futures.push_back(detail::recv_typed(m_comm, p1.second.datatype,
+                                    p1.second.address, p1.second.tag, 0));
+                            }
+#endif
+                            else if (p1.second.size > 0u)
                             {
                                 p1.second.buffer.resize(p1.second.size);
                                 auto ptr = &p1.second;
@@ -486,6 +1081,7 @@ namespace gridtools {
                                        typename communicator_type::tag_type)
                                     {
                                         packer<arch_type>::unpack(*ptr, m.data());
+                                        mark_ready(*ptr);
                                     }));
                             }
                         }
@@ -498,7 +1094,21 @@ namespace gridtools {
                     {
                         for (auto& p1: p0.second)
                         {
-                            if (p1.second.size > 0u)
+                            if (p1.second.zero_copy_ptr)
+                            {
+                                auto msg = zero_copy_message(p1.second);
+                                m.m_zero_copy_recvs.emplace_back(&p1.second, m_zero_copy_futures.size());
+                                m_zero_copy_futures.push_back(m_comm.recv(msg, p1.second.address, p1.second.tag));
+                            }
+#ifdef GHEX_COMM_OBJ_USE_MPI_DATATYPES
+                            else if (p1.second.datatype.type != MPI_DATATYPE_NULL)
+                            {
+                                m.m_zero_copy_recvs.emplace_back(&p1.second, m_zero_copy_futures.size());
+                                m_zero_copy_futures.push_back(detail::recv_typed(m_comm, p1.second.datatype,
+                                    p1.second.address, p1.second.tag, 0));
+                            }
+#endif
+                            else if (p1.second.size > 0u)
                             {
                                 p1.second.buffer.resize(p1.second.size);
                                 m.m_recv_futures.emplace_back(
@@ -517,26 +1127,111 @@ namespace gridtools {
                 detail::for_each(m_mem, [this](auto& m)
                 {
                     using arch_type = typename std::remove_reference_t<decltype(m)>::arch_type;
+                    send_zero_copy(m);
                     packer<arch_type>::pack(m,m_send_futures,m_comm);
                 });
             }
 
+            // receives into the intermediate buffers are posted by the progress thread, which also unpacks them
+            void post_recvs_progress_thread()
+            {
+                detail::for_each(m_mem, [this](auto& m)
+                {
+                    using arch_type = typename std::remove_reference_t<decltype(m)>::arch_type;
+                    for (auto& p0 : m.recv_memory)
+                    {
+                        for (auto& p1: p0.second)
+                        {
+                            if (p1.second.zero_copy_ptr)
+                            {
+                                auto msg = zero_copy_message(p1.second);
+                                m.m_zero_copy_recvs.emplace_back(&p1.second, m_zero_copy_futures.size());
+                                m_zero_copy_futures.push_back(m_comm.recv(msg, p1.second.address, p1.second.tag));
+                            }
+#ifdef GHEX_COMM_OBJ_USE_MPI_DATATYPES
+                            else if (p1.second.datatype.type != MPI_DATATYPE_NULL)
+                            {
+                                m.m_zero_copy_recvs.emplace_back(&p1.second, m_zero_copy_futures.size());
+                                m_zero_copy_futures.push_back(detail::recv_typed(m_comm, p1.second.datatype,
+                                    p1.second.address, p1.second.tag, 0));
+                            }
+#endif
+                            else if (p1.second.size > 0u)
+                            {
+                                p1.second.buffer.resize(p1.second.size);
+                                auto ptr = &p1.second;
+                                auto pending = m_pending.get();
+                                pending->fetch_add(1, std::memory_order_relaxed);
+                                m_progress->submit([ptr, pending](communicator_type& comm)
+                                {
+                                    comm.recv(ptr->buffer, ptr->address, ptr->tag,
+                                        [ptr, pending](typename communicator_type::message_type m, 
+                                           typename communicator_type::rank_type,
+                                           typename communicator_type::tag_type)
+                                        {
+                                            packer<arch_type>::unpack(*ptr, m.data());
+                                            mark_ready(*ptr);
+                                            pending->fetch_sub(1, std::memory_order_release);
+                                        });
+                                });
+                            }
+                        }
+                    }
+                });
+            }
+
+            // pack on the calling thread and hand the sends over to the progress thread
+            void pack_progress_thread()
+            {
+                detail::for_each(m_mem, [this](auto& m)
+                {
+                    using arch_type = typename std::remove_reference_t<decltype(m)>::arch_type;
+                    send_zero_copy(m);
+                    progress_thread_sender sender{m_progress, m_pending.get()};
+                    typename progress_thread_sender::discard futures;
+                    packer<arch_type>::pack(m,futures,sender);
+                });
+            }
+
+            // send messages which bypass the intermediate buffer (the packer skips them)
+            template<typename Memory>
+            void send_zero_copy(Memory& m)
+            {
+                for (auto& p0 : m.send_memory)
+                    for (auto& p1: p0.second)
+                        if (p1.second.zero_copy_ptr)
+                            m_zero_copy_futures.push_back(
+                                m_comm.send(zero_copy_message(p1.second), p1.second.address, p1.second.tag));
+#ifdef GHEX_COMM_OBJ_USE_MPI_DATATYPES
+                        else if (p1.second.datatype.type != MPI_DATATYPE_NULL)
+                            m_zero_copy_futures.push_back(detail::send_typed(m_comm, p1.second.datatype,
+                                p1.second.address, p1.second.tag, 0));
+#endif
+            }
+
         private: // wait functions
             void wait()
             {
                 if (!m_valid) return;
                 // wait for data to arrive (unpack callback will be invoked)
+                if (m_progress)
+                    wait_progress_thread();
+                else
+                {
 #ifdef GHEX_COMM_OBJ_USE_FAT_CALLBACKS
-                await_requests(m_recv_reqs, [comm = m_comm]() mutable {comm.progress();});
+                    await_requests(m_recv_reqs, [comm = m_comm]() mutable {comm.progress();});
 #else
-                detail::for_each(m_mem, [this](auto& m)
-                {
-                    using arch_type = typename std::remove_reference_t<decltype(m)>::arch_type;
-                    packer<arch_type>::unpack(m);
-                });
+                    detail::for_each(m_mem, [this](auto& m)
+                    {
+                        using arch_type = typename std::remove_reference_t<decltype(m)>::arch_type;
+                        packer<arch_type>::unpack(m);
+                    });
 #endif
+                }
                 // wait for data to be sent
                 await_requests(m_send_futures);
+                // wait for messages sent/received directly from/to the fields
+                await_requests(m_zero_copy_futures);
 #ifdef __CUDACC__
                 // wait for the unpack kernels to finish
                 auto& m = std::get<buffer_memory<gpu>>(m_mem);
@@ -548,6 +1243,149 @@ namespace gridtools {
                 clear();
             }
 
+        private: // split-phase completion
+            void reset_ready()
+            {
+                detail::for_each(m_mem, [](auto& m)
+                {
+                    for (auto& p0 : m.recv_memory)
+                        for (auto& p1 : p0.second)
+                        {
+                            p1.second.ready.store(false);
+                            p1.second.reported = false;
+                        }
+                });
+            }
+
+            // on gpus, the halos are valid once the unpack kernels have finished
+            template<typename Buffer>
+            static void mark_ready(Buffer& b)
+            {
+#ifdef __CUDACC__
+                b.m_cuda_stream.sync();
+#endif
+                for (auto part : b.parts) part->ready.store(true);
+                b.ready.store(true);
+            }
+
+            // progress the communication and unpack the messages which have arrived
+            void progress_exchange()
+            {
+                if (!m_valid) return;
+                if (m_progress)
+                    m_progress->rethrow_if_failed();
+                else
+                {
+#ifdef GHEX_COMM_OBJ_USE_FAT_CALLBACKS
+                    m_comm.progress();
+#else
+                    detail::for_each(m_mem, [](auto& m)
+                    {
+                        using arch_type = typename std::remove_reference_t<decltype(m)>::arch_type;
+                        auto& futures = m.m_recv_futures;
+                        for (std::size_t i=0; i<futures.size();)
+                        {
+                            if (futures[i].test())
+                            {
+                                auto hook = futures[i].get();
+                                packer<arch_type>::unpack(*hook, hook->buffer.data());
+                                mark_ready(*hook);
+                                if (i+1 < futures.size()) futures[i] = std::move(futures.back());
+                                futures.pop_back();
+                            }
+                            else ++i;
+                        }
+                    });
+#endif
+                }
+                // messages received directly into the fields
+                detail::for_each(m_mem, [this](auto& m)
+                {
+                    for (auto& r : m.m_zero_copy_recvs)
+                        if (!r.first->ready.load() && m_zero_copy_futures[r.second].test())
+                            mark_ready(*r.first);
+                });
+            }
+
+            bool test()
+            {
+                if (!m_valid) return true;
+                progress_exchange();
+                bool done = true;
+                if (m_progress)
+                    done = m_pending->load(std::memory_order_acquire) == 0;
+                else
+                {
+#ifdef GHEX_COMM_OBJ_USE_FAT_CALLBACKS
+                    for (auto& r : m_recv_reqs) done = done && r.test();
+#else
+                    detail::for_each(m_mem, [&done](auto& m) { done = done && m.m_recv_futures.empty(); });
+#endif
+                }
+                for (auto& f : m_send_futures) done = done && f.test();
+                for (auto& f : m_zero_copy_futures) done = done && f.test();
+                // all operations have completed: wait only finalizes the exchange
+                if (done) wait();
+                return done;
+            }
+
+            bool is_ready(domain_id_type local_id, domain_id_type remote_id)
+            {
+                if (!m_valid) return true;
+                bool ready = true;
+                detail::for_each(m_mem, [&ready, local_id, remote_id](auto& m)
+                {
+                    for (auto& p0 : m.recv_memory)
+                    {
+                        auto it = p0.second.find(domain_id_pair{local_id, remote_id});
+                        if (it != p0.second.end() && it->second.has_halos() && !it->second.ready.load())
+                            ready = false;
+                    }
+                });
+                return ready;
+            }
+
+            using halo_region = typename handle_type::halo_region;
+
+            halo_region wait_any()
+            {
+                while (m_valid)
+                {
+                    progress_exchange();
+                    bool pending = false;
+                    halo_region r;
+                    detail::for_each(m_mem, [&pending, &r](auto& m)
+                    {
+                        if (r) return;
+                        for (auto& p0 : m.recv_memory)
+                            for (auto& p1 : p0.second)
+                            {
+                                auto& b = p1.second;
+                                if (r || !b.has_halos() || b.reported) continue;
+                                if (!b.ready.load())
+                                {
+                                    pending = true;
+                                    continue;
+                                }
+                                b.reported = true;
+                                r = halo_region{p1.first.first_id, p1.first.second_id, b.field_infos[0].index_container};
+                            }
+                    });
+                    if (r || !pending) return r;
+                }
+                return {};
+            }
+
+            // the operations handed over to the progress thread are complete once the counter drops to zero
+            void wait_progress_thread()
+            {
+                while (m_pending->load(std::memory_order_acquire) > 0)
+                {
+                    m_progress->rethrow_if_failed();
+                    std::this_thread::yield();
+                }
+            }
+
 #ifdef GHEX_COMM_OBJ_USE_U
 #if defined(__CUDACC__) && !defined(GHEX_COMM_OBJ_USE_FAT_CALLBACKS)
             template<typename FieldType>
@@ -574,21 +1412,28 @@ namespace gridtools {
             {
                 m_valid = false;
                 m_send_futures.clear();
+                m_zero_copy_futures.clear();
+                detail::for_each(m_mem, [](auto& m) { m.m_zero_copy_recvs.clear(); });
 #ifdef GHEX_COMM_OBJ_USE_FAT_CALLBACKS
                 m_recv_reqs.clear();
-                detail::for_each(m_mem, [this](auto& m)
-                {
 #else
-                detail::for_each(m_mem, [this](auto& m)
-                {
-                    m.m_recv_futures.clear();
+                detail::for_each(m_mem, [](auto& m) { m.m_recv_futures.clear(); });
+#endif
+                // planned exchanges keep their buffer layouts
+                if (m_planned) return;
+#ifdef GHEX_COMM_OBJ_USE_MPI_DATATYPES
+                reset_datatypes();
 #endif
+                detail::for_each(m_mem, [](auto& m)
+                {
                     for (auto& p0 : m.send_memory)
                         for (auto& p1 : p0.second)
                         {
                             p1.second.buffer.resize(0);
                             p1.second.size = 0;
                             p1.second.field_infos.resize(0);
+                            p1.second.aggregate = nullptr;
+                            p1.second.parts.clear();
                         }
                     for (auto& p0 : m.recv_memory)
                         for (auto& p1 : p0.second)
@@ -596,10 +1441,139 @@ namespace gridtools {
                             p1.second.buffer.resize(0);
                             p1.second.size = 0;
                             p1.second.field_infos.resize(0);
+                            p1.second.aggregate = nullptr;
+                            p1.second.parts.clear();
                         }
                 });
             }
 
+        private: // planned exchange
+            // set up communication buffers once and freeze them
+            template<typename... Args>
+            void plan(Args... args)
+            {
+                exchange_impl(args...);
+                m_planned = true;
+                m_valid = false;
+#ifdef GHEX_COMM_OBJ_USE_PERSISTENT_REQUESTS
+                init_persistent(detail::persistent_request<communicator_type>{});
+#endif
+            }
+
+            // set up communication buffers with aggregated messages once and freeze them (collective)
+            template<typename SetupCommunicator, typename... Args>
+            void plan(const aggregate_messages_t<SetupCommunicator>& agg, Args... args)
+            {
+                m_aggregate = true;
+                plan(args...);
+                check_aggregation(agg.m_setup_comm);
+            }
+
+            // exchange with frozen buffer layouts: only post receives, pack and send
+            handle_type exchange_planned()
+            {
+                if (m_valid)
+                    throw std::runtime_error("earlier exchange operation was not finished");
+                m_valid = true;
+#ifdef GHEX_COMM_OBJ_USE_PERSISTENT_REQUESTS
+                if (m_persistent && !m_progress)
+                {
+                    reset_ready();
+                    start_persistent(detail::persistent_request<communicator_type>{});
+                    return handle_type(m_comm, this, [this](){this->wait();});
+                }
+#endif
+                post();
+                return handle_type(m_comm, this, [this](){this->wait();});
+            }
+
+#ifdef GHEX_COMM_OBJ_USE_PERSISTENT_REQUESTS
+            // transport does not support persistent requests: fall back to regular send/recv
+            void init_persistent(std::false_type) {}
+            void start_persistent(std::false_type) {}
+
+            // bind persistent requests to the (fixed) buffers
+            void init_persistent(std::true_type)
+            {
+                detail::for_each(m_mem, [this](auto& m)
+                {
+                    for (auto& p0 : m.recv_memory)
+                        for (auto& p1: p0.second)
+                            if (p1.second.zero_copy_ptr)
+                            {
+                                auto msg = zero_copy_message(p1.second);
+                                m.m_zero_copy_preqs.push_back(
+                                    m_comm.recv_init(msg, p1.second.address, p1.second.tag));
+                                m.m_zero_copy_recv_hooks.push_back(&p1.second);
+                            }
+#ifdef GHEX_COMM_OBJ_USE_MPI_DATATYPES
+                            else if (p1.second.datatype.type != MPI_DATATYPE_NULL)
+                            {
+                                m.m_zero_copy_preqs.push_back(m_comm.recv_init_typed(p1.second.datatype.base,
+                                    p1.second.datatype.type, p1.second.address, p1.second.tag));
+                                m.m_zero_copy_recv_hooks.push_back(&p1.second);
+                            }
+#endif
+                            else if (p1.second.size > 0u)
+                            {
+                                p1.second.buffer.resize(p1.second.size);
+                                m.m_recv_preqs.push_back(
+                                    m_comm.recv_init(p1.second.buffer, p1.second.address, p1.second.tag));
+                                m.m_recv_hooks.push_back(&p1.second);
+                            }
+                    for (auto& p0 : m.send_memory)
+                        for (auto& p1: p0.second)
+                            if (p1.second.zero_copy_ptr)
+                            {
+                                m.m_zero_copy_preqs.push_back(
+                                    m_comm.send_init(zero_copy_message(p1.second), p1.second.address, p1.second.tag));
+                            }
+#ifdef GHEX_COMM_OBJ_USE_MPI_DATATYPES
+                            else if (p1.second.datatype.type != MPI_DATATYPE_NULL)
+                            {
+                                m.m_zero_copy_preqs.push_back(m_comm.send_init_typed(p1.second.datatype.base,
+                                    p1.second.datatype.type, p1.second.address, p1.second.tag));
+                            }
+#endif
+                            else if (p1.second.size > 0u)
+                            {
+                                p1.second.buffer.resize(p1.second.size);
+                                m.m_send_preqs.insert(std::make_pair(&p1.second.buffer,
+                                    m_comm.send_init(p1.second.buffer, p1.second.address, p1.second.tag)));
+                            }
+                });
+                m_persistent = true;
+            }
+
+            // start all receives at once and pack/start the sends
+            void start_persistent(std::true_type)
+            {
+                detail::for_each(m_mem, [this](auto& m)
+                {
+                    using memory_type = std::remove_reference_t<decltype(m)>;
+                    using persistent_request_type = typename memory_type::persistent_request_type;
+                    persistent_request_type::start_all(m.m_recv_preqs.begin(), m.m_recv_preqs.end());
+                    persistent_request_type::start_all(m.m_zero_copy_preqs.begin(), m.m_zero_copy_preqs.end());
+                    // the receive requests precede the send requests
+                    for (std::size_t i=0; i<m.m_zero_copy_recv_hooks.size(); ++i)
+                        m.m_zero_copy_recvs.emplace_back(m.m_zero_copy_recv_hooks[i], m_zero_copy_futures.size()+i);
+                    for (const auto& req : m.m_zero_copy_preqs)
+                        m_zero_copy_futures.push_back(req.get_future());
+                    for (std::size_t i=0; i<m.m_recv_preqs.size(); ++i)
+                        m.m_recv_futures.emplace_back(
+                            typename memory_type::hook_future_type{
+                                typename memory_type::hook_type{m.m_recv_hooks[i]},
+                                m.m_recv_preqs[i].get_future().m_handle});
+                });
+                detail::for_each(m_mem, [this](auto& m)
+                {
+                    using arch_type = typename std::remove_reference_t<decltype(m)>::arch_type;
+                    persistent_sender<std::remove_reference_t<decltype(m)>> sender{&m};
+                    packer<arch_type>::pack(m,m_send_futures,sender);
+                });
+            }
+#endif
+
         private: // allocation member functions
             template<typename Arch, typename T, typename Memory, typename Field, typename O>
             void allocate(Memory& mem, const pattern_type& pattern, Field* field_ptr, domain_id_type dom_id, typename arch_traits<Arch>::device_id_type device_id, O tag_offset)
@@ -607,7 +1581,7 @@ namespace gridtools {
                 auto& pool = mem->m_pools[device_id];
                 if (!pool)
                 {
-                    pool.reset( new typename arch_traits<Arch>::pool_type{ typename arch_traits<Arch>::basic_allocator_type{} } );
+                    pool.reset( new typename arch_traits<Arch>::pool_type{ arch_traits<Arch>::make_basic_allocator(m_comm) } );
                 }
                 allocate<Arch,T,typename buffer_memory<Arch>::recv_buffer_type>( 
                     mem->recv_memory[device_id], 
@@ -673,7 +1647,15 @@ namespace gridtools {
                                 arch_traits<Arch>::make_message(pool, device_id),
                                 0,
                                 std::vector<typename BufferType::field_info_type>(),
-                                cuda::stream()
+                                cuda::stream(),
+                                nullptr,
+                                detail::ready_flag{},
+                                false,
+                                nullptr,
+                                std::vector<BufferType*>()
+#ifdef GHEX_COMM_OBJ_USE_MPI_DATATYPES
+                                , detail::mpi_datatype_region{}
+#endif
                             })).first;
                     }
                     else if (it->second.size==0)
@@ -685,7 +1667,12 @@ namespace gridtools {
                     const auto prev_size = it->second.size;
                     const auto padding = ((prev_size+alignof(ValueType)-1)/alignof(ValueType))*alignof(ValueType) - prev_size;
                     it->second.field_infos.push_back(
-                        typename BufferType::field_info_type{std::forward<Function>(func), &p_id_c.second, prev_size + padding, field_ptr});
+                        typename BufferType::field_info_type{std::forward<Function>(func), &p_id_c.second, prev_size + padding, field_ptr,
+                            detail::zero_copy_ptr<Arch>(field_ptr, p_id_c.second)
+#ifdef GHEX_COMM_OBJ_USE_MPI_DATATYPES
+                            , detail::mpi_datatype<Arch>(m_datatypes, field_ptr, p_id_c.second, 0)
+#endif
+                            });
                     it->second.size += padding + static_cast<std::size_t>(num_elements)*sizeof(ValueType);
                 }
             }
@@ -703,6 +1690,126 @@ namespace gridtools {
             return communication_object<communicator_type,grid_type,domain_id_type>(comm);
         }
 
+        /** @brief a pre-planned halo exchange for a fixed set of fields. The buffer_info objects are bound once
+          * at construction: buffer layouts, offsets, tags and pack/unpack callbacks are computed a single time
+          * and reused by every subsequent exchange, which only posts receives, packs and sends.
+          * Attention: holds references to the bound fields and patterns.
+          * @tparam Communicator communicator type
+          * @tparam GridType grid tag type
+          * @tparam DomainIdType domain id type*/
+        template<typename Communicator, typename GridType, typename DomainIdType>
+        class exchange_plan
+        {
+        public: // member types
+            using communication_object_type = communication_object<Communicator,GridType,DomainIdType>;
+            using handle_type               = typename communication_object_type::handle_type;
+            using communicator_type         = Communicator;
+
+            template<typename D, typename F>
+            using buffer_info_type          = typename communication_object_type::template buffer_info_type<D,F>;
+
+        private: // members
+            communication_object_type m_co;
+
+        public: // ctors
+            /** @brief plan an exchange of arbitrary field-device-pattern combinations
+              * @tparam Archs list of device types
+              * @tparam Fields list of field types
+              * @param comm communicator
+              * @param buffer_infos buffer_info objects created by binding a field descriptor to a pattern */
+            template<typename... Archs, typename... Fields>
+            exchange_plan(communicator_type comm, buffer_info_type<Archs,Fields>... buffer_infos)
+            : m_co(comm)
+            {
+                m_co.plan(buffer_infos...);
+            }
+
+            /** @brief plan an exchange of a range of buffer_info objects
+              * @tparam Iterator Iterator type to range of buffer_info objects
+              * @param comm communicator
+              * @param first points to the begin of the range
+              * @param last points to the end of the range */
+            template<typename Iterator, typename = std::enable_if_t<!is_buffer_info<Iterator>::value>>
+            exchange_plan(communicator_type comm, Iterator first, Iterator last)
+            : m_co(comm)
+            {
+                m_co.plan(std::make_pair(first, last));
+            }
+
+            /** @brief plan an exchange of arbitrary field-device-pattern combinations which aggregates the (cpu)
+              * messages for the same neighbor rank into a single message. The construction is collective over the
+              * setup communicator and throws on all ranks if the messages between two ranks are grouped differently
+              * on the two sides: all halos exchanged between two ranks must be bound to one aggregating plan on
+              * both ranks, i.e. the halos cannot be split across several plans, communication objects or threads.
+              * Messages which bypass the intermediate buffers are not aggregated.
+              * @tparam SetupCommunicator setup communicator type
+              * @tparam Archs list of device types
+              * @tparam Fields list of field types
+              * @param comm communicator
+              * @param agg aggregation request obtained from aggregate_messages(context)
+              * @param buffer_infos buffer_info objects created by binding a field descriptor to a pattern */
+            template<typename SetupCommunicator, typename... Archs, typename... Fields>
+            exchange_plan(communicator_type comm, const aggregate_messages_t<SetupCommunicator>& agg,
+                buffer_info_type<Archs,Fields>... buffer_infos)
+            : m_co(comm)
+            {
+                m_co.plan(agg, buffer_infos...);
+            }
+
+            /** @brief plan an exchange of a range of buffer_info objects which aggregates the messages for the same
+              * neighbor rank (see above)
+              * @tparam SetupCommunicator setup communicator type
+              * @tparam Iterator Iterator type to range of buffer_info objects
+              * @param comm communicator
+              * @param agg aggregation request obtained from aggregate_messages(context)
+              * @param first points to the begin of the range
+              * @param last points to the end of the range */
+            template<typename SetupCommunicator, typename Iterator,
+                typename = std::enable_if_t<!is_buffer_info<Iterator>::value>>
+            exchange_plan(communicator_type comm, const aggregate_messages_t<SetupCommunicator>& agg,
+                Iterator first, Iterator last)
+            : m_co(comm)
+            {
+                m_co.plan(agg, std::make_pair(first, last));
+            }
+
+            exchange_plan(const exchange_plan&) = delete;
+            exchange_plan(exchange_plan&&) = default;
+
+            communicator_type communicator() const { return m_co.communicator(); }
+
+        public: // member functions
+            /** @brief hand the exchanges over to a progress thread (see communication_object) */
+            void attach_progress_thread(typename communication_object_type::progress_thread_type& pt)
+            {
+                m_co.attach_progress_thread(pt);
+            }
+
+            void detach_progress_thread() { m_co.detach_progress_thread(); }
+
+            /** @brief non-blocking exchange of halo data using the planned buffers
+              * @return handle to await communication */
+            [[nodiscard]] handle_type exchange() { return m_co.exchange_planned(); }
+
+            /** @brief blocking exchange of halo data using the planned buffers */
+            void bexchange() { exchange().wait(); }
+        };
+
+        /** @brief creates an exchange plan based on the pattern type
+          * @tparam PatternContainer pattern type
+          * @tparam Args buffer_info types or iterator types
+          * @param comm communicator
+          * @param args buffer_info objects or a pair of iterators to a range of buffer_info objects
+          * @return exchange plan */
+        template<typename PatternContainer, typename... Args>
+        auto make_exchange_plan(typename PatternContainer::value_type::communicator_type comm, Args&&... args)
+        {
+            using communicator_type = typename PatternContainer::value_type::communicator_type;
+            using grid_type         = typename PatternContainer::value_type::grid_type;
+            using domain_id_type    = typename PatternContainer::value_type::domain_id_type;
+            return exchange_plan<communicator_type,grid_type,domain_id_type>(comm, std::forward<Args>(args)...);
+        }
+
     } // namespace ghex
         
 } // namespace gridtools
@@ -26,6 +26,7 @@ namespace gridtools {
         template<typename Arch>
         struct packer
         {
+#ifndef GHEX_PACKER_USE_OPENMP
             template<typename Map, typename Futures, typename Communicator>
             static void pack(Map& map, Futures& send_futures,Communicator& comm)
             {
@@ -33,7 +34,7 @@ namespace gridtools {
                 {
                     for (auto& p1: p0.second)
                     {
-                        if (p1.second.size > 0u)
+                        if (p1.second.size > 0u && !p1.second.bypasses_packer())
                         {
                             p1.second.buffer.resize(p1.second.size);
                             for (const auto& fb : p1.second.field_infos)
@@ -43,6 +44,60 @@ namespace gridtools {
                     }
                 }
             }
+#else
+            /** @brief multi-threaded pack: the (buffer, field) pairs are distributed over the OpenMP threads and
+              * each buffer is sent as soon as its last field has been packed. Sends are posted from within a
+              * critical section, hence the transport needs to support calls from different threads (for MPI at
+              * least MPI_THREAD_SERIALIZED is required). */
+            template<typename Map, typename Futures, typename Communicator>
+            static void pack(Map& map, Futures& send_futures,Communicator& comm)
+            {
+                using send_buffer_type = typename Map::send_buffer_type;
+                using field_info_type  = typename send_buffer_type::field_info_type;
+                struct work_item
+                {
+                    send_buffer_type* buffer;
+                    const field_info_type* field_info;
+                    std::size_t buffer_index;
+                };
+                static thread_local std::vector<work_item> items;
+                static thread_local std::vector<int> remaining;
+                items.resize(0);
+                remaining.resize(0);
+                for (auto& p0 : map.send_memory)
+                {
+                    for (auto& p1: p0.second)
+                    {
+                        if (p1.second.size > 0u && !p1.second.bypasses_packer())
+                        {
+                            p1.second.buffer.resize(p1.second.size);
+                            for (const auto& fb : p1.second.field_infos)
+                                items.push_back(work_item{&p1.second, &fb, remaining.size()});
+                            remaining.push_back(p1.second.field_infos.size());
+                        }
+                    }
+                }
+                const int num_items = items.size();
+                auto& items_ref = items;
+                auto& remaining_ref = remaining;
+#pragma omp parallel for schedule(dynamic)
+                for (int i=0; i<num_items; ++i)
+                {
+                    const auto& item = items_ref[i];
+                    auto b = item.buffer;
+                    item.field_info->call_back(b->buffer.data() + item.field_info->offset,
+                        *item.field_info->index_container, nullptr);
+                    int r;
+#pragma omp atomic capture seq_cst
+                    r = --remaining_ref[item.buffer_index];
+                    if (r == 0)
+                    {
+#pragma omp critical(ghex_packer_send)
+                        send_futures.push_back(comm.send(b->buffer, b->address, b->tag));
+                    }
+                }
+            }
+#endif
             
             template<typename Buffer>
             static void unpack(Buffer& buffer, unsigned char* data)
@@ -51,6 +106,7 @@ namespace gridtools {
                     fb.call_back(data + fb.offset, *fb.index_container, nullptr);
             }
 
+#ifndef GHEX_PACKER_USE_OPENMP
             template<typename BufferMem>
             static void unpack(BufferMem& m)
             {
@@ -62,6 +118,27 @@ namespace gridtools {
                             fb.call_back(hook->buffer.data() + fb.offset, *fb.index_container, nullptr);
                     });
             }
+#else
+            /** @brief multi-threaded unpack: one thread waits for the messages to arrive while the unpacking of
+              * already arrived messages is carried out by the other threads (one task per field). */
+            template<typename BufferMem>
+            static void unpack(BufferMem& m)
+            {
+#pragma omp parallel
+#pragma omp single
+                await_futures(
+                    m.m_recv_futures,
+                    [](typename BufferMem::hook_type hook)
+                    {
+                        for (const auto& fb :  hook->field_infos)
+                        {
+                            const auto fb_ptr = &fb;
+#pragma omp task firstprivate(hook, fb_ptr)
+                            fb_ptr->call_back(hook->buffer.data() + fb_ptr->offset, *fb_ptr->index_container, nullptr);
+                        }
+                    });
+            }
+#endif
         };
 
         
@@ -15,14 +15,32 @@
 #include "./thread/access_guard.hpp"
 #if defined(GHEX_USE_XPMEM_ACCESS_GUARD) && defined(GHEX_USE_XPMEM)
 #include "./xpmem/access_guard.hpp"
+#elif defined(GHEX_USE_ATOMIC_SHMEM_ACCESS_GUARD)
+#include "./shmem/atomic_access_guard.hpp"
 #else
 #include "./shmem/access_guard.hpp"
 #endif
+#ifdef GHEX_USE_MPI_RMA
+#include "./mpi/access_guard.hpp"
+#endif
 
 namespace gridtools {
 namespace ghex {
 namespace rma {
 
+// access guards used for process locality: xpmem based, lock-free atomics in shared memory, or
+// process-shared mutex and condition variable in shared memory (default)
+#if defined(GHEX_USE_XPMEM_ACCESS_GUARD) && defined(GHEX_USE_XPMEM)
+using process_local_access_guard = xpmem::local_access_guard;
+using process_remote_access_guard = xpmem::remote_access_guard;
+#elif defined(GHEX_USE_ATOMIC_SHMEM_ACCESS_GUARD)
+using process_local_access_guard = shmem::atomic_local_access_guard;
+using process_remote_access_guard = shmem::atomic_remote_access_guard;
+#else
+using process_local_access_guard = shmem::local_access_guard;
+using process_remote_access_guard = shmem::remote_access_guard;
+#endif
+
 /** @brief General local access guard wich synchronizes between the two participants in a RMA put
   * operation. This object is created at the site of the owner. All essential information can be
   * extracted through get_info(). The returned info object is POD and can be sent through the network
@@ -32,23 +50,28 @@ namespace rma {
   * read/write access to a resource. The local access guard below can
   * - start a target epoch: busy wait until the resource has been freed by the remote counterpart
   * - end a target epoch: signal the end of read/write access to the remote counterpart
+  *
+  * If GHEX_USE_MPI_RMA is defined, remote locality is supported as well: the resource is then a
+  * staging buffer in an MPI window, which the remote counterpart fills with one-sided puts.
   * */
 struct local_access_guard
 {
     locality m_locality;
     thread::local_access_guard m_thread_guard;
-#if defined(GHEX_USE_XPMEM_ACCESS_GUARD) && defined(GHEX_USE_XPMEM)
-    using process_guard_type = xpmem::local_access_guard;
-#else
-    using process_guard_type = shmem::local_access_guard;
+    using process_guard_type = process_local_access_guard;
+    process_guard_type m_process_guard;
+#ifdef GHEX_USE_MPI_RMA
+    mpi::local_access_guard m_mpi_guard;
 #endif
-     process_guard_type m_process_guard;
 
     struct info
     {
         locality m_locality;
         thread::local_access_guard::info m_thread_guard_info;
         typename process_guard_type::info m_process_guard_info;
+#ifdef GHEX_USE_MPI_RMA
+        mpi::local_access_guard::info m_mpi_guard_info;
+#endif
     };
 
     local_access_guard(locality loc, access_mode m = access_mode::local)
@@ -57,6 +80,21 @@ struct local_access_guard
     , m_process_guard(m)
     {}
 
+#ifdef GHEX_USE_MPI_RMA
+    /** @brief construct a guard which, for remote locality, guards a staging buffer in a window
+      * @param loc locality of the remote counterpart
+      * @param m initial access mode
+      * @param w window of the communicator (may be nullptr if loc is not remote)
+      * @param staging_size size of the staging buffer in bytes */
+    local_access_guard(locality loc, access_mode m, mpi::window* w, std::size_t staging_size)
+    : m_locality{loc}
+    , m_thread_guard(m)
+    , m_process_guard(m)
+    , m_mpi_guard{(loc == locality::remote && w) ? mpi::local_access_guard(w, m, staging_size)
+                                                 : mpi::local_access_guard()}
+    {}
+#endif
+
     local_access_guard(local_access_guard&&) = default;
 
     info get_info() const
@@ -64,6 +102,9 @@ struct local_access_guard
         return {m_locality
             , m_thread_guard.get_info()
             , m_process_guard.get_info()
+#ifdef GHEX_USE_MPI_RMA
+            , m_mpi_guard.get_info()
+#endif
         };
     }
 
@@ -73,12 +114,18 @@ struct local_access_guard
     {
         if (m_locality == locality::thread) m_thread_guard.start_target_epoch();
         if (m_locality == locality::process) m_process_guard.start_target_epoch();
+#ifdef GHEX_USE_MPI_RMA
+        if (m_locality == locality::remote) m_mpi_guard.start_target_epoch();
+#endif
     }
 
     bool try_start_target_epoch()
     {
         if (m_locality == locality::thread) return m_thread_guard.try_start_target_epoch();
         if (m_locality == locality::process) return m_process_guard.try_start_target_epoch();
+#ifdef GHEX_USE_MPI_RMA
+        if (m_locality == locality::remote) return m_mpi_guard.try_start_target_epoch();
+#endif
         return true;
     }
 
@@ -86,6 +133,9 @@ struct local_access_guard
     {
         if (m_locality == locality::thread) m_thread_guard.end_target_epoch();
         if (m_locality == locality::process) m_process_guard.end_target_epoch();
+#ifdef GHEX_USE_MPI_RMA
+        if (m_locality == locality::remote) m_mpi_guard.end_target_epoch();
+#endif
     }
 };
 
@@ -102,16 +152,22 @@ struct remote_access_guard
 {
     locality m_locality;
     thread::remote_access_guard m_thread_guard;
-#if defined(GHEX_USE_XPMEM_ACCESS_GUARD) && defined(GHEX_USE_XPMEM)
-    xpmem::remote_access_guard m_process_guard;
-#else
-    shmem::remote_access_guard m_process_guard;
+    process_remote_access_guard m_process_guard;
+#ifdef GHEX_USE_MPI_RMA
+    mpi::remote_access_guard m_mpi_guard;
 #endif
 
-    remote_access_guard(typename local_access_guard::info info_, int rank)
+    remote_access_guard(typename local_access_guard::info info_, int rank
+#ifdef GHEX_USE_MPI_RMA
+        , mpi::window* w
+#endif
+    )
     : m_locality(info_.m_locality)
     , m_thread_guard(info_.m_thread_guard_info, m_locality, rank)
     , m_process_guard(info_.m_process_guard_info, m_locality, rank)
+#ifdef GHEX_USE_MPI_RMA
+    , m_mpi_guard(info_.m_mpi_guard_info, m_locality, rank, w)
+#endif
     {}
 
     remote_access_guard() = default;
@@ -122,12 +178,18 @@ struct remote_access_guard
     {
         if (m_locality == locality::thread) m_thread_guard.start_source_epoch();
         if (m_locality == locality::process) m_process_guard.start_source_epoch();
+#ifdef GHEX_USE_MPI_RMA
+        if (m_locality == locality::remote) m_mpi_guard.start_source_epoch();
+#endif
     }
 
     bool try_start_source_epoch()
     {
         if (m_locality == locality::thread) return m_thread_guard.try_start_source_epoch();
         if (m_locality == locality::process) return m_process_guard.try_start_source_epoch();
+#ifdef GHEX_USE_MPI_RMA
+        if (m_locality == locality::remote) return m_mpi_guard.try_start_source_epoch();
+#endif
         return true;
     }
     
@@ -135,6 +197,9 @@ struct remote_access_guard
     {
         if (m_locality == locality::thread) m_thread_guard.end_source_epoch();
         if (m_locality == locality::process) m_process_guard.end_source_epoch();
+#ifdef GHEX_USE_MPI_RMA
+        if (m_locality == locality::remote) m_mpi_guard.end_source_epoch();
+#endif
     }
 };
 
@@ -0,0 +1,118 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_RMA_ATOMIC_WAIT_HPP
+#define INCLUDED_GHEX_RMA_ATOMIC_WAIT_HPP
+
+#include <atomic>
+#include <thread>
+#include <climits>
+#include <cstddef>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(GHEX_RMA_USE_FUTEX) && defined(__linux__)
+#define GHEX_RMA_FUTEX_ENABLED
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+namespace gridtools {
+namespace ghex {
+namespace rma {
+
+// size of a cache line, used to pad shared synchronization state
+static constexpr std::size_t cache_line_size = 64;
+
+namespace detail {
+
+// number of polls before a waiting thread yields or blocks
+static constexpr int spin_count = 256;
+
+inline void cpu_relax() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+#ifdef GHEX_RMA_FUTEX_ENABLED
+template<typename T>
+inline int* futex_address(std::atomic<T>& a) noexcept
+{
+    static_assert(sizeof(std::atomic<T>) == sizeof(int), "futex requires a 32 bit word");
+    return reinterpret_cast<int*>(&a);
+}
+#endif
+
+/** @brief block until an atomic variable holds a given value. The waiting thread spins for a short while
+  * and then yields. If GHEX_RMA_USE_FUTEX is defined (Linux only), it is put to sleep on a futex instead.
+  * Memory operations following the return are ordered after the store of the value (acquire semantics).
+  * @tparam T value type (must be 32 bits wide for the futex path)
+  * @param a atomic variable
+  * @param value value to wait for
+  * @param waiters number of threads sleeping on the variable (used to skip wake-up calls)
+  * @param process_shared whether the variable lives in memory shared between processes */
+template<typename T>
+inline void wait_for_value(std::atomic<T>& a, T value, std::atomic<int>& waiters, bool process_shared)
+{
+    for (int i=0; i<spin_count; ++i)
+    {
+        if (a.load(std::memory_order_acquire) == value) return;
+        cpu_relax();
+    }
+#ifdef GHEX_RMA_FUTEX_ENABLED
+    while (true)
+    {
+        // the increment must be ordered before the load so that a concurrent store_and_notify either sees
+        // the waiter or the waiter sees the new value (both are sequentially consistent)
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+        const T current = a.load(std::memory_order_seq_cst);
+        if (current != value)
+            syscall(SYS_futex, futex_address(a), process_shared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE,
+                static_cast<int>(current), nullptr, nullptr, 0);
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+        if (a.load(std::memory_order_acquire) == value) return;
+    }
+#else
+    (void)waiters;
+    (void)process_shared;
+    while (a.load(std::memory_order_acquire) != value) std::this_thread::yield();
+#endif
+}
+
+/** @brief store a value in an atomic variable and wake up threads blocked in wait_for_value (release semantics)
+  * @tparam T value type
+  * @param a atomic variable
+  * @param value new value
+  * @param waiters number of threads sleeping on the variable
+  * @param process_shared whether the variable lives in memory shared between processes */
+template<typename T>
+inline void store_and_notify(std::atomic<T>& a, T value, std::atomic<int>& waiters, bool process_shared)
+{
+#ifdef GHEX_RMA_FUTEX_ENABLED
+    a.store(value, std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_seq_cst) > 0)
+        syscall(SYS_futex, futex_address(a), process_shared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE,
+            INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)waiters;
+    (void)process_shared;
+    a.store(value, std::memory_order_release);
+#endif
+}
+
+} // namespace detail
+} // namespace rma
+} // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_RMA_ATOMIC_WAIT_HPP */
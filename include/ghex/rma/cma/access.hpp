@@ -0,0 +1,57 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_RMA_CMA_ACCESS_HPP
+#define INCLUDED_GHEX_RMA_CMA_ACCESS_HPP
+
+#include <fstream>
+extern "C"{
+#include <sys/prctl.h>
+}
+
+namespace gridtools {
+namespace ghex {
+namespace rma {
+namespace cma {
+
+/** @brief Check whether other processes of the same user may access this process' memory through cross
+  * memory attach (CMA).
+  *
+  * If the Yama security module restricts ptrace-like access to descendants (ptrace_scope 1), sibling
+  * ranks may only access this process if it declares any process as its ptracer. Since this relaxes the
+  * protection of the process for its whole lifetime, it is only done if GHEX_CMA_ALLOW_ANY_PTRACER is
+  * defined (CMake option GHEX_CMA_ALLOW_ANY_PTRACER, default off). Otherwise, and for the stricter
+  * ptrace scopes, CMA is reported as not permitted and callers use their non-CMA path instead. The
+  * result depends only on the node's configuration and is therefore the same for all ranks of a node.
+  * @return true if CMA access to this process is permitted */
+inline bool allow_cma_access()
+{
+    static const bool allowed = []()
+    {
+        int scope = 0;
+        std::ifstream f("/proc/sys/kernel/yama/ptrace_scope");
+        // no restrictions without the Yama module
+        if (!(f >> scope) || scope == 0) return true;
+        if (scope > 1) return false;
+#if defined(GHEX_CMA_ALLOW_ANY_PTRACER) && defined(PR_SET_PTRACER) && defined(PR_SET_PTRACER_ANY)
+        return prctl(PR_SET_PTRACER, PR_SET_PTRACER_ANY, 0, 0, 0) == 0;
+#else
+        return false;
+#endif
+    }();
+    return allowed;
+}
+
+} // namespace cma
+} // namespace rma
+} // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_RMA_CMA_ACCESS_HPP */
@@ -0,0 +1,146 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_RMA_CMA_HANDLE_HPP
+#define INCLUDED_GHEX_RMA_CMA_HANDLE_HPP
+
+#include "../locality.hpp"
+#include "./access.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <string>
+#include <vector>
+extern "C"{
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <limits.h>
+}
+
+namespace gridtools {
+namespace ghex {
+namespace rma {
+namespace cma {
+
+// Below are implementations of a handle in a multi-process setting using cross memory attach (CMA),
+// which is available on stock Linux kernels. The remote memory is not mapped: the remote side obtains
+// the address of the resource in the owner's address space and writes to it through
+// process_vm_writev. Please refer to the documentation in rma/handle.hpp for further explanations.
+
+struct info
+{
+    bool m_on_gpu;
+    pid_t m_pid;
+    std::uintptr_t m_ptr;
+};
+
+struct local_data_holder
+{
+    bool m_on_gpu;
+    void* m_ptr;
+
+    local_data_holder(void* ptr, unsigned int, bool on_gpu)
+    : m_on_gpu{on_gpu}
+    , m_ptr{ptr}
+    {
+        if (!m_on_gpu) allow_cma_access();
+    }
+
+    info get_info() const
+    {
+        return {m_on_gpu, getpid(), reinterpret_cast<std::uintptr_t>(m_ptr)};
+    }
+};
+
+struct remote_data_holder
+{
+    bool m_on_gpu;
+    locality m_loc;
+    pid_t m_pid;
+    std::uintptr_t m_ptr;
+
+    remote_data_holder(const info& info_, locality loc, int)
+    : m_on_gpu{info_.m_on_gpu}
+    , m_loc{loc}
+    , m_pid{info_.m_pid}
+    , m_ptr{info_.m_ptr}
+    {}
+
+    /** @brief address of the resource in the owner's address space (must not be dereferenced) */
+    void* get_ptr() const
+    {
+        return reinterpret_cast<void*>(m_ptr);
+    }
+
+    pid_t get_pid() const noexcept { return m_pid; }
+};
+
+/** @brief collects contiguous copies into the address space of another process and issues them in
+  * batches of process_vm_writev calls. Pending copies must be issued with flush(). */
+class writer
+{
+private: // members
+    pid_t m_pid;
+    std::vector<struct iovec> m_local;
+    std::vector<struct iovec> m_remote;
+
+public: // ctors
+    writer(pid_t pid)
+    : m_pid{pid}
+    {}
+
+    writer(const writer&) = delete;
+    writer& operator=(const writer&) = delete;
+
+public: // member functions
+    /** @brief add a copy
+      * @param dst destination address in the remote process
+      * @param src local source address
+      * @param size number of bytes */
+    void add(void* dst, const void* src, std::size_t size)
+    {
+        if (size == 0u) return;
+        m_local.push_back({const_cast<void*>(src), size});
+        m_remote.push_back({dst, size});
+    }
+
+    /** @brief issue all pending copies (at most IOV_MAX per system call) */
+    void flush()
+    {
+        std::size_t first = 0u;
+        while (first < m_local.size())
+        {
+            const std::size_t n = std::min<std::size_t>(IOV_MAX, m_local.size() - first);
+            std::size_t expected = 0u;
+            for (std::size_t i = first; i < first + n; ++i) expected += m_local[i].iov_len;
+            const auto written = process_vm_writev(m_pid, m_local.data() + first, n, m_remote.data() + first, n, 0);
+            if (written < 0 || static_cast<std::size_t>(written) != expected)
+            {
+                m_local.clear();
+                m_remote.clear();
+                throw std::runtime_error(std::string("process_vm_writev failed: ") + std::strerror(errno));
+            }
+            first += n;
+        }
+        m_local.clear();
+        m_remote.clear();
+    }
+};
+
+} // namespace cma
+} // namespace rma
+} // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_RMA_CMA_HANDLE_HPP */
@@ -18,6 +18,12 @@
 #ifdef GHEX_USE_XPMEM
 #include "./xpmem/handle.hpp"
 #endif
+#ifdef GHEX_RMA_USE_CMA
+#include "./cma/handle.hpp"
+#endif
+#ifdef GHEX_RMA_USE_SHM_SEGMENTS
+#include "./shm_segment/handle.hpp"
+#endif
 #ifdef __CUDACC__
 #include "./cuda/handle.hpp"
 #endif
@@ -28,7 +34,7 @@ namespace rma {
 
 /** @brief General local RMA handle created at the owner's site. Remote counterpart can be generated
   * through the info object which this class exposes. The info object is POD and can be sent easily
-  * over any network. */
+  * over any network. Memory in shared memory segments is exported as (segment name, offset). */
 struct local_handle
 {
     struct data_holder
@@ -39,6 +45,12 @@ struct local_handle
 #ifdef GHEX_USE_XPMEM
         xpmem::local_data_holder m_xpmem_data_holder;
 #endif
+#ifdef GHEX_RMA_USE_CMA
+        cma::local_data_holder m_cma_data_holder;
+#endif
+#ifdef GHEX_RMA_USE_SHM_SEGMENTS
+        shm_segment::local_data_holder m_shm_data_holder;
+#endif
 #ifdef __CUDACC__
         cuda::local_data_holder m_cuda_data_holder;
 #endif
@@ -50,6 +62,12 @@ struct local_handle
 #ifdef GHEX_USE_XPMEM
             xpmem::info m_xpmem_info;
 #endif
+#ifdef GHEX_RMA_USE_CMA
+            cma::info m_cma_info;
+#endif
+#ifdef GHEX_RMA_USE_SHM_SEGMENTS
+            shm_segment::info m_shm_info;
+#endif
 #ifdef __CUDACC__
             cuda::info m_cuda_info;
 #endif
@@ -62,6 +80,12 @@ struct local_handle
 #ifdef GHEX_USE_XPMEM
         , m_xpmem_data_holder(ptr,size,on_gpu)
 #endif
+#ifdef GHEX_RMA_USE_CMA
+        , m_cma_data_holder(ptr,size,on_gpu)
+#endif
+#ifdef GHEX_RMA_USE_SHM_SEGMENTS
+        , m_shm_data_holder(ptr,size,on_gpu)
+#endif
 #ifdef __CUDACC__
         , m_cuda_data_holder(ptr,size,on_gpu)
 #endif
@@ -75,6 +99,12 @@ struct local_handle
 #ifdef GHEX_USE_XPMEM
                 , m_xpmem_data_holder.get_info()
 #endif
+#ifdef GHEX_RMA_USE_CMA
+                , m_cma_data_holder.get_info()
+#endif
+#ifdef GHEX_RMA_USE_SHM_SEGMENTS
+                , m_shm_data_holder.get_info()
+#endif
 #ifdef __CUDACC__
                 , m_cuda_data_holder.get_info()
 #endif
@@ -99,6 +129,28 @@ struct local_handle
 
 using info = typename local_handle::info;
 
+/** @brief Determine the locality through which a resource is accessed by a neighbor. On-node neighbors
+  * which cannot map or write the resource directly (e.g. memory outside of shared memory segments if
+  * only those are exposed) access it as if they were remote.
+  * @param loc locality of the neighbor
+  * @param info_ info object of the resource
+  * @return locality to be used for the resource */
+inline locality access_locality(locality loc, const info& info_)
+{
+    if (loc != locality::process || info_.m_on_gpu) return loc;
+#if defined(GHEX_USE_XPMEM)
+    return loc;
+#else
+#ifdef GHEX_RMA_USE_SHM_SEGMENTS
+    if (info_.m_shm_info.m_valid) return loc;
+#endif
+#ifdef GHEX_RMA_USE_CMA
+    if (cma::allow_cma_access()) return loc;
+#endif
+    return locality::remote;
+#endif
+}
+
 /** @brief General local RMA handle created at the remote's site. The constructor
   * takes an info object exposed and sent by the owner of the memory. */
 struct remote_handle
@@ -111,6 +163,12 @@ struct remote_handle
 #ifdef GHEX_USE_XPMEM
         xpmem::remote_data_holder m_xpmem_data_holder;
 #endif
+#ifdef GHEX_RMA_USE_CMA
+        cma::remote_data_holder m_cma_data_holder;
+#endif
+#ifdef GHEX_RMA_USE_SHM_SEGMENTS
+        shm_segment::remote_data_holder m_shm_data_holder;
+#endif
 #ifdef __CUDACC__
         cuda::remote_data_holder m_cuda_data_holder;
 #endif
@@ -122,10 +180,17 @@ struct remote_handle
 #ifdef GHEX_USE_XPMEM
         , m_xpmem_data_holder(info_.m_xpmem_info, loc, rank)
 #endif
+#ifdef GHEX_RMA_USE_CMA
+        , m_cma_data_holder(info_.m_cma_info, loc, rank)
+#endif
+#ifdef GHEX_RMA_USE_SHM_SEGMENTS
+        , m_shm_data_holder(info_.m_shm_info, loc, rank)
+#endif
 #ifdef __CUDACC__
         , m_cuda_data_holder(info_.m_cuda_info, loc, rank)
 #endif
-        { }
+        {
+        }
 
         void* get_ptr(locality loc) const
         {
@@ -133,11 +198,31 @@ struct remote_handle
 #ifdef GHEX_USE_XPMEM
             if (loc == locality::process && !m_on_gpu) return m_xpmem_data_holder.get_ptr();
 #endif
+#ifdef GHEX_RMA_USE_SHM_SEGMENTS
+            if (loc == locality::process && !m_on_gpu && m_shm_data_holder.get_ptr()) return m_shm_data_holder.get_ptr();
+#endif
+#ifdef GHEX_RMA_USE_CMA
+            if (loc == locality::process && !m_on_gpu) return m_cma_data_holder.get_ptr();
+#endif
 #ifdef __CUDACC__
             if (loc == locality::process && m_on_gpu) return m_cuda_data_holder.get_ptr();
 #endif
             return m_thread_data_holder.get_ptr();
         }
+
+        // process id of the owner if the resource must be accessed through cross memory attach
+        // (get_ptr returns an address in the owner's address space), -1 otherwise
+        int cma_pid(locality loc) const
+        {
+            static_assert(std::is_same<decltype(loc),locality>::value, ""); // prevent compiler warning
+#ifdef GHEX_RMA_USE_SHM_SEGMENTS
+            if (loc == locality::process && !m_on_gpu && m_shm_data_holder.get_ptr()) return -1;
+#endif
+#ifdef GHEX_RMA_USE_CMA
+            if (loc == locality::process && !m_on_gpu) return m_cma_data_holder.get_pid();
+#endif
+            return -1;
+        }
     };
     
     std::unique_ptr<data_holder> m_impl;
@@ -152,6 +237,11 @@ struct remote_handle
         return m_impl->get_ptr(loc);
     }
 
+    int cma_pid(locality loc) const
+    {
+        return m_impl->cma_pid(loc);
+    }
+
     bool on_gpu() const noexcept { return m_impl->m_on_gpu; }
 };
 
@@ -11,6 +11,20 @@
 #ifndef INCLUDED_GHEX_RMA_LOCALITY_HPP
 #define INCLUDED_GHEX_RMA_LOCALITY_HPP
 
+// process locality is supported through xpmem or, as a fallback, through cross memory attach; fields
+// allocated in shared memory segments (allocator/shm_allocator.hpp) are mapped directly if
+// GHEX_USE_SHM_FIELDS is defined
+#if defined(GHEX_USE_CMA) && !defined(GHEX_USE_XPMEM)
+#define GHEX_RMA_USE_CMA
+#endif
+#if defined(GHEX_USE_SHM_FIELDS) && !defined(GHEX_USE_XPMEM)
+#define GHEX_RMA_USE_SHM_SEGMENTS
+#endif
+
+#ifdef GHEX_RMA_USE_CMA
+#include "./cma/access.hpp"
+#endif
+
 namespace gridtools {
 namespace ghex {
 namespace rma {
@@ -31,8 +45,9 @@ enum class locality
   * @tparam Communicator Communicator type
   * @param comm a communicator instance
   * @param remote_rank neighbor rank
-  * @return thread if on the same rank, process if on shared memory (provided xpmem is available)
-  * and remote otherwise. */
+  * @return thread if on the same rank, process if on shared memory (provided xpmem, cross memory
+  * attach or shared memory fields are enabled) and remote otherwise. Cross memory attach alone only
+  * provides process locality where it is permitted (see cma::allow_cma_access). */
 #ifdef GHEX_NO_RMA
 template<typename Communicator>
 static locality is_local(Communicator, int) {
@@ -43,9 +58,11 @@ template<typename Communicator>
 static locality is_local(Communicator comm, int remote_rank)
 {
     if (comm.rank() == remote_rank) return locality::thread;
-#ifdef GHEX_USE_XPMEM
+#if defined(GHEX_USE_XPMEM) || defined(GHEX_RMA_USE_SHM_SEGMENTS)
     else if (comm.is_local(remote_rank)) return locality::process;
-#endif /* GHEX_USE_XPMEM */
+#elif defined(GHEX_RMA_USE_CMA)
+    else if (comm.is_local(remote_rank) && cma::allow_cma_access()) return locality::process;
+#endif
     else return locality::remote;
 }
 #endif
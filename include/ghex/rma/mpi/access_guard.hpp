@@ -0,0 +1,178 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_RMA_MPI_ACCESS_GUARD_HPP
+#define INCLUDED_GHEX_RMA_MPI_ACCESS_GUARD_HPP
+
+#include <memory>
+#include <stdexcept>
+#include "../../transport_layer/mpi/window.hpp"
+#include "../access_mode.hpp"
+#include "../locality.hpp"
+
+namespace gridtools {
+namespace ghex {
+namespace rma {
+namespace mpi {
+
+// Below are implementations of access guards for remote ranks which are accessed through MPI one-sided
+// communication. Please refer to the documentation in rma/access_guard.hpp for further explanations.
+//
+// The guarded resource is a staging buffer in a dynamic window (see tl::mpi::window) which is owned by
+// the target. The access mode is an int in front of the staging buffer and is only accessed with MPI
+// atomic operations: the target polls it locally, the source polls it remotely. The source puts the
+// packed data into the staging buffer and flushes before it hands back access, so that the data is
+// complete at the target once it observes the local access mode.
+
+using window = ::gridtools::ghex::tl::mpi::window;
+
+/** @brief get the window of a communicator for one-sided communication
+  * @return pointer to the window or nullptr if the communicator does not expose one */
+template<typename Communicator>
+inline auto get_window(const Communicator& comm, int) -> decltype(comm.mpi_window())
+{
+    return comm.mpi_window();
+}
+
+template<typename Communicator>
+inline window* get_window(const Communicator&, long)
+{
+    return nullptr;
+}
+
+template<typename Communicator>
+inline window* get_window(const Communicator& comm)
+{
+    return get_window(comm, 0);
+}
+
+// offset of the staging buffer from the access mode
+static constexpr std::size_t staging_offset = window::alignment;
+
+struct local_access_guard
+{
+    struct impl
+    {
+        window* m_window;
+        window::buffer m_buffer;
+
+        impl(window* w, access_mode m, std::size_t staging_size)
+        : m_window{w}
+        , m_buffer{w->allocate(staging_offset + staging_size)}
+        {
+            m_window->store((int)m, m_window->rank(), m_buffer.m_address);
+        }
+
+        ~impl()
+        {
+            m_window->release(m_buffer);
+        }
+    };
+
+    struct info
+    {
+        MPI_Aint m_address;
+        std::size_t m_staging_size;
+    };
+
+    std::unique_ptr<impl> m_impl;
+
+    local_access_guard() = default;
+
+    local_access_guard(window* w, access_mode m, std::size_t staging_size)
+    : m_impl{std::make_unique<impl>(w, m, staging_size)}
+    {}
+
+    local_access_guard(local_access_guard&&) = default;
+
+    info get_info() const
+    {
+        if (!m_impl) return {0, 0u};
+        return {m_impl->m_buffer.m_address, m_impl->m_buffer.m_size - staging_offset};
+    }
+
+    /** @brief staging buffer which receives the data of the remote */
+    const unsigned char* staging() const noexcept
+    {
+        return m_impl->m_buffer.m_ptr + staging_offset;
+    }
+
+    void start_target_epoch()
+    {
+        while (!try_start_target_epoch()) {}
+    }
+
+    bool try_start_target_epoch()
+    {
+        if (!m_impl) return true;
+        auto w = m_impl->m_window;
+        if (w->load(w->rank(), m_impl->m_buffer.m_address) != (int)access_mode::local) return false;
+        // make the data put by the remote visible to local loads
+        w->sync();
+        return true;
+    }
+
+    void end_target_epoch()
+    {
+        if (!m_impl) return;
+        auto w = m_impl->m_window;
+        w->store((int)access_mode::remote, w->rank(), m_impl->m_buffer.m_address);
+    }
+};
+
+struct remote_access_guard
+{
+    window* m_window = nullptr;
+    int m_rank = 0;
+    typename local_access_guard::info m_info = {0, 0u};
+
+    remote_access_guard(typename local_access_guard::info info_, locality loc, int rank, window* w)
+    : m_window{loc == locality::remote ? w : nullptr}
+    , m_rank{rank}
+    , m_info(info_)
+    {}
+    remote_access_guard() = default;
+    remote_access_guard(remote_access_guard&&) = default;
+    remote_access_guard& operator=(remote_access_guard&&) = default;
+
+    /** @brief put data into the staging buffer of the target. Must be called within a source epoch. */
+    void put(const void* data, std::size_t size)
+    {
+        if (size > m_info.m_staging_size)
+            throw std::runtime_error("data does not fit into the staging buffer of the remote rank");
+        m_window->put(data, size, m_rank, m_info.m_address + staging_offset);
+    }
+
+    void start_source_epoch()
+    {
+        while (!try_start_source_epoch()) {}
+    }
+
+    bool try_start_source_epoch()
+    {
+        if (!m_window) return true;
+        return m_window->load(m_rank, m_info.m_address) == (int)access_mode::remote;
+    }
+
+    void end_source_epoch()
+    {
+        if (!m_window) return;
+        // complete the puts at the target before handing back access
+        m_window->flush(m_rank);
+        m_window->store((int)access_mode::local, m_rank, m_info.m_address);
+    }
+};
+
+} // namespace mpi
+} // namespace rma
+} // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_RMA_MPI_ACCESS_GUARD_HPP */
@@ -42,11 +42,19 @@ struct range
 
     template<typename Range>
     range(Range&& r, int id, info field_info, typename local_access_guard::info info_,
-        event_info e_info_, int rank, bool on_gpu_)
+        event_info e_info_, int rank, bool on_gpu_
+#ifdef GHEX_USE_MPI_RMA
+        , mpi::window* w
+#endif
+    )
     : m_id{id}
     , m_loc{info_.m_locality}
     , m_impl{new range_impl<std::remove_reference_t<Range>>(std::forward<Range>(r))}
+#ifdef GHEX_USE_MPI_RMA
+    , m_guard(info_, rank, w)
+#else
     , m_guard(info_, rank)
+#endif
     , m_on_gpu{on_gpu_}
     , m_event{e_info_, m_on_gpu}
     {
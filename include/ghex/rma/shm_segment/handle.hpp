@@ -0,0 +1,141 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_RMA_SHM_SEGMENT_HANDLE_HPP
+#define INCLUDED_GHEX_RMA_SHM_SEGMENT_HANDLE_HPP
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <stdexcept>
+#include "../locality.hpp"
+#include "../../allocator/shm_allocator.hpp"
+
+namespace gridtools {
+namespace ghex {
+namespace rma {
+namespace shm_segment {
+
+// Below are implementations of a handle in a multi-process setting for memory which was obtained from
+// the shared memory allocator (allocator/shm_allocator.hpp). The resource is exported as (segment name,
+// offset) and the remote side maps the whole segment into its address space.
+// Please refer to the documentation in rma/handle.hpp for further explanations.
+
+struct info
+{
+    bool m_valid;
+    allocator::shm::segment_info m_segment;
+};
+
+/** @brief process wide cache of mapped remote segments (segments are mapped once and shared by all
+  * handles referring to them). */
+class mapping_cache
+{
+private: // member types
+    struct mapping
+    {
+        unsigned char* m_base;
+        std::size_t    m_size;
+        int            m_count;
+    };
+
+private: // members
+    std::mutex                     m_mutex;
+    std::map<std::string, mapping> m_mappings;
+
+public: // static member functions
+    static mapping_cache& instance()
+    {
+        static mapping_cache c;
+        return c;
+    }
+
+public: // member functions
+    unsigned char* attach(const allocator::shm::segment_info& s)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_mappings.find(s.m_name);
+        if (it == m_mappings.end())
+        {
+            const int fd = allocator::shm::open_segment(s.m_name, s.m_hugetlbfs);
+            if (fd < 0) throw std::runtime_error("could not open shared memory segment");
+            void* ptr = mmap(nullptr, s.m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            if (ptr == MAP_FAILED) throw std::runtime_error("could not map shared memory segment");
+            it = m_mappings.insert(std::make_pair(std::string(s.m_name),
+                mapping{static_cast<unsigned char*>(ptr), s.m_size, 0})).first;
+        }
+        ++it->second.m_count;
+        return it->second.m_base;
+    }
+
+    void detach(const allocator::shm::segment_info& s)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_mappings.find(s.m_name);
+        if (it == m_mappings.end()) return;
+        if (--it->second.m_count == 0)
+        {
+            munmap(it->second.m_base, it->second.m_size);
+            m_mappings.erase(it);
+        }
+    }
+};
+
+struct local_data_holder
+{
+    info m_info;
+
+    local_data_holder(void* ptr, unsigned int, bool on_gpu)
+    {
+        m_info.m_valid = !on_gpu && allocator::shm::registry::instance().find(ptr, m_info.m_segment);
+    }
+
+    info get_info() const
+    {
+        return m_info;
+    }
+};
+
+struct remote_data_holder
+{
+    info m_info;
+    void* m_ptr = nullptr;
+
+    remote_data_holder(const info& info_, locality loc, int)
+    : m_info(info_)
+    {
+        // attach rma resource
+        if (m_info.m_valid && loc == locality::process)
+            m_ptr = mapping_cache::instance().attach(m_info.m_segment) + m_info.m_segment.m_offset;
+    }
+
+    remote_data_holder(const remote_data_holder&) = delete;
+    remote_data_holder(remote_data_holder&&) = delete;
+
+    ~remote_data_holder()
+    {
+        // detach rma resource
+        if (m_ptr) mapping_cache::instance().detach(m_info.m_segment);
+    }
+
+    /** @brief pointer to the mapped resource, or nullptr if the resource is not in shared memory */
+    void* get_ptr() const
+    {
+        return m_ptr;
+    }
+};
+
+} // namespace shm_segment
+} // namespace rma
+} // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_RMA_SHM_SEGMENT_HANDLE_HPP */
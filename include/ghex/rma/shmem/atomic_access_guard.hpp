@@ -0,0 +1,143 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_RMA_SHMEM_ATOMIC_ACCESS_GUARD_HPP
+#define INCLUDED_GHEX_RMA_SHMEM_ATOMIC_ACCESS_GUARD_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include "../access_mode.hpp"
+#include "../atomic_wait.hpp"
+#include "../locality.hpp"
+#include "./handle.hpp"
+
+namespace gridtools {
+namespace ghex {
+namespace rma {
+namespace shmem {
+
+// Below are lock-free implementations of access guards in a multi-process setting.
+// Please refer to the documentation in rma/access_guard.hpp for further explanations.
+//
+// The shared state is an epoch sequence number: even numbers denote local access, odd numbers remote
+// access. Each participant counts the epochs it has started and only needs to compare the shared
+// number against the one it expects next; ending an epoch is a single store which publishes the
+// preceding writes to the resource. Since the number grows monotonically, a sleeping participant
+// cannot miss a transition.
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "atomic access guards require address-free atomics");
+
+struct alignas(cache_line_size) atomic_access_state
+{
+    std::atomic<std::uint32_t> m_epoch;
+    std::atomic<int> m_waiters;
+
+    atomic_access_state(access_mode m) noexcept
+    : m_epoch{m == access_mode::local ? 0u : 1u}
+    , m_waiters{0}
+    {}
+};
+
+struct atomic_local_access_guard
+{
+    struct impl
+    {
+        void* m_ptr = nullptr;
+        local_data_holder m_handle;
+        atomic_access_state& m_state;
+        std::uint32_t m_next_epoch;
+
+        impl(access_mode m)
+        : m_handle(&m_ptr, sizeof(atomic_access_state), false)
+        , m_state{ *(new(m_ptr) atomic_access_state{m}) }
+        , m_next_epoch{m == access_mode::local ? 0u : 2u}
+        {}
+    };
+
+    struct info
+    {
+        ::gridtools::ghex::rma::shmem::info m_info;
+    };
+
+    std::unique_ptr<impl> m_impl;
+
+    atomic_local_access_guard(access_mode m = access_mode::local)
+    : m_impl{std::make_unique<impl>(m)}
+    {}
+
+    atomic_local_access_guard(atomic_local_access_guard&&) = default;
+
+    info get_info() const
+    {
+        return { m_impl->m_handle.get_info() };
+    }
+
+    void start_target_epoch()
+    {
+        detail::wait_for_value(m_impl->m_state.m_epoch, m_impl->m_next_epoch, m_impl->m_state.m_waiters, true);
+    }
+
+    bool try_start_target_epoch()
+    {
+        return m_impl->m_state.m_epoch.load(std::memory_order_acquire) == m_impl->m_next_epoch;
+    }
+
+    void end_target_epoch()
+    {
+        detail::store_and_notify(m_impl->m_state.m_epoch, m_impl->m_next_epoch+1u, m_impl->m_state.m_waiters, true);
+        m_impl->m_next_epoch += 2u;
+    }
+};
+
+struct atomic_remote_access_guard
+{
+    std::unique_ptr<remote_data_holder> m_handle;
+    std::uint32_t m_next_epoch = 1u;
+
+    atomic_remote_access_guard(typename atomic_local_access_guard::info info_, locality loc, int rank)
+    : m_handle{std::make_unique<remote_data_holder>(info_.m_info, loc, rank)}
+    {
+        // attach at the next remote epoch
+        if (get_ptr()) m_next_epoch = get_ptr()->m_epoch.load(std::memory_order_acquire) | 1u;
+    }
+    atomic_remote_access_guard() = default;
+    atomic_remote_access_guard(atomic_remote_access_guard&&) = default;
+    atomic_remote_access_guard& operator=(atomic_remote_access_guard&&) = default;
+
+    atomic_access_state* get_ptr()
+    {
+        return (atomic_access_state*)(m_handle->get_ptr());
+    }
+
+    void start_source_epoch()
+    {
+        detail::wait_for_value(get_ptr()->m_epoch, m_next_epoch, get_ptr()->m_waiters, true);
+    }
+
+    bool try_start_source_epoch()
+    {
+        return get_ptr()->m_epoch.load(std::memory_order_acquire) == m_next_epoch;
+    }
+
+    void end_source_epoch()
+    {
+        detail::store_and_notify(get_ptr()->m_epoch, m_next_epoch+1u, get_ptr()->m_waiters, true);
+        m_next_epoch += 2u;
+    }
+};
+
+} // namespace shmem
+} // namespace rma
+} // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_RMA_SHMEM_ATOMIC_ACCESS_GUARD_HPP */
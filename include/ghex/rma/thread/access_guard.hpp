@@ -11,10 +11,10 @@
 #ifndef INCLUDED_GHEX_RMA_THREAD_ACCESS_GUARD_HPP
 #define INCLUDED_GHEX_RMA_THREAD_ACCESS_GUARD_HPP
 
-#include <mutex>
-#include <condition_variable>
+#include <atomic>
 #include <memory>
 #include "../access_mode.hpp"
+#include "../atomic_wait.hpp"
 #include "../locality.hpp"
 #include "./handle.hpp"
 
@@ -26,11 +26,18 @@ namespace thread {
 // Below are implementations of access guards in a multi-threaded setting.
 // Please refer to the documentation in rma/access_guard.hpp for further explanations.
 
-struct access_state
+// The access mode is an atomic variable on its own cache line. Polling is a single load, and epoch
+// transitions are a single store with release semantics which publishes the preceding writes to the
+// resource.
+struct alignas(cache_line_size) access_state
 {
-    access_mode m_mode = access_mode::local;
-    std::mutex m_mtx;
-    std::condition_variable m_cv;
+    std::atomic<access_mode> m_mode;
+    std::atomic<int> m_waiters;
+
+    access_state(access_mode m) noexcept
+    : m_mode{m}
+    , m_waiters{0}
+    {}
 };
 
 struct local_access_guard
@@ -41,7 +48,7 @@ struct local_access_guard
         local_data_holder m_handle;
         
         impl(access_mode m)
-        : m_state{m,{},{}}
+        : m_state{m}
         , m_handle(&m_state, sizeof(access_state), false)    
         {}
     };
@@ -66,23 +73,19 @@ struct local_access_guard
 
     void start_target_epoch()
     {
-        std::unique_lock<std::mutex> lk{m_impl->m_state.m_mtx};
-        m_impl->m_state.m_cv.wait(lk, [this] { return m_impl->m_state.m_mode == access_mode::local; });
+        auto& s = m_impl->m_state;
+        detail::wait_for_value(s.m_mode, access_mode::local, s.m_waiters, false);
     }
 
     bool try_start_target_epoch()
     {
-        std::unique_lock<std::mutex> lk{m_impl->m_state.m_mtx};
-        return m_impl->m_state.m_mode == access_mode::local;
+        return m_impl->m_state.m_mode.load(std::memory_order_acquire) == access_mode::local;
     }
 
     void end_target_epoch()
     {
-        {
-        std::lock_guard<std::mutex> lk{m_impl->m_state.m_mtx};
-        m_impl->m_state.m_mode = access_mode::remote;
-        }
-        m_impl->m_state.m_cv.notify_one();
+        auto& s = m_impl->m_state;
+        detail::store_and_notify(s.m_mode, access_mode::remote, s.m_waiters, false);
     }
 };
 
@@ -105,23 +108,19 @@ struct remote_access_guard
 
     void start_source_epoch()
     {
-        std::unique_lock<std::mutex> lk{get_ptr()->m_mtx};
-        get_ptr()->m_cv.wait(lk, [this] { return get_ptr()->m_mode == access_mode::remote; });
+        auto s = get_ptr();
+        detail::wait_for_value(s->m_mode, access_mode::remote, s->m_waiters, false);
     }
 
     bool try_start_source_epoch()
     {
-        std::unique_lock<std::mutex> lk{get_ptr()->m_mtx};
-        return get_ptr()->m_mode == access_mode::remote;
+        return get_ptr()->m_mode.load(std::memory_order_acquire) == access_mode::remote;
     }
 
     void end_source_epoch()
     {
-        {
-        std::lock_guard<std::mutex> lk{get_ptr()->m_mtx};
-        get_ptr()->m_mode = access_mode::local;
-        }
-        get_ptr()->m_cv.notify_one();
+        auto s = get_ptr();
+        detail::store_and_notify(s->m_mode, access_mode::local, s->m_waiters, false);
     }
 };
 
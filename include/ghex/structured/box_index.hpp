@@ -0,0 +1,163 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_STRUCTURED_BOX_INDEX_HPP
+#define INCLUDED_GHEX_STRUCTURED_BOX_INDEX_HPP
+
+#include <array>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+namespace gridtools {
+    namespace ghex {
+        namespace structured {
+            namespace detail {
+
+                /** @brief spatial index over a set of boxes (hypercubes given by their first and last coordinate,
+                  * inclusive) which are contained in a global box. The global box is divided into a regular grid
+                  * of bins and each box is registered with all bins it overlaps. Queries visit only the boxes
+                  * registered with the bins overlapping the query box, hence their cost is proportional to the
+                  * number of boxes in the neighborhood rather than to the total number of boxes.
+                  * @tparam Coordinate coordinate type */
+                template<typename Coordinate>
+                class box_index
+                {
+                public: // member types
+                    using coordinate_type = Coordinate;
+                    using dimension       = typename coordinate_type::dimension;
+                    static constexpr int dim = dimension::value;
+
+                private: // member types
+                    struct entry
+                    {
+                        coordinate_type first;
+                        coordinate_type last;
+                    };
+
+                private: // members
+                    coordinate_type                        m_first;
+                    coordinate_type                        m_last;
+                    std::array<int,dimension::value>       m_num_bins;
+                    std::array<long long,dimension::value> m_bin_size;
+                    std::vector<std::vector<int>>          m_bins;
+                    std::vector<entry>                     m_boxes;
+                    mutable std::vector<int>               m_visited;
+                    mutable int                            m_query = 0;
+
+                public: // ctors
+                    /** @brief construct an empty index
+                      * @param first first coordinate of the global box
+                      * @param last last coordinate of the global box
+                      * @param num_boxes expected number of boxes (determines the number of bins) */
+                    box_index(const coordinate_type& first, const coordinate_type& last, std::size_t num_boxes)
+                    : m_first{first}
+                    , m_last{last}
+                    {
+                        // aim at roughly one box per bin
+                        const int n = std::max(1, (int)std::ceil(std::pow((double)num_boxes, 1.0/dim)));
+                        std::size_t total = 1u;
+                        for (int i=0; i<dim; ++i)
+                        {
+                            const long long extent = (long long)m_last[i] - (long long)m_first[i] + 1;
+                            m_num_bins[i] = (int)std::max(1ll, std::min((long long)n, extent));
+                            m_bin_size[i] = (extent + m_num_bins[i] - 1)/m_num_bins[i];
+                            total *= m_num_bins[i];
+                        }
+                        m_bins.resize(total);
+                        m_boxes.reserve(num_boxes);
+                    }
+
+                public: // member functions
+                    /** @brief register a box
+                      * @param first first coordinate of the box
+                      * @param last last coordinate of the box
+                      * @return id of the box (boxes are numbered consecutively in the order of insertion) */
+                    int insert(const coordinate_type& first, const coordinate_type& last)
+                    {
+                        const int id = m_boxes.size();
+                        m_boxes.push_back(entry{first, last});
+                        m_visited.push_back(-1);
+                        for_each_bin(first, last, [this,id](std::size_t b) { m_bins[b].push_back(id); });
+                        return id;
+                    }
+
+                    /** @brief invoke a function for each registered box which overlaps a query box (once per box)
+                      * @tparam Func function type with signature void(int)
+                      * @param first first coordinate of the query box
+                      * @param last last coordinate of the query box
+                      * @param f function invoked with the id of each overlapping box */
+                    template<typename Func>
+                    void query(const coordinate_type& first, const coordinate_type& last, Func&& f) const
+                    {
+                        const int q = m_query++;
+                        for_each_bin(first, last, [this,q,&first,&last,&f](std::size_t b)
+                        {
+                            for (int id : m_bins[b])
+                            {
+                                if (m_visited[id] == q) continue;
+                                m_visited[id] = q;
+                                if (overlap(m_boxes[id], first, last)) f(id);
+                            }
+                        });
+                    }
+
+                    std::size_t size() const noexcept { return m_boxes.size(); }
+
+                private: // implementation
+                    static bool overlap(const entry& e, const coordinate_type& first, const coordinate_type& last) noexcept
+                    {
+                        for (int i=0; i<dim; ++i)
+                            if (e.last[i] < first[i] || last[i] < e.first[i]) return false;
+                        return true;
+                    }
+
+                    // visits all bins overlapping a box (coordinates outside the global box are clamped)
+                    template<typename Func>
+                    void for_each_bin(const coordinate_type& first, const coordinate_type& last, Func&& f) const
+                    {
+                        std::array<int,dimension::value> lo, hi;
+                        for (int i=0; i<dim; ++i)
+                        {
+                            if (last[i] < first[i] || last[i] < m_first[i] || m_last[i] < first[i]) return;
+                            lo[i] = bin(first[i], i);
+                            hi[i] = bin(last[i], i);
+                        }
+                        std::array<int,dimension::value> idx = lo;
+                        while (true)
+                        {
+                            std::size_t b = 0u;
+                            for (int i=dim-1; i>=0; --i)
+                                b = b*m_num_bins[i] + idx[i];
+                            f(b);
+                            int i = 0;
+                            for (; i<dim; ++i)
+                            {
+                                if (idx[i] < hi[i]) { ++idx[i]; break; }
+                                idx[i] = lo[i];
+                            }
+                            if (i == dim) break;
+                        }
+                    }
+
+                    template<typename T>
+                    int bin(T x, int i) const noexcept
+                    {
+                        const long long d = (long long)x - (long long)m_first[i];
+                        return (int)std::max(0ll, std::min((long long)m_num_bins[i]-1, d/m_bin_size[i]));
+                    }
+                };
+
+            } // namespace detail
+        } // namespace structured
+    } // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_STRUCTURED_BOX_INDEX_HPP */
@@ -139,7 +139,7 @@ public: // member types
         // loop over pattern's iteration spaces
         for (const auto& is : c) {
             const size_type size = is.size()*base::num_components();
-            serialization_type::pack ( make_pack_is(is, buffer, size), arg );
+            serialization_type::pack_batch ( make_pack_is(is, buffer, size), arg );
             buffer += size;
         }
     }
@@ -13,6 +13,7 @@
 
 #include <cstring>
 #include "./field_utils.hpp"
+#include "./strided_copy.hpp"
 #include "../common/utils.hpp"
 #include "../arch_traits.hpp"
 
@@ -20,15 +21,6 @@ namespace gridtools {
 namespace ghex {
 namespace structured {
 
-// this is to exclude index Idx from a layout map
-// and return a reduced layout map
-template<std::size_t Idx, typename Seq, typename LMap>
-struct reduced_layout_map;
-template<std::size_t Idx, std::size_t... Ms, typename LMap>
-struct reduced_layout_map<Idx, std::index_sequence<Ms...>, LMap>{
-    using type = gridtools::layout_map<LMap::at(Ms<Idx ? Ms : Ms+1)...>;
-};
-
 /** @brief Helper class to dispatch to CPU/GPU implementations of pack/unpack kernels
   * @tparam Arch Architecture type
   * @tparam LayoutMap Data layout map*/
@@ -58,73 +50,68 @@ struct serialization {
             unpack_is.m_data_is.m_last);
     }
 
+    /** @brief packs a halo region by copying 2-dimensional slabs spanned by the contiguous and the
+      * second-fastest dimension (as given by the layout map) with detail::strided_copy */
     template<typename PackIterationSpace>
     static void pack_batch(PackIterationSpace&& pack_is, void*) {
         using coordinate_type = typename PackIterationSpace::coordinate_t;
         using value_type = typename PackIterationSpace::value_t;
         constexpr auto D = coordinate_type::size();
         constexpr auto cont_idx = LayoutMap::find(D-1);
-        const auto x_first = pack_is.m_data_is.m_first[cont_idx];
-        const auto x_last = pack_is.m_data_is.m_last[cont_idx];
-        using LayoutMap2 = typename reduced_layout_map<cont_idx,std::make_index_sequence<D-1>,LayoutMap>::type;
-        using scalar_coord_type = typename std::remove_cv<decltype(x_first)>::type;
-        using cont_coord_type = gridtools::array<scalar_coord_type,D-1>;
-        cont_coord_type first,last;
-        for (std::size_t j=0, i=0; i<D; ++i) {
-            if (i==cont_idx) continue;
-            first[j] = pack_is.m_data_is.m_first[i];
-            last[j++] = pack_is.m_data_is.m_last[i];
-        }
-        ::gridtools::ghex::detail::for_loop<D-1,D-1,LayoutMap2>::template apply(
-            [&pack_is,&x_first,&x_last](auto... xs) {
-                const cont_coord_type x0{xs...};
-                coordinate_type x1;
-                x1[cont_idx] = x_first;
-                for (std::size_t j=0, i=0; i<D; ++i) {
-                    if (i==cont_idx) continue;
-                    x1[i] = x0[j++];
-                }
-                value_type* buffer = &(pack_is.buffer(x1));
-                value_type const * field = &(pack_is.data(x1));
-                std::memcpy(buffer, field, (x_last-x_first+1)*sizeof(value_type));
+        constexpr auto sec_idx = LayoutMap::find(D-2);
+        const std::size_t len = pack_is.m_data_is.m_last[cont_idx] - pack_is.m_data_is.m_first[cont_idx] + 1;
+        const std::size_t n_lines = pack_is.m_data_is.m_last[sec_idx] - pack_is.m_data_is.m_first[sec_idx] + 1;
+        const std::ptrdiff_t buffer_stride = pack_is.m_buffer_desc.m_strides[sec_idx];
+        const std::ptrdiff_t field_stride = pack_is.m_data_is.m_strides[sec_idx];
+        for_each_slab(
+            [&pack_is,len,n_lines,buffer_stride,field_stride](const coordinate_type& x) {
+                value_type* buffer = &(pack_is.buffer(x));
+                value_type const * field = &(pack_is.data(x));
+                detail::strided_copy(buffer, buffer_stride, field, field_stride, len, n_lines);
             },
-            first,
-            last);
+            pack_is.m_data_is.m_first,
+            pack_is.m_data_is.m_last,
+            std::integral_constant<bool,(D>2)>{});
     }
 
+    /** @brief unpacks a halo region by copying 2-dimensional slabs (see pack_batch) */
     template<typename UnPackIterationSpace>
     static void unpack_batch(UnPackIterationSpace&& unpack_is, void*) {
         using coordinate_type = typename UnPackIterationSpace::coordinate_t;
         using value_type = typename UnPackIterationSpace::value_t;
         constexpr auto D = coordinate_type::size();
         constexpr auto cont_idx = LayoutMap::find(D-1);
-        const auto x_first = unpack_is.m_data_is.m_first[cont_idx];
-        const auto x_last = unpack_is.m_data_is.m_last[cont_idx];
-        using LayoutMap2 = typename reduced_layout_map<cont_idx,std::make_index_sequence<D-1>,LayoutMap>::type;
-        using scalar_coord_type = typename std::remove_cv<decltype(x_first)>::type;
-        using cont_coord_type = gridtools::array<scalar_coord_type,D-1>;
-        cont_coord_type first,last;
-        for (std::size_t j=0, i=0; i<D; ++i) {
-            if (i==cont_idx) continue;
-            first[j] = unpack_is.m_data_is.m_first[i];
-            last[j++] = unpack_is.m_data_is.m_last[i];
-        }
-        ::gridtools::ghex::detail::for_loop<D-1,D-1,LayoutMap2>::template apply(
-            [&unpack_is,&x_first,&x_last](auto... xs) {
-                const cont_coord_type x0{xs...};
-                coordinate_type x1;
-                x1[cont_idx] = x_first;
-                for (std::size_t j=0, i=0; i<D; ++i) {
-                    if (i==cont_idx) continue;
-                    x1[i] = x0[j++];
-                }
-                value_type const * buffer = &(unpack_is.buffer(x1));
-                value_type * field = &(unpack_is.data(x1));
-                std::memcpy(field, buffer, (x_last-x_first+1)*sizeof(value_type));
+        constexpr auto sec_idx = LayoutMap::find(D-2);
+        const std::size_t len = unpack_is.m_data_is.m_last[cont_idx] - unpack_is.m_data_is.m_first[cont_idx] + 1;
+        const std::size_t n_lines = unpack_is.m_data_is.m_last[sec_idx] - unpack_is.m_data_is.m_first[sec_idx] + 1;
+        const std::ptrdiff_t buffer_stride = unpack_is.m_buffer_desc.m_strides[sec_idx];
+        const std::ptrdiff_t field_stride = unpack_is.m_data_is.m_strides[sec_idx];
+        for_each_slab(
+            [&unpack_is,len,n_lines,buffer_stride,field_stride](const coordinate_type& x) {
+                value_type const * buffer = &(unpack_is.buffer(x));
+                value_type * field = &(unpack_is.data(x));
+                detail::strided_copy(field, field_stride, buffer, buffer_stride, len, n_lines);
             },
+            unpack_is.m_data_is.m_first,
+            unpack_is.m_data_is.m_last,
+            std::integral_constant<bool,(D>2)>{});
+    }
+
+private:
+    // calls f with the first coordinate of each 2-dimensional slab (loop over the outer D-2 dimensions)
+    template<typename Func, typename Coordinate>
+    static void for_each_slab(Func&& f, const Coordinate& first, const Coordinate& last, std::true_type) {
+        static constexpr auto D = Coordinate::size();
+        ::gridtools::ghex::detail::for_loop<D,D,LayoutMap,2>::template apply(
+            [&f](auto... xs) { f(Coordinate{xs...}); },
             first,
             last);
     }
+
+    template<typename Func, typename Coordinate>
+    static void for_each_slab(Func&& f, const Coordinate& first, const Coordinate&, std::false_type) {
+        f(first);
+    }
 };
 
 #ifdef __CUDACC__
@@ -13,7 +13,10 @@
 
 #include <map>
 #include <iosfwd>
+#include <cstring>
+#include <algorithm>
 #include "./grid.hpp"
+#include "./box_index.hpp"
 #include "../pattern.hpp"
 #include "../transport_layer/mpi/setup.hpp"
 
@@ -201,10 +204,36 @@ namespace gridtools {
 
     namespace detail {
 
-        // constructs the pattern with the help of all to all communications
+        // constructs the pattern: domain extents are gathered by all ranks, receive halos are intersected with
+        // neighboring domains only (found through a spatial index) and the send halos are delivered to their
+        // owners by a sparse data exchange
         template<typename CoordinateArrayType>
         struct make_pattern_impl<::gridtools::ghex::structured::detail::grid<CoordinateArrayType>>
         {
+            // tag used for the sparse exchange of send halos
+            static constexpr int sparse_exchange_tag = 98;
+
+            template<typename T>
+            static void serialize(std::vector<char>& buffer, const T* values, std::size_t n)
+            {
+                const auto s = buffer.size();
+                buffer.resize(s + n*sizeof(T));
+                if (n > 0u) std::memcpy(buffer.data()+s, values, n*sizeof(T));
+            }
+
+            template<typename T>
+            static void serialize(std::vector<char>& buffer, const T& value) { serialize(buffer, &value, 1u); }
+
+            template<typename T>
+            static const char* deserialize(const char* ptr, T* values, std::size_t n)
+            {
+                if (n > 0u) std::memcpy(values, ptr, n*sizeof(T));
+                return ptr + n*sizeof(T);
+            }
+
+            template<typename T>
+            static const char* deserialize(const char* ptr, T& value) { return deserialize(ptr, &value, 1u); }
+
             template<typename Transport, typename HaloGenerator, typename DomainRange>
             static auto apply(tl::context<Transport>& context, HaloGenerator&& hgen, DomainRange&& d_range)
             {
@@ -221,7 +250,7 @@ namespace gridtools {
                 using extended_domain_id_type   = typename pattern_type::extended_domain_id_type;
 
                 // get this address from new communicator
-                auto comm = tl::mpi::setup_communicator(context.mpi_comm());
+                auto comm = context.get_setup_communicator();
                 auto new_comm = context.get_serial_communicator();
                 auto my_address = new_comm.address();
 
@@ -268,7 +297,6 @@ namespace gridtools {
                 auto num_domain_ids  = comm.all_gather(my_num_domains).get();
                 auto domain_ids      = comm.all_gather(my_domain_ids, num_domain_ids).get();
                 auto domain_extents  = comm.all_gather(my_domain_extents, num_domain_ids).get();
-                const int world_size = num_domain_ids.size();
 
                 // find global extents
                 auto global_min = my_domain_extents[0].global().first();
@@ -285,7 +313,22 @@ namespace gridtools {
                     pat.global_last()  = global_max;
                 }
 
-                // check my receive halos against all existing domains (i.e. intersection check)
+                // spatial index over all domains: intersections are only computed with domains whose global
+                // extents overlap the halo
+                std::size_t num_all_domains = 0u;
+                for (const auto n : num_domain_ids) num_all_domains += n;
+                std::vector<std::pair<int,int>> box_owners;
+                box_owners.reserve(num_all_domains);
+                ::gridtools::ghex::structured::detail::box_index<coordinate_type> domain_index(
+                    global_min, global_max, num_all_domains);
+                for (unsigned int j=0; j<domain_extents.size(); ++j)
+                    for (unsigned int k=0; k<domain_extents[j].size(); ++k)
+                    {
+                        domain_index.insert(domain_extents[j][k].global().first(), domain_extents[j][k].global().last());
+                        box_owners.push_back(std::make_pair((int)j,(int)k));
+                    }
+
+                // check my receive halos against all neighboring domains (i.e. intersection check)
                 // in order to decide from which domain I shall be receiving from.
                 // loop over patterns/domains
                 auto d_it = std::begin(d_range);
@@ -293,35 +336,32 @@ namespace gridtools {
                 {
                     // get corresponding halos
                     const auto& recv_halos = my_generated_recv_halos[i];
-                    // intersect each halo with all domain extents
+                    // intersect each halo with the overlapping domain extents
                     for (const auto& halo : recv_halos)
                     {
-                        // loop over all ranks
-                        for (unsigned int j=0; j<domain_extents.size(); ++j)
+                        // collect candidates in the order of (rank, domain) to keep the halo ordering deterministic
+                        std::vector<int> candidates;
+                        domain_index.query(halo.global().first(), halo.global().last(),
+                            [&candidates](int id) { candidates.push_back(id); });
+                        std::sort(candidates.begin(), candidates.end());
+                        for (const auto id : candidates)
                         {
-                            // get vectors of extents and ids per rank
-                            const auto& extents_vec   = domain_extents[j];
-                            const auto& domain_id_vec = domain_ids[j];
-                            // loop over extents and ids
-                            for (unsigned int k=0; k<extents_vec.size(); ++k)
-                            {
-                                // intersect in global coordinates
-                                const auto& extent = extents_vec[k];
-                                const auto& domain_id = domain_id_vec[k];
-                                const auto x =
-                                hgen.intersect(*d_it, halo.local().first(),    halo.local().last(),
-                                                      halo.global().first(),   halo.global().last(),
-                                                      extent.global().first(), extent.global().last());
-                                const coordinate_type x_global_first{x.global().first()};
-                                const coordinate_type x_global_last{x.global().last()};
-                                if (x_global_first <= x_global_last) {
-                                    my_patterns[i].recv_halos()[domain_id].push_back(
-                                        iteration_space_pair{
-                                            iteration_space{
-                                                coordinate_type{x.local().first()},
-                                                coordinate_type{x.local().last()}},
-                                            iteration_space{x_global_first, x_global_last}});
-                                }
+                            // intersect in global coordinates
+                            const auto& extent = domain_extents[box_owners[id].first][box_owners[id].second];
+                            const auto& domain_id = domain_ids[box_owners[id].first][box_owners[id].second];
+                            const auto x =
+                            hgen.intersect(*d_it, halo.local().first(),    halo.local().last(),
+                                                  halo.global().first(),   halo.global().last(),
+                                                  extent.global().first(), extent.global().last());
+                            const coordinate_type x_global_first{x.global().first()};
+                            const coordinate_type x_global_last{x.global().last()};
+                            if (x_global_first <= x_global_last) {
+                                my_patterns[i].recv_halos()[domain_id].push_back(
+                                    iteration_space_pair{
+                                        iteration_space{
+                                            coordinate_type{x.local().first()},
+                                            coordinate_type{x.local().last()}},
+                                        iteration_space{x_global_first, x_global_last}});
                             }
                         }
                     }
@@ -360,13 +400,6 @@ namespace gridtools {
                     }
                 }
 
-                // communicate max tag to be used for thread safety in communication object
-                // use all_gather
-                auto max_tags  = comm.all_gather(m_max_tag).get();
-                // compute maximum tag and store in m_max_tag
-                for (auto x : max_tags)
-                    m_max_tag = std::max(x,m_max_tag);
-
                 // translate my receive halos to (remote) send halos
                 // by a detour over the following nested map
                 std::map<int,
@@ -436,143 +469,67 @@ namespace gridtools {
                     send_halos_map.erase(it);
                 }
 
-                // loop over all ranks and establish connection
-                for (int rank = 0; rank<world_size; ++rank)
+                // serialize the send halos per destination rank:
+                // for each remote domain: domain id, number of pairs, and for each pair: extended domain id,
+                // number of iteration spaces and the iteration spaces
+                std::map<int,std::vector<char>> messages;
+                for (const auto& p : send_halos_map)
                 {
-                    if (rank == comm.rank())
+                    auto& buffer = messages[p.first];
+                    for (const auto& p1 : p.second)
                     {
-                        // broadcast number of connecting ranks
-                        int num_ranks = send_halos_map.size();
-                        comm.broadcast(num_ranks, rank);
-
-                        if (num_ranks > 0)
+                        serialize(buffer, p1.first);
+                        serialize(buffer, (int)p1.second.size());
+                        for (const auto& p2 : p1.second)
                         {
-                            // broadcast ranks
-                            std::vector<int> ranks;
-                            ranks.reserve(num_ranks);
-                            for (const auto& p : send_halos_map)
-                                ranks.push_back(p.first);
-                            comm.broadcast(&ranks[0],num_ranks,rank);
-
-                            // send number of domains to each rank
-                            std::vector<int> num_domains;
-                            num_domains.reserve(num_ranks);
-                            for (const auto& p : send_halos_map)
-                                num_domains.push_back(p.second.size());
-                            int j=0;
-                            for (auto& nd : num_domains)
-                                comm.send(ranks[j++], 0, nd);
-
-                            j=0;
-                            for (const auto& p : send_halos_map)
-                            {
-                                // send domain ids
-                                std::vector<domain_id_type> dom_ids;
-                                dom_ids.reserve(num_domains[j]);
-                                for (const auto& p1 : p.second)
-                                    dom_ids.push_back(p1.first);
-                                comm.send(ranks[j], 0, &dom_ids[0], num_domains[j]);
-
-                                // send number of id_iteration_space pairs per domain
-                                std::vector<int> num_pairs;
-                                num_pairs.reserve(num_domains[j]);
-                                for (const auto& p1 : p.second)
-                                    num_pairs.push_back(p1.second.size());
-                                comm.send(ranks[j], 0, &num_pairs[0], num_domains[j]);
-
-                                int k=0;
-                                for (const auto& p1 : p.second)
-                                {
-                                    // send extended_domain_ids for each domain j and each pair k
-                                    std::vector<extended_domain_id_type> my_dom_ids;
-                                    my_dom_ids.reserve(num_pairs[k]);
-                                    for (const auto& p2 : p1.second)
-                                        my_dom_ids.push_back(p2.first);
-                                    comm.send(ranks[j], 0, &my_dom_ids[0], num_pairs[k]);
-
-                                    // send all iteration spaces for each domain j, each pair k
-                                    for (const auto& p2 :  p1.second)
-                                    {
-                                        int num_is = p2.second.size();
-                                        comm.send(ranks[j], 0, num_is);
-                                        comm.send(ranks[j], 0, &p2.second[0], num_is);
-                                    }
-                                    ++k;
-                                }
-                                ++j;
-                            }
+                            serialize(buffer, p2.first);
+                            serialize(buffer, (int)p2.second.size());
+                            serialize(buffer, p2.second.data(), p2.second.size());
                         }
                     }
-                    else
-                    {
-                        // broadcast number of connecting ranks
-                        int num_ranks;
-                        comm.broadcast(num_ranks, rank);
+                }
 
-                        if (num_ranks > 0)
+                // deliver the send halos to the owning ranks
+                for (const auto& msg : comm.sparse_exchange(messages, sparse_exchange_tag))
+                {
+                    const char* ptr = msg.second.data();
+                    const char* end = ptr + msg.second.size();
+                    while (ptr != end)
+                    {
+                        domain_id_type dom_id;
+                        int num_pairs;
+                        ptr = deserialize(ptr, dom_id);
+                        ptr = deserialize(ptr, num_pairs);
+                        // find domain in my list of patterns
+                        int k=0;
+                        for (const auto& pat : my_patterns)
                         {
-                            // broadcast ranks
-                            std::vector<int> ranks(num_ranks);
-                            comm.broadcast(&ranks[0],num_ranks,rank);
-
-                            // check if I am part of the ranks
-                            bool sending = false;
-                            for (auto r : ranks)
-                            {
-                                if (r == comm.rank())
-                                {
-                                    sending = true;
-                                    break;
-                                }
-                            }
-                            if (sending)
-                            {
-                                // recv number of domains
-                                int num_domains;
-                                comm.recv(rank, 0, num_domains);
-
-                                // recv domain ids
-                                std::vector<domain_id_type> dom_ids(num_domains);
-                                comm.recv(rank, 0, &dom_ids[0], num_domains);
-
-                                // recv number of id_iteration_space pairs per domain
-                                std::vector<int> num_pairs(num_domains);
-                                comm.recv(rank, 0, &num_pairs[0], num_domains);
-
-                                int j=0;
-                                for (auto np : num_pairs)
-                                {
-                                    // recv extended_domain_ids for each domain j and all its np pairs
-                                    std::vector<extended_domain_id_type> send_dom_ids(np);
-                                    comm.recv(rank, 0, &send_dom_ids[0], np);
-
-                                    // find domain in my list of patterns
-                                    int k=0;
-                                    for (const auto& pat : my_patterns)
-                                    {
-                                        if (pat.domain_id() == dom_ids[j]) break;
-                                        ++k;
-                                    }
-                                    auto& pat = my_patterns[k];
-
-                                    // recv all iteration spaces for each domain and each pair
-                                    for (const auto& did : send_dom_ids)
-                                    {
-                                        int num_is;
-                                        comm.recv(rank, 0, num_is);
-                                        std::vector<iteration_space_pair> is(num_is);
-                                        comm.recv(rank, 0, &is[0], num_is);
-                                        auto& vec = pat.send_halos()[did];
-                                        vec.insert(vec.end(), is.begin(), is.end());
-                                    }
-                                    ++j;
-                                }
-
-                            }
+                            if (pat.domain_id() == dom_id) break;
+                            ++k;
+                        }
+                        auto& pat = my_patterns[k];
+                        for (int j=0; j<num_pairs; ++j)
+                        {
+                            extended_domain_id_type did;
+                            int num_is;
+                            ptr = deserialize(ptr, did);
+                            ptr = deserialize(ptr, num_is);
+                            auto& vec = pat.send_halos()[did];
+                            const auto s = vec.size();
+                            vec.resize(s + num_is);
+                            ptr = deserialize(ptr, vec.data()+s, num_is);
                         }
                     }
                 }
 
+                // communicate max tag to be used for thread safety in communication object
+                // use all_gather (being collective, it also guarantees that no rank is still receiving setup
+                // messages when halo exchanges start)
+                auto max_tags  = comm.all_gather(m_max_tag).get();
+                // compute maximum tag and store in m_max_tag
+                for (auto x : max_tags)
+                    m_max_tag = std::max(x,m_max_tag);
+
                 return pattern_container<communicator_type,grid_type,domain_id_type>(std::move(my_patterns), m_max_tag);
             }
 
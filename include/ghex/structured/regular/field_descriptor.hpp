@@ -17,7 +17,9 @@
 #include "./domain_descriptor.hpp"
 #include <cstring>
 #include <cstdint>
+#include <vector>
 #include "../../arch_traits.hpp"
+#include "../../transport_layer/mpi/error.hpp"
 
 //#define NCTIS 128
 
@@ -102,6 +104,142 @@ public: // ctors
         }
     }
 
+    /** @brief checks whether the iteration spaces map to one contiguous range of the field's memory which is
+      * traversed in the same order as the serialized buffer (i.e. the buffer is an exact copy of that range)
+      * @tparam IndexContainer iteration space container type
+      * @param c iteration spaces
+      * @return pointer to the first element of the range if contiguous, nullptr otherwise */
+    template<typename IndexContainer>
+    T* contiguous_range(const IndexContainer& c) const noexcept {
+        T* first_ptr = nullptr;
+        const char* next_ptr = nullptr;
+        for (const auto& is : c) {
+            coordinate_type data_first;
+            coordinate_type data_last;
+            std::copy(is.local().first().begin(), is.local().first().end(), data_first.begin());
+            std::copy(is.local().last().begin(), is.local().last().end(), data_last.begin());
+            if (has_components::value) {
+                data_first[dimension::value-1] = 0;
+                data_last[dimension::value-1] = base::m_num_components-1;
+            }
+            // walk dimensions from the fastest to the slowest varying one
+            std::size_t span = sizeof(T);
+            for (int k=dimension::value-1; k>=0; --k) {
+                const auto d = layout_map::find(k);
+                const std::size_t n = data_last[d]-data_first[d]+1;
+                if (n > 1u) {
+                    if ((std::size_t)base::m_byte_strides[d] != span) return nullptr;
+                    span *= n;
+                }
+            }
+            const coordinate_type data_coord = data_first + base::m_offsets;
+            char* ptr = reinterpret_cast<char*>(base::m_data) + dot(data_coord, base::m_byte_strides);
+            if (next_ptr && ptr != next_ptr) return nullptr;
+            if (!first_ptr) first_ptr = reinterpret_cast<T*>(ptr);
+            next_ptr = ptr + span;
+        }
+        return first_ptr;
+    }
+
+    /** @brief key which uniquely identifies the MPI datatype created by make_mpi_datatype: consists of the
+      * memory layout of the field (value size, number of components, extents, byte strides and offsets) and
+      * the coordinates of the iteration spaces
+      * @tparam IndexContainer iteration space container type
+      * @param c iteration spaces
+      * @return key */
+    template<typename IndexContainer>
+    std::vector<std::ptrdiff_t> mpi_datatype_key(const IndexContainer& c) const {
+        std::vector<std::ptrdiff_t> res{(std::ptrdiff_t)sizeof(T), (std::ptrdiff_t)base::m_num_components};
+        for (unsigned int i=0u; i<dimension::value; ++i) {
+            res.push_back(base::m_extents[i]);
+            res.push_back(base::m_byte_strides[i]);
+            res.push_back(base::m_offsets[i]);
+        }
+        for (const auto& is : c) {
+            res.insert(res.end(), is.local().first().begin(), is.local().first().end());
+            res.insert(res.end(), is.local().last().begin(), is.local().last().end());
+        }
+        return res;
+    }
+
+    /** @brief create an MPI datatype which describes the iteration spaces relative to the field's data pointer.
+      * The type map traverses the elements in the same order as the serialized buffer. Compact fields are
+      * described by subarrays, fields with user-defined strides by nested strided vectors.
+      * @tparam IndexContainer iteration space container type
+      * @param c iteration spaces
+      * @return committed datatype (to be freed by the caller) */
+    template<typename IndexContainer>
+    MPI_Datatype make_mpi_datatype(const IndexContainer& c) const {
+        MPI_Datatype value_type_mpi;
+        GHEX_CHECK_MPI_RESULT(MPI_Type_contiguous(sizeof(T), MPI_BYTE, &value_type_mpi));
+        strides_type compact_strides;
+        ::gridtools::ghex::structured::detail::compute_strides<dimension::value>::template
+            apply<layout_map,value_type>(base::m_extents,compact_strides,0u);
+        bool compact = true;
+        for (unsigned int i=0u; i<dimension::value; ++i)
+            if (compact_strides[i] != base::m_byte_strides[i]) compact = false;
+
+        std::vector<MPI_Datatype> types;
+        std::vector<MPI_Aint> displacements;
+        for (const auto& is : c) {
+            coordinate_type data_first;
+            coordinate_type data_last;
+            std::copy(is.local().first().begin(), is.local().first().end(), data_first.begin());
+            std::copy(is.local().last().begin(), is.local().last().end(), data_last.begin());
+            if (has_components::value) {
+                data_first[dimension::value-1] = 0;
+                data_last[dimension::value-1] = base::m_num_components-1;
+            }
+            const coordinate_type data_coord = data_first + base::m_offsets;
+            MPI_Datatype t;
+            if (compact) {
+                // dimensions ordered from the slowest to the fastest varying one (C order)
+                int sizes[dimension::value], sub_sizes[dimension::value], starts[dimension::value];
+                for (unsigned int k=0u; k<dimension::value; ++k) {
+                    const auto d = layout_map::find(k);
+                    sizes[k] = base::m_extents[d];
+                    sub_sizes[k] = data_last[d]-data_first[d]+1;
+                    starts[k] = data_coord[d];
+                }
+                GHEX_CHECK_MPI_RESULT(MPI_Type_create_subarray(dimension::value, sizes, sub_sizes, starts,
+                    MPI_ORDER_C, value_type_mpi, &t));
+                displacements.push_back(0);
+            }
+            else {
+                // nest strided vectors from the fastest to the slowest varying dimension
+                MPI_Datatype inner = value_type_mpi;
+                for (int k=dimension::value-1; k>=0; --k) {
+                    const auto d = layout_map::find(k);
+                    MPI_Datatype outer;
+                    GHEX_CHECK_MPI_RESULT(MPI_Type_create_hvector(data_last[d]-data_first[d]+1, 1,
+                        (MPI_Aint)base::m_byte_strides[d], inner, &outer));
+                    if (inner != value_type_mpi) {
+                        GHEX_CHECK_MPI_RESULT(MPI_Type_free(&inner));
+                    }
+                    inner = outer;
+                }
+                t = inner;
+                displacements.push_back((MPI_Aint)dot(data_coord, base::m_byte_strides));
+            }
+            types.push_back(t);
+        }
+        MPI_Datatype res;
+        if (types.size() == 1u && displacements[0] == 0) {
+            res = types[0];
+        }
+        else {
+            std::vector<int> block_lengths(types.size(), 1);
+            GHEX_CHECK_MPI_RESULT(MPI_Type_create_struct(types.size(), block_lengths.data(), displacements.data(),
+                types.data(), &res));
+            for (auto& t : types) {
+                GHEX_CHECK_MPI_RESULT(MPI_Type_free(&t));
+            }
+        }
+        GHEX_CHECK_MPI_RESULT(MPI_Type_commit(&res));
+        GHEX_CHECK_MPI_RESULT(MPI_Type_free(&value_type_mpi));
+        return res;
+    }
+
     template<typename IterationSpace>
     pack_iteration_space make_pack_is(const IterationSpace& is, T* buffer, size_type size) {
         return {make_buffer_desc<typename base::template buffer_descriptor<T*>>(is,buffer,size),
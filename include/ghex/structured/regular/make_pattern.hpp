@@ -76,7 +76,7 @@ make_staged_pattern(
     using extended_domain_id_type   = typename pattern_type::extended_domain_id_type;
     //using h_gen_type = typename detail::domain_traits<DomainRange>::halo_gen_type;
 
-    auto comm = tl::mpi::setup_communicator(context.mpi_comm());
+    auto comm = context.get_setup_communicator();
     auto new_comm = context.get_serial_communicator();
     auto my_address = new_comm.address();
     //auto my_rank = comm.rank();
@@ -13,6 +13,15 @@
 
 #include "../common/utils.hpp"
 #include "../cuda_utils/stream.hpp"
+#include "../rma/locality.hpp"
+#ifdef GHEX_RMA_USE_CMA
+#include "../rma/cma/handle.hpp"
+#endif
+#include <cstring>
+#include <vector>
+#ifdef GHEX_USE_MPI_RMA
+#include "../rma/mpi/access_guard.hpp"
+#endif
 #include "./rma_range.hpp"
 
 namespace gridtools {
@@ -238,6 +247,174 @@ put(rma_range<SourceField>& s, rma_range<TargetField>& t, rma::locality loc
 #endif
 }
 
+#ifdef GHEX_RMA_USE_CMA
+// Put functions used when the target field lives in another process on the same node and is accessed
+// through cross memory attach: the target range refers to addresses in the other process, and all
+// chunks are written with batched process_vm_writev calls.
+
+template<typename SourceField, typename TargetField>
+inline std::enable_if_t<
+    cpu_to_cpu<SourceField,TargetField>::value>
+put_cma(rma_range<SourceField>& s, rma_range<TargetField>& t, pid_t pid
+#ifdef __CUDACC__
+    , cudaStream_t
+#endif
+)
+{
+    using sv_t = rma_range<SourceField>;
+    using coordinate = typename sv_t::coordinate;
+    static constexpr int skip = sv_t::fuse_components::value ? 2 : 1;
+    const std::size_t chunk_size = sv_t::fuse_components::value ?
+        s.m_chunk_size*s.m_field.num_components() : s.m_chunk_size;
+    rma::cma::writer w(pid);
+    gridtools::ghex::detail::for_loop<
+        sv_t::dimension::value,
+        sv_t::dimension::value,
+        typename sv_t::layout, skip>::
+    apply([&s,&t,&w,chunk_size](auto... c)
+    {
+        w.add(t.ptr(coordinate{c...}), s.ptr(coordinate{c...}), chunk_size);
+    },
+    s.m_begin, s.m_end);
+    w.flush();
+}
+
+template<typename SourceField, typename TargetField>
+inline std::enable_if_t<
+    gpu_to_cpu<SourceField,TargetField>::value>
+put_cma(rma_range<SourceField>& s, rma_range<TargetField>& t, pid_t pid
+#ifdef __CUDACC__
+    , cudaStream_t st
+#endif
+)
+{
+#ifdef __CUDACC__
+    // stage the chunks in host memory
+    using sv_t = rma_range<SourceField>;
+    using coordinate = typename sv_t::coordinate;
+    static thread_local std::vector<unsigned char> data;
+    data.resize(static_cast<std::size_t>(s.m_size)*s.m_chunk_size);
+    std::size_t offset = 0u;
+    gridtools::ghex::detail::for_loop<
+        sv_t::dimension::value,
+        sv_t::dimension::value,
+        typename sv_t::layout, 1>::
+    apply([&s,&st,&offset](auto... c)
+    {
+        GHEX_CHECK_CUDA_RESULT(cudaMemcpyAsync(data.data()+offset, s.ptr(coordinate{c...}), s.m_chunk_size,
+            cudaMemcpyDeviceToHost, st));
+        offset += s.m_chunk_size;
+    },
+    s.m_begin, s.m_end);
+    GHEX_CHECK_CUDA_RESULT(cudaStreamSynchronize(st));
+    rma::cma::writer w(pid);
+    offset = 0u;
+    gridtools::ghex::detail::for_loop<
+        sv_t::dimension::value,
+        sv_t::dimension::value,
+        typename sv_t::layout, 1>::
+    apply([&s,&t,&w,&offset](auto... c)
+    {
+        w.add(t.ptr(coordinate{c...}), data.data()+offset, s.m_chunk_size);
+        offset += s.m_chunk_size;
+    },
+    s.m_begin, s.m_end);
+    w.flush();
+#endif
+}
+
+// targets on the gpu are accessed through cuda ipc handles: the remote handle never reports a process id
+// for them, hence this overload only exists to make the dispatch compile and must not be reached
+template<typename SourceField, typename TargetField>
+inline std::enable_if_t<
+    std::is_same<typename TargetField::arch_type, gridtools::ghex::gpu>::value>
+put_cma(rma_range<SourceField>&, rma_range<TargetField>&, pid_t
+#ifdef __CUDACC__
+    , cudaStream_t
+#endif
+)
+{
+    throw std::logic_error("gpu targets cannot be accessed through cross memory attach");
+}
+#endif /* GHEX_RMA_USE_CMA */
+
+// Functions used when the target field is not directly accessible, i.e. it lives on a remote rank or its
+// memory is not exposed to other processes on the node: the source range is packed into a contiguous
+// buffer which is transferred to the target, either into a staging buffer with MPI one-sided
+// communication or as a message. The target unpacks the data into the field once it has regained
+// access. Only cpu fields are exchanged this way.
+
+template<typename SourceField, typename TargetField>
+inline std::enable_if_t<
+    cpu_to_cpu<SourceField,TargetField>::value>
+pack(rma_range<SourceField>& s, rma_range<TargetField>&, std::vector<unsigned char>& buffer)
+{
+    using sv_t = rma_range<SourceField>;
+    using coordinate = typename sv_t::coordinate;
+    static constexpr int skip = sv_t::fuse_components::value ? 2 : 1;
+    const std::size_t chunk_size = sv_t::fuse_components::value ?
+        s.m_chunk_size*s.m_field.num_components() : s.m_chunk_size;
+    buffer.resize(static_cast<std::size_t>(s.m_num_elements)*sizeof(typename sv_t::value_type));
+    std::size_t offset = 0u;
+    gridtools::ghex::detail::for_loop<
+        sv_t::dimension::value,
+        sv_t::dimension::value,
+        typename sv_t::layout, skip>::
+    apply([&s,&buffer,&offset,chunk_size](auto... c)
+    {
+        std::memcpy(buffer.data()+offset, s.ptr(coordinate{c...}), chunk_size);
+        offset += chunk_size;
+    },
+    s.m_begin, s.m_end);
+}
+
+// gpu fields are always accessible (cuda ipc) or exchanged through the communication object
+template<typename SourceField, typename TargetField>
+inline std::enable_if_t<
+    !cpu_to_cpu<SourceField,TargetField>::value>
+pack(rma_range<SourceField>&, rma_range<TargetField>&, std::vector<unsigned char>& buffer)
+{
+    buffer.clear();
+}
+
+template<typename Field>
+inline std::enable_if_t<
+    std::is_same<typename Field::arch_type, gridtools::ghex::cpu>::value>
+unpack(rma_range<Field>& t, const unsigned char* staging)
+{
+    using tv_t = rma_range<Field>;
+    using coordinate = typename tv_t::coordinate;
+    static constexpr int skip = tv_t::fuse_components::value ? 2 : 1;
+    const std::size_t chunk_size = tv_t::fuse_components::value ?
+        t.m_chunk_size*t.m_field.num_components() : t.m_chunk_size;
+    gridtools::ghex::detail::for_loop<
+        tv_t::dimension::value,
+        tv_t::dimension::value,
+        typename tv_t::layout, skip>::
+    apply([&t,&staging,chunk_size](auto... c)
+    {
+        std::memcpy(t.ptr(coordinate{c...}), staging, chunk_size);
+        staging += chunk_size;
+    },
+    t.m_begin, t.m_end);
+}
+
+template<typename Field>
+inline std::enable_if_t<
+    !std::is_same<typename Field::arch_type, gridtools::ghex::cpu>::value>
+unpack(rma_range<Field>&, const unsigned char*)
+{}
+
+#ifdef GHEX_USE_MPI_RMA
+template<typename SourceField, typename TargetField>
+inline void put_mpi(rma_range<SourceField>& s, rma_range<TargetField>& t, rma::mpi::remote_access_guard& g,
+    std::vector<unsigned char>& buffer)
+{
+    pack(s, t, buffer);
+    if (!buffer.empty()) g.put(buffer.data(), buffer.size());
+}
+#endif /* GHEX_USE_MPI_RMA */
+
 } // namespace structured
 } // namespace ghex
 } // namespace gridtools
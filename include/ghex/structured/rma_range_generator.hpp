@@ -31,6 +31,19 @@ struct rma_range_generator
     // the range type to be used for this field
     using range_type = rma_range<Field>;
 
+    // whether the halo data is transferred as a message: targets which are accessed as if they were
+    // remote use MPI one-sided communication if the communicator exposes a window
+    template<typename Communicator>
+    static bool uses_messages(const Communicator& comm, rma::locality loc)
+    {
+#ifdef GHEX_USE_MPI_RMA
+        return loc == rma::locality::remote && !rma::mpi::get_window(comm);
+#else
+        (void)comm;
+        return loc == rma::locality::remote;
+#endif
+    }
+
     /** @brief This class represents the target range of a halo exchange operation. It is
      * referencing a local target field (the endpoint of the put) to which it has direct memory
      * access. During construction and send() member function, it serializes the target range and
@@ -38,6 +51,10 @@ struct rma_range_generator
      * It is also responsible for creating a synchronization point (access guard) which will be used
      * in RMA exchanges. The access guard, along with the rma handle of the field and the range,
      * will be serialized and sent to the remote partner.
+     * If the remote partner is accessed through MPI one-sided communication, the data is put into a
+     * staging buffer owned by the access guard, which is unpacked when the target epoch starts. If the
+     * target field cannot be accessed by an on-node partner (see rma::access_locality) and no MPI window
+     * is available, the data is received as a message into a staging buffer instead.
      * @tparam RangeFactory the factory type which knows about all possible range types
      * @tparam Communicator the communicator type */
     template<typename RangeFactory, typename Communicator>
@@ -47,27 +64,40 @@ struct rma_range_generator
         using tag_type = typename Communicator::tag_type;
 
         Communicator m_comm;
-        rma::local_access_guard m_local_guard;
         range_type m_local_range;
+        rma::locality m_loc;
+        rma::local_access_guard m_local_guard;
         rank_type m_dst;
         tag_type m_tag;
         typename Communicator::template future<void> m_request;
         std::vector<unsigned char> m_archive;
         bool m_on_gpu = std::is_same<typename Field::arch_type, gridtools::ghex::gpu>::value;
         rma::local_event m_event;
+        bool m_messages; // data is received as a message
+        std::vector<unsigned char> m_staging;
 
         template<typename IterationSpace>
         target_range(const Communicator& comm, const Field& f, rma::info field_info,
             const IterationSpace& is, rank_type dst, tag_type tag, rma::locality loc)
         : m_comm{comm}
-        , m_local_guard{loc, rma::access_mode::remote}
         , m_local_range{f, is.local().first(), is.local().last()-is.local().first()+1}
+        , m_loc{rma::access_locality(loc, field_info)}
+#ifdef GHEX_USE_MPI_RMA
+        // remote targets receive the data in a staging buffer
+        , m_local_guard{m_loc, rma::access_mode::remote, rma::mpi::get_window(comm),
+            m_local_range.m_num_elements*sizeof(typename range_type::value_type)}
+#else
+        , m_local_guard{m_loc, rma::access_mode::remote}
+#endif
         , m_dst{dst}
         , m_tag{tag}
-        , m_event{m_on_gpu, loc}
+        , m_event{m_on_gpu, m_loc}
+        , m_messages{uses_messages(comm, m_loc)}
         {
             m_archive = RangeFactory::serialize(field_info, m_local_guard, m_event, m_local_range);
             m_request = m_comm.send(m_archive, m_dst, m_tag);
+            if (m_messages)
+                m_staging.resize(m_local_range.m_num_elements*sizeof(typename range_type::value_type));
         }
 
         target_range(const target_range&) = delete;
@@ -81,17 +111,21 @@ struct rma_range_generator
 
         void start_target_epoch()
         {
+            if (m_messages) m_request.wait();
             m_local_guard.start_target_epoch();
             // wait for event
             m_event.wait();
+            unpack();
         }
 
         bool try_start_target_epoch()
         {
+            if (m_messages && !m_request.test()) return false;
             if (m_local_guard.try_start_target_epoch())
             {
                 // wait for event
                 m_event.wait();
+                unpack();
                 return true;
             }
             else return false;
@@ -100,6 +134,19 @@ struct rma_range_generator
         void end_target_epoch()
         {
             m_local_guard.end_target_epoch();
+            if (m_messages) m_request = m_comm.recv(m_staging, m_dst, m_tag);
+        }
+
+    private:
+        // copy the data from the staging buffer to the field
+        void unpack()
+        {
+            if (m_messages)
+                ::gridtools::ghex::structured::unpack(m_local_range, m_staging.data());
+#ifdef GHEX_USE_MPI_RMA
+            else if (m_local_guard.get_locality() == rma::locality::remote)
+                ::gridtools::ghex::structured::unpack(m_local_range, m_local_guard.m_mpi_guard.staging());
+#endif
         }
     };
 
@@ -127,6 +174,9 @@ struct rma_range_generator
         bool m_on_gpu;
         typename Communicator::template future<void> m_request;
         std::vector<unsigned char> m_archive;
+        std::vector<unsigned char> m_buffer; // packed data for targets which are not directly accessible
+        bool m_messages = false; // data is sent as a message
+        bool m_sending = false;
 
         template<typename IterationSpace>
         source_range(const Communicator& comm, const Field& f,
@@ -148,21 +198,28 @@ struct rma_range_generator
         {
             m_request.wait();
             // creates a traget range
-            m_remote_range = RangeFactory::deserialize(m_archive.data(), m_src, m_on_gpu);
+            m_remote_range = RangeFactory::deserialize(m_archive.data(), m_src, m_on_gpu
+#ifdef GHEX_USE_MPI_RMA
+                , rma::mpi::get_window(m_comm)
+#endif
+            );
             RangeFactory::call_back_with_type(m_remote_range, [this] (auto& r)
             {
                 init(r, m_remote_range);
             });
+            m_messages = uses_messages(m_comm, m_remote_range.m_loc);
             m_remote_range.end_source_epoch();
         }
 
         void start_source_epoch()
         {
+            complete_send();
             m_remote_range.start_source_epoch();
         }
 
         bool try_start_source_epoch()
         {
+            complete_send();
             return m_remote_range.try_start_source_epoch();
         }
 
@@ -183,6 +240,33 @@ struct rma_range_generator
         template<typename TargetRange>
         void put(TargetRange& tr)
         {
+            if (m_messages)
+            {
+                ::gridtools::ghex::structured::pack(m_local_range, tr, m_buffer);
+                m_request = m_comm.send(m_buffer, m_src, m_tag);
+                m_sending = true;
+                return;
+            }
+#ifdef GHEX_USE_MPI_RMA
+            if (m_remote_range.m_loc == rma::locality::remote)
+            {
+                ::gridtools::ghex::structured::put_mpi(m_local_range, tr, m_remote_range.m_guard.m_mpi_guard,
+                    m_buffer);
+                return;
+            }
+#endif
+#ifdef GHEX_RMA_USE_CMA
+            const auto pid = m_remote_range.m_handle.cma_pid(m_remote_range.m_loc);
+            if (pid >= 0)
+            {
+                ::gridtools::ghex::structured::put_cma(m_local_range, tr, pid
+#ifdef __CUDACC__
+                    , m_remote_range.m_event.get_stream()
+#endif
+                );
+                return;
+            }
+#endif
             ::gridtools::ghex::structured::put(m_local_range, tr, m_remote_range.m_loc
 #ifdef __CUDACC__
                 , m_remote_range.m_event.get_stream()
@@ -191,6 +275,16 @@ struct rma_range_generator
         }
 
     private:
+        // Wait for the message of the previous exchange, whose buffer is reused. This does not block
+        // for long since the target has posted the receive in the previous exchange already. Messages
+        // to the same target with the same tag are thus sent in the order of the ranges, in which the
+        // target posts its receives.
+        void complete_send()
+        {
+            if (m_sending) m_request.wait();
+            m_sending = false;
+        }
+
         template<typename TargetRange>
         void init(TargetRange& tr, rma::range& r)
         {
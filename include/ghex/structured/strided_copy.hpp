@@ -0,0 +1,182 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_STRUCTURED_STRIDED_COPY_HPP
+#define INCLUDED_GHEX_STRUCTURED_STRIDED_COPY_HPP
+
+#include <cstring>
+#include <cstddef>
+#include <climits>
+#include <type_traits>
+#include <utility>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace gridtools {
+namespace ghex {
+namespace structured {
+namespace detail {
+
+/** @brief vectorized kernels for copying a strided column (lines of length 1) to/from contiguous memory.
+  * The primary template does not vectorize and reports 0 processed elements.
+  * @tparam Size size of the value type in bytes */
+template<std::size_t Size>
+struct column_copy {
+    static std::size_t gather(char*, const char*, std::ptrdiff_t, std::size_t) noexcept { return 0u; }
+    static std::size_t scatter(char*, std::ptrdiff_t, const char*, std::size_t) noexcept { return 0u; }
+};
+
+#if defined(__AVX512F__)
+template<>
+struct column_copy<4> {
+    // gathers n values at byte distance src_stride from src into contiguous dst
+    static std::size_t gather(char* dst, const char* src, std::ptrdiff_t src_stride, std::size_t n) noexcept {
+        if (src_stride > INT_MAX/15 || src_stride < INT_MIN/15) return 0u;
+        const int s = (int)src_stride;
+        const __m512i idx = _mm512_set_epi32(15*s,14*s,13*s,12*s,11*s,10*s,9*s,8*s,7*s,6*s,5*s,4*s,3*s,2*s,s,0);
+        std::size_t i = 0;
+        for (; i+16<=n; i+=16, dst+=64, src+=16*src_stride)
+            _mm512_storeu_si512((void*)dst, _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, idx, (const void*)src, 1));
+        return i;
+    }
+    // scatters n contiguous values from src into dst at byte distance dst_stride
+    static std::size_t scatter(char* dst, std::ptrdiff_t dst_stride, const char* src, std::size_t n) noexcept {
+        if (dst_stride > INT_MAX/15 || dst_stride < INT_MIN/15) return 0u;
+        const int s = (int)dst_stride;
+        const __m512i idx = _mm512_set_epi32(15*s,14*s,13*s,12*s,11*s,10*s,9*s,8*s,7*s,6*s,5*s,4*s,3*s,2*s,s,0);
+        std::size_t i = 0;
+        for (; i+16<=n; i+=16, src+=64, dst+=16*dst_stride)
+            _mm512_i32scatter_epi32((void*)dst, idx, _mm512_loadu_si512((const void*)src), 1);
+        return i;
+    }
+};
+
+template<>
+struct column_copy<8> {
+    static std::size_t gather(char* dst, const char* src, std::ptrdiff_t src_stride, std::size_t n) noexcept {
+        const long long s = src_stride;
+        const __m512i idx = _mm512_set_epi64(7*s,6*s,5*s,4*s,3*s,2*s,s,0);
+        std::size_t i = 0;
+        for (; i+8<=n; i+=8, dst+=64, src+=8*src_stride)
+            _mm512_storeu_si512((void*)dst, _mm512_mask_i64gather_epi64(_mm512_setzero_si512(), 0xFF, idx, (const void*)src, 1));
+        return i;
+    }
+    static std::size_t scatter(char* dst, std::ptrdiff_t dst_stride, const char* src, std::size_t n) noexcept {
+        const long long s = dst_stride;
+        const __m512i idx = _mm512_set_epi64(7*s,6*s,5*s,4*s,3*s,2*s,s,0);
+        std::size_t i = 0;
+        for (; i+8<=n; i+=8, src+=64, dst+=8*dst_stride)
+            _mm512_i64scatter_epi64((void*)dst, idx, _mm512_loadu_si512((const void*)src), 1);
+        return i;
+    }
+};
+#elif defined(__AVX2__)
+// AVX2 has no scatter instructions: only the gather (pack) direction is vectorized
+template<>
+struct column_copy<4> {
+    static std::size_t gather(char* dst, const char* src, std::ptrdiff_t src_stride, std::size_t n) noexcept {
+        if (src_stride > INT_MAX/7 || src_stride < INT_MIN/7) return 0u;
+        const int s = (int)src_stride;
+        const __m256i idx = _mm256_set_epi32(7*s,6*s,5*s,4*s,3*s,2*s,s,0);
+        std::size_t i = 0;
+        for (; i+8<=n; i+=8, dst+=32, src+=8*src_stride)
+            _mm256_storeu_si256((__m256i*)dst, _mm256_i32gather_epi32((const int*)src, idx, 1));
+        return i;
+    }
+    static std::size_t scatter(char*, std::ptrdiff_t, const char*, std::size_t) noexcept { return 0u; }
+};
+
+template<>
+struct column_copy<8> {
+    static std::size_t gather(char* dst, const char* src, std::ptrdiff_t src_stride, std::size_t n) noexcept {
+        const long long s = src_stride;
+        const __m256i idx = _mm256_set_epi64x(3*s,2*s,s,0);
+        std::size_t i = 0;
+        for (; i+4<=n; i+=4, dst+=32, src+=4*src_stride)
+            _mm256_storeu_si256((__m256i*)dst, _mm256_i64gather_epi64((const long long*)src, idx, 1));
+        return i;
+    }
+    static std::size_t scatter(char*, std::ptrdiff_t, const char*, std::size_t) noexcept { return 0u; }
+};
+#endif
+
+// copies n lines of compile-time length N
+template<typename T, std::size_t N>
+void copy_lines(char* dst, std::ptrdiff_t dst_stride, const char* src, std::ptrdiff_t src_stride, std::size_t n) noexcept {
+    for (std::size_t i=0; i<n; ++i, dst+=dst_stride, src+=src_stride)
+        std::memcpy(dst, src, N*sizeof(T));
+}
+
+template<typename T, std::size_t... Ns>
+void copy_short_lines(char* dst, std::ptrdiff_t dst_stride, const char* src, std::ptrdiff_t src_stride,
+    std::size_t len, std::size_t n, std::index_sequence<Ns...>) noexcept {
+    using fn_type = void(*)(char*, std::ptrdiff_t, const char*, std::ptrdiff_t, std::size_t);
+    static constexpr fn_type table[] = {&copy_lines<T,Ns+1>...};
+    table[len-1](dst, dst_stride, src, src_stride, n);
+}
+
+/** @brief maximum line length (in elements) for which specialized fixed-size copies are generated */
+template<typename T>
+struct short_line_length : std::integral_constant<std::size_t, (sizeof(T) < 64u ? 64u/sizeof(T) : 1u)> {};
+
+/** @brief selects the column kernel for a value type: vectorized for trivially copyable 4 and 8 byte types */
+template<typename T>
+using column_copy_t = column_copy<(std::is_trivially_copyable<T>::value && alignof(T)==sizeof(T)) ? sizeof(T) : 0u>;
+
+/** @brief copy a 2-dimensional strided region of n lines of len elements each.
+  * Fully contiguous regions are copied at once, lines of length 1 which are contiguous at the destination
+  * (source) are gathered (scattered) with vector instructions where available, short lines use
+  * fixed-size copies and long lines fall back to one memcpy per line.
+  * @tparam T value type
+  * @param dst destination pointer
+  * @param dst_stride distance between consecutive lines at the destination in bytes
+  * @param src source pointer
+  * @param src_stride distance between consecutive lines at the source in bytes
+  * @param len number of elements per line
+  * @param n number of lines */
+template<typename T>
+inline void strided_copy(T* dst, std::ptrdiff_t dst_stride, const T* src, std::ptrdiff_t src_stride,
+    std::size_t len, std::size_t n) noexcept {
+    if (n==0u || len==0u) return;
+    char* d = reinterpret_cast<char*>(dst);
+    const char* s = reinterpret_cast<const char*>(src);
+    const std::ptrdiff_t line_bytes = len*sizeof(T);
+    if (n==1u || (dst_stride==line_bytes && src_stride==line_bytes)) {
+        std::memcpy(d, s, n*line_bytes);
+        return;
+    }
+    if (len==1u) {
+        std::size_t i = 0u;
+        if (dst_stride==(std::ptrdiff_t)sizeof(T))
+            i = column_copy_t<T>::gather(d, s, src_stride, n);
+        else if (src_stride==(std::ptrdiff_t)sizeof(T))
+            i = column_copy_t<T>::scatter(d, dst_stride, s, n);
+        d += i*dst_stride;
+        s += i*src_stride;
+        for (; i<n; ++i, d+=dst_stride, s+=src_stride)
+            std::memcpy(d, s, sizeof(T));
+        return;
+    }
+    if (len <= short_line_length<T>::value) {
+        copy_short_lines<T>(d, dst_stride, s, src_stride, len, n,
+            std::make_index_sequence<short_line_length<T>::value>{});
+        return;
+    }
+    for (std::size_t i=0; i<n; ++i, d+=dst_stride, s+=src_stride)
+        std::memcpy(d, s, line_bytes);
+}
+
+} // namespace detail
+} // namespace structured
+} // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_STRUCTURED_STRIDED_COPY_HPP */
@@ -12,8 +12,15 @@
 #define INCLUDED_GHEX_TL_CALLBACK_UTILS_HPP
 
 #include <boost/callable_traits.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 /** @brief checks the arguments of callback function object */
 #define GHEX_CHECK_CALLBACK_F(MESSAGE_TYPE, RANK_TYPE, TAG_TYPE)                              \
@@ -35,26 +42,13 @@ namespace gridtools {
         namespace tl {
             namespace cb {
 
-                /** @brief shared request state for completion handlers returned by callback based sends/recvs. */
-                struct request_state {
-                    // volatile is needed to prevent the compiler
-                    // from optimizing away the check of this member
-                    volatile bool m_ready = false;
-                    unsigned int m_index = 0;
-                    request_state() = default;
-                    request_state(bool r) noexcept : m_ready{r} {}
-                    request_state(bool r, unsigned int i) noexcept : m_ready{r}, m_index{i} {}
-                    bool is_ready() const noexcept { return m_ready; }
-                    int queue_index() const noexcept { return m_index; }
-                };
-
-                /** @brief simple request with shared state as member returned by callback based send/recvs. */
+                /** @brief generation-counted handle to a slot of a callback_queue. The handle is ready once the
+                  * slot's generation has moved on, i.e. once the callback has been invoked or cancelled. */
                 struct request
                 {
-                    std::shared_ptr<request_state> m_request_state;
-                    bool is_ready() const noexcept { return m_request_state->is_ready(); }
-                    void reset() { m_request_state.reset(); }
-                    int queue_index() const noexcept { return m_request_state->queue_index(); }
+                    std::uint32_t m_index = 0u;
+                    std::uint32_t m_generation = 0u;
+                    int queue_index() const noexcept { return m_index; }
                 };
 
                 /** @brief simple wrapper around an l-value reference message (stores pointer and size)
@@ -71,17 +65,23 @@ namespace gridtools {
                 };
 
                 /** @brief type erased message capable of holding any message. Uses optimized initialization for  
-                  * ref_messages and std::shared_ptr pointing to messages. */
+                  * ref_messages and std::shared_ptr pointing to messages. Messages which are moved inside are stored
+                  * in place if they are small enough (this holds for message_buffer and shared_message_buffer with
+                  * the allocators used in this library), and on the heap otherwise. */
                 struct any_message
                 {
                     using value_type = unsigned char;
 
+                    // size of the in-place storage for moved-in messages
+                    static constexpr std::size_t inline_size = 64;
+
                     // common interface to a message
                     struct iface
                     {
                         virtual unsigned char* data() noexcept = 0;
                         virtual const unsigned char* data() const noexcept = 0;
                         virtual std::size_t size() const noexcept = 0;
+                        virtual iface* move_to(void* storage) noexcept = 0;
                         virtual ~iface() {}
                     };
 
@@ -96,23 +96,39 @@ namespace gridtools {
                         unsigned char* data() noexcept override { return reinterpret_cast<unsigned char*>(m_message.data()); }
                         const unsigned char* data() const noexcept override { return reinterpret_cast<const unsigned char*>(m_message.data()); }
                         std::size_t size() const noexcept override { return sizeof(value_type)*m_message.size(); }
+                        iface* move_to(void* storage) noexcept override { return new(storage) holder(std::move(m_message)); }
                     };
 
+                    /** @brief whether a message of type Message is stored in place */
+                    template<class Message>
+                    using is_inline = std::integral_constant<bool,
+                        sizeof(holder<Message>) <= inline_size &&
+                        alignof(holder<Message>) <= alignof(std::max_align_t) &&
+                        std::is_nothrow_move_constructible<Message>::value>;
+
                     unsigned char* __restrict m_data = nullptr;
-                    std::size_t m_size;
-                    std::unique_ptr<iface> m_ptr;
+                    std::size_t m_size = 0u;
+                    iface* m_ptr = nullptr;
+                    bool m_inline = false;
                     std::shared_ptr<char> m_ptr2;
+                    std::aligned_storage_t<inline_size, alignof(std::max_align_t)> m_storage;
+
+                    /** @brief construct an empty message */
+                    any_message() noexcept = default;
 
                     /** @brief Construct from an r-value: moves the message inside the type-erased structure.
                       * Requires the message not to reallocate during the move. Note, that this operation will allocate
-                      * storage on the heap for the holder structure of the message.
+                      * storage on the heap for the holder structure of the message if the message is not stored in
+                      * place.
                       * @tparam Message a message type
                       * @param m a message */
-                    template<class Message>
+                    template<class Message, typename std::enable_if<
+                        !std::is_same<std::decay_t<Message>, any_message>::value, int>::type = 0>
                     any_message(Message&& m)
                     : m_data{reinterpret_cast<unsigned char*>(m.data())}
                     , m_size{m.size()*sizeof(typename Message::value_type)}
-                    , m_ptr{std::make_unique<holder<Message>>(std::move(m))}
+                    , m_ptr{make_holder(std::move(m), is_inline<Message>{})}
+                    , m_inline{is_inline<Message>::value}
                     {}
 
                     /** @brief Construct from a reference: copies the pointer to the data and size of the data.
@@ -137,15 +153,218 @@ namespace gridtools {
                     , m_ptr2(sm,reinterpret_cast<char*>(sm.get()))
                     {}
 
-                    any_message(any_message&&) = default;
-                    any_message& operator=(any_message&&) = default;
+                    any_message(any_message&& other) noexcept
+                    : m_data{other.m_data}
+                    , m_size{other.m_size}
+                    , m_ptr2{std::move(other.m_ptr2)}
+                    {
+                        take(other);
+                    }
+
+                    any_message& operator=(any_message&& other) noexcept
+                    {
+                        if (this == &other) return *this;
+                        destroy();
+                        m_data = other.m_data;
+                        m_size = other.m_size;
+                        m_ptr2 = std::move(other.m_ptr2);
+                        take(other);
+                        return *this;
+                    }
+
+                    ~any_message() { destroy(); }
 
                     unsigned char* data() noexcept { return m_data;}
                     const unsigned char* data() const noexcept { return m_data; }
                     std::size_t size() const noexcept { return m_size; }
+
+                private: // implementation
+                    template<class Message>
+                    iface* make_holder(Message&& m, std::true_type)
+                    {
+                        return new(&m_storage) holder<Message>(std::move(m));
+                    }
+
+                    template<class Message>
+                    iface* make_holder(Message&& m, std::false_type)
+                    {
+                        return new holder<Message>(std::move(m));
+                    }
+
+                    void take(any_message& other) noexcept
+                    {
+                        m_inline = other.m_inline;
+                        if (other.m_inline)
+                        {
+                            m_ptr = other.m_ptr->move_to(&m_storage);
+                            other.m_ptr->~iface();
+                        }
+                        else
+                        {
+                            m_ptr = other.m_ptr;
+                        }
+                        other.m_ptr = nullptr;
+                        other.m_inline = false;
+                        other.m_data = nullptr;
+                        other.m_size = 0u;
+                    }
+
+                    void destroy() noexcept
+                    {
+                        if (!m_ptr) return;
+                        if (m_inline) m_ptr->~iface();
+                        else delete m_ptr;
+                        m_ptr = nullptr;
+                    }
                 };
 
-                /** @brief A container for storing callbacks and progressing them.
+                template<typename Signature>
+                class small_function;
+
+                /** @brief move-only type erased function object which stores small callables in place and only
+                  * allocates on the heap for callables larger than inline_size.
+                  * @tparam R return type
+                  * @tparam Args argument types */
+                template<typename R, typename... Args>
+                class small_function<R(Args...)>
+                {
+                public: // static constants
+                    // size of the in-place storage for callables
+                    static constexpr std::size_t inline_size = 48;
+
+                private: // member types
+                    enum class operation { move, destroy };
+                    using storage_type = std::aligned_storage_t<inline_size, alignof(std::max_align_t)>;
+                    using invoke_type  = R(*)(void*, Args&&...);
+                    using manage_type  = void(*)(operation, void*, void*);
+
+                    template<typename F>
+                    using is_inline = std::integral_constant<bool,
+                        sizeof(F) <= inline_size &&
+                        alignof(F) <= alignof(std::max_align_t) &&
+                        std::is_nothrow_move_constructible<F>::value>;
+
+                    // callable stored in place
+                    template<typename F>
+                    struct inline_ops
+                    {
+                        static R invoke(void* s, Args&&... args)
+                        {
+                            return (*static_cast<F*>(s))(std::forward<Args>(args)...);
+                        }
+                        static void manage(operation op, void* dst, void* src)
+                        {
+                            if (op == operation::move) new(dst) F(std::move(*static_cast<F*>(src)));
+                            static_cast<F*>(src)->~F();
+                        }
+                    };
+
+                    // callable stored on the heap (the storage holds a pointer)
+                    template<typename F>
+                    struct heap_ops
+                    {
+                        static R invoke(void* s, Args&&... args)
+                        {
+                            return (**static_cast<F**>(s))(std::forward<Args>(args)...);
+                        }
+                        static void manage(operation op, void* dst, void* src)
+                        {
+                            if (op == operation::move) *static_cast<F**>(dst) = *static_cast<F**>(src);
+                            else delete *static_cast<F**>(src);
+                        }
+                    };
+
+                private: // members
+                    storage_type m_storage;
+                    invoke_type  m_invoke = nullptr;
+                    manage_type  m_manage = nullptr;
+
+                public: // ctors
+                    small_function() noexcept = default;
+
+                    template<typename F, typename std::enable_if<
+                        !std::is_same<std::decay_t<F>, small_function>::value, int>::type = 0>
+                    small_function(F&& f)
+                    {
+                        assign(std::forward<F>(f));
+                    }
+
+                    small_function(small_function&& other) noexcept
+                    {
+                        take(other);
+                    }
+
+                    small_function& operator=(small_function&& other) noexcept
+                    {
+                        if (this == &other) return *this;
+                        reset();
+                        take(other);
+                        return *this;
+                    }
+
+                    small_function(const small_function&) = delete;
+                    small_function& operator=(const small_function&) = delete;
+
+                    ~small_function() { reset(); }
+
+                public: // member functions
+                    /** @brief replace the stored callable
+                      * @tparam F callable type
+                      * @param f callable */
+                    template<typename F>
+                    void assign(F&& f)
+                    {
+                        using func_type = std::decay_t<F>;
+                        reset();
+                        construct<func_type>(std::forward<F>(f), is_inline<func_type>{});
+                    }
+
+                    void reset() noexcept
+                    {
+                        if (m_manage) m_manage(operation::destroy, nullptr, &m_storage);
+                        m_invoke = nullptr;
+                        m_manage = nullptr;
+                    }
+
+                    explicit operator bool() const noexcept { return m_invoke != nullptr; }
+
+                    R operator()(Args... args)
+                    {
+                        return m_invoke(&m_storage, std::forward<Args>(args)...);
+                    }
+
+                private: // implementation
+                    template<typename F, typename G>
+                    void construct(G&& g, std::true_type)
+                    {
+                        new(&m_storage) F(std::forward<G>(g));
+                        m_invoke = &inline_ops<F>::invoke;
+                        m_manage = &inline_ops<F>::manage;
+                    }
+
+                    template<typename F, typename G>
+                    void construct(G&& g, std::false_type)
+                    {
+                        *reinterpret_cast<F**>(&m_storage) = new F(std::forward<G>(g));
+                        m_invoke = &heap_ops<F>::invoke;
+                        m_manage = &heap_ops<F>::manage;
+                    }
+
+                    void take(small_function& other) noexcept
+                    {
+                        if (!other.m_manage) return;
+                        other.m_manage(operation::move, &m_storage, &other.m_storage);
+                        m_invoke = std::exchange(other.m_invoke, nullptr);
+                        m_manage = std::exchange(other.m_manage, nullptr);
+                    }
+                };
+
+                /** @brief A container for storing callbacks and progressing them. Pending operations live in a slab of
+                  * request slots which are recycled, hence enqueueing does not allocate once the slab has grown to the
+                  * number of concurrently pending operations (given that callback and message are stored in place).
+                  * Completion handles refer to a slot by index and generation. The raw handles of the pending
+                  * operations are kept in a contiguous array in sync with the queue, so that all completed operations
+                  * are found with a single call to FutureType::test_some.
                   * @tparam FutureType a future type
                   * @tparam RankType the rank type (integer)
                   * @tparam TagType the tag type (integer) */
@@ -156,28 +375,41 @@ namespace gridtools {
                     using future_type = FutureType;
                     using rank_type = RankType;
                     using tag_type = TagType;
-                    using cb_type = std::function<void(message_type, rank_type, tag_type)>;
+                    using cb_type = small_function<void(message_type, rank_type, tag_type)>;
+                    using index_type = std::uint32_t;
+                    using raw_handle_type = typename future_type::raw_handle_type;
 
-                    // internal element which is stored in the queue
+                    // internal element which is stored in the slab
                     struct element_type {
                         message_type m_msg;
                         rank_type m_rank;
                         tag_type m_tag;
                         cb_type m_cb;
                         future_type m_future;
-                        request m_request;
+                        index_type m_generation = 0u;
+                        index_type m_position = 0u; // position in the list of pending elements
                     };
 
-                    using queue_type = std::vector<element_type>;
+                    // a deque does not move its elements when growing, so that callbacks may enqueue new elements
+                    using slab_type = std::deque<element_type>;
 
                   private: // members
-                    queue_type m_queue;
+                    slab_type m_slots;
+                    std::vector<index_type> m_free;
+                    std::vector<index_type> m_pending;
+                    std::vector<raw_handle_type> m_handles; // raw handles of the pending elements
+                    std::vector<int> m_indices;             // scratch space for test_some
 
                   public:
                     int m_progressed_cancels = 0;
 
                   public: // ctors
-                    callback_queue() { m_queue.reserve(256); }
+                    callback_queue()
+                    {
+                        m_free.reserve(256);
+                        m_pending.reserve(256);
+                        m_handles.reserve(256);
+                    }
 
                   public: // member functions
                     /** @brief Add a callback to the queue and receive a completion handle (request).
@@ -190,58 +422,94 @@ namespace gridtools {
                       * @return returns a completion handle */
                     template<typename Callback>
                     request enqueue(message_type&& msg, rank_type rank, tag_type tag, future_type&& fut, Callback&& cb) {
-                        request m_req{std::make_shared<request_state>(false,m_queue.size())};
-                        m_queue.push_back(element_type{std::move(msg), rank, tag, std::forward<Callback>(cb), std::move(fut),
-                                             m_req});
-                        return m_req;
+                        index_type i;
+                        if (m_free.empty()) {
+                            i = m_slots.size();
+                            m_slots.emplace_back();
+                        }
+                        else {
+                            i = m_free.back();
+                            m_free.pop_back();
+                        }
+                        auto& element = m_slots[i];
+                        element.m_msg = std::move(msg);
+                        element.m_rank = rank;
+                        element.m_tag = tag;
+                        element.m_cb.assign(std::forward<Callback>(cb));
+                        element.m_future = std::move(fut);
+                        element.m_position = m_pending.size();
+                        m_pending.push_back(i);
+                        m_handles.push_back(element.m_future.raw_handle());
+                        return {i, element.m_generation};
                     }
 
-                    auto size() const noexcept { return m_queue.size(); }
+                    auto size() const noexcept { return m_pending.size(); }
+
+                    /** @brief check whether the callback associated with a completion handle has been invoked or
+                      * cancelled */
+                    bool is_ready(const request& req) const noexcept {
+                        return m_slots[req.m_index].m_generation != req.m_generation;
+                    }
 
-                    /** @brief progress the queue and call the callbacks if the futures are ready. Note, that the order
-                      * of progression is not defined.
+                    /** @brief progress the queue and call the callbacks of all operations which have completed. Note,
+                      * that the order of progression is not defined. Operations enqueued by the callbacks are tested
+                      * during the next call.
                       * @return number of progressed elements */
                     int progress() {
-                        int completed = 0;
-                        while (true) {
-                            auto it = future_type::test_any(m_queue.begin(), m_queue.end(),
-                                [](auto& x) -> future_type& { return x.m_future; });
-                            if (it != m_queue.end()) {
-                                auto& element = *it;
-                                const std::size_t i = it-m_queue.begin();
-                                element.m_cb(std::move(element.m_msg), element.m_rank, element.m_tag);
-                                ++completed;
-                                element.m_request.m_request_state->m_ready = true;
-                                if (i + 1 < m_queue.size()) {
-                                    element = std::move(m_queue.back());
-                                    element.m_request.m_request_state->m_index = i;
-                                }
-                                m_queue.pop_back();
-                            }
-                            else
-                                break;
+                        // callbacks may progress the queue recursively
+                        auto indices = std::move(m_indices);
+                        indices.resize(m_handles.size());
+                        const int completed = future_type::test_some(m_handles.data(), m_handles.size(), indices.data());
+                        // translate positions into slots before the pending list is modified
+                        for (int k = 0; k < completed; ++k)
+                            indices[k] = m_pending[indices[k]];
+                        for (int k = 0; k < completed; ++k) {
+                            const index_type i = indices[k];
+                            remove_pending(i);
+                            // the slot stays reserved while the callback runs
+                            auto& element = m_slots[i];
+                            element.m_cb(std::move(element.m_msg), element.m_rank, element.m_tag);
+                            recycle(i);
                         }
+                        m_indices = std::move(indices);
                         return completed;
                     }
 
                     /** @brief Cancel a callback
-                      * @param index the queue index - access to this index is given through the request returned when
-                      * enqueing.
+                      * @param req the completion handle returned when enqueing.
                       * @return true if cancelling was successful */
-                    bool cancel(unsigned int index)
+                    bool cancel(const request& req)
                     {
-                        auto& element = m_queue[index];
+                        if (is_ready(req)) return false;
+                        auto& element = m_slots[req.m_index];
                         auto res = element.m_future.cancel();
+                        // cancelling may have freed the request
+                        m_handles[element.m_position] = element.m_future.raw_handle();
                         if (!res) return false;
-                        if (m_queue.size() > index+1)
-                        {
-                            element = std::move(m_queue.back());
-                            element.m_request.m_request_state->m_index = index;
-                        }
-                        m_queue.pop_back();
+                        remove_pending(req.m_index);
+                        recycle(req.m_index);
                         ++m_progressed_cancels;
                         return true;
                     }
+
+                  private: // implementation
+                    void remove_pending(index_type i) noexcept {
+                        const index_type pos = m_slots[i].m_position;
+                        const index_type last = m_pending.back();
+                        m_pending[pos] = last;
+                        m_handles[pos] = m_handles.back();
+                        m_slots[last].m_position = pos;
+                        m_pending.pop_back();
+                        m_handles.pop_back();
+                    }
+
+                    void recycle(index_type i) {
+                        auto& element = m_slots[i];
+                        element.m_cb.reset();
+                        element.m_msg = message_type{};
+                        ++element.m_generation;
+                        m_free.push_back(i);
+                    }
                 };
 
                 /** @brief a class to return the number of progressed callbacks */
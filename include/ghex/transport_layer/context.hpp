@@ -24,7 +24,7 @@ namespace gridtools {
 
             namespace detail {
 
-                static MPI_Comm clone_mpi_comm(MPI_Comm mpi_comm) {
+                inline MPI_Comm clone_mpi_comm(MPI_Comm mpi_comm) {
                     // clone the communicator first to be independent of user calls to the mpi runtime
                     MPI_Comm new_comm;
                     MPI_Comm_dup(mpi_comm, &new_comm);
@@ -83,9 +83,16 @@ namespace gridtools {
 
             public: // member functions
                 MPI_Comm mpi_comm() const noexcept { return m_mpi_comm.m; }
+                transport_context_type& get_transport_context() noexcept { return m_transport_context; }
                 int rank() const noexcept { return m_rank; }
                 int size() const noexcept { return m_size; }
 
+                /** @brief return the communicator used to set up patterns */
+                mpi::setup_communicator get_setup_communicator() const
+                {
+                    return {m_mpi_comm.m};
+                }
+
                 /** @brief return a per-rank communicator.
                   * This function is not thread-safe and should only be used in the serial part of the code. */
                 communicator_type get_serial_communicator()
@@ -99,6 +106,13 @@ namespace gridtools {
                 {
                     return m_transport_context.get_communicator();
                 }
+
+                /** @brief return the communicator bound to the per-thread resources of the thread with the given
+                  * index (only available if supported by the transport). */
+                communicator_type get_communicator(int thread_id)
+                {
+                    return m_transport_context.get_communicator(thread_id);
+                }
             };
 
         } // namespace tl
@@ -0,0 +1,111 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_TL_INPROC_COMMUNICATOR_STATE_HPP
+#define INCLUDED_GHEX_TL_INPROC_COMMUNICATOR_STATE_HPP
+
+#include "../callback_utils.hpp"
+#include "./future.hpp"
+
+namespace gridtools {
+
+    namespace ghex {
+
+        namespace tl {
+
+            namespace inproc {
+
+                /** @brief common data which is shared by all communicators of a logical rank: the world and the
+                 * rank. This class is thread safe.
+                 */
+                struct shared_communicator_state {
+                    using rank_type = int;
+                    using tag_type = int;
+
+                    world* m_world;
+                    rank_type m_rank;
+
+                    shared_communicator_state(world* w, rank_type r) noexcept
+                    : m_world{w}
+                    , m_rank{r}
+                    {}
+
+                    rank_type rank() const noexcept { return m_rank; }
+                    rank_type size() const noexcept { return m_world->size(); }
+                };
+
+                /** @brief communicator per-thread data.
+                 */
+                struct communicator_state {
+                    using shared_state_type = shared_communicator_state;
+                    using rank_type = typename shared_state_type::rank_type;
+                    using tag_type = typename shared_state_type::tag_type;
+                    template<typename T>
+                    using future = future_t<T>;
+                    using queue_type = ::gridtools::ghex::tl::cb::callback_queue<future<void>, rank_type, tag_type>;
+                    using progress_status = gridtools::ghex::tl::cb::progress_status;
+
+                    queue_type m_send_queue;
+                    queue_type m_recv_queue;
+                    int  m_progressed_sends = 0;
+                    int  m_progressed_recvs = 0;
+
+                    communicator_state() = default;
+
+                    progress_status progress() {
+                        m_progressed_sends += m_send_queue.progress();
+                        m_progressed_recvs += m_recv_queue.progress();
+                        return {
+                            std::exchange(m_progressed_sends,0),
+                            std::exchange(m_progressed_recvs,0),
+                            std::exchange(m_recv_queue.m_progressed_cancels,0)};
+                    }
+                };
+
+                /** @brief completion handle returned from callback based communications
+                 */
+                struct request_cb
+                {
+                    using queue_type      = typename communicator_state::queue_type;
+                    using message_type    = ::gridtools::ghex::tl::cb::any_message;
+                    using completion_type = ::gridtools::ghex::tl::cb::request;
+
+                    queue_type* m_queue = nullptr;
+                    completion_type m_completed;
+
+                    bool test()
+                    {
+                        if(!m_queue) return true;
+                        if (m_queue->is_ready(m_completed))
+                        {
+                            m_queue = nullptr;
+                            return true;
+                        }
+                        return false;
+                    }
+
+                    bool cancel()
+                    {
+                        if(!m_queue) return false;
+                        auto res = m_queue->cancel(m_completed);
+                        if (res) m_queue = nullptr;
+                        return res;
+                    }
+                };
+
+            } // namespace inproc
+
+        } // namespace tl
+
+    } // namespace ghex
+
+} //namespace gridtools
+
+#endif /* INCLUDED_GHEX_TL_INPROC_COMMUNICATOR_STATE_HPP */
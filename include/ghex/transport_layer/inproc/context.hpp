@@ -0,0 +1,174 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_TL_INPROC_CONTEXT_HPP
+#define INCLUDED_GHEX_TL_INPROC_CONTEXT_HPP
+
+#include <exception>
+#include <mutex>
+#include <thread>
+#include "../context.hpp"
+#include "./communicator.hpp"
+#include "./setup.hpp"
+#include "../communicator.hpp"
+
+namespace gridtools {
+    namespace ghex {
+        namespace tl {
+            namespace inproc {
+
+            struct transport_context
+            {
+                using tag = inproc_tag;
+                using communicator_type = tl::communicator<inproc::communicator>;
+                using shared_state_type = typename communicator_type::shared_state_type;
+                using state_type = typename communicator_type::state_type;
+                using state_ptr = std::unique_ptr<state_type>;
+                using state_vector = std::vector<state_ptr>;
+
+                std::shared_ptr<world> m_world;
+                shared_state_type m_shared_state;
+                state_type m_state;
+                state_vector m_states;
+                std::mutex m_mutex;
+
+                transport_context(std::shared_ptr<world> w, int rank)
+                    : m_world{std::move(w)}
+                    , m_shared_state(m_world.get(), rank)
+                {}
+
+                communicator_type get_serial_communicator()
+                {
+                    return {&m_shared_state, &m_state};
+                }
+
+                communicator_type get_communicator()
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex); // we need to guard only the insertion in the vector,
+                                                               // but this is not a performance critical section
+                    m_states.push_back(std::make_unique<state_type>());
+                    return {&m_shared_state, m_states[m_states.size()-1].get()};
+                }
+            };
+
+            } // namespace inproc
+
+            /** @brief context of a logical rank of the in-process transport. There is no MPI communicator behind
+              * it: the setup phase uses in-memory collectives (see inproc::setup_communicator). */
+            template<>
+            class context<inproc::transport_context>
+            {
+            public: // member types
+                using transport_context_type = inproc::transport_context;
+                using tag                    = typename transport_context_type::tag;
+                using communicator_type      = typename transport_context_type::communicator_type;
+
+                friend class context_factory<tag>;
+
+            private: // members
+                transport_context_type m_transport_context;
+                int m_rank;
+                int m_size;
+
+            private: // private ctor
+                context(std::shared_ptr<inproc::world> w, int rank)
+                    : m_transport_context{std::move(w), rank}
+                    , m_rank{rank}
+                    , m_size{m_transport_context.m_world->size()}
+                {}
+
+            public: // ctors
+                context(const context&) = delete;
+                context(context&&) = delete;
+
+            public: // member functions
+                transport_context_type& get_transport_context() noexcept { return m_transport_context; }
+                int rank() const noexcept { return m_rank; }
+                int size() const noexcept { return m_size; }
+
+                /** @brief return the communicator used to set up patterns */
+                inproc::setup_communicator get_setup_communicator() const
+                {
+                    return {m_transport_context.m_world.get(), m_rank};
+                }
+
+                /** @brief return a per-rank communicator.
+                  * This function is not thread-safe and should only be used in the serial part of the code. */
+                communicator_type get_serial_communicator()
+                {
+                    return m_transport_context.get_serial_communicator();
+                }
+
+                /** @brief return a per-thread communicator.
+                  * This function is thread-safe. */
+                communicator_type get_communicator()
+                {
+                    return m_transport_context.get_communicator();
+                }
+            };
+
+            template<>
+            struct context_factory<inproc_tag>
+            {
+                using context_type = context<inproc::transport_context>;
+
+                /** @brief create the context of one logical rank
+                  * @param w the world shared by all logical ranks
+                  * @param rank the logical rank */
+                static std::unique_ptr<context_type> create(std::shared_ptr<inproc::world> w, int rank)
+                {
+                    if (rank < 0 || rank >= w->size()) throw std::out_of_range("invalid rank");
+                    return std::unique_ptr<context_type>{
+                        new context_type{std::move(w), rank}};
+                }
+            };
+
+            namespace inproc {
+
+            /** @brief run a function on a number of logical ranks, each of which is a thread with its own context.
+              * Returns when all ranks have finished. If a rank throws, the first exception is rethrown; the other
+              * ranks must not wait for it in a collective.
+              * @tparam F function type with the signature void(context<transport_context>&)
+              * @param num_ranks number of logical ranks
+              * @param f function to run */
+            template<typename F>
+            void run(int num_ranks, F&& f)
+            {
+                auto w = std::make_shared<world>(num_ranks);
+                std::exception_ptr error;
+                std::mutex error_mutex;
+                std::vector<std::thread> threads;
+                threads.reserve(num_ranks);
+                for (int r=0; r<num_ranks; ++r)
+                {
+                    threads.emplace_back([&f, &w, &error, &error_mutex, r]() {
+                        try
+                        {
+                            auto context_ptr = context_factory<inproc_tag>::create(w, r);
+                            f(*context_ptr);
+                        }
+                        catch (...)
+                        {
+                            std::lock_guard<std::mutex> lock(error_mutex);
+                            if (!error) error = std::current_exception();
+                        }
+                    });
+                }
+                for (auto& t : threads) t.join();
+                if (error) std::rethrow_exception(error);
+            }
+
+            } // namespace inproc
+
+        } // namespace tl
+    } // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_TL_INPROC_CONTEXT_HPP */
@@ -0,0 +1,206 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_TL_INPROC_FUTURE_HPP
+#define INCLUDED_GHEX_TL_INPROC_FUTURE_HPP
+
+#include <memory>
+#include "../mpi/request.hpp"
+#include "./world.hpp"
+
+namespace gridtools{
+    namespace ghex {
+        namespace tl {
+            namespace inproc {
+
+                using request_kind = mpi::request_kind;
+
+                /** @brief raw handle of a request, which can be copied and tested in batches */
+                struct raw_request
+                {
+                    detail::operation* m_op;
+                    world*             m_world;
+                    int                m_rank;
+                };
+
+                /** @brief request of a point-to-point operation of a logical rank. A request without operation
+                  * is complete. */
+                struct request_t
+                {
+                    std::shared_ptr<detail::operation> m_op;
+                    world*                             m_world = nullptr;
+                    int                                m_rank = 0;
+                    request_kind                       m_kind = request_kind::none;
+
+                    void wait()
+                    {
+                        while (!test()) {}
+                    }
+
+                    bool test()
+                    {
+                        if (!m_op || m_op->done()) return true;
+                        m_world->progress(m_rank);
+                        return m_op->done();
+                    }
+
+                    /** Cancel the request (only receives can be cancelled).
+                      * @return True if the request was successfully canceled */
+                    bool cancel()
+                    {
+                        if (m_kind != request_kind::recv || !m_op) return false;
+                        return m_world->cancel(m_rank, m_op.get());
+                    }
+
+                    raw_request raw() const noexcept { return {m_op.get(), m_world, m_rank}; }
+                };
+
+                /** @brief test an array of requests of one logical rank for completion: the rank is progressed
+                  * once and the operations are checked.
+                  * @param reqs pointer to the requests
+                  * @param count number of requests
+                  * @param indices output array of size count receiving the positions of the completed requests
+                  * @return number of completed requests */
+                inline int test_some(raw_request* reqs, int count, int* indices)
+                {
+                    if (count == 0) return 0;
+                    if (reqs[0].m_world) reqs[0].m_world->progress(reqs[0].m_rank);
+                    int n = 0;
+                    for (int i=0; i<count; ++i)
+                        if (!reqs[i].m_op || reqs[i].m_op->done()) indices[n++] = i;
+                    return n;
+                }
+
+                template<typename RandomAccessIterator, typename Func>
+                static RandomAccessIterator test_any(RandomAccessIterator first, RandomAccessIterator last,
+                    Func&& get)
+                {
+                    for (auto it = first; it != last; ++it)
+                        if (get(*it).m_handle.test()) return it;
+                    return last;
+                }
+
+                template<typename RandomAccessIterator>
+                static RandomAccessIterator test_any(RandomAccessIterator first, RandomAccessIterator last)
+                {
+                    return test_any(first, last, [](auto& fut) -> auto& { return fut; });
+                }
+
+                /** @brief future template for non-blocking communication */
+                template<typename T>
+                struct future_t
+                {
+                    using value_type  = T;
+                    using handle_type = request_t;
+
+                    value_type m_data;
+                    handle_type m_handle;
+
+                    future_t(value_type&& data, handle_type&& h)
+                    :   m_data(std::move(data))
+                    ,   m_handle(std::move(h))
+                    {}
+                    future_t(const future_t&) = delete;
+                    future_t(future_t&&) = default;
+                    future_t& operator=(const future_t&) = delete;
+                    future_t& operator=(future_t&&) = default;
+
+                    void wait() { m_handle.wait(); }
+
+                    bool test() { return m_handle.test(); }
+
+                    bool ready() { return m_handle.test(); }
+
+                    [[nodiscard]] value_type get()
+                    {
+                        wait();
+                        return std::move(m_data);
+                    }
+
+                    bool is_recv() const noexcept { return (m_handle.m_kind == request_kind::recv); }
+
+                    /** Cancel the future.
+                      * @return True if the request was successfully canceled */
+                    bool cancel() { return m_handle.cancel(); }
+
+                    template<typename RandomAccessIterator>
+                    static RandomAccessIterator test_any(RandomAccessIterator first, RandomAccessIterator last) {
+                        return ::gridtools::ghex::tl::inproc::test_any(first,last);
+                    }
+
+                    template<typename RandomAccessIterator, typename Func>
+                    static RandomAccessIterator test_any(RandomAccessIterator first, RandomAccessIterator last,
+                        Func&& get) {
+                        return ::gridtools::ghex::tl::inproc::test_any(first,last,std::forward<Func>(get));
+                    }
+
+                    using raw_handle_type = raw_request;
+
+                    raw_handle_type raw_handle() const noexcept { return m_handle.raw(); }
+
+                    static int test_some(raw_handle_type* handles, int count, int* indices) {
+                        return ::gridtools::ghex::tl::inproc::test_some(handles, count, indices);
+                    }
+                };
+
+                template<>
+                struct future_t<void>
+                {
+                    using handle_type = request_t;
+
+                    handle_type m_handle;
+
+                    future_t() noexcept = default;
+                    future_t(handle_type&& h)
+                    :   m_handle(std::move(h))
+                    {}
+                    future_t(const future_t&) = delete;
+                    future_t(future_t&&) = default;
+                    future_t& operator=(const future_t&) = delete;
+                    future_t& operator=(future_t&&) = default;
+
+                    void wait() { m_handle.wait(); }
+
+                    bool test() { return m_handle.test(); }
+
+                    bool ready() { return m_handle.test(); }
+
+                    void get() { wait(); }
+
+                    bool is_recv() const noexcept { return (m_handle.m_kind == request_kind::recv); }
+
+                    bool cancel() { return m_handle.cancel(); }
+
+                    template<typename RandomAccessIterator>
+                    static RandomAccessIterator test_any(RandomAccessIterator first, RandomAccessIterator last) {
+                        return ::gridtools::ghex::tl::inproc::test_any(first,last);
+                    }
+
+                    template<typename RandomAccessIterator, typename Func>
+                    static RandomAccessIterator test_any(RandomAccessIterator first, RandomAccessIterator last,
+                        Func&& get) {
+                        return ::gridtools::ghex::tl::inproc::test_any(first,last,std::forward<Func>(get));
+                    }
+
+                    using raw_handle_type = raw_request;
+
+                    raw_handle_type raw_handle() const noexcept { return m_handle.raw(); }
+
+                    static int test_some(raw_handle_type* handles, int count, int* indices) {
+                        return ::gridtools::ghex::tl::inproc::test_some(handles, count, indices);
+                    }
+                };
+
+            } // namespace inproc
+        } // namespace tl
+    } // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_TL_INPROC_FUTURE_HPP */
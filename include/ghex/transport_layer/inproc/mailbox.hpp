@@ -0,0 +1,114 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_TL_INPROC_MAILBOX_HPP
+#define INCLUDED_GHEX_TL_INPROC_MAILBOX_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace gridtools {
+    namespace ghex {
+        namespace tl {
+            namespace inproc {
+
+                namespace detail {
+
+                    /** @brief a send or receive operation of a logical rank */
+                    struct operation
+                    {
+                        std::atomic<bool> m_done;
+                        unsigned char*    m_data;
+                        std::size_t       m_size;
+                        int               m_peer;
+                        int               m_tag;
+
+                        operation(unsigned char* data, std::size_t size, int peer, int tag) noexcept
+                        : m_done{false}, m_data{data}, m_size{size}, m_peer{peer}, m_tag{tag}
+                        {}
+
+                        bool done() const noexcept { return m_done.load(std::memory_order_acquire); }
+                        void complete() noexcept { m_done.store(true, std::memory_order_release); }
+                    };
+
+                    /** @brief a message in flight. The payload is not copied: it stays in the sender's buffer until
+                      * the receiver has matched the message and copied it into the receive buffer. */
+                    struct envelope
+                    {
+                        envelope*                  m_next = nullptr;
+                        int                        m_src = 0;
+                        std::shared_ptr<operation> m_send;
+                    };
+
+                } // namespace detail
+
+                /** @brief Lock-free multiple-producer single-consumer mailbox of a logical rank. Senders push their
+                  * envelopes onto an intrusive stack with a single compare-and-swap; the receiver takes all envelopes
+                  * at once and restores their arrival order, so that messages of one sender are delivered in the
+                  * order in which they were sent. */
+                class mailbox
+                {
+                private: // members
+                    std::atomic<detail::envelope*> m_head{nullptr};
+
+                public: // ctors
+                    mailbox() noexcept = default;
+                    mailbox(const mailbox&) = delete;
+                    mailbox& operator=(const mailbox&) = delete;
+
+                    ~mailbox()
+                    {
+                        auto e = take_all();
+                        while (e)
+                        {
+                            auto next = e->m_next;
+                            delete e;
+                            e = next;
+                        }
+                    }
+
+                public: // member functions
+                    /** @brief append an envelope (any thread)
+                      * @param e envelope, ownership is transferred to the mailbox */
+                    void push(detail::envelope* e) noexcept
+                    {
+                        auto head = m_head.load(std::memory_order_relaxed);
+                        do { e->m_next = head; }
+                        while (!m_head.compare_exchange_weak(head, e, std::memory_order_release,
+                            std::memory_order_relaxed));
+                    }
+
+                    bool empty() const noexcept { return m_head.load(std::memory_order_relaxed) == nullptr; }
+
+                    /** @brief remove all envelopes (consumer side)
+                      * @return linked list of envelopes in arrival order, ownership is transferred to the caller */
+                    detail::envelope* take_all() noexcept
+                    {
+                        if (empty()) return nullptr;
+                        auto e = m_head.exchange(nullptr, std::memory_order_acquire);
+                        detail::envelope* first = nullptr;
+                        while (e)
+                        {
+                            auto next = e->m_next;
+                            e->m_next = first;
+                            first = e;
+                            e = next;
+                        }
+                        return first;
+                    }
+                };
+
+            } // namespace inproc
+        } // namespace tl
+    } // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_TL_INPROC_MAILBOX_HPP */
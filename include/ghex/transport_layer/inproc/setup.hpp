@@ -0,0 +1,170 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_TL_INPROC_SETUP_HPP
+#define INCLUDED_GHEX_TL_INPROC_SETUP_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <utility>
+#include <vector>
+#include "./future.hpp"
+
+namespace gridtools{
+    namespace ghex {
+        namespace tl {
+            namespace inproc {
+
+            /** @brief special communicator of a logical rank used for setup phase. It provides the same collectives
+              * as mpi::setup_communicator, implemented in memory: each rank publishes a pointer to its
+              * contribution and copies the parts it needs from the contributions of the other ranks. All
+              * collectives are blocking and must be called by all ranks in the same order. */
+            class setup_communicator
+            {
+            public:
+                using rank_type    = int;
+                using size_type    = int;
+                using tag_type     = int;
+                using handle_type  = request_t;
+                using address_type = rank_type;
+                template<typename T>
+                using future = future_t<T>;
+
+            private:
+                world*    m_world;
+                rank_type m_rank;
+
+            public:
+                setup_communicator(world* w, rank_type r) noexcept : m_world{w}, m_rank{r} {}
+                setup_communicator(const setup_communicator&) = default;
+                setup_communicator& operator=(const setup_communicator&) = default;
+                setup_communicator(setup_communicator&&) noexcept = default;
+                setup_communicator& operator=(setup_communicator&&) noexcept = default;
+
+                rank_type rank() const noexcept { return m_rank; }
+                size_type size() const noexcept { return m_world->size(); }
+                address_type address() const { return rank(); }
+
+                void barrier() const { m_world->barrier(); }
+
+                template<typename T>
+                void broadcast(T& value, int root) const
+                {
+                    broadcast(&value, 1, root);
+                }
+
+                template<typename T>
+                void broadcast(T * values, int n, int root) const
+                {
+                    const int r = m_rank;
+                    m_world->exchange(r, values, [values, n, root, r](const void* const* contributions) {
+                        if (r != root) std::copy_n(static_cast<const T*>(contributions[root]), n, values);
+                    });
+                }
+
+                template<typename T>
+                future< std::vector<std::vector<T>> > all_gather(const std::vector<T>& payload, const std::vector<int>& sizes) const
+                {
+                    std::vector<std::vector<T>> res(size());
+                    m_world->exchange(m_rank, payload.data(), [&res, &sizes](const void* const* contributions) {
+                        for (std::size_t neigh=0; neigh<res.size(); ++neigh)
+                        {
+                            auto first = static_cast<const T*>(contributions[neigh]);
+                            res[neigh].assign(first, first + sizes[neigh]);
+                        }
+                    });
+                    return {std::move(res), handle_type{}};
+                }
+
+                template<typename T>
+                future< std::vector<T> > all_gather(const T& payload) const
+                {
+                    std::vector<T> res(size());
+                    m_world->exchange(m_rank, &payload, [&res](const void* const* contributions) {
+                        for (std::size_t neigh=0; neigh<res.size(); ++neigh)
+                            res[neigh] = *static_cast<const T*>(contributions[neigh]);
+                    });
+                    return {std::move(res), handle_type{}};
+                }
+
+                /** @brief computes the max element of a vector<T> among all ranks */
+                template<typename T>
+                T max_element(const std::vector<T>& elems) const {
+                    T local_max{*(std::max_element(elems.begin(), elems.end()))};
+                    auto all_max = all_gather(local_max).get();
+                    return *(std::max_element(all_max.begin(), all_max.end()));
+                }
+
+                /** @brief sparse data exchange: every rank sends one message to each rank of an arbitrary set of
+                  * destinations. Each rank looks up the messages addressed to it in the maps of all ranks. The tag
+                  * is not needed since the exchange is collective.
+                  * @tparam T trivially copyable value type
+                  * @param messages map of destination rank to payload
+                  * @return received messages as (source rank, payload) pairs */
+                template<typename T>
+                std::vector<std::pair<int,std::vector<T>>> sparse_exchange(const std::map<int,std::vector<T>>& messages, int) const
+                {
+                    std::vector<std::pair<int,std::vector<T>>> res;
+                    const int r = m_rank;
+                    const int s = size();
+                    m_world->exchange(r, &messages, [&res, r, s](const void* const* contributions) {
+                        for (int src=0; src<s; ++src)
+                        {
+                            const auto& m = *static_cast<const std::map<int,std::vector<T>>*>(contributions[src]);
+                            auto it = m.find(r);
+                            if (it != m.end()) res.emplace_back(src, it->second);
+                        }
+                    });
+                    return res;
+                }
+
+                /** @brief just a helper function using custom types to be used when send/recv counts can be deduced*/
+                template<typename T>
+                void all_to_all(const std::vector<T>& send_buf, std::vector<T>& recv_buf) const
+                {
+                    const int comm_size = this->size();
+                    assert(send_buf.size() % comm_size == 0);
+                    assert(recv_buf.size() % comm_size == 0);
+                    const std::size_t count = recv_buf.size() / comm_size;
+                    const int r = m_rank;
+                    m_world->exchange(r, send_buf.data(), [&recv_buf, count, r, comm_size](const void* const* contributions) {
+                        for (int src=0; src<comm_size; ++src)
+                            std::copy_n(static_cast<const T*>(contributions[src]) + r*count, count,
+                                recv_buf.data() + src*count);
+                    });
+                }
+
+                /** @brief all to all communication with variable counts, counts and displacements in elements */
+                template<typename T>
+                void all_to_allv(const std::vector<T>& send_buf, const std::vector<int>& send_counts, const std::vector<int>& send_displs,
+                        std::vector<T>& recv_buf, const std::vector<int>& recv_counts, const std::vector<int>& recv_displs) const
+                {
+                    struct contribution { const T* m_data; const int* m_counts; const int* m_displs; };
+                    const contribution c{send_buf.data(), send_counts.data(), send_displs.data()};
+                    const int r = m_rank;
+                    const int comm_size = this->size();
+                    m_world->exchange(r, &c, [&recv_buf, &recv_counts, &recv_displs, r, comm_size](const void* const* contributions) {
+                        for (int src=0; src<comm_size; ++src)
+                        {
+                            const auto& sc = *static_cast<const contribution*>(contributions[src]);
+                            assert(sc.m_counts[r] == recv_counts[src]);
+                            std::copy_n(sc.m_data + sc.m_displs[r], recv_counts[src], recv_buf.data() + recv_displs[src]);
+                        }
+                    });
+                }
+            };
+
+            } // namespace inproc
+        } // namespace tl
+    } // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_TL_INPROC_SETUP_HPP */
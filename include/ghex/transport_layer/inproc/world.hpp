@@ -0,0 +1,274 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_TL_INPROC_WORLD_HPP
+#define INCLUDED_GHEX_TL_INPROC_WORLD_HPP
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "./mailbox.hpp"
+
+namespace gridtools {
+    namespace ghex {
+        namespace tl {
+            namespace inproc {
+
+                /** @brief The state shared by all logical ranks of the in-process transport. Logical ranks are
+                  * threads of the same process which communicate through memory:
+                  * - every rank owns a lock-free mailbox into which senders push their envelopes without taking
+                  *   any lock;
+                  * - the receiving rank drains its mailbox when it is progressed and matches the envelopes against
+                  *   its posted receives by source and tag (in posting and arrival order, respectively); unmatched
+                  *   envelopes are kept as unexpected messages;
+                  * - on a match, the receiver copies the payload directly from the sender's buffer and completes
+                  *   both operations (single copy). Sends therefore complete as soon as the receiving rank has
+                  *   progressed, without any action of the sending rank;
+                  * - collectives are implemented by publishing one pointer per rank between two barriers.
+                  * This class is thread safe. */
+                class world
+                {
+                public: // member types
+                    using op_ptr = std::shared_ptr<detail::operation>;
+
+                private: // member types
+                    struct rank_state
+                    {
+                        mailbox                       m_mailbox;
+                        std::mutex                    m_mutex;
+                        std::deque<op_ptr>            m_recvs;      // posted receives, in posting order
+                        std::deque<detail::envelope*> m_unexpected; // unmatched messages, in arrival order
+
+                        ~rank_state()
+                        {
+                            for (auto e : m_unexpected) delete e;
+                        }
+                    };
+
+                private: // members
+                    const int                     m_size;
+                    std::unique_ptr<rank_state[]> m_ranks;
+                    bool                          m_yield;
+                    // collectives
+                    std::mutex                    m_barrier_mutex;
+                    std::condition_variable       m_barrier_cv;
+                    int                           m_arrived = 0;
+                    std::size_t                   m_generation = 0u;
+                    std::vector<const void*>      m_slots;
+
+                public: // ctors
+                    /** @brief create a world of logical ranks
+                      * @param size number of logical ranks */
+                    explicit world(int size)
+                    : m_size{size}
+                    , m_ranks{new rank_state[size > 0 ? size : 0]}
+                    // progressing ranks give up the processor when they are idle, unless every rank has a
+                    // hardware thread of its own
+                    , m_yield{static_cast<unsigned int>(size) > std::thread::hardware_concurrency()}
+                    , m_slots(size > 0 ? size : 0, nullptr)
+                    {
+                        if (size < 1) throw std::invalid_argument("the number of logical ranks must be positive");
+                    }
+
+                    world(const world&) = delete;
+                    world& operator=(const world&) = delete;
+
+                public: // member functions
+                    int size() const noexcept { return m_size; }
+
+                    /** @brief post a send. The buffer must be kept alive until the operation has completed.
+                      * @param src sending rank
+                      * @param data pointer to the message
+                      * @param size size of the message in bytes
+                      * @param dst destination rank
+                      * @param tag message tag
+                      * @return the operation */
+                    op_ptr send(int src, const void* data, std::size_t size, int dst, int tag)
+                    {
+                        check_rank(dst);
+                        auto op = std::make_shared<detail::operation>(
+                            static_cast<unsigned char*>(const_cast<void*>(data)), size, dst, tag);
+                        auto e = new detail::envelope;
+                        e->m_src = src;
+                        e->m_send = op;
+                        m_ranks[dst].m_mailbox.push(e);
+                        return op;
+                    }
+
+                    /** @brief post a receive. The buffer must be kept alive until the operation has completed.
+                      * @param rank receiving rank
+                      * @param data pointer to the receive buffer
+                      * @param size size of the receive buffer in bytes
+                      * @param src source rank
+                      * @param tag message tag
+                      * @return the operation */
+                    op_ptr recv(int rank, void* data, std::size_t size, int src, int tag)
+                    {
+                        check_rank(src);
+                        auto op = std::make_shared<detail::operation>(static_cast<unsigned char*>(data), size, src,
+                            tag);
+                        auto& r = m_ranks[rank];
+                        std::lock_guard<std::mutex> lock(r.m_mutex);
+                        // messages which are already in the mailbox have been sent before the receive was posted
+                        drain(r);
+                        for (auto it = r.m_unexpected.begin(); it != r.m_unexpected.end(); ++it)
+                        {
+                            if ((*it)->m_src != src || (*it)->m_send->m_tag != tag) continue;
+                            auto e = *it;
+                            r.m_unexpected.erase(it);
+                            deliver(e, *op);
+                            return op;
+                        }
+                        r.m_recvs.push_back(op);
+                        return op;
+                    }
+
+                    /** @brief cancel a posted receive
+                      * @return true if the receive has not been matched yet and was removed */
+                    bool cancel(int rank, const detail::operation* op)
+                    {
+                        auto& r = m_ranks[rank];
+                        std::lock_guard<std::mutex> lock(r.m_mutex);
+                        drain(r);
+                        for (auto it = r.m_recvs.begin(); it != r.m_recvs.end(); ++it)
+                        {
+                            if (it->get() != op) continue;
+                            r.m_recvs.erase(it);
+                            return true;
+                        }
+                        return false;
+                    }
+
+                    /** @brief match the messages in the mailbox of a rank against its posted receives. If another
+                      * thread of the same rank is already progressing, this function returns immediately.
+                      * @return number of delivered messages */
+                    int progress(int rank)
+                    {
+                        auto& r = m_ranks[rank];
+                        int n = 0;
+                        if (!r.m_mailbox.empty())
+                        {
+                            std::unique_lock<std::mutex> lock(r.m_mutex, std::try_to_lock);
+                            if (lock.owns_lock()) n = drain(r);
+                        }
+                        if (n == 0 && m_yield) std::this_thread::yield();
+                        return n;
+                    }
+
+                    /** @brief block until all ranks have called this function */
+                    void barrier()
+                    {
+                        std::unique_lock<std::mutex> lock(m_barrier_mutex);
+                        const auto generation = arrive();
+                        if (generation == m_generation)
+                            m_barrier_cv.wait(lock, [this, generation]() { return generation != m_generation; });
+                    }
+
+                    /** @brief enter a barrier without blocking. The barrier is completed when all ranks have
+                      * entered it, which can be tested with barrier_test().
+                      * @return a handle to be passed to barrier_test() */
+                    std::size_t barrier_enter()
+                    {
+                        std::lock_guard<std::mutex> lock(m_barrier_mutex);
+                        return arrive();
+                    }
+
+                    /** @brief test whether a barrier entered with barrier_enter() has been completed */
+                    bool barrier_test(std::size_t generation)
+                    {
+                        std::lock_guard<std::mutex> lock(m_barrier_mutex);
+                        return generation != m_generation;
+                    }
+
+                    /** @brief collective building block: every rank publishes a pointer to its contribution, then
+                      * all ranks read the contributions of the others concurrently. Must be called by all ranks.
+                      * @tparam F function type with the signature void(const void* const* contributions)
+                      * @param rank calling rank
+                      * @param contribution pointer to the contribution, which is valid until the function returns
+                      * @param f function reading the contributions, indexed by rank */
+                    template<typename F>
+                    void exchange(int rank, const void* contribution, F&& f)
+                    {
+                        m_slots[rank] = contribution;
+                        barrier();
+                        f(static_cast<const void* const*>(m_slots.data()));
+                        // contributions must stay valid until everybody has read them
+                        barrier();
+                    }
+
+                private: // implementation
+                    // requires the barrier lock, returns the generation of the barrier which has been entered
+                    std::size_t arrive()
+                    {
+                        const auto generation = m_generation;
+                        if (++m_arrived == m_size)
+                        {
+                            m_arrived = 0;
+                            ++m_generation;
+                            m_barrier_cv.notify_all();
+                        }
+                        return generation;
+                    }
+
+                    void check_rank(int r) const
+                    {
+                        if (r < 0 || r >= m_size) throw std::out_of_range("invalid rank");
+                    }
+
+                    // requires the lock of the rank
+                    int drain(rank_state& r)
+                    {
+                        int n = 0;
+                        auto e = r.m_mailbox.take_all();
+                        while (e)
+                        {
+                            auto next = e->m_next;
+                            auto it = r.m_recvs.begin();
+                            for (; it != r.m_recvs.end(); ++it)
+                                if ((*it)->m_peer == e->m_src && (*it)->m_tag == e->m_send->m_tag) break;
+                            if (it != r.m_recvs.end())
+                            {
+                                auto op = std::move(*it);
+                                r.m_recvs.erase(it);
+                                deliver(e, *op);
+                                ++n;
+                            }
+                            else
+                            {
+                                r.m_unexpected.push_back(e);
+                            }
+                            e = next;
+                        }
+                        return n;
+                    }
+
+                    static void deliver(detail::envelope* e, detail::operation& recv)
+                    {
+                        std::unique_ptr<detail::envelope> guard{e};
+                        auto& send = *e->m_send;
+                        if (send.m_size > recv.m_size)
+                            throw std::runtime_error("message is larger than the receive buffer");
+                        if (send.m_size > 0u) std::memcpy(recv.m_data, send.m_data, send.m_size);
+                        recv.complete();
+                        send.complete();
+                    }
+                };
+
+            } // namespace inproc
+        } // namespace tl
+    } // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_TL_INPROC_WORLD_HPP */
@@ -12,6 +12,7 @@
 #define INCLUDED_GHEX_TL_MESSAGE_BUFFER_HPP
 
 #include <cassert>
+#include <cstdint>
 #include <type_traits>
 #include "../allocator/allocation.hpp"
 #include "../common/to_address.hpp"
@@ -94,7 +95,7 @@ namespace gridtools {
                 , m_size{size_}
                 {}
 
-                message_buffer(message_buffer&& other)
+                message_buffer(message_buffer&& other) noexcept
                 : m_buffer{std::move(other.m_buffer)}
                 , m_size{other.m_size}
                 {
@@ -16,6 +16,7 @@
 #include "../shared_message_buffer.hpp"
 #include "../tags.hpp"
 #include "./future.hpp"
+#include "./persistent_request.hpp"
 #include "./request_cb.hpp"
 #include "./communicator_state.hpp"
 
@@ -38,6 +39,7 @@ namespace gridtools {
                     using rank_type = typename state_type::rank_type;
                     using tag_type = typename state_type::tag_type;
                     using request = request_t;
+                    using persistent_request_type = persistent_request_t;
                     using status = status_t;
                     template<typename T>
                     using future = typename state_type::template future<T>;
@@ -67,6 +69,10 @@ namespace gridtools {
                     bool is_local(rank_type r) const noexcept { return m_shared_state->m_rank_topology.is_local(r); }
                     rank_type local_rank() const noexcept { return m_shared_state->m_rank_topology.local_rank(); }
                     auto mpi_comm() const noexcept { return m_shared_state->m_comm; }
+#ifdef GHEX_USE_MPI_RMA
+                    /** @brief window for one-sided communication, shared by all communicators of the context */
+                    window* mpi_window() const noexcept { return m_shared_state->m_window.get(); }
+#endif
 
                     /** @brief send a message. The message must be kept alive by the caller until the communication is
                      * finished.
@@ -102,6 +108,90 @@ namespace gridtools {
                         return req;
                     }
 
+                    /** @brief create a persistent send request which can be started repeatedly. The message must be
+                     * kept alive by the caller, and must not be reallocated, during the lifetime of the request.
+                     * @tparam Message a meassage type
+                     * @param msg an l-value reference to the message to be sent
+                     * @param dst the destination rank
+                     * @param tag the communication tag
+                     * @return an inactive persistent request */
+                    template<typename Message>
+                    [[nodiscard]] persistent_request_type send_init(const Message& msg, rank_type dst, tag_type tag) {
+                        MPI_Request req;
+                        GHEX_CHECK_MPI_RESULT(MPI_Send_init(reinterpret_cast<const void*>(msg.data()),
+                                                            sizeof(typename Message::value_type) * msg.size(), MPI_BYTE,
+                                                            dst, tag, m_shared_state->m_comm, &req));
+                        return {req, request_kind::send};
+                    }
+
+                    /** @brief create a persistent receive request which can be started repeatedly. The message must be
+                     * kept alive by the caller, and must not be reallocated, during the lifetime of the request.
+                     * @tparam Message a meassage type
+                     * @param msg an l-value reference to the message to be received
+                     * @param src the source rank
+                     * @param tag the communication tag
+                     * @return an inactive persistent request */
+                    template<typename Message>
+                    [[nodiscard]] persistent_request_type recv_init(Message& msg, rank_type src, tag_type tag) {
+                        MPI_Request req;
+                        GHEX_CHECK_MPI_RESULT(MPI_Recv_init(reinterpret_cast<void*>(msg.data()),
+                                                            sizeof(typename Message::value_type) * msg.size(), MPI_BYTE,
+                                                            src, tag, m_shared_state->m_comm, &req));
+                        return {req, request_kind::recv};
+                    }
+
+                    /** @brief send data described by an MPI datatype. The data must be kept alive by the caller until
+                     * the communication is finished.
+                     * @param data base address of the data (MPI_BOTTOM for absolute displacements)
+                     * @param type a committed MPI datatype describing the data relative to the base address
+                     * @param dst the destination rank
+                     * @param tag the communication tag
+                     * @return a future to test/wait for completion */
+                    [[nodiscard]] future<void> send_typed(const void* data, MPI_Datatype type, rank_type dst, tag_type tag) {
+                        request req;
+                        GHEX_CHECK_MPI_RESULT(MPI_Isend(data, 1, type, dst, tag, m_shared_state->m_comm, &req.get()));
+                        req.m_kind = request_kind::send;
+                        return req;
+                    }
+
+                    /** @brief receive data described by an MPI datatype. The data must be kept alive by the caller
+                     * until the communication is finished.
+                     * @param data base address of the data (MPI_BOTTOM for absolute displacements)
+                     * @param type a committed MPI datatype describing the data relative to the base address
+                     * @param src the source rank
+                     * @param tag the communication tag
+                     * @return a future to test/wait for completion */
+                    [[nodiscard]] future<void> recv_typed(void* data, MPI_Datatype type, rank_type src, tag_type tag) {
+                        request req;
+                        GHEX_CHECK_MPI_RESULT(MPI_Irecv(data, 1, type, src, tag, m_shared_state->m_comm, &req.get()));
+                        req.m_kind = request_kind::recv;
+                        return req;
+                    }
+
+                    /** @brief create a persistent send request for data described by an MPI datatype.
+                     * @param data base address of the data (MPI_BOTTOM for absolute displacements)
+                     * @param type a committed MPI datatype describing the data relative to the base address
+                     * @param dst the destination rank
+                     * @param tag the communication tag
+                     * @return an inactive persistent request */
+                    [[nodiscard]] persistent_request_type send_init_typed(const void* data, MPI_Datatype type, rank_type dst, tag_type tag) {
+                        MPI_Request req;
+                        GHEX_CHECK_MPI_RESULT(MPI_Send_init(data, 1, type, dst, tag, m_shared_state->m_comm, &req));
+                        return {req, request_kind::send};
+                    }
+
+                    /** @brief create a persistent receive request for data described by an MPI datatype.
+                     * @param data base address of the data (MPI_BOTTOM for absolute displacements)
+                     * @param type a committed MPI datatype describing the data relative to the base address
+                     * @param src the source rank
+                     * @param tag the communication tag
+                     * @return an inactive persistent request */
+                    [[nodiscard]] persistent_request_type recv_init_typed(void* data, MPI_Datatype type, rank_type src, tag_type tag) {
+                        MPI_Request req;
+                        GHEX_CHECK_MPI_RESULT(MPI_Recv_init(data, 1, type, src, tag, m_shared_state->m_comm, &req));
+                        return {req, request_kind::recv};
+                    }
+
                     /** @brief Function to poll the transport layer and check for completion of operations with an
                       * associated callback. When an operation completes, the corresponfing call-back is invoked
                       * with the message, rank and tag associated with this communication.
@@ -14,6 +14,10 @@
 #include "./error.hpp"
 #include "./future.hpp"
 #include "../callback_utils.hpp"
+#ifdef GHEX_USE_MPI_RMA
+#include <memory>
+#include "./window.hpp"
+#endif
 
 namespace gridtools {
 
@@ -33,12 +37,19 @@ namespace gridtools {
                     const rank_topology& m_rank_topology;
                     rank_type m_rank;
                     rank_type m_size;
+#ifdef GHEX_USE_MPI_RMA
+                    // window for one-sided communication with remote ranks (created collectively with the context)
+                    std::unique_ptr<window> m_window;
+#endif
 
                     shared_communicator_state(const rank_topology& t)
                     : m_comm{t.mpi_comm()}
                     , m_rank_topology{t}
                     , m_rank{ [](MPI_Comm c){ int r; GHEX_CHECK_MPI_RESULT(MPI_Comm_rank(c,&r)); return r; }(t.mpi_comm()) }
                     , m_size{ [](MPI_Comm c){ int s; GHEX_CHECK_MPI_RESULT(MPI_Comm_size(c,&s)); return s; }(t.mpi_comm()) }
+#ifdef GHEX_USE_MPI_RMA
+                    , m_window{std::make_unique<window>(t.mpi_comm())}
+#endif
                     {}
 
                     rank_type rank() const noexcept { return m_rank; }
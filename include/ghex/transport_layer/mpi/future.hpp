@@ -68,6 +68,20 @@ namespace gridtools{
                     else return last;
                 }
 
+                /** @brief test an array of requests for completion in a single call. Completed requests are freed
+                  * and set to MPI_REQUEST_NULL.
+                  * @param reqs pointer to the requests
+                  * @param count number of requests
+                  * @param indices output array of size count receiving the positions of the completed requests
+                  * @return number of completed requests */
+                inline int test_some(MPI_Request* reqs, int count, int* indices) {
+                    if (count == 0) return 0;
+                    int outcount;
+                    GHEX_CHECK_MPI_RESULT(
+                        MPI_Testsome(count, reqs, &outcount, indices, MPI_STATUSES_IGNORE));
+                    return outcount == MPI_UNDEFINED ? 0 : outcount;
+                }
+
                 /** @brief future template for non-blocking communication */
                 template<typename T>
                 struct future_t
@@ -137,6 +151,15 @@ namespace gridtools{
                         Func&& get) {
                         return ::gridtools::ghex::tl::mpi::test_any(first,last,std::forward<Func>(get));
                     }
+
+                    using raw_handle_type = MPI_Request;
+
+                    /** @brief the underlying MPI request (a copy may be tested with test_some) */
+                    raw_handle_type raw_handle() const noexcept { return m_handle.get(); }
+
+                    static int test_some(raw_handle_type* handles, int count, int* indices) {
+                        return ::gridtools::ghex::tl::mpi::test_some(handles, count, indices);
+                    }
                 };
 
                 template<>
@@ -202,6 +225,15 @@ namespace gridtools{
                         Func&& get) {
                         return ::gridtools::ghex::tl::mpi::test_any(first,last,std::forward<Func>(get));
                     }
+
+                    using raw_handle_type = MPI_Request;
+
+                    /** @brief the underlying MPI request (a copy may be tested with test_some) */
+                    raw_handle_type raw_handle() const noexcept { return m_handle.get(); }
+
+                    static int test_some(raw_handle_type* handles, int count, int* indices) {
+                        return ::gridtools::ghex::tl::mpi::test_some(handles, count, indices);
+                    }
                 };
 
             } // namespace mpi
@@ -0,0 +1,110 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_TL_MPI_PERSISTENT_REQUEST_HPP
+#define INCLUDED_GHEX_TL_MPI_PERSISTENT_REQUEST_HPP
+
+#include <vector>
+#include "./future.hpp"
+#include "../../common/moved_bit.hpp"
+
+namespace gridtools{
+    namespace ghex {
+        namespace tl {
+            namespace mpi {
+
+                /** @brief owning wrapper around a persistent MPI_Request (created by MPI_Send_init or MPI_Recv_init).
+                  * The request can be started any number of times and is freed on destruction. Note, that the
+                  * associated message must be kept alive (and must not be reallocated) during the lifetime of this
+                  * object. */
+                struct persistent_request_t
+                {
+                    MPI_Request m_req = MPI_REQUEST_NULL;
+                    request_kind m_kind = request_kind::none;
+                    moved_bit m_moved;
+
+                    persistent_request_t() noexcept = default;
+                    persistent_request_t(MPI_Request req, request_kind kind) noexcept
+                    : m_req{req}, m_kind{kind} {}
+                    persistent_request_t(const persistent_request_t&) = delete;
+                    persistent_request_t(persistent_request_t&&) noexcept = default;
+                    persistent_request_t& operator=(const persistent_request_t&) = delete;
+                    persistent_request_t& operator=(persistent_request_t&& other) noexcept
+                    {
+                        destroy();
+                        m_req = other.m_req;
+                        m_kind = other.m_kind;
+                        m_moved = std::move(other.m_moved);
+                        return *this;
+                    }
+                    ~persistent_request_t() { destroy(); }
+
+                    /** @brief start the communication */
+                    void start()
+                    {
+                        GHEX_CHECK_MPI_RESULT(MPI_Start(&m_req));
+                    }
+
+                    void wait()
+                    {
+                        GHEX_CHECK_MPI_RESULT(MPI_Wait(&m_req, MPI_STATUS_IGNORE));
+                    }
+
+                    bool test()
+                    {
+                        int flag = 0;
+                        GHEX_CHECK_MPI_RESULT(MPI_Test(&m_req, &flag, MPI_STATUS_IGNORE));
+                        return flag != 0;
+                    }
+
+                    /** @brief obtain a non-owning future to test/wait for completion of the most recently started
+                      * communication. The future must not outlive this object. */
+                    future_t<void> get_future() const
+                    {
+                        request_t req;
+                        req.m_req = m_req;
+                        req.m_kind = m_kind;
+                        return {std::move(req)};
+                    }
+
+                    /** @brief start a range of persistent requests with a single call to MPI_Startall
+                      * @tparam RandomAccessIterator iterator type to a range of persistent requests
+                      * @param first points to the begin of the range
+                      * @param last points to the end of the range */
+                    template<typename RandomAccessIterator>
+                    static void start_all(RandomAccessIterator first, RandomAccessIterator last)
+                    {
+                        const auto count = last-first;
+                        if (count == 0) return;
+                        static thread_local std::vector<MPI_Request> reqs;
+                        reqs.resize(0);
+                        reqs.reserve(count);
+                        for (auto it = first; it != last; ++it)
+                            reqs.push_back(it->m_req);
+                        GHEX_CHECK_MPI_RESULT(MPI_Startall(count, reqs.data()));
+                        for (auto it = first; it != last; ++it)
+                            it->m_req = reqs[it-first];
+                    }
+
+                private:
+                    void destroy() noexcept
+                    {
+                        if (!m_moved && m_req != MPI_REQUEST_NULL)
+                            MPI_Request_free(&m_req);
+                    }
+                };
+
+            } // namespace mpi
+        } // namespace tl
+    } // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_TL_MPI_PERSISTENT_REQUEST_HPP */
+
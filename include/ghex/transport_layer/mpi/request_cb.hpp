@@ -38,10 +38,9 @@ namespace gridtools{
                     bool test()
                     {
                         if(!m_queue) return true;
-                        if (m_completed.is_ready())
+                        if (m_queue->is_ready(m_completed))
                         {
                             m_queue = nullptr;
-                            m_completed.reset();
                             return true;
                         }
                         return false;
@@ -50,12 +49,8 @@ namespace gridtools{
                     bool cancel()
                     {
                         if(!m_queue) return false;
-                        auto res = m_queue->cancel(m_completed.queue_index());
-                        if (res)
-                        {
-                            m_queue = nullptr;
-                            m_completed.reset();
-                        }
+                        auto res = m_queue->cancel(m_completed);
+                        if (res) m_queue = nullptr;
                         return res;
                     }
                 };
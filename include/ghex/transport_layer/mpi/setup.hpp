@@ -15,6 +15,8 @@
 #include "./status.hpp"
 #include "./future.hpp"
 #include <vector>
+#include <map>
+#include <utility>
 #include <cassert>
 #include <algorithm>
 
@@ -87,44 +89,28 @@ namespace gridtools{
                 template<typename T>
                 future< std::vector<std::vector<T>> > all_gather(const std::vector<T>& payload, const std::vector<int>& sizes) const
                 {
-                    std::vector<std::vector<T>> res(size());
-                    for (int neigh=0; neigh<size(); ++neigh)
-                    {
-                        res[neigh].resize(sizes[neigh]);
-                    }
-                    std::vector<handle_type> m_reqs;
-                    m_reqs.reserve((size())*2);
-                    for (int neigh=0; neigh<size(); ++neigh)
-                    {
-                        m_reqs.push_back( handle_type{} );
-                        GHEX_CHECK_MPI_RESULT(MPI_Irecv(reinterpret_cast<void*>(res[neigh].data()), sizeof(T)*sizes[neigh], MPI_BYTE, neigh, 99, *this, &m_reqs.back().get()));
-                    }
+                    // gather into one contiguous buffer with a single collective and split afterwards
+                    std::vector<int> recvcounts(size());
+                    std::vector<int> displs(size());
+                    int total = 0;
                     for (int neigh=0; neigh<size(); ++neigh)
                     {
-                        m_reqs.push_back( handle_type{} );
-                        GHEX_CHECK_MPI_RESULT(MPI_Isend(reinterpret_cast<const void*>(payload.data()), sizeof(T)*payload.size(), MPI_BYTE, neigh, 99, *this, &m_reqs.back().get()));
+                        recvcounts[neigh] = sizeof(T)*sizes[neigh];
+                        displs[neigh] = total;
+                        total += recvcounts[neigh];
                     }
-                    for (auto& r : m_reqs)
-                        r.wait();
-
-                    return {std::move(res), std::move(m_reqs.front())};
-
-                    /*handle_type h;
-                    std::vector<int> displs(size());
-                    std::vector<int> recvcounts(size());
+                    std::vector<T> flat(total/sizeof(T));
+                    GHEX_CHECK_MPI_RESULT(MPI_Allgatherv(
+                        reinterpret_cast<const void*>(payload.data()), sizeof(T)*payload.size(), MPI_BYTE,
+                        reinterpret_cast<void*>(flat.data()), recvcounts.data(), displs.data(), MPI_BYTE,
+                        *this));
                     std::vector<std::vector<T>> res(size());
-                    for (int i=0; i<size(); ++i)
+                    for (int neigh=0; neigh<size(); ++neigh)
                     {
-                        res[i].resize(sizes[i]);
-                        recvcounts[i] = sizes[i]*sizeof(T);
-                        displs[i] = reinterpret_cast<char*>(&res[i][0]) - reinterpret_cast<char*>(&res[0][0]);
+                        auto first = flat.begin() + displs[neigh]/sizeof(T);
+                        res[neigh].assign(first, first + sizes[neigh]);
                     }
-                    GHEX_CHECK_MPI_RESULT( MPI_Iallgatherv(
-                        &payload[0], payload.size()*sizeof(T), MPI_BYTE,
-                        &res[0][0], &recvcounts[0], &displs[0], MPI_BYTE,
-                        *this, 
-                        &h.m_req));
-                    return {std::move(res), std::move(h)};*/
+                    return {std::move(res), handle_type{}};
                 }
 
                 template<typename T>
@@ -149,6 +135,66 @@ namespace gridtools{
                     return *(std::max_element(all_max.begin(), all_max.end()));
                 }
 
+                /** @brief sparse data exchange: every rank sends one message to each rank of an arbitrary set of
+                  * destinations, without the receivers knowing their sources in advance. Uses the non-blocking
+                  * consensus algorithm (NBX): synchronous sends are posted, incoming messages are probed for, and
+                  * once all local sends have been matched a non-blocking barrier is entered; its completion signals
+                  * that all messages have been received everywhere. The cost scales with the number of messages
+                  * instead of the number of ranks. Note, that a rank may still be receiving when another rank has
+                  * already returned: back-to-back exchanges must use different tags (or be separated by a
+                  * collective operation).
+                  * @tparam T trivially copyable value type
+                  * @param messages map of destination rank to payload
+                  * @param tag tag reserved for this exchange
+                  * @return received messages as (source rank, payload) pairs */
+                template<typename T>
+                std::vector<std::pair<int,std::vector<T>>> sparse_exchange(const std::map<int,std::vector<T>>& messages, int tag) const
+                {
+                    std::vector<MPI_Request> send_reqs;
+                    send_reqs.reserve(messages.size());
+                    for (const auto& p : messages)
+                    {
+                        send_reqs.push_back(MPI_REQUEST_NULL);
+                        GHEX_CHECK_MPI_RESULT(MPI_Issend(reinterpret_cast<const void*>(p.second.data()),
+                            sizeof(T)*p.second.size(), MPI_BYTE, p.first, tag, *this, &send_reqs.back()));
+                    }
+                    std::vector<std::pair<int,std::vector<T>>> res;
+                    MPI_Request barrier_req = MPI_REQUEST_NULL;
+                    bool barrier_active = false;
+                    while (true)
+                    {
+                        int flag = 0;
+                        MPI_Status status;
+                        GHEX_CHECK_MPI_RESULT(MPI_Iprobe(MPI_ANY_SOURCE, tag, *this, &flag, &status));
+                        if (flag)
+                        {
+                            int count;
+                            GHEX_CHECK_MPI_RESULT(MPI_Get_count(&status, MPI_BYTE, &count));
+                            res.emplace_back(status.MPI_SOURCE, std::vector<T>(count/sizeof(T)));
+                            GHEX_CHECK_MPI_RESULT(MPI_Recv(reinterpret_cast<void*>(res.back().second.data()), count,
+                                MPI_BYTE, status.MPI_SOURCE, tag, *this, MPI_STATUS_IGNORE));
+                        }
+                        if (!barrier_active)
+                        {
+                            int sent = 0;
+                            GHEX_CHECK_MPI_RESULT(MPI_Testall(send_reqs.size(), send_reqs.data(), &sent,
+                                MPI_STATUSES_IGNORE));
+                            if (sent)
+                            {
+                                GHEX_CHECK_MPI_RESULT(MPI_Ibarrier(*this, &barrier_req));
+                                barrier_active = true;
+                            }
+                        }
+                        else
+                        {
+                            int done = 0;
+                            GHEX_CHECK_MPI_RESULT(MPI_Test(&barrier_req, &done, MPI_STATUS_IGNORE));
+                            if (done) break;
+                        }
+                    }
+                    return res;
+                }
+
                 /** @brief just a helper function using custom types to be used when send/recv counts can be deduced*/
                 template<typename T>
                 void all_to_all(const std::vector<T>& send_buf, std::vector<T>& recv_buf) const
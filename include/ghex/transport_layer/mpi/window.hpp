@@ -0,0 +1,176 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_TL_MPI_WINDOW_HPP
+#define INCLUDED_GHEX_TL_MPI_WINDOW_HPP
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "./error.hpp"
+
+namespace gridtools {
+    namespace ghex {
+        namespace tl {
+            namespace mpi {
+
+                /** @brief Dynamic MPI window for one-sided communication among the ranks of a communicator. The
+                  * window is created collectively and stays in a passive target epoch towards all ranks during its
+                  * whole lifetime, such that puts and atomic operations can be issued at any time without
+                  * involvement of the target.
+                  *
+                  * Memory exposed through the window is obtained with allocate(). Since the number of memory
+                  * regions which can be attached to a dynamic window is limited by many MPI implementations,
+                  * allocations are carved out of large segments which are attached once. A segment is detached and
+                  * freed as soon as all of its allocations have been released. This class is thread safe. */
+                class window
+                {
+                public: // member types
+                    /** @brief memory exposed through the window */
+                    struct buffer
+                    {
+                        unsigned char* m_ptr = nullptr;
+                        MPI_Aint       m_address = 0;  // address to be used by remote ranks
+                        std::size_t    m_size = 0;
+                    };
+
+                    static constexpr std::size_t alignment = 64;
+                    static constexpr std::size_t segment_size = 1u<<20;
+
+                private: // member types
+                    struct segment
+                    {
+                        std::unique_ptr<unsigned char[]> m_data;
+                        std::size_t m_size;
+                        std::size_t m_offset = 0;
+                        std::size_t m_count = 0;
+
+                        segment(std::size_t size) : m_data{new unsigned char[size]}, m_size{size} {}
+
+                        bool contains(const unsigned char* ptr) const noexcept
+                        {
+                            return ptr >= m_data.get() && ptr < m_data.get() + m_size;
+                        }
+                    };
+
+                private: // members
+                    MPI_Win m_win;
+                    int m_rank;
+                    std::mutex m_mutex;
+                    std::vector<std::unique_ptr<segment>> m_segments;
+
+                public: // ctors
+                    /** @brief create the window (collective over the communicator) */
+                    window(MPI_Comm comm)
+                    {
+                        GHEX_CHECK_MPI_RESULT(MPI_Comm_rank(comm, &m_rank));
+                        GHEX_CHECK_MPI_RESULT(MPI_Win_create_dynamic(MPI_INFO_NULL, comm, &m_win));
+                        GHEX_CHECK_MPI_RESULT(MPI_Win_lock_all(MPI_MODE_NOCHECK, m_win));
+                    }
+
+                    window(const window&) = delete;
+                    window& operator=(const window&) = delete;
+
+                    /** @brief free the window (collective over the communicator) */
+                    ~window()
+                    {
+                        MPI_Win_unlock_all(m_win);
+                        for (auto& s : m_segments) MPI_Win_detach(m_win, s->m_data.get());
+                        MPI_Win_free(&m_win);
+                    }
+
+                public: // member functions
+                    int rank() const noexcept { return m_rank; }
+
+                    /** @brief allocate memory which is exposed through the window
+                      * @param size number of bytes
+                      * @return buffer which must be released when it is no longer accessed */
+                    buffer allocate(std::size_t size)
+                    {
+                        size = size > 0u ? (size+alignment-1)/alignment*alignment : alignment;
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        if (m_segments.empty() || m_segments.back()->m_offset + size > m_segments.back()->m_size)
+                        {
+                            const std::size_t min_size = segment_size;
+                            m_segments.push_back(std::make_unique<segment>(size > min_size ? size : min_size));
+                            GHEX_CHECK_MPI_RESULT(MPI_Win_attach(m_win, m_segments.back()->m_data.get(),
+                                m_segments.back()->m_size));
+                        }
+                        auto& s = *m_segments.back();
+                        buffer b{s.m_data.get() + s.m_offset, 0, size};
+                        GHEX_CHECK_MPI_RESULT(MPI_Get_address(b.m_ptr, &b.m_address));
+                        s.m_offset += size;
+                        ++s.m_count;
+                        return b;
+                    }
+
+                    /** @brief release memory obtained from allocate() */
+                    void release(const buffer& b)
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        auto it = std::find_if(m_segments.begin(), m_segments.end(),
+                            [&b](const auto& s) { return s->contains(b.m_ptr); });
+                        if (it == m_segments.end() || --((*it)->m_count) > 0) return;
+                        if (std::next(it) == m_segments.end())
+                        {
+                            // keep the current segment for subsequent allocations
+                            (*it)->m_offset = 0;
+                            return;
+                        }
+                        MPI_Win_detach(m_win, (*it)->m_data.get());
+                        m_segments.erase(it);
+                    }
+
+                    /** @brief put data into the window of a rank (completes with flush()) */
+                    void put(const void* data, std::size_t size, int rank, MPI_Aint address)
+                    {
+                        GHEX_CHECK_MPI_RESULT(MPI_Put(data, (int)size, MPI_BYTE, rank, address, (int)size, MPI_BYTE,
+                            m_win));
+                    }
+
+                    /** @brief atomically read an int in the window of a rank */
+                    int load(int rank, MPI_Aint address)
+                    {
+                        int value;
+                        GHEX_CHECK_MPI_RESULT(MPI_Fetch_and_op(nullptr, &value, MPI_INT, rank, address, MPI_NO_OP,
+                            m_win));
+                        GHEX_CHECK_MPI_RESULT(MPI_Win_flush(rank, m_win));
+                        return value;
+                    }
+
+                    /** @brief atomically write an int in the window of a rank. Returns when the value has been
+                      * written at the target. */
+                    void store(int value, int rank, MPI_Aint address)
+                    {
+                        GHEX_CHECK_MPI_RESULT(MPI_Accumulate(&value, 1, MPI_INT, rank, address, 1, MPI_INT,
+                            MPI_REPLACE, m_win));
+                        GHEX_CHECK_MPI_RESULT(MPI_Win_flush(rank, m_win));
+                    }
+
+                    /** @brief complete all operations issued by the calling process to a rank at the target */
+                    void flush(int rank)
+                    {
+                        GHEX_CHECK_MPI_RESULT(MPI_Win_flush(rank, m_win));
+                    }
+
+                    /** @brief synchronize the public and private copies of the calling rank's window memory */
+                    void sync()
+                    {
+                        GHEX_CHECK_MPI_RESULT(MPI_Win_sync(m_win));
+                    }
+                };
+
+            } // namespace mpi
+        } // namespace tl
+    } // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_TL_MPI_WINDOW_HPP */
@@ -0,0 +1,372 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_TL_PROGRESS_THREAD_HPP
+#define INCLUDED_GHEX_TL_PROGRESS_THREAD_HPP
+
+#include "./callback_utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+extern "C"{
+#include <pthread.h>
+#include <sched.h>
+}
+
+namespace gridtools {
+    namespace ghex {
+        namespace tl {
+
+            /** @brief options of a progress thread */
+            struct progress_thread_options
+            {
+                // cpu the thread is pinned to (no pinning if negative)
+                int m_cpu = -1;
+                // number of idle polls before the thread starts yielding, and number of yielding polls before
+                // the thread starts sleeping
+                unsigned int m_spin_polls = 1000;
+                // upper bound of the sleep interval of an idle thread (the interval starts at 1us and is doubled
+                // on every idle poll); zero disables sleeping
+                std::chrono::microseconds m_max_sleep{100};
+                // capacity of the task queue (rounded up to a power of 2)
+                std::size_t m_queue_capacity = 1024;
+            };
+
+            /** @brief counters of a progress thread */
+            struct progress_thread_stats
+            {
+                std::uint64_t m_polls = 0u;
+                std::uint64_t m_tasks = 0u;
+                std::uint64_t m_sleeps = 0u;
+            };
+
+            namespace detail {
+
+                /** @brief bounded lock-free multi-producer multi-consumer queue (each cell carries a sequence
+                  * number which tells producers and consumers whether the cell is free or occupied).
+                  * @tparam T value type */
+                template<typename T>
+                class task_ring
+                {
+                private: // member types
+                    struct cell
+                    {
+                        std::atomic<std::size_t> m_sequence;
+                        T m_value;
+                    };
+
+                private: // members
+                    std::size_t m_mask;
+                    std::unique_ptr<cell[]> m_cells;
+                    // producer and consumer positions are kept on separate cache lines
+                    char m_pad0[64];
+                    std::atomic<std::size_t> m_enqueue_pos;
+                    char m_pad1[64];
+                    std::atomic<std::size_t> m_dequeue_pos;
+
+                public: // ctors
+                    task_ring(std::size_t capacity)
+                    {
+                        std::size_t n = 2u;
+                        while (n < capacity) n <<= 1;
+                        m_mask = n-1u;
+                        m_cells.reset(new cell[n]);
+                        for (std::size_t i=0; i<n; ++i) m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+                        m_enqueue_pos.store(0u, std::memory_order_relaxed);
+                        m_dequeue_pos.store(0u, std::memory_order_relaxed);
+                    }
+
+                    task_ring(const task_ring&) = delete;
+                    task_ring& operator=(const task_ring&) = delete;
+
+                public: // member functions
+                    /** @brief move a value into the queue
+                      * @return false if the queue is full (the value is left untouched) */
+                    bool try_push(T& value)
+                    {
+                        std::size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                        while (true)
+                        {
+                            cell& c = m_cells[pos & m_mask];
+                            const std::size_t seq = c.m_sequence.load(std::memory_order_acquire);
+                            const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+                            if (diff == 0)
+                            {
+                                if (m_enqueue_pos.compare_exchange_weak(pos, pos+1u, std::memory_order_relaxed))
+                                {
+                                    c.m_value = std::move(value);
+                                    c.m_sequence.store(pos+1u, std::memory_order_release);
+                                    return true;
+                                }
+                            }
+                            else if (diff < 0)
+                                return false;
+                            else
+                                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                        }
+                    }
+
+                    /** @brief move the oldest value out of the queue
+                      * @return false if the queue is empty */
+                    bool try_pop(T& value)
+                    {
+                        std::size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                        while (true)
+                        {
+                            cell& c = m_cells[pos & m_mask];
+                            const std::size_t seq = c.m_sequence.load(std::memory_order_acquire);
+                            const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos+1u);
+                            if (diff == 0)
+                            {
+                                if (m_dequeue_pos.compare_exchange_weak(pos, pos+1u, std::memory_order_relaxed))
+                                {
+                                    value = std::move(c.m_value);
+                                    c.m_sequence.store(pos+m_mask+1u, std::memory_order_release);
+                                    return true;
+                                }
+                            }
+                            else if (diff < 0)
+                                return false;
+                            else
+                                pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                        }
+                    }
+                };
+
+            } // namespace detail
+
+            /** @brief A dedicated thread which owns a communicator and progresses it continuously, so that
+              * callbacks (e.g. unpacking of received halos) run as soon as messages arrive, independently of
+              * the application threads. Since communicators are not thread safe, all operations on the owned
+              * communicator are handed over to the progress thread as tasks through a lock-free queue; results
+              * are typically handed back through atomic variables which are modified by the callbacks.
+              * When idle, the thread spins, then yields, and finally sleeps with exponentially growing
+              * intervals bounded by progress_thread_options::m_max_sleep.
+              * Note, that the transport must support concurrent use from several threads (for MPI,
+              * MPI_THREAD_MULTIPLE is required).
+              * @tparam Communicator communicator type */
+            template<typename Communicator>
+            class progress_thread
+            {
+            public: // member types
+                using communicator_type = Communicator;
+                using task_type         = cb::small_function<void(communicator_type&)>;
+
+            private: // members
+                communicator_type                m_comm;
+                progress_thread_options          m_options;
+                detail::task_ring<task_type>     m_tasks;
+                std::atomic<bool>                m_stop;
+                // number of threads which are currently inside submit()
+                std::atomic<int>                 m_submitters;
+                std::atomic<bool>                m_failed;
+                std::exception_ptr               m_error;
+                std::atomic<std::uint64_t>       m_polls;
+                std::atomic<std::uint64_t>       m_num_tasks;
+                std::atomic<std::uint64_t>       m_sleeps;
+                std::thread                      m_thread;
+                std::thread::id                  m_thread_id;
+
+            public: // ctors
+                /** @brief start the progress thread
+                  * @param comm communicator which is used exclusively by the progress thread
+                  * @param options pinning and backoff options */
+                progress_thread(communicator_type comm, progress_thread_options options = {})
+                : m_comm{comm}
+                , m_options{options}
+                , m_tasks{options.m_queue_capacity}
+                , m_stop{false}
+                , m_submitters{0}
+                , m_failed{false}
+                , m_polls{0u}
+                , m_num_tasks{0u}
+                , m_sleeps{0u}
+                , m_thread{[this](){ run(); }}
+                , m_thread_id{m_thread.get_id()}
+                {
+                    if (m_options.m_cpu >= 0 && !pin(m_options.m_cpu))
+                    {
+                        stop();
+                        throw std::runtime_error("could not pin progress thread");
+                    }
+                }
+
+                progress_thread(const progress_thread&) = delete;
+                progress_thread(progress_thread&&) = delete;
+
+                ~progress_thread() { join(); }
+
+            public: // member functions
+                /** @brief hand a task over to the progress thread. Tasks are executed in submission order (per
+                  * submitting thread) and are invoked with the owned communicator. If called from the progress
+                  * thread itself, the task is executed immediately. Blocks while the task queue is full. Throws
+                  * if the progress thread was stopped or has failed, in which case the task is not executed.
+                  * May be called concurrently with stop().
+                  * @tparam F callable type with signature void(communicator_type&)
+                  * @param f callable */
+                template<typename F>
+                void submit(F&& f)
+                {
+                    rethrow_if_failed();
+                    if (is_progress_thread())
+                    {
+                        f(m_comm);
+                        return;
+                    }
+                    // announce the submission before checking the stop flag: either stop() is observed here, or
+                    // the progress thread observes this submitter and waits for it before its final drain
+                    m_submitters.fetch_add(1, std::memory_order_seq_cst);
+                    submitter_guard guard{m_submitters};
+                    if (m_stop.load(std::memory_order_seq_cst))
+                        throw std::runtime_error("progress thread was stopped");
+                    task_type t{std::forward<F>(f)};
+                    while (!m_tasks.try_push(t))
+                    {
+                        rethrow_if_failed();
+                        std::this_thread::yield();
+                    }
+                    // a queued task is executed unless the progress thread fails
+                    rethrow_if_failed();
+                }
+
+                /** @brief stop the progress thread after all submitted tasks have been executed, including
+                  * tasks of submit() calls which are in flight. Pending communication is not awaited. Rethrows
+                  * exceptions raised on the progress thread. Must not be called concurrently with itself. */
+                void stop()
+                {
+                    join();
+                    rethrow_if_failed();
+                }
+
+                /** @brief rethrow an exception which was raised by a task or callback on the progress thread.
+                  * The progress thread terminates on the first exception. */
+                void rethrow_if_failed() const
+                {
+                    if (m_failed.load(std::memory_order_acquire)) std::rethrow_exception(m_error);
+                }
+
+                /** @brief whether the calling thread is the progress thread */
+                bool is_progress_thread() const noexcept
+                {
+                    return std::this_thread::get_id() == m_thread_id;
+                }
+
+                progress_thread_stats stats() const noexcept
+                {
+                    return {
+                        m_polls.load(std::memory_order_relaxed),
+                        m_num_tasks.load(std::memory_order_relaxed),
+                        m_sleeps.load(std::memory_order_relaxed)};
+                }
+
+                const progress_thread_options& options() const noexcept { return m_options; }
+
+            private: // implementation
+                struct submitter_guard
+                {
+                    std::atomic<int>& m_count;
+                    ~submitter_guard() { m_count.fetch_sub(1, std::memory_order_release); }
+                };
+
+                // raise the stop flag and wait for the thread, which in turn waits for in-flight submitters
+                void join()
+                {
+                    m_stop.store(true, std::memory_order_seq_cst);
+                    if (m_thread.joinable()) m_thread.join();
+                }
+
+                bool pin(int cpu)
+                {
+#if defined(__linux__)
+                    cpu_set_t set;
+                    CPU_ZERO(&set);
+                    CPU_SET(cpu, &set);
+                    return pthread_setaffinity_np(m_thread.native_handle(), sizeof(cpu_set_t), &set) == 0;
+#else
+                    return false;
+#endif
+                }
+
+                // execute all queued tasks
+                bool drain(task_type& t)
+                {
+                    bool active = false;
+                    while (m_tasks.try_pop(t))
+                    {
+                        t(m_comm);
+                        t.reset();
+                        m_num_tasks.fetch_add(1u, std::memory_order_relaxed);
+                        active = true;
+                    }
+                    return active;
+                }
+
+                void run()
+                {
+                    task_type t;
+                    unsigned int idle = 0u;
+                    std::chrono::microseconds sleep{1};
+                    try
+                    {
+                        while (true)
+                        {
+                            // tasks submitted before stop() was called are still executed
+                            const bool stopping = m_stop.load(std::memory_order_seq_cst);
+                            bool active = drain(t);
+                            active = (m_comm.progress().num() > 0) || active;
+                            m_polls.fetch_add(1u, std::memory_order_relaxed);
+                            if (stopping)
+                            {
+                                // submitters which have not observed the stop flag may still push: keep
+                                // draining (a full queue would block them) until all of them have left
+                                while (m_submitters.load(std::memory_order_seq_cst) != 0)
+                                {
+                                    if (!drain(t)) std::this_thread::yield();
+                                }
+                                drain(t);
+                                break;
+                            }
+                            if (active)
+                            {
+                                idle = 0u;
+                                sleep = std::chrono::microseconds{1};
+                                continue;
+                            }
+                            if (idle < 2u*m_options.m_spin_polls) ++idle;
+                            if (idle <= m_options.m_spin_polls) continue;
+                            if (idle < 2u*m_options.m_spin_polls || m_options.m_max_sleep.count() <= 0)
+                            {
+                                std::this_thread::yield();
+                                continue;
+                            }
+                            std::this_thread::sleep_for(sleep);
+                            m_sleeps.fetch_add(1u, std::memory_order_relaxed);
+                            sleep = std::min(2*sleep, m_options.m_max_sleep);
+                        }
+                    }
+                    catch (...)
+                    {
+                        m_error = std::current_exception();
+                        m_failed.store(true, std::memory_order_release);
+                    }
+                }
+            };
+
+        } // namespace tl
+    } // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_TL_PROGRESS_THREAD_HPP */
@@ -0,0 +1,199 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_TL_SHM_COMMUNICATOR_HPP
+#define INCLUDED_GHEX_TL_SHM_COMMUNICATOR_HPP
+
+#include "../shared_message_buffer.hpp"
+#include "../tags.hpp"
+#include "./future.hpp"
+#include "./communicator_state.hpp"
+
+namespace gridtools {
+
+    namespace ghex {
+
+        namespace tl {
+
+            namespace shm {
+
+                /** @brief A communicator which delivers messages to ranks on the same node through shared memory
+                  * (see node_state) and all other messages through MPI point-to-point communication.
+                  * This class is lightweight and copying/moving instances is safe and cheap.
+                  * Communicators can be created through the context, and are thread-compatible.
+                  */
+                class communicator {
+                  public: // member types
+                    using shared_state_type = shared_communicator_state;
+                    using state_type = communicator_state;
+                    using rank_type = typename state_type::rank_type;
+                    using tag_type = typename state_type::tag_type;
+                    using request = request_t;
+                    template<typename T>
+                    using future = typename state_type::template future<T>;
+                    using address_type    = rank_type;
+                    using request_cb_type = request_cb;
+                    using message_type    = typename request_cb_type::message_type;
+                    using progress_status = typename state_type::progress_status;
+
+                  private: // members
+                    shared_state_type* m_shared_state;
+                    state_type* m_state;
+
+                  public: // ctors
+                    communicator(shared_state_type* shared_state, state_type* state)
+                    : m_shared_state{shared_state}
+                    , m_state{state}
+                    {}
+                    communicator(const communicator&) = default;
+                    communicator(communicator&&) = default;
+                    communicator& operator=(const communicator&) = default;
+                    communicator& operator=(communicator&&) = default;
+
+                  public: // member functions
+                    rank_type rank() const noexcept { return m_shared_state->rank(); }
+                    rank_type size() const noexcept { return m_shared_state->size(); }
+                    address_type address() const noexcept { return rank(); }
+                    bool is_local(rank_type r) const noexcept { return m_shared_state->m_rank_topology.is_local(r); }
+                    rank_type local_rank() const noexcept { return m_shared_state->m_rank_topology.local_rank(); }
+                    auto mpi_comm() const noexcept { return m_shared_state->m_comm; }
+#ifdef GHEX_USE_MPI_RMA
+                    /** @brief window for one-sided communication, shared by all communicators of the context */
+                    mpi::window* mpi_window() const noexcept { return m_shared_state->m_window.get(); }
+#endif
+
+                    /** @brief send a message. The message must be kept alive by the caller until the communication is
+                     * finished.
+                     * @tparam Message a meassage type
+                     * @param msg an l-value reference to the message to be sent
+                     * @param dst the destination rank
+                     * @param tag the communication tag
+                     * @return a future to test/wait for completion */
+                    template<typename Message>
+                    [[nodiscard]] future<void> send(const Message& msg, rank_type dst, tag_type tag) {
+                        request req;
+                        req.m_kind = request_kind::send;
+                        const auto size = sizeof(typename Message::value_type) * msg.size();
+                        auto& node = m_shared_state->m_node;
+                        if (node.is_local(dst))
+                        {
+                            req.m_node = &node;
+                            req.m_op = node.send(msg.data(), size, dst, tag);
+                        }
+                        else
+                        {
+                            GHEX_CHECK_MPI_RESULT(MPI_Isend(reinterpret_cast<const void*>(msg.data()), size, MPI_BYTE,
+                                                            dst, tag, m_shared_state->m_comm, &req.m_mpi.get()));
+                        }
+                        return req;
+                    }
+
+                    /** @brief receive a message. The message must be kept alive by the caller until the communication is
+                     * finished.
+                     * @tparam Message a meassage type
+                     * @param msg an l-value reference to the message to be sent
+                     * @param src the source rank
+                     * @param tag the communication tag
+                     * @return a future to test/wait for completion */
+                    template<typename Message>
+                    [[nodiscard]] future<void> recv(Message& msg, rank_type src, tag_type tag) {
+                        request req;
+                        req.m_kind = request_kind::recv;
+                        const auto size = sizeof(typename Message::value_type) * msg.size();
+                        auto& node = m_shared_state->m_node;
+                        if (node.is_local(src))
+                        {
+                            req.m_node = &node;
+                            req.m_op = node.recv(msg.data(), size, src, tag);
+                        }
+                        else
+                        {
+                            GHEX_CHECK_MPI_RESULT(MPI_Irecv(reinterpret_cast<void*>(msg.data()), size, MPI_BYTE,
+                                                            src, tag, m_shared_state->m_comm, &req.m_mpi.get()));
+                        }
+                        return req;
+                    }
+
+                    /** @brief Function to poll the transport layer and check for completion of operations with an
+                      * associated callback. When an operation completes, the corresponfing call-back is invoked
+                      * with the message, rank and tag associated with this communication.
+                      * @return non-zero if any communication was progressed, zero otherwise. */
+                    progress_status progress() {
+                        m_shared_state->m_node.progress();
+                        return m_state->progress();
+                    }
+
+                   /** @brief send a message and get notified with a callback when the communication has finished.
+                     * The ownership of the message is transferred to this communicator and it is safe to destroy the
+                     * message at the caller's site.
+                     * Note, that the communicator has to be progressed explicitely in order to guarantee completion.
+                     * @tparam CallBack a callback type with the signature void(message_type, rank_type, tag_type)
+                     * @param msg r-value reference to any_message instance
+                     * @param dst the destination rank
+                     * @param tag the communication tag
+                     * @param callback a callback instance
+                     * @return a request to test (but not wait) for completion */
+                    template<typename CallBack>
+                    request_cb_type send(message_type&& msg, rank_type dst, tag_type tag, CallBack&& callback)
+                    {
+                        auto fut = send(msg, dst, tag);
+                        if (fut.ready())
+                        {
+                            callback(std::move(msg), dst, tag);
+                            ++(m_state->m_progressed_sends);
+                            return {};
+                        }
+                        else
+                        {
+                            return { &m_state->m_send_queue,
+                                m_state->m_send_queue.enqueue(std::move(msg), dst, tag, std::move(fut),
+                                        std::forward<CallBack>(callback))};
+                        }
+                    }
+
+                   /** @brief receive a message and get notified with a callback when the communication has finished.
+                     * The ownership of the message is transferred to this communicator and it is safe to destroy the
+                     * message at the caller's site.
+                     * Note, that the communicator has to be progressed explicitely in order to guarantee completion.
+                     * @tparam CallBack a callback type with the signature void(message_type, rank_type, tag_type)
+                     * @param msg r-value reference to any_message instance
+                     * @param src the source rank
+                     * @param tag the communication tag
+                     * @param callback a callback instance
+                     * @return a request to test (but not wait) for completion */
+                    template<typename CallBack>
+                    request_cb_type recv(message_type&& msg, rank_type src, tag_type tag, CallBack&& callback)
+                    {
+                        auto fut = recv(msg, src, tag);
+                        if (fut.ready())
+                        {
+                            callback(std::move(msg), src, tag);
+                            ++(m_state->m_progressed_recvs);
+                            return {};
+                        }
+                        else
+                        {
+                            return { &m_state->m_recv_queue,
+                                m_state->m_recv_queue.enqueue(std::move(msg), src, tag, std::move(fut),
+                                        std::forward<CallBack>(callback))};
+                        }
+                    }
+
+                };
+
+            } // namespace shm
+
+        } // namespace tl
+
+    } // namespace ghex
+
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_TL_SHM_COMMUNICATOR_HPP */
@@ -0,0 +1,245 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_TL_SHM_FUTURE_HPP
+#define INCLUDED_GHEX_TL_SHM_FUTURE_HPP
+
+#include <memory>
+#include <vector>
+#include "../mpi/future.hpp"
+#include "./node_state.hpp"
+
+namespace gridtools{
+    namespace ghex {
+        namespace tl {
+            namespace shm {
+
+                using request_kind = mpi::request_kind;
+
+                /** @brief raw handle of a request, which can be copied and tested in batches */
+                struct raw_request
+                {
+                    MPI_Request        m_req;
+                    detail::operation* m_op;
+                    node_state*        m_node;
+                };
+
+                /** @brief request of either an on-node operation or an MPI operation */
+                struct request_t
+                {
+                    mpi::request_t                     m_mpi;
+                    std::shared_ptr<detail::operation> m_op;   // nullptr for off-node operations
+                    node_state*                        m_node = nullptr;
+                    request_kind                       m_kind = request_kind::none;
+
+                    void wait()
+                    {
+                        if (!m_op) return m_mpi.wait();
+                        while (!test()) {}
+                    }
+
+                    bool test()
+                    {
+                        if (!m_op) return m_mpi.test();
+                        if (!m_op->done()) m_node->progress();
+                        if (!m_op->done()) return false;
+                        m_op->check();
+                        return true;
+                    }
+
+                    /** Cancel the request (only receives can be cancelled).
+                      * @return True if the request was successfully canceled */
+                    bool cancel()
+                    {
+                        if (m_kind != request_kind::recv) return false;
+                        if (m_op) return m_node->cancel(m_op.get());
+                        GHEX_CHECK_MPI_RESULT(MPI_Cancel(&m_mpi.get()));
+                        MPI_Status st;
+                        GHEX_CHECK_MPI_RESULT(MPI_Wait(&m_mpi.get(), &st));
+                        int flag = false;
+                        GHEX_CHECK_MPI_RESULT(MPI_Test_cancelled(&st, &flag));
+                        return flag;
+                    }
+
+                    raw_request raw() const noexcept { return {m_mpi.get(), m_op.get(), m_node}; }
+                };
+
+                /** @brief test an array of requests for completion in a single call: on-node operations are
+                  * progressed once and MPI requests are tested with MPI_Testsome.
+                  * @param reqs pointer to the requests
+                  * @param count number of requests
+                  * @param indices output array of size count receiving the positions of the completed requests
+                  * @return number of completed requests */
+                inline int test_some(raw_request* reqs, int count, int* indices)
+                {
+                    if (count == 0) return 0;
+                    for (int i=0; i<count; ++i)
+                    {
+                        if (reqs[i].m_node)
+                        {
+                            reqs[i].m_node->progress();
+                            break;
+                        }
+                    }
+                    static thread_local std::vector<MPI_Request> mpi_reqs;
+                    static thread_local std::vector<int> positions;
+                    static thread_local std::vector<int> mpi_indices;
+                    mpi_reqs.resize(0);
+                    positions.resize(0);
+                    int n = 0;
+                    for (int i=0; i<count; ++i)
+                    {
+                        if (reqs[i].m_op)
+                        {
+                            if (!reqs[i].m_op->done()) continue;
+                            reqs[i].m_op->check();
+                            indices[n++] = i;
+                        }
+                        else
+                        {
+                            mpi_reqs.push_back(reqs[i].m_req);
+                            positions.push_back(i);
+                        }
+                    }
+                    if (mpi_reqs.empty()) return n;
+                    mpi_indices.resize(mpi_reqs.size());
+                    const int m = mpi::test_some(mpi_reqs.data(), mpi_reqs.size(), mpi_indices.data());
+                    for (int k=0; k<m; ++k) indices[n++] = positions[mpi_indices[k]];
+                    // completed MPI requests have been freed
+                    for (std::size_t k=0; k<mpi_reqs.size(); ++k) reqs[positions[k]].m_req = mpi_reqs[k];
+                    return n;
+                }
+
+                template<typename RandomAccessIterator, typename Func>
+                static RandomAccessIterator test_any(RandomAccessIterator first, RandomAccessIterator last,
+                    Func&& get)
+                {
+                    for (auto it = first; it != last; ++it)
+                        if (get(*it).m_handle.test()) return it;
+                    return last;
+                }
+
+                template<typename RandomAccessIterator>
+                static RandomAccessIterator test_any(RandomAccessIterator first, RandomAccessIterator last)
+                {
+                    return test_any(first, last, [](auto& fut) -> auto& { return fut; });
+                }
+
+                /** @brief future template for non-blocking communication */
+                template<typename T>
+                struct future_t
+                {
+                    using value_type  = T;
+                    using handle_type = request_t;
+
+                    value_type m_data;
+                    handle_type m_handle;
+
+                    future_t(value_type&& data, handle_type&& h)
+                    :   m_data(std::move(data))
+                    ,   m_handle(std::move(h))
+                    {}
+                    future_t(const future_t&) = delete;
+                    future_t(future_t&&) = default;
+                    future_t& operator=(const future_t&) = delete;
+                    future_t& operator=(future_t&&) = default;
+
+                    void wait() { m_handle.wait(); }
+
+                    bool test() { return m_handle.test(); }
+
+                    bool ready() { return m_handle.test(); }
+
+                    [[nodiscard]] value_type get()
+                    {
+                        wait();
+                        return std::move(m_data);
+                    }
+
+                    bool is_recv() const noexcept { return (m_handle.m_kind == request_kind::recv); }
+
+                    /** Cancel the future.
+                      * @return True if the request was successfully canceled */
+                    bool cancel() { return m_handle.cancel(); }
+
+                    template<typename RandomAccessIterator>
+                    static RandomAccessIterator test_any(RandomAccessIterator first, RandomAccessIterator last) {
+                        return ::gridtools::ghex::tl::shm::test_any(first,last);
+                    }
+
+                    template<typename RandomAccessIterator, typename Func>
+                    static RandomAccessIterator test_any(RandomAccessIterator first, RandomAccessIterator last,
+                        Func&& get) {
+                        return ::gridtools::ghex::tl::shm::test_any(first,last,std::forward<Func>(get));
+                    }
+
+                    using raw_handle_type = raw_request;
+
+                    raw_handle_type raw_handle() const noexcept { return m_handle.raw(); }
+
+                    static int test_some(raw_handle_type* handles, int count, int* indices) {
+                        return ::gridtools::ghex::tl::shm::test_some(handles, count, indices);
+                    }
+                };
+
+                template<>
+                struct future_t<void>
+                {
+                    using handle_type = request_t;
+
+                    handle_type m_handle;
+
+                    future_t() noexcept = default;
+                    future_t(handle_type&& h)
+                    :   m_handle(std::move(h))
+                    {}
+                    future_t(const future_t&) = delete;
+                    future_t(future_t&&) = default;
+                    future_t& operator=(const future_t&) = delete;
+                    future_t& operator=(future_t&&) = default;
+
+                    void wait() { m_handle.wait(); }
+
+                    bool test() { return m_handle.test(); }
+
+                    bool ready() { return m_handle.test(); }
+
+                    void get() { wait(); }
+
+                    bool is_recv() const noexcept { return (m_handle.m_kind == request_kind::recv); }
+
+                    bool cancel() { return m_handle.cancel(); }
+
+                    template<typename RandomAccessIterator>
+                    static RandomAccessIterator test_any(RandomAccessIterator first, RandomAccessIterator last) {
+                        return ::gridtools::ghex::tl::shm::test_any(first,last);
+                    }
+
+                    template<typename RandomAccessIterator, typename Func>
+                    static RandomAccessIterator test_any(RandomAccessIterator first, RandomAccessIterator last,
+                        Func&& get) {
+                        return ::gridtools::ghex::tl::shm::test_any(first,last,std::forward<Func>(get));
+                    }
+
+                    using raw_handle_type = raw_request;
+
+                    raw_handle_type raw_handle() const noexcept { return m_handle.raw(); }
+
+                    static int test_some(raw_handle_type* handles, int count, int* indices) {
+                        return ::gridtools::ghex::tl::shm::test_some(handles, count, indices);
+                    }
+                };
+
+            } // namespace shm
+        } // namespace tl
+    } // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_TL_SHM_FUTURE_HPP */
@@ -0,0 +1,668 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_TL_SHM_NODE_STATE_HPP
+#define INCLUDED_GHEX_TL_SHM_NODE_STATE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../mpi/error.hpp"
+#include "../../rma/cma/access.hpp"
+#include "./ring_buffer.hpp"
+extern "C"{
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+}
+
+namespace gridtools {
+    namespace ghex {
+        namespace tl {
+            namespace shm {
+
+                /** @brief options of the shared memory transport */
+                struct context_options
+                {
+                    // capacity (in bytes) of the ring buffer of each ordered pair of ranks on a node (rounded up to a
+                    // power of 2)
+                    std::size_t m_ring_capacity = 1u<<16;
+                    // messages larger than this size (in bytes) are read by the receiver directly from the sender's
+                    // memory through cross memory attach (single copy); smaller messages are copied through the ring
+                    std::size_t m_rendezvous_threshold = 1u<<14;
+                    // use cross memory attach if it is permitted between all ranks of the node, otherwise large
+                    // messages are streamed through the ring in fragments (see rma::cma::allow_cma_access)
+                    bool m_use_cma = true;
+                    // yield the processor when progressing finds nothing to do. This is enabled automatically if
+                    // there are more ranks on the node than hardware threads.
+                    bool m_yield_when_idle = false;
+                };
+
+                namespace detail {
+
+                    /** @brief an on-node send or receive operation */
+                    struct operation
+                    {
+                        std::atomic<bool> m_done;
+                        unsigned char*    m_data;
+                        std::size_t       m_size;
+                        int               m_tag;
+                        int               m_peer; // index of the peer on the node
+                        int               m_error = 0; // errno value if the operation has failed
+
+                        operation(unsigned char* data, std::size_t size, int tag, int peer) noexcept
+                        : m_done{false}, m_data{data}, m_size{size}, m_tag{tag}, m_peer{peer}
+                        {}
+
+                        bool done() const noexcept { return m_done.load(std::memory_order_acquire); }
+                        void complete() noexcept { m_done.store(true, std::memory_order_release); }
+                        void fail(int error) noexcept { m_error = error; complete(); }
+
+                        /** @brief throw if the operation has failed (must only be called once it is done) */
+                        void check() const
+                        {
+                            if (m_error)
+                                throw std::runtime_error(std::string("on-node receive failed: ")
+                                    + std::strerror(m_error));
+                        }
+                    };
+
+                    /** @brief a message which has arrived before the matching receive was posted */
+                    struct unexpected_message
+                    {
+                        int                        m_tag;
+                        std::size_t                m_size;
+                        std::vector<unsigned char> m_data;
+                        std::size_t                m_received = 0u;
+                        // announced by rts: the data still resides in the sender's memory
+                        bool                       m_rendezvous = false;
+                        std::uint64_t              m_id = 0u;
+                        std::uint64_t              m_addr = 0u;
+                    };
+
+                    /** @brief a record (and the message it belongs to) waiting to be pushed into a ring */
+                    struct outgoing
+                    {
+                        std::shared_ptr<operation> m_op; // nullptr for control records
+                        record_header              m_header;
+                        std::size_t                m_offset;
+                    };
+
+                    /** @brief per-peer state of the on-node transport */
+                    struct peer
+                    {
+                        int         m_rank;
+                        pid_t       m_pid;
+                        ring_buffer m_out; // located in the peer's segment, written by this rank
+                        ring_buffer m_in;  // located in this rank's segment, written by the peer
+                        // sends are pushed in order, so that fragments of different messages never interleave
+                        std::deque<outgoing> m_sends;
+                        // posted receives which have not been matched yet
+                        std::deque<std::shared_ptr<operation>> m_recvs;
+                        // messages which have not been matched yet (in order of arrival)
+                        std::deque<std::unique_ptr<unexpected_message>> m_unexpected;
+                        // destination of the message which is currently streamed from this peer
+                        std::shared_ptr<operation> m_in_op;
+                        unexpected_message*        m_in_msg = nullptr;
+                        // sink for the remaining fragments of a message whose receive has failed
+                        std::unique_ptr<unexpected_message> m_discarded;
+                        std::size_t                m_in_offset = 0u;
+                        std::size_t                m_in_size = 0u;
+                    };
+
+                    /** @brief a shared memory segment mapped into this process */
+                    struct mapping
+                    {
+                        void*       m_ptr = nullptr;
+                        std::size_t m_size = 0u;
+
+                        mapping() noexcept = default;
+                        mapping(void* ptr, std::size_t size) noexcept : m_ptr{ptr}, m_size{size} {}
+                        mapping(const mapping&) = delete;
+                        mapping(mapping&& other) noexcept
+                        : m_ptr{std::exchange(other.m_ptr, nullptr)}, m_size{other.m_size} {}
+                        ~mapping() { if (m_ptr) munmap(m_ptr, m_size); }
+                    };
+
+                } // namespace detail
+
+                /** @brief On-node part of the shared memory transport, shared by all communicators of a context.
+                  * Every rank owns a POSIX shared memory segment with one lock-free single-producer single-consumer
+                  * ring buffer per rank on the node (including itself), into which that rank writes the messages
+                  * addressed to the owner. Messages up to the rendezvous threshold are copied through the ring.
+                  * Larger messages are announced through the ring and read by the receiver directly from the
+                  * sender's memory with process_vm_readv (single copy), or streamed through the ring in fragments
+                  * if cross memory attach is not permitted. Messages are matched by source and tag in the order
+                  * in which they were sent, like MPI messages.
+                  * The rings are lock-free across processes; within a process, posting operations and progressing
+                  * are serialized by a mutex. Construction is collective over the node.
+                  * Note, that on-node messages are only progressed by the communicators (progress, and testing or
+                  * waiting for futures): unlike MPI messages, they make no progress while a rank is blocked in an
+                  * MPI call.
+                  * Errors which occur while a message is received (receive buffer too small, failing cross memory
+                  * attach) do not interrupt progressing: the message is consumed, and the error is reported when
+                  * the receive is tested or waited for. */
+                class node_state
+                {
+                private: // member types
+                    using operation = detail::operation;
+                    using op_ptr    = std::shared_ptr<operation>;
+                    using peer      = detail::peer;
+
+                    static constexpr std::size_t max_name_length = 48;
+                    static constexpr std::uint64_t probe_value = 0x6768657873686d31ull;
+
+                    struct peer_info
+                    {
+                        char          m_name[max_name_length];
+                        pid_t         m_pid;
+                        std::uint64_t m_probe;
+                    };
+
+                private: // members
+                    context_options                m_options;
+                    std::size_t                    m_capacity;
+                    int                            m_local_rank;
+                    pid_t                          m_pid;
+                    bool                           m_cma = false;
+                    bool                           m_yield;
+                    std::uint64_t                  m_probe = probe_value;
+                    std::unordered_map<int, int>   m_index; // rank -> index of the peer on the node
+                    std::vector<detail::mapping>   m_segments;
+                    std::vector<peer>              m_peers;
+                    std::unordered_map<std::uint64_t, op_ptr> m_rendezvous; // sends waiting for fin
+                    std::uint64_t                  m_next_id = 0u;
+                    std::mutex                     m_mutex;
+
+                public: // ctors
+                    /** @brief set up the segments and rings of all ranks on this node
+                      * @param comm MPI communicator
+                      * @param options transport options */
+                    node_state(MPI_Comm comm, const context_options& options)
+                    : m_options{options}
+                    , m_pid{getpid()}
+                    {
+                        m_capacity = 4096u;
+                        while (m_capacity < m_options.m_ring_capacity) m_capacity <<= 1;
+
+                        int rank;
+                        GHEX_CHECK_MPI_RESULT(MPI_Comm_rank(comm, &rank));
+                        MPI_Comm node_comm;
+                        GHEX_CHECK_MPI_RESULT(MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL,
+                            &node_comm));
+                        int local_size;
+                        GHEX_CHECK_MPI_RESULT(MPI_Comm_rank(node_comm, &m_local_rank));
+                        GHEX_CHECK_MPI_RESULT(MPI_Comm_size(node_comm, &local_size));
+                        std::vector<int> ranks(local_size);
+                        GHEX_CHECK_MPI_RESULT(MPI_Allgather(&rank, 1, MPI_INT, ranks.data(), 1, MPI_INT, node_comm));
+                        for (int i=0; i<local_size; ++i) m_index[ranks[i]] = i;
+                        m_yield = m_options.m_yield_when_idle ||
+                            static_cast<unsigned int>(local_size) > std::thread::hardware_concurrency();
+
+                        // create the segment holding the rings written by the other ranks
+                        const std::size_t ring_size = (ring_buffer::footprint(m_capacity) + 63u) & ~std::size_t{63u};
+                        const std::size_t page_size = sysconf(_SC_PAGESIZE);
+                        const std::size_t segment_size = ((local_size*ring_size + page_size - 1u)/page_size)*page_size;
+                        const std::string name = make_name();
+                        const bool created = create_segment(name, segment_size);
+                        int all_created = created;
+                        GHEX_CHECK_MPI_RESULT(MPI_Allreduce(MPI_IN_PLACE, &all_created, 1, MPI_INT, MPI_LAND,
+                            node_comm));
+                        if (!all_created)
+                        {
+                            if (created) shm_unlink(name.c_str());
+                            MPI_Comm_free(&node_comm);
+                            throw std::runtime_error("could not create shared memory segment");
+                        }
+                        for (int i=0; i<local_size; ++i)
+                            ring_buffer::init(static_cast<unsigned char*>(m_segments[0].m_ptr) + i*ring_size);
+
+                        // exchange segment names, process ids and the probe address for cross memory attach
+                        // (does not relax the ptrace protection unless GHEX_CMA_ALLOW_ANY_PTRACER is defined)
+                        const bool cma_allowed = m_options.m_use_cma && rma::cma::allow_cma_access();
+                        peer_info info;
+                        std::memset(&info, 0, sizeof(peer_info));
+                        std::memcpy(info.m_name, name.c_str(), std::min(name.size(), max_name_length-1));
+                        info.m_pid = m_pid;
+                        info.m_probe = reinterpret_cast<std::uintptr_t>(&m_probe);
+                        std::vector<peer_info> infos(local_size);
+                        GHEX_CHECK_MPI_RESULT(MPI_Allgather(&info, sizeof(peer_info), MPI_BYTE, infos.data(),
+                            sizeof(peer_info), MPI_BYTE, node_comm));
+
+                        // map the segments of the other ranks
+                        bool mapped = true;
+                        for (int i=0; i<local_size; ++i)
+                            if (i != m_local_rank) mapped = attach_segment(infos[i].m_name, segment_size) && mapped;
+                        int all_mapped = mapped;
+                        GHEX_CHECK_MPI_RESULT(MPI_Allreduce(MPI_IN_PLACE, &all_mapped, 1, MPI_INT, MPI_LAND,
+                            node_comm));
+                        // all ranks have mapped the segment: the name is not needed any more
+                        shm_unlink(name.c_str());
+                        if (!all_mapped)
+                        {
+                            MPI_Comm_free(&node_comm);
+                            throw std::runtime_error("could not map shared memory segment");
+                        }
+
+                        // constructed in place: the queues of a peer are not nothrow movable
+                        std::vector<peer>(local_size).swap(m_peers);
+                        for (int i=0, j=1; i<local_size; ++i)
+                        {
+                            auto& p = m_peers[i];
+                            p.m_rank = ranks[i];
+                            p.m_pid = infos[i].m_pid;
+                            auto remote = static_cast<unsigned char*>(m_segments[i == m_local_rank ? 0 : j++].m_ptr);
+                            auto local = static_cast<unsigned char*>(m_segments[0].m_ptr);
+                            p.m_out = ring_buffer(remote + m_local_rank*ring_size, m_capacity);
+                            p.m_in = ring_buffer(local + i*ring_size, m_capacity);
+                        }
+
+                        // check whether cross memory attach is permitted between all ranks on the node
+                        int cma = cma_allowed;
+                        for (int i=0; i<local_size && cma; ++i)
+                            cma = probe_cma(infos[i].m_pid, infos[i].m_probe);
+                        GHEX_CHECK_MPI_RESULT(MPI_Allreduce(MPI_IN_PLACE, &cma, 1, MPI_INT, MPI_LAND, node_comm));
+                        m_cma = cma;
+                        GHEX_CHECK_MPI_RESULT(MPI_Comm_free(&node_comm));
+                    }
+
+                    node_state(const node_state&) = delete;
+                    node_state(node_state&&) = delete;
+
+                public: // member functions
+                    /** @brief return whether rank is located on this node */
+                    bool is_local(int rank) const noexcept { return m_index.find(rank) != m_index.end(); }
+
+                    /** @brief return whether large messages are transferred with cross memory attach */
+                    bool uses_cma() const noexcept { return m_cma; }
+
+                    /** @brief capacity of the ring buffers in bytes */
+                    std::size_t ring_capacity() const noexcept { return m_capacity; }
+
+                    /** @brief post a send to a rank on this node
+                      * @param data pointer to the message (must be kept alive until completion)
+                      * @param size message size in bytes
+                      * @param dst destination rank
+                      * @param tag message tag
+                      * @return the operation */
+                    op_ptr send(const void* data, std::size_t size, int dst, int tag)
+                    {
+                        const int idx = index_of(dst);
+                        auto op = std::make_shared<operation>(
+                            static_cast<unsigned char*>(const_cast<void*>(data)), size, tag, idx);
+                        record_header h;
+                        std::memset(&h, 0, sizeof(record_header));
+                        h.m_tag = tag;
+                        h.m_size = size;
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        if (m_cma && size > m_options.m_rendezvous_threshold)
+                        {
+                            h.m_kind = record_kind::rts;
+                            h.m_id = ++m_next_id;
+                            h.m_addr = reinterpret_cast<std::uintptr_t>(data);
+                            m_rendezvous[h.m_id] = op;
+                            m_peers[idx].m_sends.push_back({nullptr, h, 0u});
+                        }
+                        else
+                        {
+                            h.m_kind = record_kind::message;
+                            m_peers[idx].m_sends.push_back({op, h, 0u});
+                        }
+                        push(m_peers[idx]);
+                        return op;
+                    }
+
+                    /** @brief post a receive from a rank on this node
+                      * @param data pointer to the receive buffer (must be kept alive until completion)
+                      * @param size size of the receive buffer in bytes
+                      * @param src source rank
+                      * @param tag message tag
+                      * @return the operation */
+                    op_ptr recv(void* data, std::size_t size, int src, int tag)
+                    {
+                        const int idx = index_of(src);
+                        auto op = std::make_shared<operation>(static_cast<unsigned char*>(data), size, tag, idx);
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        auto& p = m_peers[idx];
+                        drain(p);
+                        for (auto it = p.m_unexpected.begin(); it != p.m_unexpected.end(); ++it)
+                        {
+                            auto& m = **it;
+                            if (m.m_tag != tag) continue;
+                            if (m.m_rendezvous)
+                            {
+                                finish(*op, fits(*op, m.m_size) ? read_remote(p, op->m_data, m.m_addr, m.m_size)
+                                                                : EMSGSIZE);
+                                send_fin(p, m.m_id);
+                            }
+                            else if (!fits(*op, m.m_size))
+                            {
+                                op->fail(EMSGSIZE);
+                                // a message which is still being streamed is received into the sink
+                                if (m.m_received < m.m_size) p.m_discarded = std::move(*it);
+                            }
+                            else
+                            {
+                                std::memcpy(op->m_data, m.m_data.data(), m.m_received);
+                                if (m.m_received == m.m_size)
+                                    op->complete();
+                                else
+                                {
+                                    // the message is still being streamed: receive the rest directly
+                                    p.m_in_op = op;
+                                    p.m_in_msg = nullptr;
+                                }
+                            }
+                            p.m_unexpected.erase(it);
+                            return op;
+                        }
+                        p.m_recvs.push_back(op);
+                        return op;
+                    }
+
+                    /** @brief cancel a receive which has not been matched yet
+                      * @return true if the receive was cancelled */
+                    bool cancel(const operation* op)
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        auto& recvs = m_peers[op->m_peer].m_recvs;
+                        auto it = std::find_if(recvs.begin(), recvs.end(),
+                            [op](const op_ptr& x) { return x.get() == op; });
+                        if (it == recvs.end()) return false;
+                        recvs.erase(it);
+                        return true;
+                    }
+
+                    /** @brief push pending sends and receive arriving messages. Returns immediately if another
+                      * thread is progressing.
+                      * @return number of processed records */
+                    int progress()
+                    {
+                        std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+                        if (!lock.owns_lock()) return 0;
+                        int n = 0;
+                        bool active = false;
+                        for (auto& p : m_peers)
+                        {
+                            n += drain(p);
+                            active = push(p) || active;
+                        }
+                        if (m_yield && n == 0 && !active)
+                        {
+                            lock.unlock();
+                            std::this_thread::yield();
+                        }
+                        return n;
+                    }
+
+                private: // implementation
+                    int index_of(int rank) const
+                    {
+                        auto it = m_index.find(rank);
+                        if (it == m_index.end())
+                            throw std::invalid_argument("rank " + std::to_string(rank)
+                                + " is not located on this node");
+                        return it->second;
+                    }
+
+                    static std::string make_name()
+                    {
+                        static std::atomic<unsigned long> counter{0ul};
+                        return "/ghex-tl-shm-" + std::to_string(getpid()) + "-" + std::to_string(counter++);
+                    }
+
+                    bool create_segment(const std::string& name, std::size_t size)
+                    {
+                        const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+                        if (fd < 0) return false;
+                        if (ftruncate(fd, size) != 0)
+                        {
+                            close(fd);
+                            shm_unlink(name.c_str());
+                            return false;
+                        }
+                        void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                        close(fd);
+                        if (ptr == MAP_FAILED)
+                        {
+                            shm_unlink(name.c_str());
+                            return false;
+                        }
+                        m_segments.emplace_back(ptr, size);
+                        return true;
+                    }
+
+                    bool attach_segment(const char* name, std::size_t size)
+                    {
+                        const int fd = shm_open(name, O_RDWR, 0600);
+                        if (fd < 0) return false;
+                        void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                        close(fd);
+                        if (ptr == MAP_FAILED) return false;
+                        m_segments.emplace_back(ptr, size);
+                        return true;
+                    }
+
+                    bool probe_cma(pid_t pid, std::uint64_t addr) const
+                    {
+                        std::uint64_t value = 0u;
+                        struct iovec local{&value, sizeof(value)};
+                        struct iovec remote{reinterpret_cast<void*>(addr), sizeof(value)};
+                        const auto n = process_vm_readv(pid, &local, 1, &remote, 1, 0);
+                        return n == static_cast<ssize_t>(sizeof(value)) && value == probe_value;
+                    }
+
+                    // read a message from the sender's memory
+                    // returns 0 on success and the errno value otherwise
+                    int read_remote(const peer& p, unsigned char* dst, std::uint64_t addr, std::size_t size)
+                    {
+                        if (p.m_pid == m_pid)
+                        {
+                            std::memcpy(dst, reinterpret_cast<const void*>(addr), size);
+                            return 0;
+                        }
+                        std::size_t done = 0u;
+                        while (done < size)
+                        {
+                            struct iovec local{dst + done, size - done};
+                            struct iovec remote{reinterpret_cast<void*>(addr + done), size - done};
+                            const auto n = process_vm_readv(p.m_pid, &local, 1, &remote, 1, 0);
+                            if (n < 0) return errno;
+                            if (n == 0) return EIO;
+                            done += n;
+                        }
+                        return 0;
+                    }
+
+                    static bool fits(const operation& op, std::size_t size) noexcept { return size <= op.m_size; }
+
+                    static void finish(operation& op, int error) noexcept
+                    {
+                        if (error) op.fail(error);
+                        else op.complete();
+                    }
+
+                    static op_ptr match(peer& p, int tag)
+                    {
+                        for (auto it = p.m_recvs.begin(); it != p.m_recvs.end(); ++it)
+                        {
+                            if ((*it)->m_tag != tag) continue;
+                            auto op = std::move(*it);
+                            p.m_recvs.erase(it);
+                            return op;
+                        }
+                        return {};
+                    }
+
+                    void send_fin(peer& p, std::uint64_t id)
+                    {
+                        record_header h;
+                        std::memset(&h, 0, sizeof(record_header));
+                        h.m_kind = record_kind::fin;
+                        h.m_id = id;
+                        p.m_sends.push_back({nullptr, h, 0u});
+                        push(p);
+                    }
+
+                    // push as many pending records to a peer as fit into its ring
+                    // returns whether any record was pushed
+                    bool push(peer& p)
+                    {
+                        bool pushed = false;
+                        while (!p.m_sends.empty())
+                        {
+                            auto& s = p.m_sends.front();
+                            auto& h = s.m_header;
+                            if (!s.m_op)
+                            {
+                                // control record
+                                if (p.m_out.available(sizeof(record_header)) < sizeof(record_header)) return pushed;
+                                h.m_length = 0u;
+                                p.m_out.push(h, nullptr);
+                                pushed = true;
+                                p.m_sends.pop_front();
+                                continue;
+                            }
+                            const std::size_t remaining = h.m_size - s.m_offset;
+                            const std::size_t avail = p.m_out.available(sizeof(record_header) + remaining);
+                            if (avail < sizeof(record_header)) return pushed;
+                            const std::size_t length = std::min(remaining, avail - sizeof(record_header));
+                            // avoid splitting messages into small fragments
+                            if (length < remaining && length < p.m_out.capacity()/4) return pushed;
+                            h.m_kind = (s.m_offset == 0u) ? record_kind::message : record_kind::fragment;
+                            h.m_length = length;
+                            p.m_out.push(h, s.m_op->m_data + s.m_offset);
+                            pushed = true;
+                            s.m_offset += length;
+                            if (s.m_offset < h.m_size) continue;
+                            s.m_op->complete();
+                            p.m_sends.pop_front();
+                        }
+                        return pushed;
+                    }
+
+                    // process all records which have arrived from a peer
+                    int drain(peer& p)
+                    {
+                        int n = 0;
+                        record_header h;
+                        while (p.m_in.peek(h))
+                        {
+                            switch (h.m_kind)
+                            {
+                                case record_kind::message:  on_message(p, h); break;
+                                case record_kind::fragment: on_fragment(p, h); break;
+                                case record_kind::rts:      on_rts(p, h); break;
+                                case record_kind::fin:      on_fin(h); break;
+                            }
+                            p.m_in.pop(h);
+                            ++n;
+                        }
+                        return n;
+                    }
+
+                    void on_message(peer& p, const record_header& h)
+                    {
+                        auto op = match(p, h.m_tag);
+                        if (op && fits(*op, h.m_size))
+                        {
+                            p.m_in.read(h, op->m_data);
+                            if (h.m_length == h.m_size)
+                                op->complete();
+                            else
+                            {
+                                p.m_in_op = std::move(op);
+                                p.m_in_msg = nullptr;
+                                p.m_in_offset = h.m_length;
+                                p.m_in_size = h.m_size;
+                            }
+                            return;
+                        }
+                        std::unique_ptr<detail::unexpected_message> m{new detail::unexpected_message};
+                        m->m_tag = h.m_tag;
+                        m->m_size = h.m_size;
+                        m->m_data.resize(h.m_size);
+                        p.m_in.read(h, m->m_data.data());
+                        m->m_received = h.m_length;
+                        if (h.m_length < h.m_size)
+                        {
+                            p.m_in_op.reset();
+                            p.m_in_msg = m.get();
+                            p.m_in_offset = h.m_length;
+                            p.m_in_size = h.m_size;
+                        }
+                        // the matched receive is too small: the message is dropped
+                        if (op)
+                        {
+                            op->fail(EMSGSIZE);
+                            p.m_discarded = std::move(m);
+                        }
+                        else
+                            p.m_unexpected.push_back(std::move(m));
+                    }
+
+                    void on_fragment(peer& p, const record_header& h)
+                    {
+                        unsigned char* dst = p.m_in_op ? p.m_in_op->m_data : p.m_in_msg->m_data.data();
+                        p.m_in.read(h, dst + p.m_in_offset);
+                        p.m_in_offset += h.m_length;
+                        if (p.m_in_msg) p.m_in_msg->m_received = p.m_in_offset;
+                        if (p.m_in_offset < p.m_in_size) return;
+                        if (p.m_in_op) p.m_in_op->complete();
+                        p.m_in_op.reset();
+                        p.m_in_msg = nullptr;
+                    }
+
+                    void on_rts(peer& p, const record_header& h)
+                    {
+                        if (auto op = match(p, h.m_tag))
+                        {
+                            finish(*op, fits(*op, h.m_size) ? read_remote(p, op->m_data, h.m_addr, h.m_size)
+                                                            : EMSGSIZE);
+                            send_fin(p, h.m_id);
+                            return;
+                        }
+                        std::unique_ptr<detail::unexpected_message> m{new detail::unexpected_message};
+                        m->m_tag = h.m_tag;
+                        m->m_size = h.m_size;
+                        m->m_rendezvous = true;
+                        m->m_id = h.m_id;
+                        m->m_addr = h.m_addr;
+                        p.m_unexpected.push_back(std::move(m));
+                    }
+
+                    void on_fin(const record_header& h)
+                    {
+                        auto it = m_rendezvous.find(h.m_id);
+                        if (it == m_rendezvous.end()) return;
+                        it->second->complete();
+                        m_rendezvous.erase(it);
+                    }
+                };
+
+            } // namespace shm
+        } // namespace tl
+    } // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_TL_SHM_NODE_STATE_HPP */
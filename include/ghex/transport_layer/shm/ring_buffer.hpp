@@ -0,0 +1,182 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_TL_SHM_RING_BUFFER_HPP
+#define INCLUDED_GHEX_TL_SHM_RING_BUFFER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+namespace gridtools {
+    namespace ghex {
+        namespace tl {
+            namespace shm {
+
+                /** @brief kinds of records which are exchanged through a ring buffer */
+                enum class record_kind : std::uint32_t
+                {
+                    message = 1,  // first (or only) part of a message, payload follows
+                    fragment,     // continuation of the message which is currently streamed
+                    rts,          // ready to send: the receiver reads the message from the sender's memory
+                    fin           // the receiver has read a message announced by rts
+                };
+
+                /** @brief header of a record */
+                struct record_header
+                {
+                    record_kind   m_kind;
+                    std::int32_t  m_tag;
+                    std::uint64_t m_size;   // size of the whole message
+                    std::uint64_t m_length; // size of the payload following this header
+                    std::uint64_t m_id;     // rendezvous id (rts, fin)
+                    std::uint64_t m_addr;   // address of the message in the sender's address space (rts)
+                };
+
+                /** @brief control block of a ring buffer. Producer and consumer positions are kept on separate
+                  * cache lines. */
+                struct ring_control
+                {
+                    alignas(64) std::atomic<std::uint64_t> m_head; // written by the producer
+                    alignas(64) std::atomic<std::uint64_t> m_tail; // written by the consumer
+                };
+
+                /** @brief Lock-free single-producer single-consumer byte ring located in shared memory. Records
+                  * consist of a header followed by their payload and wrap around the end of the buffer. The
+                  * producer publishes a record by advancing the head, the consumer releases it by advancing the
+                  * tail. Each side caches the position of the other side to avoid touching the remote cache line
+                  * on every operation.
+                  * This class is a process-local view: producer and consumer each hold their own instance. */
+                class ring_buffer
+                {
+                private: // members
+                    ring_control*  m_control = nullptr;
+                    unsigned char* m_data = nullptr;
+                    std::uint64_t  m_capacity = 0u;
+                    std::uint64_t  m_cached_head = 0u; // consumer side
+                    std::uint64_t  m_cached_tail = 0u; // producer side
+
+                public: // static member functions
+                    /** @brief number of bytes occupied by a ring buffer in shared memory
+                      * @param capacity data capacity in bytes (power of 2) */
+                    static constexpr std::size_t footprint(std::size_t capacity) noexcept
+                    {
+                        return sizeof(ring_control) + capacity;
+                    }
+
+                    /** @brief initialize the control block (must be called by the owner of the memory before
+                      * producer or consumer attach to it) */
+                    static void init(void* ptr) noexcept
+                    {
+                        auto c = new (ptr) ring_control;
+                        c->m_head.store(0u, std::memory_order_relaxed);
+                        c->m_tail.store(0u, std::memory_order_relaxed);
+                    }
+
+                public: // ctors
+                    ring_buffer() noexcept = default;
+
+                    /** @brief attach to an initialized ring buffer
+                      * @param ptr start of the ring buffer in shared memory
+                      * @param capacity data capacity in bytes (power of 2) */
+                    ring_buffer(void* ptr, std::size_t capacity) noexcept
+                    : m_control{static_cast<ring_control*>(ptr)}
+                    , m_data{static_cast<unsigned char*>(ptr) + sizeof(ring_control)}
+                    , m_capacity{capacity}
+                    , m_cached_head{m_control->m_head.load(std::memory_order_acquire)}
+                    , m_cached_tail{m_control->m_tail.load(std::memory_order_acquire)}
+                    {}
+
+                public: // member functions
+                    std::size_t capacity() const noexcept { return m_capacity; }
+
+                    /** @brief number of bytes which can be pushed (producer side). The consumer position is only
+                      * reloaded if less than the wanted number of bytes is known to be available.
+                      * @param wanted number of bytes the caller intends to push */
+                    std::size_t available(std::size_t wanted) noexcept
+                    {
+                        const auto head = m_control->m_head.load(std::memory_order_relaxed);
+                        if (m_capacity - (head - m_cached_tail) < wanted)
+                            m_cached_tail = m_control->m_tail.load(std::memory_order_acquire);
+                        return m_capacity - (head - m_cached_tail);
+                    }
+
+                    /** @brief append a record (producer side). The caller must make sure that enough space is
+                      * available.
+                      * @param h record header
+                      * @param payload pointer to h.m_length bytes */
+                    void push(const record_header& h, const void* payload) noexcept
+                    {
+                        const auto head = m_control->m_head.load(std::memory_order_relaxed);
+                        copy_in(head, &h, sizeof(record_header));
+                        if (payload) copy_in(head + sizeof(record_header), payload, h.m_length);
+                        m_control->m_head.store(head + sizeof(record_header) + h.m_length,
+                            std::memory_order_release);
+                    }
+
+                    /** @brief read the header of the oldest record (consumer side)
+                      * @return false if the ring is empty */
+                    bool peek(record_header& h) noexcept
+                    {
+                        const auto tail = m_control->m_tail.load(std::memory_order_relaxed);
+                        if (m_cached_head == tail)
+                        {
+                            m_cached_head = m_control->m_head.load(std::memory_order_acquire);
+                            if (m_cached_head == tail) return false;
+                        }
+                        copy_out(tail, &h, sizeof(record_header));
+                        return true;
+                    }
+
+                    /** @brief copy the payload of the oldest record (consumer side)
+                      * @param h header of the oldest record
+                      * @param dst destination of h.m_length bytes */
+                    void read(const record_header& h, void* dst) const noexcept
+                    {
+                        const auto tail = m_control->m_tail.load(std::memory_order_relaxed);
+                        copy_out(tail + sizeof(record_header), dst, h.m_length);
+                    }
+
+                    /** @brief release the oldest record (consumer side) */
+                    void pop(const record_header& h) noexcept
+                    {
+                        const auto tail = m_control->m_tail.load(std::memory_order_relaxed);
+                        m_control->m_tail.store(tail + sizeof(record_header) + h.m_length,
+                            std::memory_order_release);
+                    }
+
+                private: // implementation
+                    void copy_in(std::uint64_t pos, const void* src, std::size_t n) noexcept
+                    {
+                        if (n == 0u) return;
+                        const std::size_t first = pos & (m_capacity - 1u);
+                        const std::size_t n0 = std::min<std::size_t>(n, m_capacity - first);
+                        std::memcpy(m_data + first, src, n0);
+                        std::memcpy(m_data, static_cast<const unsigned char*>(src) + n0, n - n0);
+                    }
+
+                    void copy_out(std::uint64_t pos, void* dst, std::size_t n) const noexcept
+                    {
+                        if (n == 0u) return;
+                        const std::size_t first = pos & (m_capacity - 1u);
+                        const std::size_t n0 = std::min<std::size_t>(n, m_capacity - first);
+                        std::memcpy(dst, m_data + first, n0);
+                        std::memcpy(static_cast<unsigned char*>(dst) + n0, m_data, n - n0);
+                    }
+                };
+
+            } // namespace shm
+        } // namespace tl
+    } // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_TL_SHM_RING_BUFFER_HPP */
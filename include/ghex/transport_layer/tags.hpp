@@ -20,6 +20,10 @@ namespace gridtools {
             /** @brief mpi transport tag */
             struct mpi_tag {};
             struct ucx_tag {};
+            /** @brief hybrid transport tag: shared memory within a node, mpi across nodes */
+            struct shm_tag {};
+            /** @brief in-process transport tag: logical ranks are threads of one process */
+            struct inproc_tag {};
 
 
         } // namespace tl
@@ -11,9 +11,11 @@
 #ifndef INCLUDED_GHEX_TL_UCX_ADDRESS_HPP
 #define INCLUDED_GHEX_TL_UCX_ADDRESS_HPP
 
+#include <cstdint>
 #include <cstring>
 #include <iosfwd>
 #include <ios>
+#include <stdexcept>
 #include <vector>
 #include "./error.hpp"
 
@@ -72,6 +74,39 @@ namespace gridtools{
                     }
                 };
 
+                /** @brief concatenate several addresses into one address, e.g. in order to publish the addresses
+                  * of all workers of a rank at once. Each address is prefixed by its length. */
+                inline address_t join_addresses(const std::vector<address_t>& addresses)
+                {
+                    std::vector<unsigned char> buffer;
+                    for (const auto& addr : addresses)
+                    {
+                        const std::uint32_t length = addr.size();
+                        const auto first = reinterpret_cast<const unsigned char*>(&length);
+                        buffer.insert(buffer.end(), first, first + sizeof(std::uint32_t));
+                        buffer.insert(buffer.end(), addr.begin(), addr.end());
+                    }
+                    return {std::move(buffer)};
+                }
+
+                /** @brief extract the i-th address from an address created with join_addresses */
+                inline address_t select_address(const address_t& joined, std::size_t i)
+                {
+                    std::size_t pos = 0u;
+                    while (pos + sizeof(std::uint32_t) <= joined.size())
+                    {
+                        std::uint32_t length;
+                        std::memcpy(&length, joined.data() + pos, sizeof(std::uint32_t));
+                        pos += sizeof(std::uint32_t);
+                        if (pos + length > joined.size())
+                            break;
+                        if (i-- == 0u)
+                            return {joined.begin() + pos, joined.begin() + pos + length};
+                        pos += length;
+                    }
+                    throw std::runtime_error("ghex: ucx error - worker address not found");
+                }
+
             } // namespace ucx
         } // namespace tl
     } // namespace ghex
@@ -11,36 +11,118 @@
 #ifndef INCLUDED_GHEX_TL_UCX_ENDPOINT_DB_MPI_HPP
 #define INCLUDED_GHEX_TL_UCX_ENDPOINT_DB_MPI_HPP
 
-#include <map>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
 #include <vector>
 #include "../mpi/error.hpp"
 #include "./error.hpp"
 #include "./endpoint.hpp"
 #include "./address.hpp"
 
-#include <iostream>
-
 namespace gridtools {
     namespace ghex {
         namespace tl {
             namespace ucx {
 
+                /** @brief Address database which distributes the worker addresses through MPI. Two modes are
+                  * available:
+                  * - eager (default): all addresses are gathered at initialization with one MPI_Allgather of the
+                  *   address lengths and one MPI_Allgatherv of the addresses into a flat, rank-indexed buffer.
+                  * - lazy: every rank exposes its own address in an MPI window (a distributed directory) and the
+                  *   address of a peer is fetched with a one-sided get on first lookup, i.e. on the first connect
+                  *   to that peer. Initialization cost and memory then scale with the number of neighbors
+                  *   instead of the number of ranks. */
                 struct address_db_mpi
                 {
                     using key_t     = endpoint_t::rank_type;
                     using value_t   = address_t;
 
+                    // one-sided directory of the lazy mode: every rank exposes a slot of fixed size holding the
+                    // length of its address followed by the address
+                    struct directory
+                    {
+                        std::vector<unsigned char> m_slot;
+                        MPI_Win m_win;
+                        std::mutex m_mutex;
+                        std::unordered_map<key_t,value_t> m_cache;
+
+                        directory(MPI_Comm comm, const value_t& addr)
+                        {
+                            std::uint64_t size = addr.size();
+                            std::uint64_t max_size;
+                            GHEX_CHECK_MPI_RESULT(
+                                MPI_Allreduce(&size, &max_size, 1, MPI_UINT64_T, MPI_MAX, comm)
+                            );
+                            m_slot.resize(sizeof(std::uint64_t) + max_size);
+                            std::memcpy(m_slot.data(), &size, sizeof(std::uint64_t));
+                            std::memcpy(m_slot.data() + sizeof(std::uint64_t), addr.data(), size);
+                            GHEX_CHECK_MPI_RESULT(
+                                MPI_Win_create(m_slot.data(), m_slot.size(), 1, MPI_INFO_NULL, comm, &m_win)
+                            );
+                            GHEX_CHECK_MPI_RESULT(MPI_Win_lock_all(MPI_MODE_NOCHECK, m_win));
+                        }
+
+                        directory(const directory&) = delete;
+                        directory& operator=(const directory&) = delete;
+
+                        ~directory()
+                        {
+                            int finalized;
+                            MPI_Finalized(&finalized);
+                            if (!finalized)
+                            {
+                                MPI_Win_unlock_all(m_win);
+                                MPI_Win_free(&m_win);
+                            }
+                        }
+
+                        value_t find(key_t k)
+                        {
+                            std::lock_guard<std::mutex> lock(m_mutex);
+                            auto it = m_cache.find(k);
+                            if (it != m_cache.end())
+                                return it->second;
+                            std::vector<unsigned char> slot(m_slot.size());
+                            GHEX_CHECK_MPI_RESULT(
+                                MPI_Get(slot.data(), slot.size(), MPI_BYTE, k, 0, slot.size(), MPI_BYTE, m_win)
+                            );
+                            GHEX_CHECK_MPI_RESULT(MPI_Win_flush(k, m_win));
+                            std::uint64_t size;
+                            std::memcpy(&size, slot.data(), sizeof(std::uint64_t));
+                            if (size + sizeof(std::uint64_t) > slot.size())
+                                throw std::runtime_error("Invalid peer address in the MPI address directory.");
+                            slot.erase(slot.begin(), slot.begin() + sizeof(std::uint64_t));
+                            slot.resize(size);
+                            return m_cache.emplace(k, value_t{std::move(slot)}).first->second;
+                        }
+                    };
+
                     MPI_Comm m_mpi_comm;
                     const key_t m_rank;
                     const key_t m_size;
+                    const bool m_lazy;
 
                     value_t m_value;
-                    std::map<key_t,value_t> m_address_map;
+                    // eager mode: addresses of all ranks, the address of rank r is stored in
+                    // m_addresses[m_offsets[r]] ... m_addresses[m_offsets[r+1]-1]
+                    std::vector<unsigned char> m_addresses;
+                    std::vector<int> m_offsets;
+                    // lazy mode
+                    std::unique_ptr<directory> m_directory;
 
-                    address_db_mpi(MPI_Comm comm)
+                    /** @brief construct the database
+                      * @param comm MPI communicator
+                      * @param lazy whether peer addresses are fetched on demand */
+                    address_db_mpi(MPI_Comm comm, bool lazy = false)
                         : m_mpi_comm{comm}
                     , m_rank{ [](MPI_Comm c){ int r; GHEX_CHECK_MPI_RESULT(MPI_Comm_rank(c,&r)); return r; }(comm) }
                     , m_size{ [](MPI_Comm c){ int s; GHEX_CHECK_MPI_RESULT(MPI_Comm_size(c,&s)); return s; }(comm) }
+                    , m_lazy{lazy}
                     {}
 
                     address_db_mpi(const address_db_mpi&) = delete;
@@ -49,48 +131,46 @@ namespace gridtools {
                     key_t rank() const noexcept { return m_rank; }
                     key_t size() const noexcept { return m_size; }
                     int est_size() const noexcept { return m_size; }
+                    bool lazy() const noexcept { return m_lazy; }
 
                     value_t find(key_t k)
                     {
-                        auto it = m_address_map.find(k);
-                        if (it != m_address_map.end())
-                        {
-                            return it->second;
-                        }
-                        throw std::runtime_error("Cound not find peer address in the MPI address xdatabase.");
+                        if (k == m_rank)
+                            return m_value;
+                        if (k < 0 || k >= m_size)
+                            throw std::runtime_error("Cound not find peer address in the MPI address xdatabase.");
+                        if (m_directory)
+                            return m_directory->find(k);
+                        if (m_offsets.empty() || m_lazy)
+                            throw std::runtime_error("MPI address database is not initialized.");
+                        return value_t{m_addresses.begin() + m_offsets[k], m_addresses.begin() + m_offsets[k+1]};
                     }
 
                     void init(const value_t& addr)
                     {
                         m_value = addr;
-                        m_address_map[m_rank] = addr;
-                        for (key_t r=0; r<m_size; ++r)
+                        if (m_lazy)
                         {
-                            if (r==m_rank)
-                            {
-                                std::size_t size = m_value.size();
-                                GHEX_CHECK_MPI_RESULT(
-                                    MPI_Bcast(&size, sizeof(std::size_t), MPI_BYTE, r, m_mpi_comm)
-                                );
-                                GHEX_CHECK_MPI_RESULT(
-                                    MPI_Bcast(m_value.data(), m_value.size(), MPI_BYTE, r, m_mpi_comm)
-                                );
-                            }
-                            else
-                            {
-                                std::size_t size;
-                                GHEX_CHECK_MPI_RESULT(
-                                    MPI_Bcast(&size, sizeof(std::size_t), MPI_BYTE, r, m_mpi_comm)
-                                );
-                                value_t addr(size);
-                                GHEX_CHECK_MPI_RESULT(
-                                    MPI_Bcast(addr.data(), size, MPI_BYTE, r, m_mpi_comm)
-                                );
-                                m_address_map[r] = addr;
-                            }
+                            // a single rank only connects to itself
+                            if (m_size > 1)
+                                m_directory.reset(new directory(m_mpi_comm, m_value));
+                            return;
                         }
+                        int size = m_value.size();
+                        std::vector<int> sizes(m_size);
+                        GHEX_CHECK_MPI_RESULT(
+                            MPI_Allgather(&size, 1, MPI_INT, sizes.data(), 1, MPI_INT, m_mpi_comm)
+                        );
+                        m_offsets.resize(m_size+1);
+                        m_offsets[0] = 0;
+                        for (key_t r=0; r<m_size; ++r)
+                            m_offsets[r+1] = m_offsets[r] + sizes[r];
+                        m_addresses.resize(m_offsets[m_size]);
+                        GHEX_CHECK_MPI_RESULT(
+                            MPI_Allgatherv(m_value.data(), size, MPI_BYTE, m_addresses.data(), sizes.data(),
+                                m_offsets.data(), MPI_BYTE, m_mpi_comm)
+                        );
                     }
-
                 };
 
             } // namespace ucx
@@ -28,6 +28,11 @@ namespace gridtools {
 #define GHEX_SPECIFIC_SOURCE_MASK           0x00000000fffffffful
 #define GHEX_TAG_MASK                       0xffffffff00000000ul
 
+// buffers in registered memory are posted with their memory handle, which requires the nbx interface of ucx 1.10
+#if defined(GHEX_UCX_USE_REGISTRATION_CACHE) && (UCP_API_VERSION >= UCP_VERSION(1, 10))
+#define GHEX_UCX_POST_WITH_MEMH
+#endif
+
 		
                 struct communicator
                 {
@@ -74,6 +79,11 @@ namespace gridtools {
                     bool is_local(rank_type r) const noexcept { return m_recv_worker->rank_topology().is_local(r); }
                     rank_type local_rank() const noexcept { return m_recv_worker->rank_topology().local_rank(); }
                     auto mpi_comm() const noexcept { return m_recv_worker->rank_topology().mpi_comm(); }
+                    /** @brief cache of the memory registered with the context of this communicator */
+                    std::shared_ptr<registration_cache> get_registration_cache() const noexcept
+                    {
+                        return m_send_worker->m_rcache;
+                    }
 
                     /** @brief send a message. The message must be kept alive by the caller until the communication is
                      * finished.
@@ -88,13 +98,12 @@ namespace gridtools {
                         const auto& ep = m_send_worker->connect(dst);
                         const auto stag = ((std::uint_fast64_t)tag << GHEX_TAG_BITS) |
                                            (std::uint_fast64_t)(rank());
-                        auto ret = ucp_tag_send_nb(
+                        const auto size = msg.size()*sizeof(typename Message::value_type);
+                        auto ret = tag_send<&communicator::empty_send_callback>(
                             ep.get(),                                        // destination
                             msg.data(),                                      // buffer
-                            msg.size()*sizeof(typename Message::value_type), // buffer size
-                            ucp_dt_make_contig(1),                           // data type
-                            stag,                                            // tag
-                            &communicator::empty_send_callback);             // callback function pointer: empty here
+                            size,                                            // buffer size
+                            stag);                                           // tag
 
                         if (reinterpret_cast<std::uintptr_t>(ret) == UCS_OK)
                         {
@@ -128,15 +137,14 @@ namespace gridtools {
 			const auto rtag_mask = (GHEX_ANY_SOURCE == src) ?
 			    (GHEX_TAG_MASK | GHEX_ANY_SOURCE_MASK) :
 			    (GHEX_TAG_MASK | GHEX_SPECIFIC_SOURCE_MASK);
-                        std::lock_guard<worker_type::mutex_t> lock(m_send_worker->mutex());
-                                auto ret = ucp_tag_recv_nb(
+                        auto lock = m_recv_worker->lock();
+                                const auto size = msg.size()*sizeof(typename Message::value_type);
+                                auto ret = tag_recv<&communicator::empty_recv_callback>(
                                     m_recv_worker->get(),                            // worker
                                     msg.data(),                                      // buffer
-                                    msg.size()*sizeof(typename Message::value_type), // buffer size
-                                    ucp_dt_make_contig(1),                           // data type
+                                    size,                                            // buffer size
                                     rtag,                                            // tag
-                                    rtag_mask,                                       // tag mask
-                                    &communicator::empty_recv_callback);             // callback function pointer: empty here
+                                    rtag_mask);                                      // tag mask
                                 if(!UCS_PTR_IS_ERR(ret))
                                 {
                                     if (UCS_INPROGRESS != ucp_request_check_status(ret))
@@ -172,13 +180,14 @@ namespace gridtools {
 			while((c = ucp_worker_progress(m_ucp_sw))) p+=c;
 
                         /* this is really important for large-scale multithreading */
-                        sched_yield();
+                        m_send_worker->yield(p > 0);
 
                         status.m_num_sends = std::exchange(m_send_worker->m_progressed_sends, 0);
                         {
-                        std::lock_guard<worker_type::mutex_t> lock(m_send_worker->mutex());
-                        int c;
-                        while((c = ucp_worker_progress(m_ucp_rw))) p+=c;
+                        auto lock = m_recv_worker->lock();
+                        // a worker owned by this thread was progressed above already
+                        if (m_recv_worker != m_send_worker || m_recv_worker->shared())
+                            while((c = ucp_worker_progress(m_ucp_rw))) p+=c;
                         status.m_num_recvs = std::exchange(m_recv_worker->m_progressed_recvs, 0);
                         status.m_num_cancels = std::exchange(m_recv_worker->m_progressed_cancels, 0);
                         }
@@ -201,13 +210,11 @@ namespace gridtools {
                         const auto& ep = m_send_worker->connect(dst);
                         const auto stag = ((std::uint_fast64_t)tag << GHEX_TAG_BITS) |
                                            (std::uint_fast64_t)(rank());
-                        auto ret = ucp_tag_send_nb(
+                        auto ret = tag_send<&communicator::send_callback>(
                             ep.get(),                                        // destination
                             msg.data(),                                      // buffer
                             msg.size(),                                      // buffer size
-                            ucp_dt_make_contig(1),                           // data type
-                            stag,                                            // tag
-                            &communicator::send_callback);                   // callback function pointer
+                            stag);                                           // tag
 
                         if (reinterpret_cast<std::uintptr_t>(ret) == UCS_OK)
                         {
@@ -255,15 +262,13 @@ namespace gridtools {
 			const auto rtag_mask = (GHEX_ANY_SOURCE == src) ?
 			    (GHEX_TAG_MASK | GHEX_ANY_SOURCE_MASK) :
 			    (GHEX_TAG_MASK | GHEX_SPECIFIC_SOURCE_MASK);
-                        std::lock_guard<worker_type::mutex_t> lock(m_send_worker->mutex());
-                        auto ret = ucp_tag_recv_nb(
+                        auto lock = m_recv_worker->lock();
+                        auto ret = tag_recv<&communicator::recv_callback>(
                                     m_ucp_rw,                                        // worker
                                     msg.data(),                                      // buffer
                                     msg.size(),                                      // buffer size
-                                    ucp_dt_make_contig(1),                           // data type
                                     rtag,                                            // tag
-                                    rtag_mask,                                       // tag mask
-                                    &communicator::recv_callback);                   // callback function pointer
+                                    rtag_mask);                                      // tag mask
                                 if(!UCS_PTR_IS_ERR(ret))
                                 {
                                     if (UCS_INPROGRESS != ucp_request_check_status(ret))
@@ -299,6 +304,58 @@ namespace gridtools {
 
                 private:
 
+                    // post a tagged send. With GHEX_UCX_POST_WITH_MEMH, buffers in registered memory are sent with
+                    // the nbx interface which takes the memory handle.
+                    template<void (*Callback)(void*, ucs_status_t)>
+                    ucs_status_ptr_t tag_send(ucp_ep_h ep, const void* buffer, std::size_t size, ucp_tag_t tag)
+                    {
+#ifdef GHEX_UCX_POST_WITH_MEMH
+                        if (auto memh = m_send_worker->memory_handle(buffer, size))
+                        {
+                            ucp_request_param_t param;
+                            param.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK | UCP_OP_ATTR_FIELD_MEMH;
+                            param.cb.send = &send_nbx_callback<Callback>;
+                            param.memh = memh;
+                            return ucp_tag_send_nbx(ep, buffer, size, tag, &param);
+                        }
+#endif
+                        return ucp_tag_send_nb(ep, buffer, size, ucp_dt_make_contig(1), tag, Callback);
+                    }
+
+                    // post a tagged receive (see tag_send). Immediate completion of the nbx receive is disabled in
+                    // order to obtain a request in any case, as with ucp_tag_recv_nb.
+                    template<void (*Callback)(void*, ucs_status_t, ucp_tag_recv_info_t*)>
+                    ucs_status_ptr_t tag_recv(ucp_worker_h worker, void* buffer, std::size_t size, ucp_tag_t tag,
+                        ucp_tag_t tag_mask)
+                    {
+#ifdef GHEX_UCX_POST_WITH_MEMH
+                        if (auto memh = m_recv_worker->memory_handle(buffer, size))
+                        {
+                            ucp_request_param_t param;
+                            param.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK | UCP_OP_ATTR_FIELD_MEMH |
+                                UCP_OP_ATTR_FLAG_NO_IMM_CMPL;
+                            param.cb.recv = &recv_nbx_callback<Callback>;
+                            param.memh = memh;
+                            return ucp_tag_recv_nbx(worker, buffer, size, tag, tag_mask, &param);
+                        }
+#endif
+                        return ucp_tag_recv_nb(worker, buffer, size, ucp_dt_make_contig(1), tag, tag_mask, Callback);
+                    }
+
+#ifdef GHEX_UCX_POST_WITH_MEMH
+                    template<void (*Callback)(void*, ucs_status_t)>
+                    static void send_nbx_callback(void* ucx_req, ucs_status_t status, void*)
+                    {
+                        Callback(ucx_req, status);
+                    }
+
+                    template<void (*Callback)(void*, ucs_status_t, ucp_tag_recv_info_t*)>
+                    static void recv_nbx_callback(void* ucx_req, ucs_status_t status, const ucp_tag_recv_info_t* info, void*)
+                    {
+                        Callback(ucx_req, status, const_cast<ucp_tag_recv_info_t*>(info));
+                    }
+#endif
+
                     static void empty_send_callback(void *, ucs_status_t) {}
 
                     static void empty_recv_callback(void *, ucs_status_t, ucp_tag_recv_info_t*) {}
@@ -30,6 +30,21 @@ namespace gridtools {
         namespace tl {
             namespace ucx {
 
+                /** @brief options of the ucx transport context */
+                struct context_options
+                {
+                    // number of per-thread workers: communicators obtained with get_communicator(thread_id) own the
+                    // worker of the thread with the given index and send and receive without locking. Messages sent
+                    // by the communicator of thread i are received by the communicator of thread i on the
+                    // destination rank, i.e. every thread has its own tag space.
+                    int m_num_thread_workers = 0;
+                    // when progressing communicators yield the processor
+                    yield_policy m_yield = yield_policy::always;
+                    // messages of at least this size (in bytes) residing in registered memory are sent and received
+                    // with their memory handle (see registration_cache)
+                    std::size_t m_registration_threshold = 8192u;
+                };
+
                 struct transport_context
                 {
                 public: // member types
@@ -54,9 +69,12 @@ namespace gridtools {
                     const mpi::rank_topology&    m_rank_topology;
                     type_erased_address_db_t     m_db;
                     ucp_context_h_holder         m_context;
+                    std::shared_ptr<registration_cache> m_rcache;
                     std::size_t                  m_req_size;
+                    context_options              m_options;
                     std::unique_ptr<worker_type> m_worker;  // shared, serialized - per rank
                     worker_vector                m_workers; // per thread
+                    worker_vector                m_thread_workers; // per thread index, owned by one thread
                     mutex_t                      m_mutex;
 
                     friend class worker_t;
@@ -75,6 +93,8 @@ namespace gridtools {
                             // make communicators from workers and progress
                             for (auto& w_ptr : m_workers)
                                 communicator_type{m_worker.get(), w_ptr.get()}.progress();
+                            for (auto& w_ptr : m_thread_workers)
+                                communicator_type{w_ptr.get(), w_ptr.get()}.progress();
                             communicator_type{m_worker.get(), m_worker.get()}.progress();
                             MPI_Test(&req, &flag, MPI_STATUS_IGNORE);
                             if(flag) break;
@@ -82,17 +102,22 @@ namespace gridtools {
                         // close endpoints
                         for (auto& w_ptr : m_workers)
                             w_ptr->m_endpoint_cache.clear();
+                        for (auto& w_ptr : m_thread_workers)
+                            w_ptr->m_endpoint_cache.clear();
                         m_worker->m_endpoint_cache.clear();
                         // another MPI barrier to be sure
                         MPI_Barrier(m_mpi_comm);
+                        // registered memory may outlive the context
+                        m_rcache->detach();
                     }
 
                 public: // ctors
                     template<typename DB>
-                    transport_context(const mpi::rank_topology& t, DB&& db)
+                    transport_context(const mpi::rank_topology& t, DB&& db, context_options options = {})
                         : m_mpi_comm{t.mpi_comm()}
                         , m_rank_topology{t}
                         , m_db{std::forward<DB>(db)}
+                        , m_options{options}
                     {
                         // read run-time context
                         ucp_config_t* config_ptr;
@@ -149,13 +174,24 @@ namespace gridtools {
                         if (attr.thread_mode != UCS_THREAD_MODE_MULTI)
                             throw std::runtime_error("ucx cannot be used with multi-threaded context");
 
+                        // memory is registered with this context through the cache handed out by its communicators
+                        m_rcache = std::make_shared<registration_cache>(get(), m_options.m_registration_threshold);
+
                         // make shared worker
                         // use single-threaded UCX mode, as per developer advice
                         // https://github.com/openucx/ucx/issues/4609
-                        m_worker.reset(new worker_type{get(), m_db, m_mutex, UCS_THREAD_MODE_SINGLE, m_rank_topology});
+                        m_worker = make_worker(UCS_THREAD_MODE_SINGLE);
+
+                        // make per-thread workers: each one is used by a single thread at a time
+                        std::vector<address_t> addresses{m_worker->address()};
+                        for (int i=0; i<m_options.m_num_thread_workers; ++i)
+                        {
+                            m_thread_workers.push_back(make_worker(UCS_THREAD_MODE_SINGLE, i));
+                            addresses.push_back(m_thread_workers.back()->address());
+                        }
 
                         // intialize database
-                        m_db.init(m_worker->address());
+                        m_db.init(join_addresses(addresses));
                     }
 
                     MPI_Comm mpi_comm() const noexcept { return m_mpi_comm; }
@@ -169,13 +205,39 @@ namespace gridtools {
                     {
                         std::lock_guard<mutex_t> lock(m_mutex); // we need to guard only the insertion in the vector,
                                                                 // but this is not a performance critical section
-                        m_workers.push_back(std::make_unique<worker_type>(get(), m_db, m_mutex, UCS_THREAD_MODE_SERIALIZED, m_rank_topology));
+                        m_workers.push_back(make_worker(UCS_THREAD_MODE_SERIALIZED));
                     return {m_worker.get(), m_workers[m_workers.size()-1].get()};
                     }
 
+                    /** @brief return the communicator owning the worker of the thread with the given index, which is
+                      * used for both sending and receiving without locking. The communicator must only be used by one
+                      * thread at a time and only exchanges messages with the communicators of the same thread index on
+                      * other ranks. */
+                    communicator_type get_communicator(int thread_id)
+                    {
+                        if (thread_id < 0 || thread_id >= m_options.m_num_thread_workers)
+                            throw std::runtime_error("ghex: ucx error - no worker for this thread index");
+                        auto w_ptr = m_thread_workers[thread_id].get();
+                        return {w_ptr, w_ptr};
+                    }
+
+                    const context_options& options() const noexcept { return m_options; }
+
+                    /** @brief cache of the memory registered with this context */
+                    std::shared_ptr<registration_cache> get_registration_cache() const noexcept { return m_rcache; }
+
                     rank_type rank() const { return m_db.rank(); }
                     rank_type size() const { return m_db.size(); }
                     ucp_context_h get() const noexcept { return m_context.m_context; }
+
+                private:
+                    std::unique_ptr<worker_type> make_worker(ucs_thread_mode_t mode, int thread_id = -1)
+                    {
+                        auto w = std::make_unique<worker_type>(get(), m_db, m_mutex, mode, m_rank_topology, thread_id,
+                            m_options.m_yield);
+                        w->m_rcache = m_rcache;
+                        return w;
+                    }
                 };
 
             } // namespace ucx
@@ -184,16 +246,18 @@ namespace gridtools {
             struct context_factory<ucx_tag>
             {
                 using context_type = context<ucx::transport_context>;
-                static std::unique_ptr<context_type> create(MPI_Comm comm)
+                static std::unique_ptr<context_type> create(MPI_Comm comm, ucx::context_options options = {})
                 {
                     auto new_comm = detail::clone_mpi_comm(comm);
 #if defined GHEX_USE_PMI
                     ucx::address_db_pmi addr_db{new_comm};
+#elif defined GHEX_UCX_USE_LAZY_ADDRESS_DB
+                    ucx::address_db_mpi addr_db{new_comm, true};
 #else
                     ucx::address_db_mpi addr_db{new_comm};
 #endif
                     return std::unique_ptr<context_type>{
-                        new context_type{new_comm, std::move(addr_db)}};
+                        new context_type{new_comm, std::move(addr_db), options}};
                 }
             };
 
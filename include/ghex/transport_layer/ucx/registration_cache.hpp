@@ -0,0 +1,218 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef INCLUDED_GHEX_TL_UCX_REGISTRATION_CACHE_HPP
+#define INCLUDED_GHEX_TL_UCX_REGISTRATION_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include "./error.hpp"
+
+namespace gridtools {
+    namespace ghex {
+        namespace tl {
+            namespace ucx {
+
+                /** @brief counters of a registration cache */
+                struct registration_stats
+                {
+                    std::size_t m_regions = 0u;
+                    std::size_t m_bytes = 0u;
+                    std::uint64_t m_hits = 0u;
+                    std::uint64_t m_misses = 0u;
+                };
+
+                /** @brief Cache of memory regions which are registered with a ucp context (ucp_mem_map). Regions are
+                  * registered once when they are allocated (see allocator::ucx_registered_allocator) and the memory handles are
+                  * looked up by address when messages are sent or received, so that ucx can transfer directly from
+                  * and to the registered memory. The cache is owned by the transport context and handed out by its
+                  * communicators: when the context is destroyed, all regions are unmapped and the cache is detached,
+                  * i.e. it does not register memory any more.
+                  * Lookups do not take a lock exclusively: every thread remembers its most recent hits, which stay
+                  * valid until a region is unmapped, and falls back to a lookup under a shared lock otherwise.
+                  * This class is thread safe. */
+                class registration_cache
+                {
+                private: // member types
+                    using mutex_type = std::shared_timed_mutex;
+
+                    struct region
+                    {
+                        std::uintptr_t m_end;
+                        ucp_mem_h m_memh;
+                    };
+
+                    // a region found by a thread, valid as long as the generation of its cache is unchanged
+                    struct recent_hit
+                    {
+                        std::uint64_t m_cache_id = 0u;
+                        std::uint64_t m_generation = 0u;
+                        std::uintptr_t m_first = 0u;
+                        std::uintptr_t m_end = 0u;
+                        ucp_mem_h m_memh = nullptr;
+                    };
+
+                    static constexpr std::size_t num_recent_hits = 4u;
+
+                    struct recent_hits
+                    {
+                        recent_hit m_hits[num_recent_hits];
+                        std::size_t m_next = 0u;
+                    };
+
+                private: // members
+                    mutable mutex_type m_mutex;
+                    const std::uint64_t m_id;
+                    ucp_context_h m_context;
+                    std::size_t m_threshold;
+                    std::map<std::uintptr_t, region> m_regions;
+                    std::atomic<std::size_t> m_num_regions;
+                    // incremented whenever regions are unmapped, invalidates the recent hits of all threads
+                    std::atomic<std::uint64_t> m_generation;
+                    std::size_t m_bytes = 0u;
+                    mutable std::atomic<std::uint64_t> m_hits;
+                    mutable std::atomic<std::uint64_t> m_misses;
+
+                public: // ctors
+                    /** @brief construct a cache
+                      * @param context ucp context
+                      * @param threshold messages smaller than this size (in bytes) are not looked up */
+                    registration_cache(ucp_context_h context, std::size_t threshold = 0u) noexcept
+                    : m_id{next_id()}
+                    , m_context{context}
+                    , m_threshold{threshold}
+                    , m_num_regions{0u}
+                    , m_generation{0u}
+                    , m_hits{0u}
+                    , m_misses{0u}
+                    {}
+
+                    registration_cache(const registration_cache&) = delete;
+                    registration_cache& operator=(const registration_cache&) = delete;
+
+                    ~registration_cache() { detach(); }
+
+                public: // member functions
+                    /** @brief register a memory region (does nothing if the cache is detached)
+                      * @param ptr start address
+                      * @param size size in bytes */
+                    void map(void* ptr, std::size_t size)
+                    {
+                        if (size == 0u) return;
+                        std::lock_guard<mutex_type> lock(m_mutex);
+                        if (!m_context) return;
+                        ucp_mem_map_params_t params;
+                        params.field_mask = UCP_MEM_MAP_PARAM_FIELD_ADDRESS | UCP_MEM_MAP_PARAM_FIELD_LENGTH;
+                        params.address = ptr;
+                        params.length = size;
+                        ucp_mem_h memh;
+                        GHEX_CHECK_UCX_RESULT(
+                            ucp_mem_map(m_context, &params, &memh)
+                        );
+                        const auto first = reinterpret_cast<std::uintptr_t>(ptr);
+                        m_regions[first] = region{first + size, memh};
+                        m_bytes += size;
+                        m_num_regions.store(m_regions.size(), std::memory_order_relaxed);
+                    }
+
+                    /** @brief deregister the memory region starting at ptr (if it is registered) */
+                    void unmap(void* ptr)
+                    {
+                        std::lock_guard<mutex_type> lock(m_mutex);
+                        auto it = m_regions.find(reinterpret_cast<std::uintptr_t>(ptr));
+                        if (it == m_regions.end()) return;
+                        m_generation.fetch_add(1u, std::memory_order_release);
+                        ucp_mem_unmap(m_context, it->second.m_memh);
+                        m_bytes -= it->second.m_end - it->first;
+                        m_regions.erase(it);
+                        m_num_regions.store(m_regions.size(), std::memory_order_relaxed);
+                    }
+
+                    /** @brief find the memory handle of a registered region containing [ptr, ptr+size)
+                      * @return memory handle or nullptr if the range is not registered */
+                    ucp_mem_h find(const void* ptr, std::size_t size) const
+                    {
+                        if (size < m_threshold || m_num_regions.load(std::memory_order_relaxed) == 0u) return nullptr;
+                        const auto first = reinterpret_cast<std::uintptr_t>(ptr);
+                        auto& recent = thread_recent_hits();
+                        const auto generation = m_generation.load(std::memory_order_acquire);
+                        for (const auto& h : recent.m_hits)
+                        {
+                            if (h.m_cache_id == m_id && h.m_generation == generation && h.m_first <= first &&
+                                first + size <= h.m_end)
+                            {
+                                m_hits.fetch_add(1u, std::memory_order_relaxed);
+                                return h.m_memh;
+                            }
+                        }
+                        std::shared_lock<mutex_type> lock(m_mutex);
+                        auto it = m_regions.upper_bound(first);
+                        if (it != m_regions.begin())
+                        {
+                            --it;
+                            if (first + size <= it->second.m_end)
+                            {
+                                // the generation cannot change while the lock is held
+                                recent.m_hits[recent.m_next] = recent_hit{m_id,
+                                    m_generation.load(std::memory_order_relaxed), it->first, it->second.m_end,
+                                    it->second.m_memh};
+                                recent.m_next = (recent.m_next + 1u) % num_recent_hits;
+                                m_hits.fetch_add(1u, std::memory_order_relaxed);
+                                return it->second.m_memh;
+                            }
+                        }
+                        m_misses.fetch_add(1u, std::memory_order_relaxed);
+                        return nullptr;
+                    }
+
+                    /** @brief unmap all regions and stop registering memory */
+                    void detach()
+                    {
+                        std::lock_guard<mutex_type> lock(m_mutex);
+                        m_generation.fetch_add(1u, std::memory_order_release);
+                        for (auto& r : m_regions)
+                            ucp_mem_unmap(m_context, r.second.m_memh);
+                        m_regions.clear();
+                        m_bytes = 0u;
+                        m_num_regions.store(0u, std::memory_order_relaxed);
+                        m_context = nullptr;
+                    }
+
+                    registration_stats stats() const
+                    {
+                        std::shared_lock<mutex_type> lock(m_mutex);
+                        return {m_regions.size(), m_bytes, m_hits.load(std::memory_order_relaxed),
+                            m_misses.load(std::memory_order_relaxed)};
+                    }
+
+                private:
+                    // unique id of a cache, so that recent hits of destroyed caches are never matched
+                    static std::uint64_t next_id()
+                    {
+                        static std::atomic<std::uint64_t> id{0u};
+                        return ++id;
+                    }
+
+                    static recent_hits& thread_recent_hits()
+                    {
+                        thread_local recent_hits h;
+                        return h;
+                    }
+                };
+
+            } // namespace ucx
+        } // namespace tl
+    } // namespace ghex
+} // namespace gridtools
+
+#endif /* INCLUDED_GHEX_TL_UCX_REGISTRATION_CACHE_HPP */
@@ -139,7 +139,7 @@ namespace gridtools{
                     void destroy()
                     {
                         void* ucx_ptr = m_req->m_ucx_ptr;
-                        std::lock_guard<decltype(m_req->m_send_worker->mutex())> lock(m_req->m_send_worker->mutex());
+                        auto lock = m_req->m_recv_worker->lock();
                         request_init(ucx_ptr);
                         ucp_request_free(ucx_ptr);
                     }
@@ -148,13 +148,15 @@ namespace gridtools{
                     {
                         if (!m_req) return true;
 
-                        while(ucp_worker_progress(m_req->m_send_worker->get()));
+                        int p = 0, c;
+                        while((c = ucp_worker_progress(m_req->m_send_worker->get()))) p+=c;
 
                         /* this is really important for large-scale multithreading */
-                        sched_yield();
+                        m_req->m_send_worker->yield(p > 0);
 
-                        std::lock_guard<decltype(m_req->m_send_worker->mutex())> lock(m_req->m_send_worker->mutex());
-                        while(ucp_worker_progress(m_req->m_recv_worker->get()));
+                        auto lock = m_req->m_recv_worker->lock();
+                        if (m_req->m_recv_worker != m_req->m_send_worker || m_req->m_recv_worker->shared())
+                            while(ucp_worker_progress(m_req->m_recv_worker->get()));
 
                         // check request status
                         // TODO check whether ucp_request_check_status has to be locked also:
@@ -199,7 +201,7 @@ namespace gridtools{
                         if (m_req->m_kind == request_kind::send) return false;
 
                         {
-                            std::lock_guard<decltype(m_req->m_send_worker->mutex())> lock(m_req->m_send_worker->mutex());
+                            auto lock = m_req->m_recv_worker->lock();
                             auto ucx_ptr = m_req->m_ucx_ptr;
                             auto worker = m_req->m_recv_worker->get();
                             ucp_request_cancel(worker, ucx_ptr);
@@ -271,7 +273,7 @@ namespace gridtools{
 
                         if (m_req->m_kind == request_kind::send) return false;
 
-                        std::lock_guard<decltype(m_req->m_worker->mutex())> lock(m_req->m_worker->mutex());
+                        auto lock = m_req->m_worker->lock();
 
                         if (!(*m_completed)) {
                             auto ucx_ptr = m_req->m_ucx_ptr;
@@ -12,12 +12,18 @@
 #define INCLUDED_GHEX_TL_UCX_WORKER_HPP
 
 #include <map>
+#include <memory>
 #include <deque>
+#include <mutex>
 #include <unordered_map>
+extern "C"{
+#include <sched.h>
+}
 #include "../../common/moved_bit.hpp"
 #include "./error.hpp"
 #include "./endpoint.hpp"
 #include "./address_db.hpp"
+#include "./registration_cache.hpp"
 #include "../util/pthread_spin_mutex.hpp"
 #include "../mpi/rank_topology.hpp"
 
@@ -27,6 +33,15 @@ namespace gridtools {
 
             namespace ucx {
 
+                /** @brief when a communicator yields the processor while progressing:
+                  * - always: on every progress call
+                  * - idle: only if nothing was progressed
+                  * - never: the calling thread keeps polling */
+                enum class yield_policy : int { always, idle, never };
+
+                /** @brief A ucp worker and its endpoints. A worker is either shared by the threads of a rank (access
+                  * for receiving is then serialized with a mutex), or it is owned by a single thread and used without
+                  * locking. */
                 struct worker_t
                 {
                     using rank_type = typename endpoint_t::rank_type;
@@ -80,13 +95,29 @@ namespace gridtools {
                     mutex_t*                m_mutex_ptr = nullptr;
                     volatile int            m_progressed_recvs = 0;
                     volatile int            m_progressed_cancels = 0;
-
-                    worker_t(ucp_context_h ucp_handle, type_erased_address_db_t& db, mutex_t& mm, ucs_thread_mode_t mode, const mpi::rank_topology& t)
+                    // thread which owns this worker (negative if the worker is shared)
+                    int                     m_thread_id = -1;
+                    yield_policy            m_yield = yield_policy::always;
+                    std::shared_ptr<registration_cache> m_rcache;
+
+                    /** @brief create a worker
+                      * @param ucp_handle ucp context
+                      * @param db address database
+                      * @param mm mutex which serializes the access to shared workers
+                      * @param mode ucx thread mode
+                      * @param t rank topology
+                      * @param thread_id index of the thread owning the worker, or negative for shared workers. Owned
+                      * workers connect to the workers owned by the thread with the same index on the remote ranks.
+                      * @param yield yield policy of communicators using this worker */
+                    worker_t(ucp_context_h ucp_handle, type_erased_address_db_t& db, mutex_t& mm, ucs_thread_mode_t mode,
+                        const mpi::rank_topology& t, int thread_id = -1, yield_policy yield = yield_policy::always)
                     : m_rank_topology(t)
                     , m_db{db}
                     , m_rank{m_db.rank()}
                     , m_size{m_db.size()}
                     , m_mutex_ptr{&mm}
+                    , m_thread_id{thread_id}
+                    , m_yield{yield}
                     {
                         ucp_worker_params_t params;
                         params.field_mask  = UCP_WORKER_PARAM_FIELD_THREAD_MODE;
@@ -121,12 +152,36 @@ namespace gridtools {
                         auto it = m_endpoint_cache.find(rank);
                         if (it != m_endpoint_cache.end())
                             return it->second;
-                        auto addr = m_db.find(rank);
+                        // the database holds the joined addresses of the shared worker and the per-thread workers
+                        auto addr = select_address(m_db.find(rank), m_thread_id+1);
                         auto p = m_endpoint_cache.insert(std::make_pair(rank, endpoint_t{rank, m_worker.get(), addr}));
                         return p.first->second;
                     }
                     mutex_t& mutex() { return *m_mutex_ptr; }
 
+                    /** @brief memory handle of a buffer in registered memory (nullptr if not registered) */
+                    ucp_mem_h memory_handle(const void* ptr, std::size_t size) const
+                    {
+                        return m_rcache ? m_rcache->find(ptr, size) : nullptr;
+                    }
+
+                    /** @brief whether the worker is shared among threads */
+                    bool shared() const noexcept { return m_thread_id < 0; }
+
+                    /** @brief lock the worker for receiving (no-op for workers owned by a single thread) */
+                    std::unique_lock<mutex_t> lock()
+                    {
+                        return shared() ? std::unique_lock<mutex_t>{*m_mutex_ptr} : std::unique_lock<mutex_t>{};
+                    }
+
+                    /** @brief yield the processor according to the yield policy
+                      * @param progressed whether any communication was progressed */
+                    void yield(bool progressed) const noexcept
+                    {
+                        if (m_yield == yield_policy::always || (m_yield == yield_policy::idle && !progressed))
+                            sched_yield();
+                    }
+
                     const mpi::rank_topology& rank_topology() const noexcept { return m_rank_topology; }
                 };
 
@@ -93,14 +93,7 @@ namespace gridtools {
                 template <typename TLCommunicator>
                 void rank_barrier(TLCommunicator& tlcomm) const
                 {
-                    MPI_Request req = MPI_REQUEST_NULL;
-                    int flag;
-                    MPI_Ibarrier(tlcomm.mpi_comm(), &req);
-                    while(true) {
-                        tlcomm.progress();
-                        MPI_Test(&req, &flag, MPI_STATUS_IGNORE);
-                        if(flag) break;
-                    }
+                    rank_barrier(tlcomm, 0);
                 }
 
                 /**
@@ -118,6 +111,27 @@ namespace gridtools {
                  }
 
             private:
+                // transports built on top of MPI
+                template <typename TLCommunicator>
+                auto rank_barrier(TLCommunicator& tlcomm, int) const -> decltype(tlcomm.mpi_comm(), void())
+                {
+                    MPI_Request req = MPI_REQUEST_NULL;
+                    int flag;
+                    MPI_Ibarrier(tlcomm.mpi_comm(), &req);
+                    while(true) {
+                        tlcomm.progress();
+                        MPI_Test(&req, &flag, MPI_STATUS_IGNORE);
+                        if(flag) break;
+                    }
+                }
+
+                // transports without an MPI communicator provide a progressing barrier themselves
+                template <typename TLCommunicator>
+                void rank_barrier(TLCommunicator& tlcomm, long) const
+                {
+                    tlcomm.barrier();
+                }
+
                 template <typename TLCommunicator>
                 bool in_node1(TLCommunicator& tlcomm) const
                 {
@@ -158,6 +158,7 @@ namespace gridtools {
                         std::size_t size;
                         std::vector<field_info_type> field_infos;
                         cuda::stream m_cuda_stream;
+                        bool bypasses_packer() const noexcept { return false; } // all sends are packed
                     };
 
                     /** @brief Message-like wrapper over in-place receive memory*/
@@ -414,7 +415,7 @@ namespace gridtools {
                                   O tag_offset) {
                         auto& pool = mem->m_pools[device_id];
                         if (!pool) {
-                            pool.reset(new typename arch_traits<Arch>::pool_type{typename arch_traits<Arch>::basic_allocator_type{}});
+                            pool.reset(new typename arch_traits<Arch>::pool_type{arch_traits<Arch>::make_basic_allocator(m_comm)});
                         }
                         set_recv_size<Arch,T>(
                             mem->recv_memory[device_id],
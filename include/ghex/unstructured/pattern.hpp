@@ -16,6 +16,7 @@
 #include <map>
 #include <numeric>
 #include <algorithm>
+#include <functional>
 #include <iosfwd>
 
 #include "../transport_layer/mpi/setup.hpp"
@@ -180,15 +181,52 @@ namespace gridtools {
             template<typename Index>
             struct make_pattern_impl<unstructured::detail::grid<Index>> {
 
+                /** @brief sparse all-to-all exchange of records: per destination rank vectors are flattened and
+                 * exchanged with one all_to_all (counts) and one all_to_allv (payload)
+                 * @tparam SetupCommunicator setup communicator type
+                 * @tparam Record trivially copyable record type
+                 * @param comm setup communicator
+                 * @param send_records records for each destination rank
+                 * @return received records for each source rank*/
+                template<typename SetupCommunicator, typename Record>
+                static std::vector<std::vector<Record>> exchange_records(const SetupCommunicator& comm,
+                                                                         const std::vector<std::vector<Record>>& send_records) {
+                    const auto size = comm.size();
+                    std::vector<int> send_counts(size), send_displs(size), recv_counts(size), recv_displs(size);
+                    std::vector<Record> flat_send_records{};
+                    for (auto r = 0; r < size; ++r) {
+                        send_counts[r] = static_cast<int>(send_records[r].size());
+                        send_displs[r] = static_cast<int>(flat_send_records.size());
+                        flat_send_records.insert(flat_send_records.end(), send_records[r].begin(), send_records[r].end());
+                    }
+                    comm.all_to_all(send_counts, recv_counts);
+                    int tot_recv_count{0};
+                    for (auto r = 0; r < size; ++r) {
+                        recv_displs[r] = tot_recv_count;
+                        tot_recv_count += recv_counts[r];
+                    }
+                    std::vector<Record> flat_recv_records(tot_recv_count);
+                    comm.all_to_allv(flat_send_records, send_counts, send_displs, flat_recv_records, recv_counts, recv_displs);
+                    std::vector<std::vector<Record>> recv_records(size);
+                    for (auto r = 0; r < size; ++r) {
+                        recv_records[r].assign(flat_recv_records.begin() + recv_displs[r],
+                                               flat_recv_records.begin() + recv_displs[r] + recv_counts[r]);
+                    }
+                    return recv_records;
+                }
+
                 /** @brief specialization used when no hints on neighbor domains are provided
+                 * Ownership of halo vertices is resolved through a distributed directory: every global vertex id is
+                 * assigned to a home rank by hashing, so that no rank needs to know the halos of all the others.
                  * The workflow is as follows:
-                 * - all gather communications to retrive receive halos from all domains, plus some metadata;
-                 * - for each local domain, loop through all receive halos to fetch items to be sent to each other domian,
-                 *   and set up send halos in pattern, as well as vector of local indices to be sent to other domains;
-                 * - all to all communication to inform each other domain of the indices which will be sent,
-                 *   which becomes receive indices on the receive side (2 all to all communications in total,
-                 *   one for the send / recv elements counters and one for the send / recv indices);
-                 * - reconstruct recv halos on the receive side and set up receive halos in pattern.*/
+                 * - each rank registers the inner vertices of its local domains with their home ranks;
+                 * - each rank queries the home ranks for the owners of its receive halo vertices;
+                 * - home ranks match queries against registrations and notify both the owner (which sets up its
+                 *   send halos) and the requester (which sets up its receive halos).
+                 * Each of the three steps is one all to all communication of counters followed by one all to all
+                 * communication of records. Both sides order the halo elements of a (sender, receiver) domain pair
+                 * by their position in the receiver's halo. Memory per rank scales with the local domain and halo
+                 * sizes.*/
                 template<typename Transport, typename HaloGenerator, typename DomainRange>
                 static auto apply(tl::context<Transport>& context, HaloGenerator&& hgen, DomainRange&& d_range) {
 
@@ -204,15 +242,22 @@ namespace gridtools {
                     using extended_domain_id_type = typename pattern_type::extended_domain_id_type;
                     using iteration_space_type = typename pattern_type::iteration_space;
                     using index_container_type = typename pattern_type::index_container_type;
-                    using vertices_type = std::vector<global_index_type>;
-                    using vertices_map_type = std::map<global_index_type, index_type>;
+
+                    // directory records
+                    struct registration { global_index_type vertex; domain_id_type id; int domain_idx; index_type local_idx; };
+                    struct query { global_index_type vertex; domain_id_type id; int pos; };
+                    struct owner_match { int rank; domain_id_type id; int pos; int domain_idx; index_type local_idx; };
+                    struct requester_match { int rank; domain_id_type id; int pos; };
 
                     // get setup comm and new comm, and then this rank, this address and size from new comm
-                    auto comm = tl::mpi::setup_communicator(context.mpi_comm());
+                    auto comm = context.get_setup_communicator();
                     auto new_comm = context.get_serial_communicator();
                     auto my_rank = new_comm.rank();
                     auto my_address = new_comm.address();
                     auto size = new_comm.size();
+                    const auto home_rank = [size](const global_index_type v) {
+                        return static_cast<int>(std::hash<global_index_type>{}(v) % static_cast<std::size_t>(size));
+                    };
 
                     // setup patterns
                     std::vector<pattern_type> my_patterns;
@@ -221,221 +266,132 @@ namespace gridtools {
                         my_patterns.push_back(p);
                     }
 
-                    // gather halos from all local domains on all ranks. TO DO: from here to the end of the function, are all casts actually needed?
-                    int num_domains = static_cast<int>(d_range.size()); // number of local domains (int, since has to be used as elem counter)
-                    auto all_num_domains = comm.all_gather(num_domains).get(); // numbers of local domains on all ranks
+                    // receive halos of the local domains, concatenated in one reduced halo (positions in the reduced
+                    // halo identify halo vertices in the directory)
                     std::vector<domain_id_type> domain_ids{}; // domain id for each local domain
                     std::vector<std::size_t> halo_sizes{}; // halo size for each local domain
                     std::vector<std::size_t> num_levels{}; // halo levels for each local domain
-                    vertices_type reduced_halo{}; // single reduced halo with halo vertices of all local domains
+                    std::vector<int> halo_starts{}; // position of each local domain's halo in the reduced halo
+                    std::vector<std::vector<query>> queries(size);
+                    int pos{0};
                     for (const auto& d : d_range) {
                         domain_ids.push_back(d.domain_id());
                         auto h = hgen(d);
                         halo_sizes.push_back(h.size());
                         num_levels.push_back(h.levels());
-                        reduced_halo.insert(reduced_halo.end(), h.vertices().begin(), h.vertices().end());
-                    }
-                    auto all_domain_ids = comm.all_gather(domain_ids, all_num_domains).get(); // domain id for each local domain on all ranks
-                    auto all_halo_sizes = comm.all_gather(halo_sizes, all_num_domains).get(); // halo size for each local domain on all ranks
-                    std::vector<int> all_reduced_halo_sizes{}; // size of reduced halo on all ranks (int, since has to be used as elem counter)
-                    for (const auto& hs : all_halo_sizes) {
-                        all_reduced_halo_sizes.push_back(static_cast<int>(std::accumulate(hs.begin(), hs.end(), 0)));
+                        halo_starts.push_back(pos);
+                        for (const auto v : h.vertices()) {
+                            queries[home_rank(v)].push_back(query{v, d.domain_id(), pos++});
+                        }
                     }
-                    auto all_reduced_halos = comm.all_gather(reduced_halo, all_reduced_halo_sizes).get(); // single reduced halos with halo vertices of all local domains on all ranks
 
                     // other setup helpers
                     auto all_addresses = comm.all_gather(my_address).get(); // addresses of all ranks
-                    std::vector<domain_id_type> max_domain_ids{}; // max domain id on every rank
-                    for (const auto& d_ids : all_domain_ids) {
-                        max_domain_ids.push_back(*(std::max_element(d_ids.begin(), d_ids.end())));
-                    }
-                    domain_id_type max_domain_id = *(std::max_element(max_domain_ids.begin(), max_domain_ids.end())); // max domain id among all ranks
+                    domain_id_type max_domain_id = comm.max_element(domain_ids); // max domain id among all ranks
                     int m_max_tag = (max_domain_id << 7) + max_domain_id; // TO DO: maximum shift should not be hard-coded. TO DO: should add 1?
 
-                    // ========== SEND ==========
-
-                    std::vector<std::vector<int>> all_send_counts(size); // number of elements to be sent from each local domain to all ranks (int, since has to be used as elem counter)
-                    for (auto& scs : all_send_counts) {
-                        scs.resize(d_range.size());
-                    }
-
-                    std::vector<std::vector<index_type>> all_send_indices(size); // elements to be sent from all local domains to all ranks (in terms of local indices)
-
-                    for (std::size_t p = 0; p < my_patterns.size(); ++p) { // loop through local domains
+                    // ========== DIRECTORY ==========
 
-                        auto d = d_range[p]; // local domain
-                        auto my_id = d.domain_id(); // local domain id
-                        vertices_map_type d_vertices_map{}; // local vertices map
+                    // register inner vertices with their home ranks
+                    std::vector<std::vector<registration>> registrations(size);
+                    for (std::size_t p = 0; p < my_patterns.size(); ++p) {
+                        const auto& d = d_range[p];
                         for (std::size_t local_idx = 0; local_idx < d.inner_size(); ++local_idx) {
-                            d_vertices_map.insert(std::make_pair(d.vertices()[local_idx], local_idx));
-                        }
-
-                        for (auto other_rank = 0; other_rank < size; ++other_rank) { // loop through all_reduced_halos, one rank at a time
-                            auto other_address = all_addresses[static_cast<std::size_t>(other_rank)];
-                            std::size_t reduced_halo_start_idx{0};
-                            index_type rank_local_idx{0};
-                            for (auto other_domain_idx = 0; other_domain_idx < all_num_domains[static_cast<std::size_t>(other_rank)]; ++other_domain_idx) { // loop through all domains on other rank; TO DO: std::size_t?
-                                auto other_halo_size = all_halo_sizes[static_cast<std::size_t>(other_rank)][static_cast<std::size_t>(other_domain_idx)];
-                                if (other_halo_size) {
-                                    auto other_id = all_domain_ids[static_cast<std::size_t>(other_rank)][static_cast<std::size_t>(other_domain_idx)];
-                                    int tag = (static_cast<int>(my_id) << 7) + static_cast<int>(other_id); // TO DO: maximum shift should not be hard-coded
-                                    extended_domain_id_type id{other_id, other_rank, other_address, tag};
-                                    iteration_space_type is{num_levels[p]};
-                                    for (auto reduced_halo_idx = reduced_halo_start_idx;
-                                         reduced_halo_idx < reduced_halo_start_idx + other_halo_size;
-                                         ++reduced_halo_idx, ++rank_local_idx) { // loop through halo vertices
-                                        auto it = d_vertices_map.find(all_reduced_halos[static_cast<std::size_t>(other_rank)][reduced_halo_idx]);
-                                        if (it != d_vertices_map.end()) {
-                                            is.push_back((*it).second);
-                                            all_send_indices[static_cast<std::size_t>(other_rank)].push_back(rank_local_idx);
-                                        }
-                                    }
-                                    if (is.size()) {
-                                        index_container_type ic{is};
-                                        my_patterns[p].send_halos().insert(std::make_pair(id, ic));
-                                        all_send_counts[static_cast<std::size_t>(other_rank)][p] += static_cast<int>(is.size());
-                                    }
-                                    reduced_halo_start_idx += other_halo_size;
-                                }
-                            }
+                            const auto v = d.vertices()[local_idx];
+                            registrations[home_rank(v)].push_back(
+                                registration{v, d.domain_id(), static_cast<int>(p), static_cast<index_type>(local_idx)});
                         }
-
                     }
-
-                    // setup all-to-all communications, send side (TO DO: all_to_all interface should be made similar to all_gather, this will avoid vector flattening)
-                    // first communication variables setup
-                    std::vector<int> all_flat_send_counts{}; // 1/6
-                    std::vector<int> all_my_num_domains(size); // 2/6
-                    std::fill(all_my_num_domains.begin(), all_my_num_domains.end(), num_domains);
-                    std::vector<int> all_my_num_domains_displs(size); // 3/6
-                    all_my_num_domains_displs[0] = 0;
-                    // 4/6: recv side
-                    // 5/6: all_num_domains
-                    std::vector<int> all_num_domains_displs(size); // 6/6
-                    all_num_domains_displs[0] = 0;
-                    // second communication variables setup
-                    std::vector<index_type> all_flat_send_indices; // 1/6
-                    std::vector<int> all_rank_send_counts(size); // 2/6
-                    std::vector<int> all_rank_send_displs(size); // 3/6
-                    all_rank_send_displs[0] = 0;
-                    // 4/6: recv side
-                    // 5/6: recv side, obtained from previous communication
-                    // 6/6: recv side, obtained from 5/6
-                    // other setup
+                    auto directory_entries = exchange_records(comm, registrations);
+                    auto directory_queries = exchange_records(comm, queries);
+                    registrations = std::vector<std::vector<registration>>{};
+                    queries = std::vector<std::vector<query>>{};
+
+                    // directory: vertex -> owners (rank, registration); the first local index is kept if a vertex
+                    // appears more than once in a domain
+                    std::map<global_index_type, std::vector<std::pair<int, registration>>> directory;
                     for (auto other_rank = 0; other_rank < size; ++other_rank) {
-                        all_flat_send_counts.insert(all_flat_send_counts.end(),
-                                                    all_send_counts[static_cast<std::size_t>(other_rank)].begin(),
-                                                    all_send_counts[static_cast<std::size_t>(other_rank)].end());
-                        all_flat_send_indices.insert(all_flat_send_indices.end(),
-                                                     all_send_indices[static_cast<std::size_t>(other_rank)].begin(),
-                                                     all_send_indices[static_cast<std::size_t>(other_rank)].end());
-                        all_rank_send_counts[static_cast<std::size_t>(other_rank)] =
-                                static_cast<int>(all_send_indices[static_cast<std::size_t>(other_rank)].size());
-                        if (other_rank > 0) {
-                            all_my_num_domains_displs[static_cast<std::size_t>(other_rank)] =
-                                    all_my_num_domains_displs[static_cast<std::size_t>(other_rank - 1)] +
-                                    num_domains;
-                            all_num_domains_displs[static_cast<std::size_t>(other_rank)] =
-                                    all_num_domains_displs[static_cast<std::size_t>(other_rank - 1)] +
-                                    all_num_domains[static_cast<std::size_t>(other_rank - 1)];
-                            all_rank_send_displs[static_cast<std::size_t>(other_rank)] =
-                                    all_rank_send_displs[static_cast<std::size_t>(other_rank - 1)] +
-                                    all_rank_send_counts[static_cast<std::size_t>(other_rank - 1)];
+                        for (const auto& r : directory_entries[other_rank]) {
+                            auto& owners = directory[r.vertex];
+                            if (owners.empty() || owners.back().first != other_rank || owners.back().second.domain_idx != r.domain_idx)
+                                owners.push_back(std::make_pair(other_rank, r));
                         }
                     }
+                    directory_entries = std::vector<std::vector<registration>>{};
 
-                    // ========== RECV ==========
-
-                    // setup all-to-all communications, recv side
-                    // first communication variables setup
-                    auto tot_num_domains = std::accumulate(all_num_domains.begin(), all_num_domains.end(), 0); // overall number of local domains
-                    std::vector<int> all_flat_recv_counts(tot_num_domains); // 4/6
-                    // first communication
-                    comm.all_to_allv(all_flat_send_counts, all_my_num_domains, all_my_num_domains_displs,
-                                     all_flat_recv_counts, all_num_domains, all_num_domains_displs);
-                    // second communication variables setup
-                    auto tot_recv_count = std::accumulate(all_flat_recv_counts.begin(), all_flat_recv_counts.end(), 0); // overall number of received indices
-                    std::vector<index_type> all_flat_recv_indices(tot_recv_count); // 4/6
-                    std::vector<int> all_rank_recv_counts(size); // 5/6
-                    std::fill(all_rank_recv_counts.begin(), all_rank_recv_counts.end(), 0);
-                    std::vector<int> all_rank_recv_displs(size); // 6/6
-                    all_rank_recv_displs[0] = 0;
-                    // other setup
-                    std::size_t all_flat_recv_counts_idx{0};
-                    for (auto other_rank = 0; other_rank < size; ++other_rank) {
-                        for (auto other_domain_idx = 0; other_domain_idx < all_num_domains[static_cast<std::size_t>(other_rank)]; ++other_domain_idx) {
-                            all_rank_recv_counts[static_cast<std::size_t>(other_rank)] += all_flat_recv_counts[all_flat_recv_counts_idx++];
-                        }
-                        if (other_rank > 0) {
-                            all_rank_recv_displs[static_cast<std::size_t>(other_rank)] =
-                                    all_rank_recv_displs[static_cast<std::size_t>(other_rank - 1)] +
-                                    all_rank_recv_counts[static_cast<std::size_t>(other_rank - 1)];
-                        }
-                    }
-                    // second communication
-                    comm.all_to_allv(all_flat_send_indices, all_rank_send_counts, all_rank_send_displs,
-                                     all_flat_recv_indices, all_rank_recv_counts, all_rank_recv_displs);
-
-                    // back to multidimensional objects
-                    std::vector<std::vector<int>> all_recv_counts(size); // number of elements to be received from each local domain from all ranks (int, since will be derived from elem counter)
-                    std::vector<std::vector<index_type>> all_recv_indices(size);
-                    all_flat_recv_counts_idx = 0;
-                    std::size_t all_flat_recv_indices_start_idx{0};
+                    // resolve queries
+                    std::vector<std::vector<owner_match>> owner_matches(size);
+                    std::vector<std::vector<requester_match>> requester_matches(size);
                     for (auto other_rank = 0; other_rank < size; ++other_rank) {
-                        for (auto other_domain_idx = 0; other_domain_idx < all_num_domains[static_cast<std::size_t>(other_rank)]; ++other_domain_idx) {
-                            all_recv_counts[static_cast<std::size_t>(other_rank)].push_back(all_flat_recv_counts[all_flat_recv_counts_idx++]);
-                            for (auto all_flat_recv_indices_idx = all_flat_recv_indices_start_idx;
-                                 all_flat_recv_indices_idx < all_flat_recv_indices_start_idx +
-                                 static_cast<std::size_t>(all_recv_counts[static_cast<std::size_t>(other_rank)][static_cast<std::size_t>(other_domain_idx)]);
-                                 ++all_flat_recv_indices_idx) {
-                                all_recv_indices[static_cast<std::size_t>(other_rank)].push_back(all_flat_recv_indices[all_flat_recv_indices_idx]);
+                        for (const auto& q : directory_queries[other_rank]) {
+                            auto it = directory.find(q.vertex);
+                            if (it == directory.end()) continue;
+                            for (const auto& owner : it->second) {
+                                owner_matches[owner.first].push_back(
+                                    owner_match{other_rank, q.id, q.pos, owner.second.domain_idx, owner.second.local_idx});
+                                requester_matches[other_rank].push_back(
+                                    requester_match{owner.first, owner.second.id, q.pos});
                             }
-                            all_flat_recv_indices_start_idx +=
-                                    static_cast<std::size_t>(all_recv_counts[static_cast<std::size_t>(other_rank)][static_cast<std::size_t>(other_domain_idx)]);
                         }
                     }
+                    directory_queries = std::vector<std::vector<query>>{};
+                    directory.clear();
+                    auto my_owner_matches = exchange_records(comm, owner_matches);
+                    auto my_requester_matches = exchange_records(comm, requester_matches);
 
-                    index_type rank_local_start_index{0};
-                    for (std::size_t p = 0; p < my_patterns.size(); ++p) { // loop through local domains. TO DO: this should probably be the innermost loop
-
-                        auto d = d_range[p]; // local domain
-                        auto my_id = d.domain_id(); // local domain id
-                        auto halo_size = hgen(d).size(); // local halo size
+                    // ========== SEND ==========
 
-                        for (auto other_rank = 0; other_rank < size; ++other_rank) {
-                            auto other_address = all_addresses[static_cast<std::size_t>(other_rank)];
-                            std::size_t recv_indices_start_idx{0};
-                            for (auto other_domain_idx = 0; other_domain_idx < all_num_domains[static_cast<std::size_t>(other_rank)]; ++other_domain_idx) {
-                                if (all_recv_counts[static_cast<std::size_t>(other_rank)][static_cast<std::size_t>(other_domain_idx)]) {
-                                    auto other_id = all_domain_ids[static_cast<std::size_t>(other_rank)][static_cast<std::size_t>(other_domain_idx)];
-                                    int tag = (static_cast<int>(other_id) << 7) + static_cast<int>(my_id); // TO DO: maximum shift should not be hard-coded
-                                    extended_domain_id_type id{other_id, other_rank, other_address, tag};
-                                    iteration_space_type is{num_levels[p]};
-                                    for (auto recv_indices_idx = recv_indices_start_idx;
-                                         recv_indices_idx < recv_indices_start_idx +
-                                         static_cast<std::size_t>(all_recv_counts[static_cast<std::size_t>(other_rank)][static_cast<std::size_t>(other_domain_idx)]);
-                                         ++recv_indices_idx) {
-                                        if ((all_recv_indices[static_cast<std::size_t>(other_rank)][recv_indices_idx] >=
-                                             rank_local_start_index) &&
-                                                (all_recv_indices[static_cast<std::size_t>(other_rank)][recv_indices_idx] <
-                                                 rank_local_start_index + static_cast<index_type>(halo_size))) {
-                                            is.push_back(all_recv_indices[static_cast<std::size_t>(other_rank)][recv_indices_idx] -
-                                                    rank_local_start_index +
-                                                    d.inner_size()); // index offset
-                                        }
-                                    }
-                                    if (is.size()) {
-                                        index_container_type ic{is};
-                                        my_patterns[p].recv_halos().insert(std::make_pair(id, ic));
-                                    }
-                                    recv_indices_start_idx +=
-                                            static_cast<std::size_t>(all_recv_counts[static_cast<std::size_t>(other_rank)][static_cast<std::size_t>(other_domain_idx)]);
-                                }
-                            }
+                    // sort by local domain, requesting rank and position in the requester's halo
+                    std::vector<std::pair<int, owner_match>> sends;
+                    for (auto other_rank = 0; other_rank < size; ++other_rank)
+                        for (const auto& m : my_owner_matches[other_rank])
+                            sends.push_back(std::make_pair(other_rank, m));
+                    std::sort(sends.begin(), sends.end(), [](const auto& a, const auto& b) {
+                        return a.second.domain_idx < b.second.domain_idx ? true : (a.second.domain_idx > b.second.domain_idx ? false :
+                            (a.second.rank < b.second.rank ? true : (a.second.rank > b.second.rank ? false : a.second.pos < b.second.pos)));
+                    });
+                    for (std::size_t i = 0; i < sends.size();) {
+                        const auto& m = sends[i].second;
+                        const auto p = static_cast<std::size_t>(m.domain_idx);
+                        const auto my_id = domain_ids[p];
+                        int tag = (static_cast<int>(my_id) << 7) + static_cast<int>(m.id); // TO DO: maximum shift should not be hard-coded
+                        extended_domain_id_type id{m.id, m.rank, all_addresses[static_cast<std::size_t>(m.rank)], tag};
+                        iteration_space_type is{num_levels[p]};
+                        std::size_t j = i;
+                        for (; j < sends.size() && sends[j].second.domain_idx == m.domain_idx &&
+                               sends[j].second.rank == m.rank && sends[j].second.id == m.id; ++j) {
+                            is.push_back(sends[j].second.local_idx);
                         }
+                        my_patterns[p].send_halos().insert(std::make_pair(id, index_container_type{is}));
+                        i = j;
+                    }
 
-                        rank_local_start_index += halo_size;
+                    // ========== RECV ==========
+
+                    // sort by owning rank, owning domain and position in my halo
+                    std::vector<requester_match> recvs;
+                    for (auto other_rank = 0; other_rank < size; ++other_rank)
+                        recvs.insert(recvs.end(), my_requester_matches[other_rank].begin(), my_requester_matches[other_rank].end());
+                    std::sort(recvs.begin(), recvs.end(), [](const auto& a, const auto& b) {
+                        return a.rank < b.rank ? true : (a.rank > b.rank ? false :
+                            (a.id < b.id ? true : (a.id > b.id ? false : a.pos < b.pos)));
+                    });
+                    std::vector<std::map<extended_domain_id_type, iteration_space_type>> recv_spaces(my_patterns.size());
+                    for (const auto& m : recvs) {
+                        // find the local domain the halo vertex belongs to
+                        const auto p = static_cast<std::size_t>(
+                            std::upper_bound(halo_starts.begin(), halo_starts.end(), m.pos) - halo_starts.begin() - 1);
+                        const auto& d = d_range[p];
+                        int tag = (static_cast<int>(m.id) << 7) + static_cast<int>(domain_ids[p]); // TO DO: maximum shift should not be hard-coded
+                        extended_domain_id_type id{m.id, m.rank, all_addresses[static_cast<std::size_t>(m.rank)], tag};
+                        auto it = recv_spaces[p].find(id);
+                        if (it == recv_spaces[p].end())
+                            it = recv_spaces[p].insert(std::make_pair(id, iteration_space_type{num_levels[p]})).first;
+                        it->second.push_back(static_cast<index_type>(m.pos - halo_starts[p] + d.inner_size())); // index offset
                     }
+                    for (std::size_t p = 0; p < my_patterns.size(); ++p)
+                        for (auto& id_is : recv_spaces[p])
+                            my_patterns[p].recv_halos().insert(std::make_pair(id_is.first, index_container_type{id_is.second}));
 
                     return pattern_container<communicator_type, grid_type, domain_id_type>(std::move(my_patterns), m_max_tag);
 
@@ -470,7 +426,7 @@ namespace gridtools {
                     using all_recv_indices_type = std::vector<std::map<domain_id_type, std::vector<index_type>>>;
 
                     // get setup comm and new comm, and then this rank, this address and size from new comm
-                    auto comm = tl::mpi::setup_communicator(context.mpi_comm());
+                    auto comm = context.get_setup_communicator();
                     auto new_comm = context.get_serial_communicator();
                     auto my_rank = new_comm.rank();
                     auto my_address = new_comm.address();
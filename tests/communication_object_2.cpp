@@ -14,10 +14,12 @@
 #include <ghex/structured/regular/halo_generator.hpp>
 #include <ghex/structured/regular/field_descriptor.hpp>
 #include <ghex/communication_object_2.hpp>
-#ifndef GHEX_TEST_USE_UCX
-#include <ghex/transport_layer/mpi/context.hpp>
-#else
+#if defined(GHEX_TEST_USE_UCX)
 #include <ghex/transport_layer/ucx/context.hpp>
+#elif defined(GHEX_TEST_USE_SHM)
+#include <ghex/transport_layer/shm/context.hpp>
+#else
+#include <ghex/transport_layer/mpi/context.hpp>
 #endif
 #include <array>
 #include <iomanip>
@@ -41,10 +43,12 @@ __global__ void print_kernel() {
 }
 #endif
 
-#ifndef GHEX_TEST_USE_UCX
-using transport = gridtools::ghex::tl::mpi_tag;
-#else
+#if defined(GHEX_TEST_USE_UCX)
 using transport = gridtools::ghex::tl::ucx_tag;
+#elif defined(GHEX_TEST_USE_SHM)
+using transport = gridtools::ghex::tl::shm_tag;
+#else
+using transport = gridtools::ghex::tl::mpi_tag;
 #endif
 using context_type = gridtools::ghex::tl::context<transport>;
 
@@ -77,7 +81,7 @@ using field_descriptor_type  = gridtools::ghex::structured::regular::field_descr
 
 
 template<typename T, typename Domain, typename Field>
-void fill_values(const Domain& d, Field& f)
+void fill_values(const Domain& d, Field& f, int shift = 0)
 {
     int xl = 0;
     for (int x=d.first()[0]; x<=d.last()[0]; ++x, ++xl)
@@ -88,7 +92,7 @@ void fill_values(const Domain& d, Field& f)
             int zl = 0;
             for (int z=d.first()[2]; z<=d.last()[2]; ++z, ++zl)
             {
-                f(xl,yl,zl) = array_type<T,3>{(T)x,(T)y,(T)z};
+                f(xl,yl,zl) = array_type<T,3>{(T)(x+shift),(T)(y+shift),(T)(z+shift)};
             }
         }
     }
@@ -96,7 +100,7 @@ void fill_values(const Domain& d, Field& f)
 
 template<typename T, typename Domain, typename Halos, typename Periodic, typename Global, typename Field, typename Communicator>
 bool test_values(const Domain& d, const Halos& halos, const Periodic& periodic, const Global& g_first, const Global& g_last,
-        const Field& f, Communicator comm)
+        const Field& f, Communicator comm, int shift = 0)
 {
     bool passed = true;
     const int i = d.domain_id()%2;
@@ -122,19 +126,19 @@ bool test_values(const Domain& d, const Halos& halos, const Periodic& periodic,
     {
         if (i==0 && x<d.first()[0] && !periodic[0]) continue;
         if (i==1 && x>d.last()[0]  && !periodic[0]) continue;
-        T x_wrapped = (((x-g_first[0])+(g_last[0]-g_first[0]+1))%(g_last[0]-g_first[0]+1) + g_first[0]);
+        T x_wrapped = (((x-g_first[0])+(g_last[0]-g_first[0]+1))%(g_last[0]-g_first[0]+1) + g_first[0]) + shift;
         int yl = -halos[2];
         for (int y=d.first()[1]-halos[2]; y<=d.last()[1]+halos[3]; ++y, ++yl)
         {
             if (d.domain_id()<2 &&      y<d.first()[1] && !periodic[1]) continue;
             if (d.domain_id()>size-3 && y>d.last()[1]  && !periodic[1]) continue;
-            T y_wrapped = (((y-g_first[1])+(g_last[1]-g_first[1]+1))%(g_last[1]-g_first[1]+1) + g_first[1]);
+            T y_wrapped = (((y-g_first[1])+(g_last[1]-g_first[1]+1))%(g_last[1]-g_first[1]+1) + g_first[1]) + shift;
             int zl = -halos[4];
             for (int z=d.first()[2]-halos[4]; z<=d.last()[2]+halos[5]; ++z, ++zl)
             {
                 if (z<d.first()[2] && !periodic[2]) continue;
                 if (z>d.last()[2]  && !periodic[2]) continue;
-                T z_wrapped = (((z-g_first[2])+(g_last[2]-g_first[2]+1))%(g_last[2]-g_first[2]+1) + g_first[2]);
+                T z_wrapped = (((z-g_first[2])+(g_last[2]-g_first[2]+1))%(g_last[2]-g_first[2]+1) + g_first[2]) + shift;
 
                 const auto& value = f(xl,yl,zl);
                 if(value[0]!=x_wrapped || value[1]!=y_wrapped || value[2]!=z_wrapped)
@@ -230,7 +234,8 @@ TEST(communication_object_2, exchange)
 || defined(GHEX_TEST_THREADS_VECTOR)          \
 || defined(GHEX_TEST_ASYNC_ASYNC_VECTOR)      \
 || defined(GHEX_TEST_ASYNC_DEFERRED_VECTOR)   \
-|| defined(GHEX_TEST_ASYNC_ASYNC_WAIT_VECTOR)
+|| defined(GHEX_TEST_ASYNC_ASYNC_WAIT_VECTOR) \
+|| defined(GHEX_TEST_PLANNED_VECTOR)
     using T1 = double;
     using T2 = double;
     using T3 = double;
@@ -288,6 +293,30 @@ TEST(communication_object_2, exchange)
     fill_values<T3>(local_domains[0], field_3a);
     fill_values<T3>(local_domains[1], field_3b);
 
+#if defined(GHEX_TEST_PLANNED) || defined(GHEX_TEST_PLANNED_VECTOR)
+    // planned exchanges are repeated with shifted values, such that stale buffers are detected
+    auto fill_all = [&](int shift)
+    {
+        fill_values<T1>(local_domains[0], field_1a, shift);
+        fill_values<T1>(local_domains[1], field_1b, shift);
+        fill_values<T2>(local_domains[0], field_2a, shift);
+        fill_values<T2>(local_domains[1], field_2b, shift);
+        fill_values<T3>(local_domains[0], field_3a, shift);
+        fill_values<T3>(local_domains[1], field_3b, shift);
+    };
+    auto test_all = [&](int shift)
+    {
+        bool passed = true;
+        passed = passed && test_values<T1>(local_domains[0], halos1, periodic, g_first, g_last, field_1a, context.mpi_comm(), shift);
+        passed = passed && test_values<T1>(local_domains[1], halos1, periodic, g_first, g_last, field_1b, context.mpi_comm(), shift);
+        passed = passed && test_values<T2>(local_domains[0], halos2, periodic, g_first, g_last, field_2a, context.mpi_comm(), shift);
+        passed = passed && test_values<T2>(local_domains[1], halos2, periodic, g_first, g_last, field_2b, context.mpi_comm(), shift);
+        passed = passed && test_values<T3>(local_domains[0], halos1, periodic, g_first, g_last, field_3a, context.mpi_comm(), shift);
+        passed = passed && test_values<T3>(local_domains[1], halos1, periodic, g_first, g_last, field_3b, context.mpi_comm(), shift);
+        return passed;
+    };
+#endif
+
 
 #ifndef GHEX_TEST_SERIAL
 #ifndef GHEX_TEST_SERIAL_VECTOR
@@ -301,7 +330,11 @@ TEST(communication_object_2, exchange)
 #ifndef GHEX_TEST_ASYNC_DEFERRED_VECTOR
 #ifndef GHEX_TEST_ASYNC_ASYNC_WAIT
 #ifndef GHEX_TEST_ASYNC_ASYNC_WAIT_VECTOR
-#error "At least one of the following macros should be defined: GHEX_TEST_SERIAL GHEX_TEST_SERIAL_SPLIT GHEX_TEST_EXCHANGE_THREADS GHEX_TEST_ASYNC_ASYNC GHEX_TEST_ASYNC_DEFERRED GHEX_TEST_ASYNC_ASYNC_WAIT"
+#ifndef GHEX_TEST_PLANNED
+#ifndef GHEX_TEST_PLANNED_VECTOR
+#error "At least one of the following macros should be defined: GHEX_TEST_SERIAL GHEX_TEST_SERIAL_SPLIT GHEX_TEST_EXCHANGE_THREADS GHEX_TEST_ASYNC_ASYNC GHEX_TEST_ASYNC_DEFERRED GHEX_TEST_ASYNC_ASYNC_WAIT GHEX_TEST_PLANNED"
+#endif
+#endif
 #endif
 #endif
 #endif
@@ -385,6 +418,31 @@ TEST(communication_object_2, exchange)
 #endif
 #endif
 
+#if defined(GHEX_TEST_PLANNED) || defined(GHEX_TEST_PLANNED_VECTOR)
+        // copy the fields to the device (to_device=true) or back to the host
+        auto copy_fields = [&](bool to_device)
+        {
+            auto copy = [to_device](auto& host_field, auto& device_field, std::size_t size)
+            {
+                auto dst = to_device ? device_field.data() : host_field.data();
+                auto src = to_device ? host_field.data() : device_field.data();
+#ifdef __CUDACC__
+                GT_CUDA_CHECK(cudaMemcpy(dst, src, size, cudaMemcpyDefault));
+#else
+                std::memcpy(dst, src, size);
+#endif
+            };
+            copy(field_1a, field_1a_gpu, max_memory*sizeof(TT1));
+            copy(field_2a, field_2a_gpu, max_memory*sizeof(TT2));
+            copy(field_3a, field_3a_gpu, max_memory*sizeof(TT3));
+#ifndef GHEX_HYBRID_TESTS
+            copy(field_1b, field_1b_gpu, max_memory*sizeof(TT1));
+            copy(field_2b, field_2b_gpu, max_memory*sizeof(TT2));
+            copy(field_3b, field_3b_gpu, max_memory*sizeof(TT3));
+#endif
+        };
+#endif
+
         // exchange
 #ifdef GHEX_TEST_SERIAL
     // blocking variant
@@ -458,6 +516,56 @@ TEST(communication_object_2, exchange)
     h2.wait();
 #endif
 
+#ifdef GHEX_TEST_PLANNED
+    // buffers are set up once and reused for every exchange
+#ifdef GHEX_HYBRID_TESTS
+    auto plan = gridtools::ghex::make_exchange_plan<pattern_type>(context.get_communicator(),
+        pattern1(field_1a_gpu),
+        pattern1(field_1b),
+        pattern2(field_2a_gpu),
+        pattern2(field_2b),
+        pattern1(field_3a_gpu),
+        pattern1(field_3b));
+#else
+    auto plan = gridtools::ghex::make_exchange_plan<pattern_type>(context.get_communicator(),
+        pattern1(field_1a_gpu),
+        pattern1(field_1b_gpu),
+        pattern2(field_2a_gpu),
+        pattern2(field_2b_gpu),
+        pattern1(field_3a_gpu),
+        pattern1(field_3b_gpu));
+#endif
+    // the last exchange restores the original values which are checked below
+    for (int i=2; i>=0; --i)
+    {
+        fill_all(i);
+        copy_fields(true);
+        plan.exchange().wait();
+        copy_fields(false);
+        EXPECT_TRUE(test_all(i));
+    }
+#endif
+#ifdef GHEX_TEST_PLANNED_VECTOR
+    std::vector<std::remove_reference_t<decltype(pattern1(field_1a_gpu))>> field_vec{
+        pattern1(field_1a_gpu),
+        pattern1(field_1b_gpu),
+        pattern2(field_2a_gpu),
+        pattern2(field_2b_gpu),
+        pattern1(field_3a_gpu),
+        pattern1(field_3b_gpu)};
+    auto plan = gridtools::ghex::make_exchange_plan<pattern_type>(context.get_communicator(),
+        field_vec.begin(), field_vec.end());
+    // the last exchange restores the original values which are checked below
+    for (int i=2; i>=0; --i)
+    {
+        fill_all(i);
+        copy_fields(true);
+        plan.exchange().wait();
+        copy_fields(false);
+        EXPECT_TRUE(test_all(i));
+    }
+#endif
+
 #ifdef GHEX_TEST_THREADS
     auto func = [&context, device_id=local_comm.rank()](auto... bis)
     {
@@ -816,6 +924,42 @@ TEST(communication_object_2, exchange)
     h2.wait();
 #endif
 
+#ifdef GHEX_TEST_PLANNED
+    // buffers are set up once and reused for every exchange
+    auto plan = gridtools::ghex::make_exchange_plan<pattern_type>(context.get_communicator(),
+        pattern1(field_1a),
+        pattern1(field_1b),
+        pattern2(field_2a),
+        pattern2(field_2b),
+        pattern1(field_3a),
+        pattern1(field_3b));
+    // the last exchange restores the original values which are checked below
+    for (int i=2; i>=0; --i)
+    {
+        fill_all(i);
+        plan.exchange().wait();
+        EXPECT_TRUE(test_all(i));
+    }
+#endif
+#ifdef GHEX_TEST_PLANNED_VECTOR
+    std::vector<std::remove_reference_t<decltype(pattern1(field_1a))>> field_vec{
+        pattern1(field_1a),
+        pattern1(field_1b),
+        pattern2(field_2a),
+        pattern2(field_2b),
+        pattern1(field_3a),
+        pattern1(field_3b)};
+    auto plan = gridtools::ghex::make_exchange_plan<pattern_type>(context.get_communicator(),
+        field_vec.begin(), field_vec.end());
+    // the last exchange restores the original values which are checked below
+    for (int i=2; i>=0; --i)
+    {
+        fill_all(i);
+        plan.exchange().wait();
+        EXPECT_TRUE(test_all(i));
+    }
+#endif
+
 #ifdef GHEX_TEST_THREADS
     auto func = [&context](auto... bis)
     {
@@ -0,0 +1,168 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef GHEX_TEST_USE_UCX
+#include <ghex/transport_layer/mpi/context.hpp>
+using transport = gridtools::ghex::tl::mpi_tag;
+#else
+#include <ghex/transport_layer/ucx/context.hpp>
+using transport = gridtools::ghex::tl::ucx_tag;
+#endif
+#include <ghex/structured/pattern.hpp>
+#include <ghex/structured/regular/domain_descriptor.hpp>
+#include <ghex/structured/regular/halo_generator.hpp>
+#include <ghex/structured/regular/field_descriptor.hpp>
+#include <ghex/communication_object_2.hpp>
+#include <array>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using context_type = typename gridtools::ghex::tl::context_factory<transport>::context_type;
+using domain_descriptor_type = gridtools::ghex::structured::regular::domain_descriptor<int,std::integral_constant<int, 3>>;
+using halo_generator_type = gridtools::ghex::structured::regular::halo_generator<int,std::integral_constant<int, 3>>;
+
+// each rank owns a slab along z which is split into two domains along y: all halos exchanged between two
+// ranks are carried by one message (fields 2*i and 2*i+1 are the parts of field i on the two domains)
+constexpr int nx = 6;
+constexpr int ny = 3;
+constexpr int nz = 4;
+
+template<typename Field>
+void fill_values(const domain_descriptor_type& d, Field& f, int shift)
+{
+    for (int z=-1; z<=nz; ++z)
+        for (int y=-1; y<=ny; ++y)
+            for (int x=0; x<nx; ++x)
+                f(x,y,z) = -1;
+    for (int z=0; z<nz; ++z)
+        for (int y=0; y<ny; ++y)
+            for (int x=0; x<nx; ++x)
+                f(x,y,z) = x + 10*(y+d.first()[1]) + 100*(z+d.first()[2]) + shift;
+}
+
+template<typename Field>
+bool test_values(const domain_descriptor_type& d, const Field& f, int shift, int num_ranks)
+{
+    bool passed = true;
+    for (int z=-1; z<=nz; ++z)
+    {
+        const int gz = (d.first()[2] + z + num_ranks*nz) % (num_ranks*nz);
+        for (int y=-1; y<=ny; ++y)
+        {
+            const int gy = (d.first()[1] + y + 2*ny) % (2*ny);
+            for (int x=0; x<nx; ++x)
+                if (f(x,y,z) != x + 10*gy + 100*gz + shift) passed = false;
+        }
+    }
+    return passed;
+}
+
+TEST(communication_object_2, aggregation)
+{
+    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
+    auto& context = *context_ptr;
+    auto comm = context.get_communicator();
+    const int rank = context.rank();
+    const int size = context.size();
+
+    const std::array<int,3> g_first{0, 0, 0};
+    const std::array<int,3> g_last{nx-1, 2*ny-1, size*nz-1};
+    const std::array<int,6> halos{0, 0, 1, 1, 1, 1};
+    const std::array<bool,3> periodic{true, true, true};
+    const std::array<int,3> offset{0, 1, 1};
+    const std::array<int,3> extents{nx, ny+2, nz+2};
+
+    std::vector<domain_descriptor_type> local_domains;
+    for (int j=0; j<2; ++j)
+        local_domains.push_back(domain_descriptor_type{2*rank+j,
+            std::array<int,3>{0, j*ny, rank*nz}, std::array<int,3>{nx-1, (j+1)*ny-1, (rank+1)*nz-1}});
+    auto halo_gen = halo_generator_type(g_first, g_last, halos, periodic);
+    auto pattern = gridtools::ghex::make_pattern<gridtools::ghex::structured::grid>(context, halo_gen, local_domains);
+
+    std::vector<std::vector<double>> raw(4, std::vector<double>(nx*(ny+2)*(nz+2)));
+    using field_type = decltype(gridtools::ghex::wrap_field<gridtools::ghex::cpu,::gridtools::layout_map<2,1,0>>(
+        local_domains[0], raw[0].data(), offset, extents));
+    std::vector<field_type> fields;
+    for (int i=0; i<4; ++i)
+        fields.push_back(gridtools::ghex::wrap_field<gridtools::ghex::cpu,::gridtools::layout_map<2,1,0>>(
+            local_domains[i%2], raw[i].data(), offset, extents));
+
+    // aggregating plan: the halos of the domain pairs carried by one message become ready together
+    auto plan = gridtools::ghex::make_exchange_plan<decltype(pattern)>(comm,
+        gridtools::ghex::aggregate_messages(context),
+        pattern(fields[0]), pattern(fields[1]), pattern(fields[2]), pattern(fields[3]));
+    for (int k=0; k<3; ++k)
+    {
+        for (int i=0; i<4; ++i) fill_values(local_domains[i%2], fields[i], 10*k+i/2);
+        auto h = plan.exchange();
+        int num_regions = 0;
+        while (auto r = h.wait_any())
+        {
+            EXPECT_TRUE(h.is_ready(r));
+            ++num_regions;
+        }
+        EXPECT_EQ(num_regions, (int)(pattern[0].recv_halos().size() + pattern[1].recv_halos().size()));
+        h.wait();
+        for (int i=0; i<4; ++i)
+            EXPECT_TRUE(test_values(local_domains[i%2], fields[i], 10*k+i/2, size));
+    }
+
+    // aggregating plan over a range of buffer infos
+    std::vector<decltype(pattern(fields[0]))> bis;
+    for (int i=0; i<4; ++i) bis.push_back(pattern(fields[i]));
+    auto plan_range = gridtools::ghex::make_exchange_plan<decltype(pattern)>(comm,
+        gridtools::ghex::aggregate_messages(context), bis.begin(), bis.end());
+    for (int i=0; i<4; ++i) fill_values(local_domains[i%2], fields[i], 100+i/2);
+    plan_range.exchange().wait();
+    for (int i=0; i<4; ++i)
+        EXPECT_TRUE(test_values(local_domains[i%2], fields[i], 100+i/2, size));
+}
+
+TEST(communication_object_2, aggregation_mismatch)
+{
+    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
+    auto& context = *context_ptr;
+    auto comm = context.get_communicator();
+    const int rank = context.rank();
+    const int size = context.size();
+
+    const std::array<int,3> g_first{0, 0, 0};
+    const std::array<int,3> g_last{nx-1, 2*ny-1, size*nz-1};
+    const std::array<int,6> halos{0, 0, 1, 1, 1, 1};
+    const std::array<bool,3> periodic{true, true, true};
+    const std::array<int,3> offset{0, 1, 1};
+    const std::array<int,3> extents{nx, ny+2, nz+2};
+
+    std::vector<domain_descriptor_type> local_domains;
+    for (int j=0; j<2; ++j)
+        local_domains.push_back(domain_descriptor_type{2*rank+j,
+            std::array<int,3>{0, j*ny, rank*nz}, std::array<int,3>{nx-1, (j+1)*ny-1, (rank+1)*nz-1}});
+    auto halo_gen = halo_generator_type(g_first, g_last, halos, periodic);
+    auto pattern = gridtools::ghex::make_pattern<gridtools::ghex::structured::grid>(context, halo_gen, local_domains);
+
+    std::vector<std::vector<double>> raw(2, std::vector<double>(nx*(ny+2)*(nz+2)));
+    auto field_0 = gridtools::ghex::wrap_field<gridtools::ghex::cpu,::gridtools::layout_map<2,1,0>>(
+        local_domains[0], raw[0].data(), offset, extents);
+    auto field_1 = gridtools::ghex::wrap_field<gridtools::ghex::cpu,::gridtools::layout_map<2,1,0>>(
+        local_domains[1], raw[1].data(), offset, extents);
+
+    // the halos of the two domains are split across two plans: the messages a plan sends to a neighbor rank are
+    // grouped by the sending domain, while the neighbor groups the messages it receives by the receiving domain
+    using plan_type = decltype(gridtools::ghex::make_exchange_plan<decltype(pattern)>(comm, pattern(field_0)));
+    const auto make_plan = [&](auto& field)
+    {
+        return gridtools::ghex::make_exchange_plan<decltype(pattern)>(comm,
+            gridtools::ghex::aggregate_messages(context), pattern(field));
+    };
+    EXPECT_THROW(plan_type p = make_plan(field_0), std::runtime_error);
+    EXPECT_THROW(plan_type p = make_plan(field_1), std::runtime_error);
+}
@@ -0,0 +1,189 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <ghex/transport_layer/mpi/context.hpp>
+#include <ghex/structured/pattern.hpp>
+#include <ghex/structured/regular/domain_descriptor.hpp>
+#include <ghex/structured/regular/halo_generator.hpp>
+#include <ghex/structured/regular/field_descriptor.hpp>
+#include <ghex/communication_object_2.hpp>
+#include <array>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using transport = gridtools::ghex::tl::mpi_tag;
+using context_type = gridtools::ghex::tl::context<transport>;
+using domain_descriptor_type = gridtools::ghex::structured::regular::domain_descriptor<int,std::integral_constant<int, 3>>;
+using halo_generator_type = gridtools::ghex::structured::regular::halo_generator<int,std::integral_constant<int, 3>>;
+using layout_type = ::gridtools::layout_map<2,1,0>;
+using field_type = gridtools::ghex::structured::regular::field_descriptor<double,gridtools::ghex::cpu,domain_descriptor_type,layout_type>;
+
+// the domain is decomposed along x (the fastest varying dimension): all halos are strided in memory
+constexpr int nx = 4;
+constexpr int ny = 5;
+constexpr int nz = 3;
+
+double value(int x, int y, int z, int num_ranks, int shift)
+{
+    x = (x + num_ranks*nx) % (num_ranks*nx);
+    y = (y + ny) % ny;
+    z = (z + nz) % nz;
+    return x + 100*y + 10000*z + shift;
+}
+
+void fill_values(const domain_descriptor_type& d, field_type& f, int num_ranks, int shift)
+{
+    for (int z=-1; z<=nz; ++z)
+        for (int y=-1; y<=ny; ++y)
+            for (int x=-1; x<=nx; ++x)
+            {
+                const bool inner = x>=0 && x<nx && y>=0 && y<ny && z>=0 && z<nz;
+                f(x,y,z) = inner ? value(x+d.first()[0], y, z, num_ranks, shift) : -1;
+            }
+}
+
+bool test_values(const domain_descriptor_type& d, const field_type& f, int num_ranks, int shift)
+{
+    bool passed = true;
+    for (int z=-1; z<=nz; ++z)
+        for (int y=-1; y<=ny; ++y)
+            for (int x=-1; x<=nx; ++x)
+                if (f(x,y,z) != value(x+d.first()[0], y, z, num_ranks, shift)) passed = false;
+    return passed;
+}
+
+TEST(communication_object_2, mpi_datatypes)
+{
+    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
+    auto& context = *context_ptr;
+    auto comm = context.get_communicator();
+    const int rank = context.rank();
+    const int size = context.size();
+
+    const std::array<int,3> g_first{0, 0, 0};
+    const std::array<int,3> g_last{size*nx-1, ny-1, nz-1};
+    const std::array<int,6> halos{1, 1, 1, 1, 1, 1};
+    const std::array<bool,3> periodic{true, true, true};
+    const std::array<int,3> offset{1, 1, 1};
+    const std::array<int,3> extents{nx+2, ny+2, nz+2};
+
+    std::vector<domain_descriptor_type> local_domains{domain_descriptor_type{
+        rank, std::array<int,3>{rank*nx, 0, 0}, std::array<int,3>{(rank+1)*nx-1, ny-1, nz-1}}};
+    auto halo_gen = halo_generator_type(g_first, g_last, halos, periodic);
+    auto pattern = gridtools::ghex::make_pattern<gridtools::ghex::structured::grid>(context, halo_gen, local_domains);
+
+    // two compact fields
+    std::vector<double> raw_1((nx+2)*(ny+2)*(nz+2));
+    std::vector<double> raw_2((nx+2)*(ny+2)*(nz+2));
+    auto field_1 = gridtools::ghex::wrap_field<gridtools::ghex::cpu,layout_type>(
+        local_domains[0], raw_1.data(), offset, extents);
+    auto field_2 = gridtools::ghex::wrap_field<gridtools::ghex::cpu,layout_type>(
+        local_domains[0], raw_2.data(), offset, extents);
+    // a field with padded strides
+    const std::array<int,3> padded{nx+5, ny+3, nz+2};
+    const std::array<std::size_t,3> strides{sizeof(double), padded[0]*sizeof(double), padded[0]*padded[1]*sizeof(double)};
+    std::vector<double> raw_3(padded[0]*padded[1]*padded[2]);
+    field_type field_3(local_domains[0], raw_3.data(), offset, extents, strides, 1, false, 0);
+
+    // the datatypes describe the halos in the same order as the serialized buffer
+    for (const auto& p : pattern[0].send_halos())
+    {
+        MPI_Datatype t = field_3.make_mpi_datatype(p.second);
+        int type_size;
+        MPI_Type_size(t, &type_size);
+        EXPECT_EQ(type_size, (int)(pattern[0].num_elements(p.second)*sizeof(double)));
+        std::vector<double> packed(pattern[0].num_elements(p.second));
+        fill_values(local_domains[0], field_3, size, 0);
+        field_3.pack(packed.data(), p.second, nullptr);
+        std::vector<double> typed(packed.size());
+        int pos = 0;
+        MPI_Pack(raw_3.data(), 1, t, typed.data(), type_size, &pos, MPI_COMM_WORLD);
+        EXPECT_EQ(packed, typed);
+        MPI_Type_free(&t);
+    }
+
+    // datatypes combining several fields are built once and reused
+    {
+        gridtools::ghex::mpi_datatype_cache cache;
+        const auto& is = pattern[0].send_halos().begin()->second;
+        std::vector<std::pair<MPI_Datatype, void*>> regions{
+            {cache.get(field_1, is), field_1.data()}, {cache.get(field_3, is), field_3.data()}};
+        MPI_Datatype t = cache.get(regions);
+        EXPECT_EQ(cache.get(regions), t);
+        EXPECT_EQ(cache.get(field_1, is), regions[0].first);
+        EXPECT_EQ(cache.size(), 3u);
+
+        // the combined datatypes only depend on the relative position of the fields
+        std::vector<double> moved_1(raw_1.size() + raw_3.size());
+        std::vector<std::pair<MPI_Datatype, void*>> moved_regions{
+            {regions[0].first, moved_1.data()}, {regions[1].first, moved_1.data() + raw_1.size()}};
+        const MPI_Datatype t_moved = cache.get(moved_regions);
+        EXPECT_EQ(cache.size(), 4u);
+        moved_regions[0].second = moved_1.data() + raw_3.size();
+        moved_regions[1].second = moved_1.data() + raw_3.size() + raw_1.size();
+        EXPECT_EQ(cache.get(moved_regions), t_moved);
+        EXPECT_EQ(cache.size(), 4u);
+    }
+
+    // combined datatypes of fields which are reallocated for every exchange do not accumulate
+    {
+        gridtools::ghex::mpi_datatype_cache cache(4u);
+        const auto& is = pattern[0].send_halos().begin()->second;
+        const MPI_Datatype t_1 = cache.get(field_1, is);
+        std::vector<double> raw((nx+2)*(ny+2)*(nz+2)*20);
+        for (int i=0; i<10; ++i)
+        {
+            cache.next_epoch();
+            std::vector<std::pair<MPI_Datatype, void*>> regions{{t_1, raw.data()}, {t_1, raw.data() + 2*i*(raw.size()/20)}};
+            cache.get(regions);
+            EXPECT_LE(cache.size(), 1u + 4u);
+        }
+        // datatypes of the current epoch are not evicted
+        cache.next_epoch();
+        for (int i=1; i<=6; ++i)
+        {
+            std::vector<std::pair<MPI_Datatype, void*>> regions{{t_1, raw.data() + i}, {t_1, raw.data()}};
+            cache.get(regions);
+        }
+        EXPECT_EQ(cache.size(), 1u + 6u);
+    }
+
+    auto co = gridtools::ghex::make_communication_object<decltype(pattern)>(comm);
+
+    // single field
+    fill_values(local_domains[0], field_1, size, 0);
+    co.exchange(pattern(field_1)).wait();
+    EXPECT_TRUE(test_values(local_domains[0], field_1, size, 0));
+
+    // several fields per message, including a non-compact one
+    for (int i=0; i<2; ++i)
+    {
+        fill_values(local_domains[0], field_1, size, 1+i);
+        fill_values(local_domains[0], field_2, size, 2+i);
+        fill_values(local_domains[0], field_3, size, 3+i);
+        co.exchange(pattern(field_1), pattern(field_2), pattern(field_3)).wait();
+        EXPECT_TRUE(test_values(local_domains[0], field_1, size, 1+i));
+        EXPECT_TRUE(test_values(local_domains[0], field_2, size, 2+i));
+        EXPECT_TRUE(test_values(local_domains[0], field_3, size, 3+i));
+    }
+
+    // planned exchange
+    auto plan = gridtools::ghex::make_exchange_plan<decltype(pattern)>(comm, pattern(field_2), pattern(field_3));
+    for (int i=0; i<3; ++i)
+    {
+        fill_values(local_domains[0], field_2, size, 4+i);
+        fill_values(local_domains[0], field_3, size, 5+i);
+        plan.exchange().wait();
+        EXPECT_TRUE(test_values(local_domains[0], field_2, size, 4+i));
+        EXPECT_TRUE(test_values(local_domains[0], field_3, size, 5+i));
+    }
+}
@@ -0,0 +1,215 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef GHEX_TEST_USE_UCX
+#include <ghex/transport_layer/mpi/context.hpp>
+using transport = gridtools::ghex::tl::mpi_tag;
+#else
+#include <ghex/transport_layer/ucx/context.hpp>
+using transport = gridtools::ghex::tl::ucx_tag;
+#endif
+#include <ghex/structured/pattern.hpp>
+#include <ghex/structured/regular/domain_descriptor.hpp>
+#include <ghex/structured/regular/halo_generator.hpp>
+#include <ghex/structured/regular/field_descriptor.hpp>
+#include <ghex/communication_object_2.hpp>
+#include <ghex/transport_layer/progress_thread.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using context_type = typename gridtools::ghex::tl::context_factory<transport>::context_type;
+using communicator_type = typename context_type::communicator_type;
+using progress_thread_type = gridtools::ghex::tl::progress_thread<communicator_type>;
+using domain_descriptor_type = gridtools::ghex::structured::regular::domain_descriptor<int,std::integral_constant<int, 3>>;
+using halo_generator_type = gridtools::ghex::structured::regular::halo_generator<int,std::integral_constant<int, 3>>;
+
+constexpr int nx = 6;
+constexpr int ny = 5;
+constexpr int nz = 4;
+
+template<typename Field>
+void fill_values(const domain_descriptor_type& d, Field& f, int shift)
+{
+    for (int z=-1; z<=nz; ++z)
+        for (int y=-1; y<=ny; ++y)
+            for (int x=-1; x<=nx; ++x)
+                f(x,y,z) = -1;
+    for (int z=0; z<nz; ++z)
+        for (int y=0; y<ny; ++y)
+            for (int x=0; x<nx; ++x)
+                f(x,y,z) = x + 10*y + 100*(z+d.first()[2]) + shift;
+}
+
+template<typename Field>
+bool test_values(const domain_descriptor_type& d, const Field& f, int shift, int num_ranks)
+{
+    bool passed = true;
+    for (int z=-1; z<=nz; ++z)
+    {
+        const int gz = (d.first()[2] + z + num_ranks*nz) % (num_ranks*nz);
+        for (int y=-1; y<=ny; ++y)
+            for (int x=-1; x<=nx; ++x)
+                if (f(x,y,z) != (x+nx)%nx + 10*((y+ny)%ny) + 100*gz + shift) passed = false;
+    }
+    return passed;
+}
+
+TEST(progress_thread, tasks)
+{
+    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
+    auto& context = *context_ptr;
+
+    gridtools::ghex::tl::progress_thread_options options;
+    options.m_spin_polls = 10;
+    options.m_max_sleep = std::chrono::microseconds(50);
+    options.m_queue_capacity = 4;
+    progress_thread_type pt(context.get_communicator(), options);
+
+    // tasks from several threads are executed on the progress thread
+    std::atomic<int> counter{0};
+    std::atomic<bool> on_progress_thread{true};
+    std::vector<std::thread> threads;
+    for (int t=0; t<4; ++t)
+        threads.push_back(std::thread([&pt, &counter, &on_progress_thread]() {
+            for (int i=0; i<100; ++i)
+                pt.submit([&pt, &counter, &on_progress_thread](communicator_type&) {
+                    if (!pt.is_progress_thread()) on_progress_thread = false;
+                    ++counter;
+                });
+        }));
+    for (auto& th : threads) th.join();
+    while (counter < 400) std::this_thread::yield();
+    EXPECT_TRUE(on_progress_thread);
+
+    // an idle progress thread backs off
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const auto s = pt.stats();
+    EXPECT_EQ(s.m_tasks, 400u);
+    EXPECT_GT(s.m_sleeps, 0u);
+
+    // exceptions are handed back to the application
+    pt.submit([](communicator_type&) { throw std::runtime_error("task failed"); });
+    EXPECT_THROW(pt.stop(), std::runtime_error);
+}
+
+TEST(progress_thread, stop_while_submitting)
+{
+    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
+    auto& context = *context_ptr;
+
+    for (int round=0; round<20; ++round)
+    {
+        gridtools::ghex::tl::progress_thread_options options;
+        options.m_spin_polls = 10;
+        options.m_queue_capacity = 2;
+        progress_thread_type pt(context.get_communicator(), options);
+
+        // every task which was accepted by submit() is executed, the others are rejected with an exception
+        std::atomic<int> executed{0};
+        std::atomic<int> accepted{0};
+        std::atomic<int> started{0};
+        std::vector<std::thread> threads;
+        for (int t=0; t<4; ++t)
+            threads.push_back(std::thread([&pt, &executed, &accepted, &started]() {
+                ++started;
+                try
+                {
+                    while (true)
+                    {
+                        pt.submit([&executed](communicator_type&) { ++executed; });
+                        ++accepted;
+                    }
+                }
+                catch (std::runtime_error&) {}
+            }));
+        while (started < 4) std::this_thread::yield();
+        std::this_thread::sleep_for(std::chrono::microseconds(100*round));
+        pt.stop();
+        for (auto& th : threads) th.join();
+        EXPECT_EQ(executed.load(), accepted.load());
+        EXPECT_EQ(pt.stats().m_tasks, static_cast<std::uint64_t>(accepted.load()));
+        EXPECT_THROW(pt.submit([](communicator_type&) {}), std::runtime_error);
+    }
+}
+
+TEST(progress_thread, exchange)
+{
+    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
+    auto& context = *context_ptr;
+    auto comm = context.get_communicator();
+    const int rank = context.rank();
+    const int size = context.size();
+
+    const std::array<int,3> g_first{0, 0, 0};
+    const std::array<int,3> g_last{nx-1, ny-1, size*nz-1};
+    const std::array<int,6> halos{1, 1, 1, 1, 1, 1};
+    const std::array<bool,3> periodic{true, true, true};
+    const std::array<int,3> offset{1, 1, 1};
+    const std::array<int,3> extents{nx+2, ny+2, nz+2};
+
+    std::vector<domain_descriptor_type> local_domains{domain_descriptor_type{
+        rank, std::array<int,3>{0, 0, rank*nz}, std::array<int,3>{nx-1, ny-1, (rank+1)*nz-1}}};
+    auto halo_gen = halo_generator_type(g_first, g_last, halos, periodic);
+    auto pattern = gridtools::ghex::make_pattern<gridtools::ghex::structured::grid>(context, halo_gen, local_domains);
+
+    std::vector<double> raw_1((nx+2)*(ny+2)*(nz+2));
+    std::vector<double> raw_2((nx+2)*(ny+2)*(nz+2));
+    auto field_1 = gridtools::ghex::wrap_field<gridtools::ghex::cpu,::gridtools::layout_map<2,1,0>>(
+        local_domains[0], raw_1.data(), offset, extents);
+    auto field_2 = gridtools::ghex::wrap_field<gridtools::ghex::cpu,::gridtools::layout_map<2,1,0>>(
+        local_domains[0], raw_2.data(), offset, extents);
+
+    gridtools::ghex::tl::progress_thread_options options;
+    options.m_max_sleep = std::chrono::microseconds(10);
+    progress_thread_type pt(context.get_communicator(), options);
+
+    auto co = gridtools::ghex::make_communication_object<decltype(pattern)>(comm);
+    co.attach_progress_thread(pt);
+
+    for (int i=0; i<3; ++i)
+    {
+        fill_values(local_domains[0], field_1, 2*i);
+        fill_values(local_domains[0], field_2, 2*i+1);
+        auto h = co.exchange(pattern(field_1), pattern(field_2));
+        EXPECT_THROW(co.detach_progress_thread(), std::runtime_error);
+        h.wait();
+        EXPECT_TRUE(test_values(local_domains[0], field_1, 2*i, size));
+        EXPECT_TRUE(test_values(local_domains[0], field_2, 2*i+1, size));
+    }
+    EXPECT_GT(pt.stats().m_tasks, 0u);
+
+    // back to exchanges progressed by the waiting thread
+    co.detach_progress_thread();
+    fill_values(local_domains[0], field_1, 7);
+    co.exchange(pattern(field_1)).wait();
+    EXPECT_TRUE(test_values(local_domains[0], field_1, 7, size));
+
+    // planned exchange
+    auto plan = gridtools::ghex::make_exchange_plan<decltype(pattern)>(comm, pattern(field_1), pattern(field_2));
+    plan.attach_progress_thread(pt);
+    for (int i=0; i<3; ++i)
+    {
+        fill_values(local_domains[0], field_1, 10+i);
+        fill_values(local_domains[0], field_2, 20+i);
+        plan.exchange().wait();
+        EXPECT_TRUE(test_values(local_domains[0], field_1, 10+i, size));
+        EXPECT_TRUE(test_values(local_domains[0], field_2, 20+i, size));
+    }
+
+    // all ranks must be done before the progress threads are stopped
+    MPI_Barrier(MPI_COMM_WORLD);
+    pt.stop();
+}
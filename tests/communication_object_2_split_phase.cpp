@@ -0,0 +1,202 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef GHEX_TEST_USE_UCX
+#include <ghex/transport_layer/mpi/context.hpp>
+using transport = gridtools::ghex::tl::mpi_tag;
+#else
+#include <ghex/transport_layer/ucx/context.hpp>
+using transport = gridtools::ghex::tl::ucx_tag;
+#endif
+#include <ghex/structured/pattern.hpp>
+#include <ghex/structured/regular/domain_descriptor.hpp>
+#include <ghex/structured/regular/halo_generator.hpp>
+#include <ghex/structured/regular/field_descriptor.hpp>
+#include <ghex/communication_object_2.hpp>
+#include <array>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using context_type = typename gridtools::ghex::tl::context_factory<transport>::context_type;
+using domain_descriptor_type = gridtools::ghex::structured::regular::domain_descriptor<int,std::integral_constant<int, 3>>;
+using halo_generator_type = gridtools::ghex::structured::regular::halo_generator<int,std::integral_constant<int, 3>>;
+
+// the domain is decomposed along z: each rank receives the lower z-halo from rank-1 and the upper z-halo from
+// rank+1 (domain ids are equal to the ranks)
+constexpr int nx = 6;
+constexpr int ny = 5;
+constexpr int nz = 4;
+
+template<typename Field>
+void fill_values(const domain_descriptor_type& d, Field& f, int shift)
+{
+    for (int z=0; z<nz; ++z)
+        for (int y=0; y<ny; ++y)
+            for (int x=0; x<nx; ++x)
+                f(x,y,z) = x + 10*y + 100*(z+d.first()[2]) + shift;
+    for (int y=0; y<ny; ++y)
+        for (int x=0; x<nx; ++x)
+        {
+            f(x,y,-1) = -1;
+            f(x,y,nz) = -1;
+        }
+}
+
+// test the z-halo at z (either -1 or nz)
+template<typename Field>
+bool test_halo(const domain_descriptor_type& d, const Field& f, int z, int shift, int num_ranks)
+{
+    bool passed = true;
+    const int gz = (d.first()[2] + z + num_ranks*nz) % (num_ranks*nz);
+    for (int y=0; y<ny; ++y)
+        for (int x=0; x<nx; ++x)
+            if (f(x,y,z) != x + 10*y + 100*gz + shift) passed = false;
+    return passed;
+}
+
+// test the halos which are received from the neighbor nb
+template<typename Field>
+bool test_neighbor(const domain_descriptor_type& d, const Field& f, int nb, int shift, int num_ranks)
+{
+    const int rank = d.domain_id();
+    bool passed = true;
+    if (nb == (rank+num_ranks-1)%num_ranks) passed = passed && test_halo(d, f, -1, shift, num_ranks);
+    if (nb == (rank+1)%num_ranks) passed = passed && test_halo(d, f, nz, shift, num_ranks);
+    return passed;
+}
+
+// complete an exchange through test/progress and check the halos of each neighbor as soon as they are ready
+template<typename Handle, typename Field>
+bool complete(Handle& h, const domain_descriptor_type& d, Field& f_1, Field& f_2, int shift, int num_ranks)
+{
+    const int rank = d.domain_id();
+    const std::array<int,2> neighbors{(rank+num_ranks-1)%num_ranks, (rank+1)%num_ranks};
+    std::array<bool,2> checked{false, false};
+    bool passed = true;
+    while (!h.test())
+    {
+        h.progress();
+        for (int i=0; i<2; ++i)
+        {
+            if (checked[i] || !h.is_ready(rank, neighbors[i])) continue;
+            passed = passed && test_neighbor(d, f_1, neighbors[i], shift, num_ranks);
+            passed = passed && test_neighbor(d, f_2, neighbors[i], shift+1, num_ranks);
+            checked[i] = true;
+        }
+    }
+    // a finished exchange is ready
+    for (int i=0; i<2; ++i) passed = passed && h.is_ready(rank, neighbors[i]);
+    h.wait();
+    passed = passed && test_halo(d, f_1, -1, shift, num_ranks) && test_halo(d, f_1, nz, shift, num_ranks);
+    passed = passed && test_halo(d, f_2, -1, shift+1, num_ranks) && test_halo(d, f_2, nz, shift+1, num_ranks);
+    return passed;
+}
+
+TEST(communication_object_2, split_phase)
+{
+    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
+    auto& context = *context_ptr;
+    auto comm = context.get_communicator();
+    const int rank = context.rank();
+    const int size = context.size();
+
+    const std::array<int,3> g_first{0, 0, 0};
+    const std::array<int,3> g_last{nx-1, ny-1, size*nz-1};
+    const std::array<int,6> halos{0, 0, 0, 0, 1, 1};
+    const std::array<bool,3> periodic{true, true, true};
+    const std::array<int,3> offset{0, 0, 1};
+    const std::array<int,3> extents{nx, ny, nz+2};
+
+    std::vector<domain_descriptor_type> local_domains{domain_descriptor_type{
+        rank, std::array<int,3>{0, 0, rank*nz}, std::array<int,3>{nx-1, ny-1, (rank+1)*nz-1}}};
+    auto halo_gen = halo_generator_type(g_first, g_last, halos, periodic);
+    auto pattern = gridtools::ghex::make_pattern<gridtools::ghex::structured::grid>(context, halo_gen, local_domains);
+
+    std::vector<double> raw_1(nx*ny*(nz+2));
+    std::vector<double> raw_2(nx*ny*(nz+2));
+    auto field_1 = gridtools::ghex::wrap_field<gridtools::ghex::cpu,::gridtools::layout_map<2,1,0>>(
+        local_domains[0], raw_1.data(), offset, extents);
+    auto field_2 = gridtools::ghex::wrap_field<gridtools::ghex::cpu,::gridtools::layout_map<2,1,0>>(
+        local_domains[0], raw_2.data(), offset, extents);
+
+    auto co = gridtools::ghex::make_communication_object<decltype(pattern)>(comm);
+    for (int i=0; i<3; ++i)
+    {
+        fill_values(local_domains[0], field_1, 2*i);
+        fill_values(local_domains[0], field_2, 2*i+1);
+        auto h = co.exchange(pattern(field_1), pattern(field_2));
+        EXPECT_TRUE(complete(h, local_domains[0], field_1, field_2, 2*i, size));
+    }
+
+    // planned exchange
+    auto plan = gridtools::ghex::make_exchange_plan<decltype(pattern)>(comm, pattern(field_1), pattern(field_2));
+    for (int i=0; i<3; ++i)
+    {
+        fill_values(local_domains[0], field_1, 10+2*i);
+        fill_values(local_domains[0], field_2, 10+2*i+1);
+        auto h = plan.exchange();
+        EXPECT_TRUE(complete(h, local_domains[0], field_1, field_2, 10+2*i, size));
+    }
+}
+
+TEST(communication_object_2, halo_regions)
+{
+    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
+    auto& context = *context_ptr;
+    auto comm = context.get_communicator();
+    const int rank = context.rank();
+    const int size = context.size();
+
+    const std::array<int,3> g_first{0, 0, 0};
+    const std::array<int,3> g_last{nx-1, ny-1, size*nz-1};
+    const std::array<int,6> halos{0, 0, 0, 0, 1, 1};
+    const std::array<bool,3> periodic{true, true, true};
+    const std::array<int,3> offset{0, 0, 1};
+    const std::array<int,3> extents{nx, ny, nz+2};
+
+    std::vector<domain_descriptor_type> local_domains{domain_descriptor_type{
+        rank, std::array<int,3>{0, 0, rank*nz}, std::array<int,3>{nx-1, ny-1, (rank+1)*nz-1}}};
+    auto halo_gen = halo_generator_type(g_first, g_last, halos, periodic);
+    auto pattern = gridtools::ghex::make_pattern<gridtools::ghex::structured::grid>(context, halo_gen, local_domains);
+
+    std::vector<double> raw_1(nx*ny*(nz+2));
+    std::vector<double> raw_2(nx*ny*(nz+2));
+    auto field_1 = gridtools::ghex::wrap_field<gridtools::ghex::cpu,::gridtools::layout_map<2,1,0>>(
+        local_domains[0], raw_1.data(), offset, extents);
+    auto field_2 = gridtools::ghex::wrap_field<gridtools::ghex::cpu,::gridtools::layout_map<2,1,0>>(
+        local_domains[0], raw_2.data(), offset, extents);
+
+    auto co = gridtools::ghex::make_communication_object<decltype(pattern)>(comm);
+    for (int i=0; i<3; ++i)
+    {
+        fill_values(local_domains[0], field_1, 2*i);
+        fill_values(local_domains[0], field_2, 2*i+1);
+        auto h = co.exchange(pattern(field_1), pattern(field_2));
+        // each neighbor's halos are returned once, as soon as they are valid
+        std::vector<int> neighbors;
+        while (auto r = h.wait_any())
+        {
+            EXPECT_EQ(r.local_id, rank);
+            EXPECT_TRUE(h.is_ready(r));
+            EXPECT_TRUE(test_neighbor(local_domains[0], field_1, r.remote_id, 2*i, size));
+            EXPECT_TRUE(test_neighbor(local_domains[0], field_2, r.remote_id, 2*i+1, size));
+            bool found = false;
+            for (const auto& p : pattern[0].recv_halos())
+                if (p.first.id == r.remote_id) found = (&p.second == r.iteration_spaces);
+            EXPECT_TRUE(found);
+            neighbors.push_back(r.remote_id);
+        }
+        EXPECT_EQ(neighbors.size(), pattern[0].recv_halos().size());
+        h.wait();
+        EXPECT_FALSE(h.wait_any());
+    }
+}
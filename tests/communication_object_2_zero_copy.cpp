@@ -0,0 +1,138 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef GHEX_TEST_USE_UCX
+#include <ghex/transport_layer/mpi/context.hpp>
+using transport = gridtools::ghex::tl::mpi_tag;
+#else
+#include <ghex/transport_layer/ucx/context.hpp>
+using transport = gridtools::ghex::tl::ucx_tag;
+#endif
+#include <ghex/structured/pattern.hpp>
+#include <ghex/structured/regular/domain_descriptor.hpp>
+#include <ghex/structured/regular/halo_generator.hpp>
+#include <ghex/structured/regular/field_descriptor.hpp>
+#include <ghex/communication_object_2.hpp>
+#include <array>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using context_type = gridtools::ghex::tl::context<transport>;
+using domain_descriptor_type = gridtools::ghex::structured::regular::domain_descriptor<int,std::integral_constant<int, 3>>;
+using halo_generator_type = gridtools::ghex::structured::regular::halo_generator<int,std::integral_constant<int, 3>>;
+
+// the domain is decomposed along z (the slowest varying dimension): the z-halos are contiguous in memory
+// as long as there are no halos in x and y
+constexpr int nx = 6;
+constexpr int ny = 5;
+constexpr int nz = 4;
+
+template<typename Field>
+void fill_values(const domain_descriptor_type& d, Field& f, int shift)
+{
+    for (int z=0; z<nz; ++z)
+        for (int y=0; y<ny; ++y)
+            for (int x=0; x<nx; ++x)
+                f(x,y,z) = x + 10*y + 100*(z+d.first()[2]) + shift;
+    for (int y=0; y<ny; ++y)
+        for (int x=0; x<nx; ++x)
+        {
+            f(x,y,-1) = -1;
+            f(x,y,nz) = -1;
+        }
+}
+
+template<typename Field>
+bool test_values(const domain_descriptor_type& d, const Field& f, int shift, int num_ranks)
+{
+    bool passed = true;
+    const int z_lo = (d.first()[2] - 1 + num_ranks*nz) % (num_ranks*nz);
+    const int z_hi = (d.last()[2] + 1) % (num_ranks*nz);
+    for (int y=0; y<ny; ++y)
+        for (int x=0; x<nx; ++x)
+        {
+            if (f(x,y,-1) != x + 10*y + 100*z_lo + shift) passed = false;
+            if (f(x,y,nz) != x + 10*y + 100*z_hi + shift) passed = false;
+        }
+    return passed;
+}
+
+TEST(communication_object_2, zero_copy)
+{
+    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
+    auto& context = *context_ptr;
+    auto comm = context.get_communicator();
+    const int rank = context.rank();
+    const int size = context.size();
+
+    const std::array<int,3> g_first{0, 0, 0};
+    const std::array<int,3> g_last{nx-1, ny-1, size*nz-1};
+    const std::array<int,6> halos{0, 0, 0, 0, 1, 1};
+    const std::array<bool,3> periodic{true, true, true};
+    const std::array<int,3> offset{0, 0, 1};
+    const std::array<int,3> extents{nx, ny, nz+2};
+
+    std::vector<domain_descriptor_type> local_domains{domain_descriptor_type{
+        rank, std::array<int,3>{0, 0, rank*nz}, std::array<int,3>{nx-1, ny-1, (rank+1)*nz-1}}};
+    auto halo_gen = halo_generator_type(g_first, g_last, halos, periodic);
+    auto pattern = gridtools::ghex::make_pattern<gridtools::ghex::structured::grid>(context, halo_gen, local_domains);
+
+    std::vector<double> raw_1(nx*ny*(nz+2));
+    std::vector<double> raw_2(nx*ny*(nz+2));
+    auto field_1 = gridtools::ghex::wrap_field<gridtools::ghex::cpu,::gridtools::layout_map<2,1,0>>(
+        local_domains[0], raw_1.data(), offset, extents);
+    auto field_2 = gridtools::ghex::wrap_field<gridtools::ghex::cpu,::gridtools::layout_map<2,1,0>>(
+        local_domains[0], raw_2.data(), offset, extents);
+
+    // z-halos map to a single contiguous range of memory (with less than 3 ranks both z-halos are exchanged
+    // with the same neighbor and end up in the same message)
+    if (size > 2)
+    {
+        for (const auto& p : pattern[0].send_halos())
+            EXPECT_NE(field_1.contiguous_range(p.second), nullptr);
+        for (const auto& p : pattern[0].recv_halos())
+            EXPECT_NE(field_1.contiguous_range(p.second), nullptr);
+    }
+
+    // halos in x direction break contiguity
+    const std::array<int,6> halos_x{1, 1, 0, 0, 1, 1};
+    auto halo_gen_x = halo_generator_type(g_first, g_last, halos_x, periodic);
+    auto pattern_x = gridtools::ghex::make_pattern<gridtools::ghex::structured::grid>(context, halo_gen_x, local_domains);
+    std::vector<double> raw_x((nx+2)*ny*(nz+2));
+    auto field_x = gridtools::ghex::wrap_field<gridtools::ghex::cpu,::gridtools::layout_map<2,1,0>>(
+        local_domains[0], raw_x.data(), std::array<int,3>{1, 0, 1}, std::array<int,3>{nx+2, ny, nz+2});
+    for (const auto& p : pattern_x[0].recv_halos())
+        EXPECT_EQ(field_x.contiguous_range(p.second), nullptr);
+
+    auto co = gridtools::ghex::make_communication_object<decltype(pattern)>(comm);
+
+    // single field: sent and received directly from/to the field
+    fill_values(local_domains[0], field_1, 0);
+    co.exchange(pattern(field_1)).wait();
+    EXPECT_TRUE(test_values(local_domains[0], field_1, 0, size));
+
+    // two fields per message: packed into an intermediate buffer
+    fill_values(local_domains[0], field_1, 1);
+    fill_values(local_domains[0], field_2, 2);
+    co.exchange(pattern(field_1), pattern(field_2)).wait();
+    EXPECT_TRUE(test_values(local_domains[0], field_1, 1, size));
+    EXPECT_TRUE(test_values(local_domains[0], field_2, 2, size));
+
+    // planned exchange
+    auto plan = gridtools::ghex::make_exchange_plan<decltype(pattern)>(comm, pattern(field_1));
+    for (int i=0; i<3; ++i)
+    {
+        fill_values(local_domains[0], field_1, 3+i);
+        plan.exchange().wait();
+        EXPECT_TRUE(test_values(local_domains[0], field_1, 3+i, size));
+    }
+}
@@ -28,6 +28,9 @@ using transport = gridtools::ghex::tl::ucx_tag;
 #include <ghex/structured/regular/domain_descriptor.hpp>
 #include <ghex/structured/regular/field_descriptor.hpp>
 #include <ghex/structured/regular/halo_generator.hpp>
+#ifdef GHEX_USE_SHM_FIELDS
+#include <ghex/allocator/shm_allocator.hpp>
+#endif
 
 
 
@@ -52,6 +55,16 @@ struct simulation_1
     using TT1 = array_type<T1,3>;
     using TT2 = array_type<T2,3>;
     using TT3 = array_type<T3,3>;
+    // fields exchanged through process-level rma are mapped directly if they are allocated in shared
+    // memory; otherwise, and if neither xpmem nor cross memory attach is available, their halos are sent
+    // as messages (GHEX_TEST_SHM_FIELDS_FALLBACK)
+#if defined(GHEX_USE_SHM_FIELDS) && !defined(GHEX_TEST_SHM_FIELDS_FALLBACK)
+    template<typename T>
+    using raw_allocator = gridtools::ghex::allocator::shm_allocator<T>;
+#else
+    template<typename T>
+    using raw_allocator = std::allocator<T>;
+#endif
 
     using context_type = typename gridtools::ghex::tl::context_factory<transport>::context_type;
     using context_ptr_type = std::unique_ptr<context_type>;
@@ -89,12 +102,12 @@ struct simulation_1
     const std::array<int,3> offset;
     const std::array<int,3> local_ext_buffer;
     const int max_memory;
-    std::vector<TT1> field_1a_raw;
-    std::vector<TT1> field_1b_raw;
-    std::vector<TT2> field_2a_raw;
-    std::vector<TT2> field_2b_raw;
-    std::vector<TT3> field_3a_raw;
-    std::vector<TT3> field_3b_raw;
+    std::vector<TT1, raw_allocator<TT1>> field_1a_raw;
+    std::vector<TT1, raw_allocator<TT1>> field_1b_raw;
+    std::vector<TT2, raw_allocator<TT2>> field_2a_raw;
+    std::vector<TT2, raw_allocator<TT2>> field_2b_raw;
+    std::vector<TT3, raw_allocator<TT3>> field_3a_raw;
+    std::vector<TT3, raw_allocator<TT3>> field_3b_raw;
 #ifdef __CUDACC__
     std::unique_ptr<TT1,cuda_deleter<TT1>> field_1a_raw_gpu;
     std::unique_ptr<TT1,cuda_deleter<TT1>> field_1b_raw_gpu;
@@ -64,3 +64,38 @@ TEST(all_gather, all_gather_vector)
     EXPECT_TRUE(passed);
 }
 
+
+TEST(sparse_exchange, sparse_exchange)
+{
+    using T = int;
+    gridtools::ghex::tl::mpi::communicator_base mpi_comm;
+    gridtools::ghex::tl::mpi::setup_communicator comm{mpi_comm};
+    const int rank = comm.rank();
+    const int size = comm.size();
+
+    // send rank+1 values to the next rank and one value to rank 0 (receivers do not know their sources)
+    std::map<int,std::vector<T>> messages;
+    messages[(rank+1)%size] = std::vector<T>(rank+1, rank);
+    messages[0].push_back(-rank);
+
+    // consecutive exchanges use different tags
+    for (int iteration=0; iteration<2; ++iteration)
+    {
+        auto received = comm.sparse_exchange(messages, 7+iteration);
+
+        std::map<int,std::vector<T>> expected;
+        const int prev = (rank+size-1)%size;
+        expected[prev] = std::vector<T>(prev+1, prev);
+        if (rank == 0)
+            for (int r=0; r<size; ++r)
+                expected[r].push_back(-r);
+
+        std::map<int,std::vector<T>> result;
+        for (const auto& m : received)
+        {
+            EXPECT_EQ(result.count(m.first), 0u);
+            result[m.first] = m.second;
+        }
+        EXPECT_EQ(result, expected);
+    }
+}
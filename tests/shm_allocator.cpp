@@ -0,0 +1,120 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <ghex/allocator/shm_allocator.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+#include <cstring>
+
+using namespace gridtools::ghex::allocator;
+
+TEST(shm_allocator, vector)
+{
+    shm::arena_options options;
+    options.m_segment_size = 1<<16;
+    shm::arena a(options);
+    shm_allocator<double> alloc(a);
+
+    std::vector<double, shm_allocator<double>> vec(1000, 1.5, alloc);
+    EXPECT_EQ(vec[999], 1.5);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(vec.data()) % 64u, 0u);
+
+    // the memory can be located within its segment
+    shm::segment_info info;
+    EXPECT_TRUE(shm::registry::instance().find(vec.data()+10, info));
+    EXPECT_EQ(info.m_size, std::size_t(1<<16));
+    std::vector<double> local(10);
+    EXPECT_FALSE(shm::registry::instance().find(local.data(), info));
+}
+
+TEST(shm_allocator, segments)
+{
+    shm::arena_options options;
+    options.m_segment_size = 1<<16;
+    shm::arena a(options);
+
+    // blocks are carved out of the same segment and freed blocks are reused
+    void* p1 = a.allocate(1000);
+    void* p2 = a.allocate(1000);
+    EXPECT_EQ(a.num_segments(), 1u);
+    a.deallocate(p1, 1000);
+    void* p3 = a.allocate(500);
+    EXPECT_EQ(p3, p1);
+
+    // large blocks get their own segment which is released when it is empty
+    void* p4 = a.allocate(1<<20);
+    EXPECT_EQ(a.num_segments(), 2u);
+    a.deallocate(p2, 1000);
+    a.deallocate(p3, 500);
+    EXPECT_EQ(a.num_segments(), 1u);
+    std::memset(p4, 1, 1<<20);
+    a.deallocate(p4, 1<<20);
+    EXPECT_EQ(a.num_segments(), 1u);
+
+    // the segment is coalesced again
+    void* p5 = a.allocate((1<<20)-64);
+    EXPECT_EQ(p5, p4);
+    a.deallocate(p5, (1<<20)-64);
+}
+
+TEST(shm_allocator, mapping)
+{
+    shm::arena a;
+    shm_allocator<int> alloc(a);
+    int* ptr = alloc.allocate(100);
+    for (int i=0; i<100; ++i) ptr[i] = i;
+
+    // map the segment a second time, as another process would
+    shm::segment_info info;
+    ASSERT_TRUE(shm::registry::instance().find(ptr, info));
+    EXPECT_FALSE(info.m_hugetlbfs);
+    const int fd = shm::open_segment(info.m_name, info.m_hugetlbfs);
+    ASSERT_GE(fd, 0);
+    void* base = mmap(nullptr, info.m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(base, MAP_FAILED);
+    int* other = reinterpret_cast<int*>(static_cast<unsigned char*>(base) + info.m_offset);
+    EXPECT_EQ(other[42], 42);
+    other[7] = -7;
+    EXPECT_EQ(ptr[7], -7);
+    munmap(base, info.m_size);
+    alloc.deallocate(ptr, 100);
+}
+
+TEST(shm_allocator, huge_pages)
+{
+    // without a usable hugetlbfs mount, segments fall back to regular shared memory
+    shm::arena_options options;
+    options.m_huge_pages = true;
+    options.m_huge_page_dir = "/nonexistent";
+    shm::arena a(options);
+    void* ptr = a.allocate(1000);
+    shm::segment_info info;
+    ASSERT_TRUE(shm::registry::instance().find(ptr, info));
+    EXPECT_FALSE(info.m_hugetlbfs);
+    a.deallocate(ptr, 1000);
+
+    // file backed segments (as created on a hugetlbfs mount) can be opened by name
+    options.m_huge_page_dir = "/tmp";
+    shm::arena b(options);
+    int* iptr = static_cast<int*>(b.allocate(100*sizeof(int)));
+    iptr[42] = 42;
+    ASSERT_TRUE(shm::registry::instance().find(iptr, info));
+    EXPECT_TRUE(info.m_hugetlbfs);
+    const int fd = shm::open_segment(info.m_name, info.m_hugetlbfs);
+    ASSERT_GE(fd, 0);
+    void* base = mmap(nullptr, info.m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(base, MAP_FAILED);
+    EXPECT_EQ(reinterpret_cast<int*>(static_cast<unsigned char*>(base) + info.m_offset)[42], 42);
+    munmap(base, info.m_size);
+    b.deallocate(iptr, 100*sizeof(int));
+}
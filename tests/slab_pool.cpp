@@ -0,0 +1,236 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <ghex/allocator/slab_pool.hpp>
+#include <ghex/arch_traits.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace gridtools::ghex;
+
+// byte allocator which counts the live bytes obtained from it
+template<typename T>
+struct counting_allocator : public std::allocator<T>
+{
+    using value_type = T;
+    template<typename U>
+    struct rebind { using other = counting_allocator<U>; };
+
+    static std::atomic<long>& bytes() { static std::atomic<long> b{0}; return b; }
+
+    counting_allocator() = default;
+    template<typename U>
+    counting_allocator(const counting_allocator<U>&) {}
+
+    T* allocate(std::size_t n, const void* = nullptr)
+    {
+        bytes() += n*sizeof(T);
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        bytes() -= n*sizeof(T);
+        std::allocator<T>{}.deallocate(p, n);
+    }
+};
+
+TEST(slab_pool, size_classes)
+{
+    using namespace allocator::slab;
+    EXPECT_EQ(class_size(size_class(1)), 64u);
+    EXPECT_EQ(class_size(size_class(64)), 64u);
+    EXPECT_EQ(class_size(size_class(65)), 80u);
+    EXPECT_EQ(class_size(size_class(128)), 128u);
+    EXPECT_EQ(class_size(size_class(129)), 160u);
+    EXPECT_EQ(size_class(max_class_size), num_classes-1);
+    for (std::size_t k=1; k<num_classes; ++k)
+    {
+        EXPECT_EQ(size_class(class_size(k)), k);
+        EXPECT_EQ(size_class(class_size(k-1)+1), k);
+    }
+}
+
+TEST(slab_pool, reuse)
+{
+    allocator::slab_pool<counting_allocator<unsigned char>> pool{counting_allocator<unsigned char>{}};
+    auto alloc = pool.get_allocator();
+    using alloc_t = decltype(alloc);
+    using traits = std::allocator_traits<alloc_t>;
+
+    // sizes which differ slightly share a size class
+    auto p0 = traits::allocate(alloc, 1000);
+    traits::deallocate(alloc, p0, 1000);
+    auto p1 = traits::allocate(alloc, 1001);
+    EXPECT_EQ(p0, p1);
+    auto s = pool.stats();
+    EXPECT_EQ(s.m_hits, 1u);
+    EXPECT_EQ(s.m_misses, 1u);
+    EXPECT_EQ(s.m_bytes_in_use, allocator::slab::class_size(allocator::slab::size_class(1001)));
+    traits::deallocate(alloc, p1, 1001);
+
+    // typed allocation through rebinding
+    using double_alloc_t = typename traits::template rebind_alloc<double>;
+    std::vector<double, double_alloc_t> vec(100, 1.0, double_alloc_t{alloc.m_pool});
+    EXPECT_EQ(vec[99], 1.0);
+}
+
+TEST(slab_pool, trim)
+{
+    const long base_bytes = counting_allocator<unsigned char>::bytes();
+    {
+        allocator::slab::pool_options options;
+        options.m_thread_cache_bytes = 4096;
+        options.m_max_depot_bytes = 1 << 16;
+        allocator::slab_pool<counting_allocator<unsigned char>> pool{counting_allocator<unsigned char>{}, options};
+        auto alloc = pool.get_allocator();
+
+        std::vector<unsigned char*> ptrs;
+        for (int i=0; i<64; ++i) ptrs.push_back(alloc.allocate(1024));
+        for (auto p : ptrs) alloc.deallocate(p, 1024);
+
+        // thread cache and depot are bounded, the rest was released
+        auto s = pool.stats();
+        EXPECT_EQ(s.m_bytes_in_use, 0u);
+        EXPECT_LE(s.m_bytes_cached, options.m_thread_cache_bytes + options.m_max_depot_bytes);
+        EXPECT_EQ(counting_allocator<unsigned char>::bytes() - base_bytes, (long)s.m_bytes_cached);
+
+        pool.trim();
+        EXPECT_EQ(pool.stats().m_bytes_cached, 0u);
+        EXPECT_EQ(counting_allocator<unsigned char>::bytes(), base_bytes);
+
+        for (int i=0; i<8; ++i) ptrs[i] = alloc.allocate(1024);
+        for (int i=0; i<8; ++i) alloc.deallocate(ptrs[i], 1024);
+    }
+    // destruction releases everything
+    EXPECT_EQ(counting_allocator<unsigned char>::bytes(), base_bytes);
+}
+
+TEST(slab_pool, threads)
+{
+    const long base_bytes = counting_allocator<unsigned char>::bytes();
+    {
+        allocator::slab::pool_options options;
+        options.m_thread_cache_bytes = 1 << 14;
+        allocator::slab_pool<counting_allocator<unsigned char>> pool{counting_allocator<unsigned char>{}, options};
+        auto alloc = pool.get_allocator();
+
+        // blocks allocated by one thread are returned by another one
+        const int num_threads = 4;
+        const int n = 2000;
+        std::vector<std::vector<unsigned char*>> blocks(num_threads, std::vector<unsigned char*>(n));
+        std::vector<std::thread> threads;
+        for (int t=0; t<num_threads; ++t)
+            threads.push_back(std::thread([&alloc, &blocks, t]() {
+                for (int i=0; i<n; ++i)
+                {
+                    blocks[t][i] = alloc.allocate(64 + (i % 7)*100);
+                    blocks[t][i][0] = static_cast<unsigned char>(t);
+                }
+            }));
+        for (auto& th : threads) th.join();
+        threads.clear();
+        for (int t=0; t<num_threads; ++t)
+            threads.push_back(std::thread([&alloc, &blocks, t]() {
+                auto& b = blocks[(t+1)%num_threads];
+                for (int i=0; i<n; ++i)
+                {
+                    EXPECT_EQ(b[i][0], static_cast<unsigned char>((t+1)%num_threads));
+                    alloc.deallocate(b[i], 64 + (i % 7)*100);
+                }
+                for (int i=0; i<n; ++i) alloc.deallocate(alloc.allocate(64 + (i % 7)*100), 64 + (i % 7)*100);
+            }));
+        for (auto& th : threads) th.join();
+
+        auto s = pool.stats();
+        EXPECT_EQ(s.m_bytes_in_use, 0u);
+        EXPECT_GT(s.m_hits, 0u);
+        EXPECT_EQ(s.m_hits + s.m_misses, 2u*num_threads*n);
+    }
+    EXPECT_EQ(counting_allocator<unsigned char>::bytes(), base_bytes);
+}
+
+TEST(slab_pool, exited_threads)
+{
+    const long base_bytes = counting_allocator<unsigned char>::bytes();
+    {
+        allocator::slab_pool<counting_allocator<unsigned char>> pool{counting_allocator<unsigned char>{}};
+        auto alloc = pool.get_allocator();
+
+        // short-lived threads cache blocks and keep one block in use each
+        const int num_threads = 8;
+        std::vector<unsigned char*> kept(num_threads);
+        for (int t=0; t<num_threads; ++t)
+        {
+            std::thread([&alloc, &kept, t]() {
+                std::vector<unsigned char*> ptrs;
+                for (int i=0; i<8; ++i) ptrs.push_back(alloc.allocate(1024));
+                for (auto p : ptrs) alloc.deallocate(p, 1024);
+                kept[t] = alloc.allocate(2048);
+            }).join();
+        }
+
+        // the caches of the exited threads were moved to the depot, their counters are kept
+        auto s = pool.stats();
+        EXPECT_EQ(s.m_bytes_in_use, num_threads*allocator::slab::class_size(allocator::slab::size_class(2048)));
+        EXPECT_EQ(s.m_hits + s.m_misses, num_threads*9u);
+        EXPECT_GT(s.m_hits, 0u);
+        EXPECT_EQ(counting_allocator<unsigned char>::bytes() - base_bytes,
+            (long)(s.m_bytes_cached + s.m_bytes_in_use));
+
+        // blocks of exited threads are reused and can be trimmed
+        auto p = alloc.allocate(1024);
+        EXPECT_EQ(pool.stats().m_hits, s.m_hits + 1u);
+        alloc.deallocate(p, 1024);
+        for (auto k : kept) alloc.deallocate(k, 2048);
+        pool.trim();
+        s = pool.stats();
+        EXPECT_EQ(s.m_bytes_in_use, 0u);
+        EXPECT_EQ(s.m_bytes_cached, 0u);
+        EXPECT_EQ(counting_allocator<unsigned char>::bytes(), base_bytes);
+    }
+    EXPECT_EQ(counting_allocator<unsigned char>::bytes(), base_bytes);
+
+    // threads which exit after the pool was destroyed do not touch it
+    {
+        std::atomic<int> state{0};
+        std::unique_ptr<allocator::slab_pool<counting_allocator<unsigned char>>> pool(
+            new allocator::slab_pool<counting_allocator<unsigned char>>{counting_allocator<unsigned char>{}});
+        auto alloc = pool->get_allocator();
+        std::thread th([&alloc, &state]() {
+            alloc.deallocate(alloc.allocate(1024), 1024);
+            state = 1;
+            while (state != 2) std::this_thread::yield();
+        });
+        while (state != 1) std::this_thread::yield();
+        pool.reset();
+        state = 2;
+        th.join();
+    }
+    EXPECT_EQ(counting_allocator<unsigned char>::bytes(), base_bytes);
+}
+
+TEST(slab_pool, messages)
+{
+    using traits = arch_traits<cpu>;
+    traits::pool_type pool{traits::basic_allocator_type{}};
+    for (int i=0; i<3; ++i)
+    {
+        auto msg = traits::make_message(pool);
+        msg.resize(1000 + i);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(msg.data()) % 64u, 0u);
+    }
+    auto s = pool.stats();
+    EXPECT_EQ(s.m_misses, 1u);
+    EXPECT_EQ(s.m_hits, 2u);
+}
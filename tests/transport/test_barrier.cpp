@@ -17,34 +17,30 @@
 #include <ghex/common/timer.hpp>
 #include <gtest/gtest.h>
 
-#ifdef GHEX_TEST_USE_UCX
-#include <ghex/transport_layer/ucx/context.hpp>
-using transport = gridtools::ghex::tl::ucx_tag;
-#else
-#include <ghex/transport_layer/mpi/context.hpp>
-using transport = gridtools::ghex::tl::mpi_tag;
-#endif
+#include "./transport.hpp"
 
 
 TEST(transport, rank_barrier) {
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
+    run_test_ranks([](test_rank& tr) {
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
 
-    gridtools::ghex::tl::barrier_t barrier;
+        gridtools::ghex::tl::barrier_t barrier;
 
-    auto comm = context.get_communicator();
-    int rank = context.rank();
-    gridtools::ghex::timer timer;
+        auto comm = context.get_communicator();
+        int rank = context.rank();
+        gridtools::ghex::timer timer;
 
-    timer.tic();
-    for(int i=0; i<20; i++)  {
-        barrier.rank_barrier(comm);
-    }
-    const auto t = timer.stoc();
-    if(rank==0)
-    {
-        std::cout << "time:       " << t/1000000 << "s\n";
-    }
+        timer.tic();
+        for(int i=0; i<20; i++)  {
+            barrier.rank_barrier(comm);
+        }
+        const auto t = timer.stoc();
+        if(rank==0)
+        {
+            std::cout << "time:       " << t/1000000 << "s\n";
+        }
+    });
 }
 
 namespace gridtools {
@@ -79,83 +75,89 @@ namespace gridtools {
 
 
 TEST(transport, in_barrier_1) {
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
+    run_test_ranks([](test_rank& tr) {
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
 
-    size_t n_threads = 4;
-    gridtools::ghex::tl::barrier_t barrier{n_threads};
+        size_t n_threads = 4;
+        gridtools::ghex::tl::barrier_t barrier{n_threads};
 
-    gridtools::ghex::tl::test_barrier test(barrier);
-    test.test_in_node1(context);
+        gridtools::ghex::tl::test_barrier test(barrier);
+        test.test_in_node1(context);
+    });
 }
 
 TEST(transport, in_barrier) {
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
-
-    size_t n_threads = 4;
-    gridtools::ghex::tl::barrier_t barrier{n_threads};
-
-    auto work =
-        [&]()
-        {
-            auto comm = context.get_communicator();
-            int rank = context.rank();
-            gridtools::ghex::timer timer;
-
-            timer.tic();
-            for(int i=0; i<20; i++)  {
-                comm.progress();
-                barrier.in_node(comm);
-            }
-            const auto t = timer.stoc();
-            if(rank==0)
-                {
-                    std::cout << "time:       " << t/1000000 << "s\n";
+    run_test_ranks([](test_rank& tr) {
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+
+        size_t n_threads = 4;
+        gridtools::ghex::tl::barrier_t barrier{n_threads};
+
+        auto work =
+            [&]()
+            {
+                auto comm = context.get_communicator();
+                int rank = context.rank();
+                gridtools::ghex::timer timer;
+
+                timer.tic();
+                for(int i=0; i<20; i++)  {
+                    comm.progress();
+                    barrier.in_node(comm);
                 }
-        };
+                const auto t = timer.stoc();
+                if(rank==0)
+                    {
+                        std::cout << "time:       " << t/1000000 << "s\n";
+                    }
+            };
 
-    std::vector<std::thread> ths;
-    for (size_t i = 0; i < n_threads; ++i) {
-        ths.push_back(std::thread{work});
-    }
-    for (size_t i = 0; i < n_threads; ++i) {
-        ths[i].join();
-    }
+        std::vector<std::thread> ths;
+        for (size_t i = 0; i < n_threads; ++i) {
+            ths.push_back(std::thread{work});
+        }
+        for (size_t i = 0; i < n_threads; ++i) {
+            ths[i].join();
+        }
 
+    });
 }
 
 TEST(transport, full_barrier) {
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
-
-    size_t n_threads = 4;
-    gridtools::ghex::tl::barrier_t barrier{n_threads};
-
-    auto work =
-        [&]()
-        {
-            auto comm = context.get_communicator();
-            int rank = context.rank();
-            gridtools::ghex::timer timer;
-
-            timer.tic();
-            for(int i=0; i<20; i++)  {
-                barrier(comm);
-            }
-            const auto t = timer.stoc();
-            if(rank==0)
-                {
-                    std::cout << "time:       " << t/1000000 << "s\n";
+    run_test_ranks([](test_rank& tr) {
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+
+        size_t n_threads = 4;
+        gridtools::ghex::tl::barrier_t barrier{n_threads};
+
+        auto work =
+            [&]()
+            {
+                auto comm = context.get_communicator();
+                int rank = context.rank();
+                gridtools::ghex::timer timer;
+
+                timer.tic();
+                for(int i=0; i<20; i++)  {
+                    barrier(comm);
                 }
-        };
+                const auto t = timer.stoc();
+                if(rank==0)
+                    {
+                        std::cout << "time:       " << t/1000000 << "s\n";
+                    }
+            };
 
-    std::vector<std::thread> ths;
-    for (size_t i = 0; i < n_threads; ++i) {
-        ths.push_back(std::thread{work});
-    }
-    for (size_t i = 0; i < n_threads; ++i) {
-        ths[i].join();
-    }
+        std::vector<std::thread> ths;
+        for (size_t i = 0; i < n_threads; ++i) {
+            ths.push_back(std::thread{work});
+        }
+        for (size_t i = 0; i < n_threads; ++i) {
+            ths[i].join();
+        }
 
+    });
 }
@@ -8,19 +8,14 @@
  * SPDX-License-Identifier: BSD-3-Clause
  *
  */
+#include <array>
 #include <vector>
 #include <iomanip>
 #include <utility>
 
 #include <gtest/gtest.h>
 
-#ifdef GHEX_TEST_USE_UCX
-#include <ghex/transport_layer/ucx/context.hpp>
-using transport = gridtools::ghex::tl::ucx_tag;
-#else
-#include <ghex/transport_layer/mpi/context.hpp>
-using transport = gridtools::ghex::tl::mpi_tag;
-#endif
+#include "./transport.hpp"
 
 
 template<typename Message, typename Context>
@@ -50,12 +45,14 @@ bool test_1(Context& context, unsigned int size) {
 }
 
 TEST(cancel, future) {
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
+    run_test_ranks([](test_rank& tr) {
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
 
-    EXPECT_TRUE(test_1<std::vector<unsigned char>>(context,1));
-    EXPECT_TRUE(test_1<std::vector<unsigned char>>(context,32));
-    EXPECT_TRUE(test_1<std::vector<unsigned char>>(context,4096));
+        EXPECT_TRUE(test_1<std::vector<unsigned char>>(context,1));
+        EXPECT_TRUE(test_1<std::vector<unsigned char>>(context,32));
+        EXPECT_TRUE(test_1<std::vector<unsigned char>>(context,4096));
+    });
 }
 
 template<typename Message, typename Context>
@@ -94,10 +91,12 @@ bool test_2(Context& context, unsigned int size) {
 }
 
 TEST(cancel, callbacks) {
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
+    run_test_ranks([](test_rank& tr) {
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
 
-    EXPECT_TRUE(test_2<std::vector<unsigned char>>(context,1));
-    EXPECT_TRUE(test_2<std::vector<unsigned char>>(context,32));
-    EXPECT_TRUE(test_2<std::vector<unsigned char>>(context,4096));
+        EXPECT_TRUE(test_2<std::vector<unsigned char>>(context,1));
+        EXPECT_TRUE(test_2<std::vector<unsigned char>>(context,32));
+        EXPECT_TRUE(test_2<std::vector<unsigned char>>(context,4096));
+    });
 }
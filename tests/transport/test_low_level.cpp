@@ -16,15 +16,7 @@
 
 //#define GHEX_TEST_COUNT_ITERATIONS
 
-#ifdef GHEX_TEST_USE_UCX
-#include <ghex/transport_layer/ucx/context.hpp>
-using transport = gridtools::ghex::tl::ucx_tag;
-#else
-#include <ghex/transport_layer/mpi/context.hpp>
-using transport = gridtools::ghex::tl::mpi_tag;
-#endif
-
-using context_type = gridtools::ghex::tl::context<transport>;
+#include "./transport.hpp"
 
 #define SIZE 40
 
@@ -34,8 +26,6 @@ using context_type = gridtools::ghex::tl::context<transport>;
  * P1 sends a message to P0 and receive from P0.
  */
 
-int rank;
-
 template <typename M>
 void init_msg(M& msg) {
     int* data = msg.template data<int>();
@@ -52,7 +42,7 @@ void init_msg(std::vector<unsigned char>& msg) {
 }
 
 template <typename M>
-bool check_msg(M const& msg) {
+bool check_msg(M const& msg, int rank) {
     bool ok = true;
     if (rank > 1)
         return ok;
@@ -65,7 +55,7 @@ bool check_msg(M const& msg) {
     return ok;
 }
 
-bool check_msg(std::vector<unsigned char> const& msg) {
+bool check_msg(std::vector<unsigned char> const& msg, int rank) {
     bool ok = true;
     if (rank > 1)
         return ok;
@@ -82,6 +72,7 @@ bool check_msg(std::vector<unsigned char> const& msg) {
 template<typename MsgType, typename Context>
 auto test_unidirectional(Context& context) {
     auto comm = context.get_communicator();
+    const int rank = comm.rank();
 
     MsgType smsg(SIZE);
     MsgType rmsg(SIZE);
@@ -113,6 +104,7 @@ auto test_unidirectional(Context& context) {
 template<typename MsgType, typename Context>
 auto test_bidirectional(Context& context) {
     auto comm = context.get_communicator();
+    const int rank = comm.rank();
     using comm_type = std::remove_reference_t<decltype(comm)>;
 
     MsgType smsg(SIZE);
@@ -121,12 +113,13 @@ auto test_bidirectional(Context& context) {
 
     typename comm_type::template future<void> rfut;
 
+    // the receives are posted first: a blocking send may only complete once it has been matched
     if ( rank == 0 ) {
-        comm.send(smsg, 1, 1).get();
         rfut = comm.recv(rmsg, 1, 2);
+        comm.send(smsg, 1, 1).get();
     } else if (rank == 1) {
-        comm.send(smsg, 0, 2).get();
         rfut = comm.recv(rmsg, 0, 1);
+        comm.send(smsg, 0, 2).get();
     }
 
 #ifdef GHEX_TEST_COUNT_ITERATIONS
@@ -150,6 +143,7 @@ auto test_bidirectional(Context& context) {
 template<typename MsgType, typename Context>
 auto test_unidirectional_cb(Context& context) {
     auto comm = context.get_communicator();
+    const int rank = comm.rank();
 
     using comm_type       = std::remove_reference_t<decltype(comm)>;
     using cb_msg_type     = typename comm_type::message_type;
@@ -192,6 +186,7 @@ template<typename MsgType, typename Context>
 auto test_bidirectional_cb(Context& context) {
 
     auto comm = context.get_communicator();
+    const int rank = comm.rank();
 
     using comm_type       = std::remove_reference_t<decltype(comm)>;
     using cb_msg_type     = typename comm_type::message_type;
@@ -236,151 +231,175 @@ auto test_bidirectional_cb(Context& context) {
 
 
 template <typename Test>
-bool run_test(Test&& test) {
+bool run_test(Test&& test, int rank) {
     bool ok;
     auto msg = test();
-    ok = check_msg(msg);
+    ok = check_msg(msg, rank);
     return ok;
 }
 
 TEST(low_level, basic_unidirectional_vector) {
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
-    using MsgType = std::vector<unsigned char>;
-    auto test_func = [&context]() mutable { return test_unidirectional<MsgType>(context);};
-    if (rank == 1) {
-        EXPECT_TRUE(run_test(test_func));
-    }
-    else if (rank == 0) {
-        run_test(test_func);
-    }
+    run_test_ranks([](test_rank& tr) {
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        const int rank = context.rank();
+        using MsgType = std::vector<unsigned char>;
+        auto test_func = [&context]() mutable { return test_unidirectional<MsgType>(context);};
+        if (rank == 1) {
+            EXPECT_TRUE(run_test(test_func, rank));
+        }
+        else if (rank == 0) {
+            run_test(test_func, rank);
+        }
+    });
 }
 TEST(low_level, basic_unidirectional_buffer) {
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    using MsgType = gridtools::ghex::tl::message_buffer<std::allocator<unsigned char>>;
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
-    auto test_func = [&context]() mutable { return test_unidirectional<MsgType>(context);};
-    if (rank == 1) {
-        EXPECT_TRUE(run_test(test_func));
-    }
-    else if (rank == 0) {
-        run_test(test_func);
-    }
+    run_test_ranks([](test_rank& tr) {
+        using MsgType = gridtools::ghex::tl::message_buffer<std::allocator<unsigned char>>;
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        const int rank = context.rank();
+        auto test_func = [&context]() mutable { return test_unidirectional<MsgType>(context);};
+        if (rank == 1) {
+            EXPECT_TRUE(run_test(test_func, rank));
+        }
+        else if (rank == 0) {
+            run_test(test_func, rank);
+        }
+    });
 }
 TEST(low_level, basic_unidirectional_shared_buffer) {
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    using MsgType = gridtools::ghex::tl::shared_message_buffer<std::allocator<unsigned char>>;
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
-    auto test_func = [&context]() mutable { return test_unidirectional<MsgType>(context);};
-    if (rank == 1) {
-        EXPECT_TRUE(run_test(test_func));
-    }
-    else if (rank == 0) {
-        run_test(test_func);
-    }
+    run_test_ranks([](test_rank& tr) {
+        using MsgType = gridtools::ghex::tl::shared_message_buffer<std::allocator<unsigned char>>;
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        const int rank = context.rank();
+        auto test_func = [&context]() mutable { return test_unidirectional<MsgType>(context);};
+        if (rank == 1) {
+            EXPECT_TRUE(run_test(test_func, rank));
+        }
+        else if (rank == 0) {
+            run_test(test_func, rank);
+        }
+    });
 }
 
 TEST(low_level, basic_bidirectional_vector) {
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    using MsgType = std::vector<unsigned char>;
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
-    auto test_func = [&context]() mutable { return test_bidirectional<MsgType>(context);};
-    if (rank < 2) {
-        EXPECT_TRUE(run_test(test_func));
-    }
+    run_test_ranks([](test_rank& tr) {
+        using MsgType = std::vector<unsigned char>;
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        const int rank = context.rank();
+        auto test_func = [&context]() mutable { return test_bidirectional<MsgType>(context);};
+        if (rank < 2) {
+            EXPECT_TRUE(run_test(test_func, rank));
+        }
+    });
 }
 TEST(low_level, basic_bidirectional_buffer) {
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    using MsgType = gridtools::ghex::tl::message_buffer<std::allocator<unsigned char>>;
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
-    auto test_func = [&context]() mutable { return test_bidirectional<MsgType>(context);};
-    if (rank < 2) {
-        EXPECT_TRUE(run_test(test_func));
-    }
+    run_test_ranks([](test_rank& tr) {
+        using MsgType = gridtools::ghex::tl::message_buffer<std::allocator<unsigned char>>;
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        const int rank = context.rank();
+        auto test_func = [&context]() mutable { return test_bidirectional<MsgType>(context);};
+        if (rank < 2) {
+            EXPECT_TRUE(run_test(test_func, rank));
+        }
+    });
 }
 TEST(low_level, basic_bidirectional_shared_buffer) {
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    using MsgType = gridtools::ghex::tl::shared_message_buffer<std::allocator<unsigned char>>;
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
-    auto test_func = [&context]() mutable { return test_bidirectional<MsgType>(context);};
-    if (rank < 2) {
-        EXPECT_TRUE(run_test(test_func));
-    }
+    run_test_ranks([](test_rank& tr) {
+        using MsgType = gridtools::ghex::tl::shared_message_buffer<std::allocator<unsigned char>>;
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        const int rank = context.rank();
+        auto test_func = [&context]() mutable { return test_bidirectional<MsgType>(context);};
+        if (rank < 2) {
+            EXPECT_TRUE(run_test(test_func, rank));
+        }
+    });
 }
 
 TEST(low_level, basic_unidirectional_cb_vector) {
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    using MsgType = std::vector<unsigned char>;
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
-    auto test_func = [&context]() mutable { return test_unidirectional_cb<MsgType>(context);};
-    if (rank == 1) {
-        EXPECT_TRUE(run_test(test_func));
-    }
-    else if (rank == 0) {
-        run_test(test_func);
-    }
+    run_test_ranks([](test_rank& tr) {
+        using MsgType = std::vector<unsigned char>;
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        const int rank = context.rank();
+        auto test_func = [&context]() mutable { return test_unidirectional_cb<MsgType>(context);};
+        if (rank == 1) {
+            EXPECT_TRUE(run_test(test_func, rank));
+        }
+        else if (rank == 0) {
+            run_test(test_func, rank);
+        }
+    });
 }
 TEST(low_level, basic_unidirectional_cb_buffer) {
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    using MsgType = gridtools::ghex::tl::message_buffer<std::allocator<unsigned char>>;
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
-    auto test_func = [&context]() mutable { return test_unidirectional_cb<MsgType>(context);};
-    if (rank == 1) {
-        EXPECT_TRUE(run_test(test_func));
-    }
-    else if (rank == 0) {
-        run_test(test_func);
-    }
+    run_test_ranks([](test_rank& tr) {
+        using MsgType = gridtools::ghex::tl::message_buffer<std::allocator<unsigned char>>;
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        const int rank = context.rank();
+        auto test_func = [&context]() mutable { return test_unidirectional_cb<MsgType>(context);};
+        if (rank == 1) {
+            EXPECT_TRUE(run_test(test_func, rank));
+        }
+        else if (rank == 0) {
+            run_test(test_func, rank);
+        }
+    });
 }
 TEST(low_level, basic_unidirectional_cb_shared_buffer) {
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    using MsgType = gridtools::ghex::tl::shared_message_buffer<std::allocator<unsigned char>>;
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
-    auto test_func = [&context]() mutable { return test_unidirectional_cb<MsgType>(context);};
-    if (rank == 1) {
-        EXPECT_TRUE(run_test(test_func));
-    }
-    else if (rank == 0) {
-        run_test(test_func);
-    }
+    run_test_ranks([](test_rank& tr) {
+        using MsgType = gridtools::ghex::tl::shared_message_buffer<std::allocator<unsigned char>>;
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        const int rank = context.rank();
+        auto test_func = [&context]() mutable { return test_unidirectional_cb<MsgType>(context);};
+        if (rank == 1) {
+            EXPECT_TRUE(run_test(test_func, rank));
+        }
+        else if (rank == 0) {
+            run_test(test_func, rank);
+        }
+    });
 }
 
 TEST(low_level, basic_bidirectional_cb_vector) {
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    using MsgType = std::vector<unsigned char>;
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
-    auto test_func = [&context]() mutable { return test_bidirectional_cb<MsgType>(context);};
-    if (rank < 2) {
-        EXPECT_TRUE(run_test(test_func));
-    }
+    run_test_ranks([](test_rank& tr) {
+        using MsgType = std::vector<unsigned char>;
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        const int rank = context.rank();
+        auto test_func = [&context]() mutable { return test_bidirectional_cb<MsgType>(context);};
+        if (rank < 2) {
+            EXPECT_TRUE(run_test(test_func, rank));
+        }
+    });
 }
 TEST(low_level, basic_bidirectional_cb_buffer) {
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    using MsgType = gridtools::ghex::tl::message_buffer<std::allocator<unsigned char>>;
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
-    auto test_func = [&context]() mutable{ return test_bidirectional_cb<MsgType>(context);};
-    if (rank < 2) {
-        EXPECT_TRUE(run_test(test_func));
-    }
+    run_test_ranks([](test_rank& tr) {
+        using MsgType = gridtools::ghex::tl::message_buffer<std::allocator<unsigned char>>;
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        const int rank = context.rank();
+        auto test_func = [&context]() mutable{ return test_bidirectional_cb<MsgType>(context);};
+        if (rank < 2) {
+            EXPECT_TRUE(run_test(test_func, rank));
+        }
+    });
 }
 TEST(low_level, basic_bidirectional_cb_shared_buffer) {
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    using MsgType = gridtools::ghex::tl::shared_message_buffer<std::allocator<unsigned char>>;
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
-    auto test_func = [&context]() mutable { return test_bidirectional_cb<MsgType>(context);};
-    if (rank < 2) {
-        EXPECT_TRUE(run_test(test_func));
-    }
+    run_test_ranks([](test_rank& tr) {
+        using MsgType = gridtools::ghex::tl::shared_message_buffer<std::allocator<unsigned char>>;
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        const int rank = context.rank();
+        auto test_func = [&context]() mutable { return test_bidirectional_cb<MsgType>(context);};
+        if (rank < 2) {
+            EXPECT_TRUE(run_test(test_func, rank));
+        }
+    });
 }
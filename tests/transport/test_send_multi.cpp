@@ -8,25 +8,17 @@
  * SPDX-License-Identifier: BSD-3-Clause
  *
  */
+#include <array>
 #include <iostream>
 #include <iomanip>
 
 #include <gtest/gtest.h>
 
-#ifdef GHEX_TEST_USE_UCX
-#include <ghex/transport_layer/ucx/context.hpp>
-using transport = gridtools::ghex::tl::ucx_tag;
-#else
-#include <ghex/transport_layer/mpi/context.hpp>
-using transport = gridtools::ghex::tl::mpi_tag;
-#endif
-
-using context_type = gridtools::ghex::tl::context<transport>;
+#include "./transport.hpp"
 
 //#define GHEX_TEST_COUNT_ITERATIONS
 //
 const int SIZE = 4000000;
-int rank;
 
 template <typename M>
 void init_msg(M& msg) {
@@ -44,7 +36,7 @@ void init_msg(std::vector<unsigned char>& msg) {
 }
 
 template <typename M>
-bool check_msg(M const& msg) {
+bool check_msg(M const& msg, int rank) {
     bool ok = true;
     if (rank > 1)
         return ok;
@@ -57,7 +49,7 @@ bool check_msg(M const& msg) {
     return ok;
 }
 
-bool check_msg(std::vector<unsigned char> const& msg) {
+bool check_msg(std::vector<unsigned char> const& msg, int rank) {
     bool ok = true;
     if (rank > 1)
         return ok;
@@ -72,172 +64,163 @@ bool check_msg(std::vector<unsigned char> const& msg) {
 }
 
 TEST(transport, send_multi) {
-    {
-        int size;
-        MPI_Comm_size(MPI_COMM_WORLD, &size);
-        EXPECT_EQ(size, 4);
-    }
+    run_test_ranks([](test_rank& tr) {
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        EXPECT_EQ(context.size(), 4);
 
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
+        auto comm = context.get_communicator();
+        //comm.barrier();
 
-    auto comm = context.get_communicator();
-    //comm.barrier();
+        const int rank = context.rank();
 
-    rank = context.rank();
+        using allocator_type = std::allocator<unsigned char>;
+        using smsg_type      = gridtools::ghex::tl::shared_message_buffer<allocator_type>;
 
-    using allocator_type = std::allocator<unsigned char>;
-    using smsg_type      = gridtools::ghex::tl::shared_message_buffer<allocator_type>;
+        if (rank == 0) {
+            smsg_type smsg{SIZE};
+            init_msg(smsg);
 
-    if (rank == 0) {
-        smsg_type smsg{SIZE};
-        init_msg(smsg);
+            std::array<int, 3> dsts = {1,2,3};
 
-        std::array<int, 3> dsts = {1,2,3};
+            auto fut_vec = comm.send_multi(smsg, dsts, 42);
 
-        auto fut_vec = comm.send_multi(smsg, dsts, 42);
+            for (auto& fut : fut_vec)
+                fut.wait();
+        }
+        else {
+            smsg_type rmsg{SIZE};
+            comm.recv(rmsg, 0, 42).wait();
+            bool ok = check_msg(rmsg, rank);
 
-        for (auto& fut : fut_vec)
-            fut.wait();
-    }
-    else {
-        smsg_type rmsg{SIZE};
-        comm.recv(rmsg, 0, 42).wait();
-        bool ok = check_msg(rmsg);
-
-        EXPECT_TRUE(ok);
-    }
+            EXPECT_TRUE(ok);
+        }
 
-    auto status = comm.progress();
-    EXPECT_EQ(status.num(), 0);
+        auto status = comm.progress();
+        EXPECT_EQ(status.num(), 0);
+    });
 }
 
 TEST(transport, send_multi_cb) {
-    {
-        int size;
-        MPI_Comm_size(MPI_COMM_WORLD, &size);
-        EXPECT_EQ(size, 4);
-    }
-
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
+    run_test_ranks([](test_rank& tr) {
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        EXPECT_EQ(context.size(), 4);
 
-    auto comm = context.get_communicator();
-    // comm.barrier();
+        auto comm = context.get_communicator();
+        // comm.barrier();
 
-    rank = context.rank();
+        const int rank = context.rank();
 
-    using comm_type      = std::remove_reference_t<decltype(comm)>;
-    using allocator_type = std::allocator<unsigned char>;
-    using smsg_type      = gridtools::ghex::tl::shared_message_buffer<allocator_type>;
-    //using smsg_type      = gridtools::ghex::tl::message_buffer<allocator_type>;
-    using cb_msg_type    = comm_type::message_type;
-    using rank_type      = comm_type::rank_type;
-    using tag_type       = comm_type::tag_type;
+        using comm_type      = std::remove_reference_t<decltype(comm)>;
+        using allocator_type = std::allocator<unsigned char>;
+        using smsg_type      = gridtools::ghex::tl::shared_message_buffer<allocator_type>;
+        //using smsg_type      = gridtools::ghex::tl::message_buffer<allocator_type>;
+        using cb_msg_type    = comm_type::message_type;
+        using rank_type      = comm_type::rank_type;
+        using tag_type       = comm_type::tag_type;
 
-    if (rank == 0) {
+        if (rank == 0) {
 
-        smsg_type smsg{SIZE};
-        init_msg(smsg);
+            smsg_type smsg{SIZE};
+            init_msg(smsg);
 
-        std::array<int, 3> dsts = {1,2,3};
+            std::array<int, 3> dsts = {1,2,3};
 
-        bool arrived = false;
-        auto req_vec = comm.send_multi(smsg, dsts, 42, [&arrived](cb_msg_type, rank_type, tag_type){ arrived=true;});
+            bool arrived = false;
+            auto req_vec = comm.send_multi(smsg, dsts, 42, [&arrived](cb_msg_type, rank_type, tag_type){ arrived=true;});
 
 #ifdef GHEX_TEST_COUNT_ITERATIONS
-        int c = 0;
+            int c = 0;
 #endif
-        do {
+            do {
 #ifdef GHEX_TEST_COUNT_ITERATIONS
-            c++;
+                c++;
 #endif
-            comm.progress();
-         } while (!arrived);
+                comm.progress();
+             } while (!arrived);
 
-        EXPECT_EQ(smsg.use_count(), 1);
-        for (auto& req : req_vec)
-            EXPECT_TRUE(req.test());
+            EXPECT_EQ(smsg.use_count(), 1);
+            for (auto& req : req_vec)
+                EXPECT_TRUE(req.test());
 
 #ifdef GHEX_TEST_COUNT_ITERATIONS
-        std::cout  << "\n***********\n";
-        std::cout  <<   "*" << std::setw(8) << c << " *\n";
-        std::cout  << "***********\n";
+            std::cout  << "\n***********\n";
+            std::cout  <<   "*" << std::setw(8) << c << " *\n";
+            std::cout  << "***********\n";
 #endif
 
-    } else {
-        smsg_type rmsg{SIZE};
-        comm.recv(rmsg, 0, 42).wait();
-        bool ok = check_msg(rmsg);
+        } else {
+            smsg_type rmsg{SIZE};
+            comm.recv(rmsg, 0, 42).wait();
+            bool ok = check_msg(rmsg, rank);
 
-        EXPECT_TRUE(ok);
-    }
+            EXPECT_TRUE(ok);
+        }
 
-    auto status = comm.progress();
-    EXPECT_EQ(status.num(), 0);
+        auto status = comm.progress();
+        EXPECT_EQ(status.num(), 0);
+    });
 }
 
 TEST(transport, send_multi_cb_move) {
-    {
-        int size;
-        MPI_Comm_size(MPI_COMM_WORLD, &size);
-        EXPECT_EQ(size, 4);
-    }
-
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
+    run_test_ranks([](test_rank& tr) {
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        EXPECT_EQ(context.size(), 4);
 
-    auto comm = context.get_communicator();
-    // comm.barrier();
+        auto comm = context.get_communicator();
+        // comm.barrier();
 
-    rank = context.rank();
+        const int rank = context.rank();
 
-    using comm_type      = std::remove_reference_t<decltype(comm)>;
-    using allocator_type = std::allocator<unsigned char>;
-    //using smsg_type      = gridtools::ghex::tl::message_buffer<allocator_type>;
-    using smsg_type      = gridtools::ghex::tl::shared_message_buffer<allocator_type>;
-    using cb_msg_type    = comm_type::message_type;
-    using rank_type      = comm_type::rank_type;
-    using tag_type       = comm_type::tag_type;
+        using comm_type      = std::remove_reference_t<decltype(comm)>;
+        using allocator_type = std::allocator<unsigned char>;
+        //using smsg_type      = gridtools::ghex::tl::message_buffer<allocator_type>;
+        using smsg_type      = gridtools::ghex::tl::shared_message_buffer<allocator_type>;
+        using cb_msg_type    = comm_type::message_type;
+        using rank_type      = comm_type::rank_type;
+        using tag_type       = comm_type::tag_type;
 
-    if (rank == 0) {
+        if (rank == 0) {
 
-        smsg_type smsg{SIZE};
-        init_msg(smsg);
+            smsg_type smsg{SIZE};
+            init_msg(smsg);
 
-        std::array<int, 3> dsts = {1,2,3};
+            std::array<int, 3> dsts = {1,2,3};
 
-        bool arrived = false;
-        auto req_vec = comm.send_multi(std::move(smsg), dsts, 42, [&arrived](cb_msg_type, rank_type, tag_type){ arrived=true;});
+            bool arrived = false;
+            auto req_vec = comm.send_multi(std::move(smsg), dsts, 42, [&arrived](cb_msg_type, rank_type, tag_type){ arrived=true;});
 
 #ifdef GHEX_TEST_COUNT_ITERATIONS
-        int c = 0;
+            int c = 0;
 #endif
-        do {
+            do {
 #ifdef GHEX_TEST_COUNT_ITERATIONS
-            c++;
+                c++;
 #endif
-            comm.progress();
-         } while (!arrived);
+                comm.progress();
+             } while (!arrived);
 
-        EXPECT_EQ(smsg.use_count(), 0);
-        for (auto& req : req_vec)
-            EXPECT_TRUE(req.test());
+            EXPECT_EQ(smsg.use_count(), 0);
+            for (auto& req : req_vec)
+                EXPECT_TRUE(req.test());
 
 #ifdef GHEX_TEST_COUNT_ITERATIONS
-        std::cout  << "\n***********\n";
-        std::cout  <<   "*" << std::setw(8) << c << " *\n";
-        std::cout  << "***********\n";
+            std::cout  << "\n***********\n";
+            std::cout  <<   "*" << std::setw(8) << c << " *\n";
+            std::cout  << "***********\n";
 #endif
 
-    } else {
-        smsg_type rmsg{SIZE};
-        comm.recv(rmsg, 0, 42).wait();
-        bool ok = check_msg(rmsg);
+        } else {
+            smsg_type rmsg{SIZE};
+            comm.recv(rmsg, 0, 42).wait();
+            bool ok = check_msg(rmsg, rank);
 
-        EXPECT_TRUE(ok);
-    }
+            EXPECT_TRUE(ok);
+        }
 
-    auto status = comm.progress();
-    EXPECT_EQ(status.num(), 0);
+        auto status = comm.progress();
+        EXPECT_EQ(status.num(), 0);
+    });
 }
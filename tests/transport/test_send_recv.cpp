@@ -10,20 +10,14 @@
  */
 #include <iostream>
 #include <iomanip>
+#include <array>
 #include <ghex/transport_layer/message_buffer.hpp>
 #include <ghex/transport_layer/shared_message_buffer.hpp>
 #include <ghex/common/timer.hpp>
 #include <gtest/gtest.h>
 
-#ifdef GHEX_TEST_USE_UCX
-#include <ghex/transport_layer/ucx/context.hpp>
-using transport = gridtools::ghex::tl::ucx_tag;
-#else
-#include <ghex/transport_layer/mpi/context.hpp>
-using transport = gridtools::ghex::tl::mpi_tag;
-#endif
+#include "./transport.hpp"
 
-using context_type = typename gridtools::ghex::tl::context_factory<transport>::context_type;
 using communicator_type = typename context_type::communicator_type;
 using msg_type = typename communicator_type::message_type;
 
@@ -40,7 +34,7 @@ struct message_factory<msg_type> {
 };
 
 template<typename Factory, typename CommType>
-auto test_ring_send_recv_ft(CommType& comm, std::size_t buffer_size)
+auto test_ring_send_recv_ft(context_type& context, CommType& comm, std::size_t buffer_size)
 {
     gridtools::ghex::timer timer;
     int *data_ptr;
@@ -56,7 +50,7 @@ auto test_ring_send_recv_ft(CommType& comm, std::size_t buffer_size)
     data_ptr = reinterpret_cast<int*>(smsg.data());
     *data_ptr = rank;
 
-    MPI_Barrier(MPI_COMM_WORLD);
+    context.get_setup_communicator().barrier();
     timer.tic();
     for(int i=0; i<NITERS; i++){
 
@@ -76,20 +70,22 @@ auto test_ring_send_recv_ft(CommType& comm, std::size_t buffer_size)
 
 TEST(transport, ring_send_recv_ft)
 {
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    //auto& context = *context_ptr;
-    auto comm = context_ptr->get_communicator();
-
-    test_ring_send_recv_ft< message_factory<std::vector<unsigned char>> >(comm, sizeof(int));
-    test_ring_send_recv_ft< message_factory<gridtools::ghex::tl::message_buffer<>> >(comm, sizeof(int));
-    test_ring_send_recv_ft< message_factory<gridtools::ghex::tl::shared_message_buffer<>> >(comm, sizeof(int));
-    test_ring_send_recv_ft< message_factory<msg_type> >(comm, sizeof(int));
+    run_test_ranks([](test_rank& tr) {
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        auto comm = context.get_communicator();
+
+        test_ring_send_recv_ft< message_factory<std::vector<unsigned char>> >(context, comm, sizeof(int));
+        test_ring_send_recv_ft< message_factory<gridtools::ghex::tl::message_buffer<>> >(context, comm, sizeof(int));
+        test_ring_send_recv_ft< message_factory<gridtools::ghex::tl::shared_message_buffer<>> >(context, comm, sizeof(int));
+        test_ring_send_recv_ft< message_factory<msg_type> >(context, comm, sizeof(int));
+    });
 }
 
 
 
 template<typename Factory, typename CommType>
-auto test_ring_send_recv_cb(CommType& comm, std::size_t buffer_size)
+auto test_ring_send_recv_cb(context_type& context, CommType& comm, std::size_t buffer_size)
 {
     gridtools::ghex::timer timer;
     int *data_ptr;
@@ -105,7 +101,7 @@ auto test_ring_send_recv_cb(CommType& comm, std::size_t buffer_size)
     data_ptr = reinterpret_cast<int*>(smsg.data());
     *data_ptr = rank;
 
-    MPI_Barrier(MPI_COMM_WORLD);
+    context.get_setup_communicator().barrier();
     timer.tic();
     volatile int received = 0;
     volatile int sent = 0;
@@ -136,18 +132,20 @@ auto test_ring_send_recv_cb(CommType& comm, std::size_t buffer_size)
 
 TEST(transport, ring_send_recv_cb)
 {
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
-    auto comm = context.get_communicator();
-
-    test_ring_send_recv_cb< message_factory<std::vector<unsigned char>> >(comm, sizeof(int));
-    test_ring_send_recv_cb< message_factory<gridtools::ghex::tl::message_buffer<>> >(comm, sizeof(int));
-    test_ring_send_recv_cb< message_factory<gridtools::ghex::tl::shared_message_buffer<>> >(comm, sizeof(int));
-    test_ring_send_recv_cb< message_factory<msg_type> >(comm, sizeof(int));
+    run_test_ranks([](test_rank& tr) {
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        auto comm = context.get_communicator();
+
+        test_ring_send_recv_cb< message_factory<std::vector<unsigned char>> >(context, comm, sizeof(int));
+        test_ring_send_recv_cb< message_factory<gridtools::ghex::tl::message_buffer<>> >(context, comm, sizeof(int));
+        test_ring_send_recv_cb< message_factory<gridtools::ghex::tl::shared_message_buffer<>> >(context, comm, sizeof(int));
+        test_ring_send_recv_cb< message_factory<msg_type> >(context, comm, sizeof(int));
+    });
 }
 
 template<typename Factory, typename CommType>
-auto test_ring_send_recv_cb_disown(CommType& comm, std::size_t buffer_size)
+auto test_ring_send_recv_cb_disown(context_type& context, CommType& comm, std::size_t buffer_size)
 {
     gridtools::ghex::timer timer;
     int rank = comm.rank();
@@ -156,7 +154,7 @@ auto test_ring_send_recv_cb_disown(CommType& comm, std::size_t buffer_size)
     int rpeer_rank = (rank-1)%size;
     if(rpeer_rank<0) rpeer_rank = size-1;
 
-    MPI_Barrier(MPI_COMM_WORLD);
+    context.get_setup_communicator().barrier();
     timer.tic();
     volatile int received = 0;
     volatile int sent = 0;
@@ -190,14 +188,16 @@ auto test_ring_send_recv_cb_disown(CommType& comm, std::size_t buffer_size)
 
 TEST(transport, ring_send_recv_cb_disown)
 {
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
-    auto comm = context.get_communicator();
-
-    test_ring_send_recv_cb_disown< message_factory<std::vector<unsigned char>> >(comm, sizeof(int));
-    test_ring_send_recv_cb_disown< message_factory<gridtools::ghex::tl::message_buffer<>> >(comm, sizeof(int));
-    test_ring_send_recv_cb_disown< message_factory<gridtools::ghex::tl::shared_message_buffer<>> >(comm, sizeof(int));
-    test_ring_send_recv_cb_disown< message_factory<msg_type> >(comm, sizeof(int));
+    run_test_ranks([](test_rank& tr) {
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        auto comm = context.get_communicator();
+
+        test_ring_send_recv_cb_disown< message_factory<std::vector<unsigned char>> >(context, comm, sizeof(int));
+        test_ring_send_recv_cb_disown< message_factory<gridtools::ghex::tl::message_buffer<>> >(context, comm, sizeof(int));
+        test_ring_send_recv_cb_disown< message_factory<gridtools::ghex::tl::shared_message_buffer<>> >(context, comm, sizeof(int));
+        test_ring_send_recv_cb_disown< message_factory<msg_type> >(context, comm, sizeof(int));
+    });
 }
 
 struct recursive_functor {
@@ -221,7 +221,7 @@ struct recursive_functor {
 };
 
 template<typename Factory, typename CommType>
-auto test_ring_send_recv_cb_resubmit(CommType& comm, std::size_t buffer_size)
+auto test_ring_send_recv_cb_resubmit(context_type& context, CommType& comm, std::size_t buffer_size)
 {
     gridtools::ghex::timer timer;
     int *data_ptr;
@@ -233,7 +233,7 @@ auto test_ring_send_recv_cb_resubmit(CommType& comm, std::size_t buffer_size)
     auto smsg = Factory::make(buffer_size);
     auto rmsg = Factory::make(buffer_size);
 
-    MPI_Barrier(MPI_COMM_WORLD);
+    context.get_setup_communicator().barrier();
     timer.tic();
 
     volatile int received = 0;
@@ -270,18 +270,20 @@ auto test_ring_send_recv_cb_resubmit(CommType& comm, std::size_t buffer_size)
 
 TEST(transport, ring_send_recv_cb_resubmit)
 {
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
-    auto comm = context.get_communicator();
-
-    test_ring_send_recv_cb_resubmit< message_factory<std::vector<unsigned char>> >(comm, sizeof(int));
-    test_ring_send_recv_cb_resubmit< message_factory<gridtools::ghex::tl::message_buffer<>> >(comm, sizeof(int));
-    test_ring_send_recv_cb_resubmit< message_factory<gridtools::ghex::tl::shared_message_buffer<>> >(comm, sizeof(int));
-    test_ring_send_recv_cb_resubmit< message_factory<msg_type> >(comm, sizeof(int));
+    run_test_ranks([](test_rank& tr) {
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        auto comm = context.get_communicator();
+
+        test_ring_send_recv_cb_resubmit< message_factory<std::vector<unsigned char>> >(context, comm, sizeof(int));
+        test_ring_send_recv_cb_resubmit< message_factory<gridtools::ghex::tl::message_buffer<>> >(context, comm, sizeof(int));
+        test_ring_send_recv_cb_resubmit< message_factory<gridtools::ghex::tl::shared_message_buffer<>> >(context, comm, sizeof(int));
+        test_ring_send_recv_cb_resubmit< message_factory<msg_type> >(context, comm, sizeof(int));
+    });
 }
 
 template<typename Factory, typename CommType>
-auto test_ring_send_recv_cb_resubmit_disown(CommType& comm, std::size_t buffer_size)
+auto test_ring_send_recv_cb_resubmit_disown(context_type& context, CommType& comm, std::size_t buffer_size)
 {
     gridtools::ghex::timer timer;
     int *data_ptr;
@@ -292,7 +294,7 @@ auto test_ring_send_recv_cb_resubmit_disown(CommType& comm, std::size_t buffer_s
 
     auto smsg = Factory::make(buffer_size);
 
-    MPI_Barrier(MPI_COMM_WORLD);
+    context.get_setup_communicator().barrier();
     timer.tic();
 
     volatile int received = 0;
@@ -329,12 +331,46 @@ auto test_ring_send_recv_cb_resubmit_disown(CommType& comm, std::size_t buffer_s
 
 TEST(transport, ring_send_recv_cb_resubmit_disown)
 {
-    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
-    auto& context = *context_ptr;
-    auto comm = context.get_communicator();
-
-    test_ring_send_recv_cb_resubmit_disown< message_factory<std::vector<unsigned char>> >(comm, sizeof(int));
-    test_ring_send_recv_cb_resubmit_disown< message_factory<gridtools::ghex::tl::message_buffer<>> >(comm, sizeof(int));
-    test_ring_send_recv_cb_resubmit_disown< message_factory<gridtools::ghex::tl::shared_message_buffer<>> >(comm, sizeof(int));
-    test_ring_send_recv_cb_resubmit_disown< message_factory<msg_type> >(comm, sizeof(int));
+    run_test_ranks([](test_rank& tr) {
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        auto comm = context.get_communicator();
+
+        test_ring_send_recv_cb_resubmit_disown< message_factory<std::vector<unsigned char>> >(context, comm, sizeof(int));
+        test_ring_send_recv_cb_resubmit_disown< message_factory<gridtools::ghex::tl::message_buffer<>> >(context, comm, sizeof(int));
+        test_ring_send_recv_cb_resubmit_disown< message_factory<gridtools::ghex::tl::shared_message_buffer<>> >(context, comm, sizeof(int));
+        test_ring_send_recv_cb_resubmit_disown< message_factory<msg_type> >(context, comm, sizeof(int));
+    });
+}
+
+TEST(transport, callback_storage)
+{
+    using namespace gridtools::ghex::tl;
+
+    // common messages are stored in place
+    static_assert(cb::any_message::is_inline<message_buffer<>>::value, "message_buffer must be stored in place");
+    static_assert(cb::any_message::is_inline<shared_message_buffer<>>::value, "shared_message_buffer must be stored in place");
+
+    message_buffer<> mb(64);
+    auto ptr = mb.data();
+    cb::any_message m0{std::move(mb)};
+    cb::any_message m1{std::move(m0)};
+    EXPECT_EQ(m1.data(), ptr);
+    EXPECT_EQ(m1.size(), 64u);
+    EXPECT_EQ(m0.data(), nullptr);
+    m0 = std::move(m1);
+    EXPECT_EQ(m0.data(), ptr);
+
+    // small callables are stored in place, large ones on the heap
+    using func_type = cb::small_function<int(cb::any_message, int, int)>;
+    int x = 1;
+    std::array<int, 32> large;
+    large.fill(2);
+    func_type f0{[&x](cb::any_message m, int r, int t) { return x + r + t + (int)m.size(); }};
+    func_type f1{[large](cb::any_message m, int r, int t) { return large[31] + r + t + (int)m.size(); }};
+    func_type f2{std::move(f0)};
+    EXPECT_FALSE(f0);
+    EXPECT_EQ(f2(std::move(m0), 1, 2), 68);
+    f0 = std::move(f1);
+    EXPECT_EQ(f0(cb::any_message{}, 1, 2), 5);
 }
@@ -0,0 +1,133 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#include <array>
+#include <map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "./transport.hpp"
+
+#include <ghex/structured/pattern.hpp>
+#include <ghex/structured/regular/domain_descriptor.hpp>
+#include <ghex/structured/regular/halo_generator.hpp>
+#include <ghex/structured/regular/field_descriptor.hpp>
+#include <ghex/communication_object_2.hpp>
+
+namespace ghex = gridtools::ghex;
+
+TEST(setup, collectives)
+{
+    run_test_ranks([](test_rank& tr) {
+        auto context_ptr = tr.create_context();
+        auto comm = context_ptr->get_setup_communicator();
+        const int rank = comm.rank();
+        const int size = comm.size();
+
+        auto ranks = comm.all_gather(rank).get();
+        for (int r=0; r<size; ++r) EXPECT_EQ(ranks[r], r);
+
+        std::vector<int> sizes(size);
+        for (int r=0; r<size; ++r) sizes[r] = r%3;
+        auto payloads = comm.all_gather(std::vector<int>(rank%3, rank), sizes).get();
+        for (int r=0; r<size; ++r) EXPECT_EQ(payloads[r], std::vector<int>(r%3, r));
+
+        EXPECT_EQ(comm.max_element(std::vector<int>{rank, -rank}), size-1);
+
+        std::array<double,3> value{0., 0., 0.};
+        if (rank == size-1) value = {1., 2., 3.};
+        comm.broadcast(value.data(), 3, size-1);
+        EXPECT_EQ(value, (std::array<double,3>{1., 2., 3.}));
+
+        // rank r sends r+d values to rank d
+        std::vector<int> send_counts(size), send_displs(size), recv_counts(size), recv_displs(size);
+        std::vector<int> send_buf;
+        for (int d=0; d<size; ++d)
+        {
+            send_counts[d] = rank+d;
+            send_displs[d] = send_buf.size();
+            send_buf.insert(send_buf.end(), rank+d, rank*1000+d);
+        }
+        comm.all_to_all(send_counts, recv_counts);
+        int total = 0;
+        for (int s=0; s<size; ++s)
+        {
+            EXPECT_EQ(recv_counts[s], s+rank);
+            recv_displs[s] = total;
+            total += recv_counts[s];
+        }
+        std::vector<int> recv_buf(total);
+        comm.all_to_allv(send_buf, send_counts, send_displs, recv_buf, recv_counts, recv_displs);
+        for (int s=0; s<size; ++s)
+            for (int i=0; i<recv_counts[s]; ++i) EXPECT_EQ(recv_buf[recv_displs[s]+i], s*1000+rank);
+
+        // every rank sends to its two neighbors
+        std::map<int,std::vector<int>> messages;
+        messages[(rank+1)%size].push_back(rank);
+        messages[(rank+size-1)%size].push_back(rank);
+        auto received = comm.sparse_exchange(messages, 0);
+        std::map<int,std::vector<int>> by_source(received.begin(), received.end());
+        EXPECT_EQ(by_source.size(), size > 2 ? 2u : 1u);
+        for (const auto& p : by_source) EXPECT_EQ(p.second[0], p.first);
+    });
+}
+
+TEST(setup, halo_exchange)
+{
+    // a periodic 3D halo exchange, the pattern is set up through the setup communicator
+    using domain_descriptor_type = ghex::structured::regular::domain_descriptor<int,std::integral_constant<int, 3>>;
+    using halo_generator_type = ghex::structured::regular::halo_generator<int,std::integral_constant<int, 3>>;
+
+    run_test_ranks([](test_rank& tr) {
+        auto context_ptr = tr.create_context();
+        auto& context = *context_ptr;
+        ASSERT_EQ(context.size(), 4);
+
+        const std::array<int,3> dims{2, 2, 1};
+        const std::array<int,3> local_ext{6, 5, 4};
+        const std::array<int,3> g_first{0, 0, 0};
+        const std::array<int,3> g_last{dims[0]*local_ext[0]-1, dims[1]*local_ext[1]-1, dims[2]*local_ext[2]-1};
+        const std::array<int,6> halos{1, 1, 1, 1, 1, 1};
+        const std::array<bool,3> periodic{true, true, true};
+        const auto value = [&g_last](int x, int y, int z) { return (z*(g_last[1]+1) + y)*(g_last[0]+1) + x; };
+
+        const int rank = context.rank();
+        const std::array<int,3> coord{rank%dims[0], (rank/dims[0])%dims[1], rank/(dims[0]*dims[1])};
+        std::array<int,3> first, last;
+        for (int i=0; i<3; ++i)
+        {
+            first[i] = coord[i]*local_ext[i];
+            last[i] = first[i] + local_ext[i] - 1;
+        }
+        std::vector<domain_descriptor_type> local_domains{domain_descriptor_type{rank, first, last}};
+        auto halo_gen = halo_generator_type(g_first, g_last, halos, periodic);
+        auto pattern = ghex::make_pattern<ghex::structured::grid>(context, halo_gen, local_domains);
+
+        const std::array<int,3> offset{1, 1, 1};
+        const std::array<int,3> ext{local_ext[0]+2, local_ext[1]+2, local_ext[2]+2};
+        std::vector<int> raw(ext[0]*ext[1]*ext[2], -1);
+        auto field = ghex::wrap_field<ghex::cpu,::gridtools::layout_map<2,1,0>>(local_domains[0], raw.data(), offset, ext);
+        for (int z=0; z<local_ext[2]; ++z)
+            for (int y=0; y<local_ext[1]; ++y)
+                for (int x=0; x<local_ext[0]; ++x)
+                    field(x,y,z) = value(first[0]+x, first[1]+y, first[2]+z);
+
+        auto co = ghex::make_communication_object<decltype(pattern)>(context.get_communicator());
+        co.exchange(pattern(field)).wait();
+
+        const auto wrap = [&g_last](int v, int i) { return (v + g_last[i] + 1) % (g_last[i] + 1); };
+        for (int z=-1; z<=local_ext[2]; ++z)
+            for (int y=-1; y<=local_ext[1]; ++y)
+                for (int x=-1; x<=local_ext[0]; ++x)
+                    EXPECT_EQ(field(x,y,z),
+                        value(wrap(first[0]+x, 0), wrap(first[1]+y, 1), wrap(first[2]+z, 2)));
+    });
+}
@@ -0,0 +1,197 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#include <ghex/transport_layer/shm/context.hpp>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+namespace ghex = gridtools::ghex;
+
+using transport    = ghex::tl::shm_tag;
+using factory_type = ghex::tl::context_factory<transport>;
+
+namespace {
+
+    std::vector<unsigned char> make_payload(std::size_t size, int rank, int tag)
+    {
+        std::vector<unsigned char> v(size);
+        for (std::size_t i=0; i<size; ++i) v[i] = static_cast<unsigned char>(rank*31 + tag*7 + i);
+        return v;
+    }
+
+    // send a message of each size around a ring of ranks. With late_recv, all messages are sent before the receives
+    // are posted, so that they arrive unexpectedly.
+    void ring_exchange(const ghex::tl::shm::context_options& options, bool late_recv)
+    {
+        auto context_ptr = factory_type::create(MPI_COMM_WORLD, options);
+        auto comm = context_ptr->get_communicator();
+        const int rank = comm.rank();
+        const int size = comm.size();
+        const int dst = (rank+1)%size;
+        const int src = (rank+size-1)%size;
+
+        const std::vector<std::size_t> sizes{0u, 1u, 100u, 4096u, 1u<<15, 1u<<20};
+        std::vector<std::vector<unsigned char>> smsgs, rmsgs;
+        for (std::size_t i=0; i<sizes.size(); ++i)
+        {
+            smsgs.push_back(make_payload(sizes[i], rank, i));
+            rmsgs.emplace_back(sizes[i]);
+        }
+
+        using future_type = typename decltype(comm)::template future<void>;
+        std::vector<future_type> futs;
+        if (!late_recv)
+            for (std::size_t i=0; i<sizes.size(); ++i) futs.push_back(comm.recv(rmsgs[i], src, i));
+        for (std::size_t i=0; i<sizes.size(); ++i) futs.push_back(comm.send(smsgs[i], dst, i));
+        if (late_recv)
+        {
+            // progress until all messages which fit into the ring have been delivered
+            for (int k=0; k<100; ++k) comm.progress();
+            for (std::size_t i=sizes.size(); i>0; --i) futs.push_back(comm.recv(rmsgs[i-1], src, i-1));
+        }
+        for (auto& f : futs) f.wait();
+
+        for (std::size_t i=0; i<sizes.size(); ++i)
+            EXPECT_EQ(rmsgs[i], make_payload(sizes[i], src, i));
+    }
+
+} // namespace
+
+TEST(transport_layer, shm_send_recv)
+{
+    ghex::tl::shm::context_options options;
+    ring_exchange(options, false);
+    ring_exchange(options, true);
+}
+
+TEST(transport_layer, shm_send_recv_streamed)
+{
+    // without cross memory attach and with the smallest ring, large messages are streamed in many fragments
+    ghex::tl::shm::context_options options;
+    options.m_use_cma = false;
+    options.m_ring_capacity = 4096u;
+    ring_exchange(options, false);
+    ring_exchange(options, true);
+}
+
+TEST(transport_layer, shm_message_order)
+{
+    auto context_ptr = factory_type::create(MPI_COMM_WORLD);
+    auto comm = context_ptr->get_communicator();
+    const int rank = comm.rank();
+    const int size = comm.size();
+    const int dst = (rank+1)%size;
+    const int src = (rank+size-1)%size;
+
+    // messages with the same tag are received in the order in which they were sent
+    const int n = 8;
+    std::vector<std::vector<int>> smsgs, rmsgs;
+    for (int i=0; i<n; ++i)
+    {
+        smsgs.push_back(std::vector<int>(1000*(i%3)+1, rank*100+i));
+        rmsgs.emplace_back(2001);
+    }
+    using future_type = typename decltype(comm)::template future<void>;
+    std::vector<future_type> futs;
+    for (int i=0; i<n/2; ++i) futs.push_back(comm.recv(rmsgs[i], src, 42));
+    for (int i=0; i<n; ++i) futs.push_back(comm.send(smsgs[i], dst, 42));
+    for (int i=n/2; i<n; ++i) futs.push_back(comm.recv(rmsgs[i], src, 42));
+    for (auto& f : futs) f.wait();
+    for (int i=0; i<n; ++i) EXPECT_EQ(rmsgs[i][0], src*100+i);
+}
+
+TEST(transport_layer, shm_cancel)
+{
+    auto context_ptr = factory_type::create(MPI_COMM_WORLD);
+    auto comm = context_ptr->get_communicator();
+    const int src = (comm.rank()+comm.size()-1)%comm.size();
+    std::vector<int> msg(10);
+    auto fut = comm.recv(msg, src, 7);
+    for (int k=0; k<10; ++k) comm.progress();
+    EXPECT_FALSE(fut.test());
+    EXPECT_TRUE(fut.cancel());
+    MPI_Barrier(MPI_COMM_WORLD);
+}
+
+TEST(transport_layer, shm_truncated_recv)
+{
+    // a receive which is too small fails when it is waited for, and the rings remain usable: small, streamed and
+    // (with cross memory attach) rendezvous messages, which arrive before or after the receive is posted
+    for (bool use_cma : {true, false})
+    {
+        ghex::tl::shm::context_options options;
+        options.m_use_cma = use_cma;
+        options.m_ring_capacity = 4096u;
+        auto context_ptr = factory_type::create(MPI_COMM_WORLD, options);
+        auto comm = context_ptr->get_communicator();
+        const int rank = comm.rank();
+        const int size = comm.size();
+        const int dst = (rank+1)%size;
+        const int src = (rank+size-1)%size;
+
+        for (std::size_t msg_size : {100u, 1u<<20})
+        {
+            for (bool late_recv : {false, true})
+            {
+                std::vector<unsigned char> smsg = make_payload(msg_size, rank, 1);
+                std::vector<unsigned char> small(10);
+                auto rfut = late_recv ? decltype(comm.recv(small, src, 1)){} : comm.recv(small, src, 1);
+                auto sfut = comm.send(smsg, dst, 1);
+                if (late_recv)
+                {
+                    for (int k=0; k<100; ++k) comm.progress();
+                    rfut = comm.recv(small, src, 1);
+                }
+                EXPECT_THROW(rfut.wait(), std::runtime_error);
+                sfut.wait();
+
+                std::vector<unsigned char> rmsg(msg_size);
+                auto f1 = comm.recv(rmsg, src, 2);
+                auto f2 = comm.send(smsg, dst, 2);
+                f1.wait();
+                f2.wait();
+                EXPECT_EQ(rmsg, make_payload(msg_size, src, 1));
+            }
+        }
+    }
+}
+
+TEST(transport_layer, shm_callbacks_threads)
+{
+    const int num_threads = 4;
+    auto context_ptr = factory_type::create(MPI_COMM_WORLD);
+    auto& context = *context_ptr;
+    using comm_type = typename factory_type::context_type::communicator_type;
+
+    auto func = [&context](int id)
+    {
+        auto comm = context.get_communicator();
+        const int dst = (comm.rank()+1)%comm.size();
+        const int src = (comm.rank()+comm.size()-1)%comm.size();
+        std::vector<unsigned char> smsg = make_payload(50000, comm.rank(), id);
+        std::vector<unsigned char> rmsg(50000);
+        int completed = 0;
+        auto cb = [&completed](typename comm_type::message_type, int, int) { ++completed; };
+        comm.recv(rmsg, src, id, cb);
+        comm.send(smsg, dst, id, cb);
+        while (completed < 2) comm.progress();
+        EXPECT_EQ(rmsg, make_payload(50000, src, id));
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (int i=0; i<num_threads; ++i)
+        threads.push_back(std::thread(func, i));
+    for (auto& t : threads)
+        t.join();
+}
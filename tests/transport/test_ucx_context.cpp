@@ -11,9 +11,12 @@
 #include <iostream>
 #include <ghex/transport_layer/ucx/address_db_mpi.hpp>
 #include <ghex/transport_layer/ucx/context.hpp>
+#include <ghex/allocator/ucx_allocator.hpp>
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <memory>
 #include <thread>
 #include <vector>
 
@@ -64,3 +67,141 @@ TEST(transport_layer, ucx_context)
     for (auto& t : threads)
         t.join();
 }
+
+TEST(transport_layer, ucx_address_db)
+{
+    // addresses of different length and content on every rank
+    auto make_address = [](int r)
+    {
+        ghex::tl::ucx::address_t addr(16 + (r % 5));
+        for (std::size_t i=0; i<addr.size(); ++i)
+            addr[i] = static_cast<unsigned char>(r*7 + i);
+        return addr;
+    };
+
+    for (bool lazy : {false, true})
+    {
+        db_type db{MPI_COMM_WORLD, lazy};
+        db.init(make_address(db.rank()));
+        EXPECT_EQ(db.lazy(), lazy);
+
+        auto check = [&db, &make_address](int r)
+        {
+            const auto addr = db.find(r);
+            const auto expected = make_address(r);
+            EXPECT_EQ(addr.size(), expected.size());
+            EXPECT_TRUE(std::equal(addr.begin(), addr.end(), expected.begin()));
+        };
+
+        // lookups in arbitrary order, concurrently from several threads
+        std::vector<std::thread> threads;
+        for (int t=0; t<4; ++t)
+            threads.push_back(std::thread([&db, &check, t]()
+            {
+                for (int i=0; i<db.size(); ++i)
+                    check((db.rank() + t + i*3) % db.size());
+            }));
+        for (auto& t : threads)
+            t.join();
+        EXPECT_THROW(db.find(db.size()), std::runtime_error);
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+}
+
+TEST(transport_layer, ucx_thread_workers)
+{
+    const int num_threads = 4;
+    ghex::tl::ucx::context_options options;
+    options.m_num_thread_workers = num_threads;
+    options.m_yield = ghex::tl::ucx::yield_policy::idle;
+    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD, options);
+    auto& context = *context_ptr;
+    EXPECT_THROW(context.get_communicator(num_threads), std::runtime_error);
+
+    auto func = [&context](int id)
+    {
+        // every thread communicates with the thread of the same index on the neighbor ranks
+        auto comm = context.get_communicator(id);
+        const int dst = (comm.rank()+1) % comm.size();
+        const int src = (comm.rank()+comm.size()-1) % comm.size();
+        for (int tag=0; tag<10; ++tag)
+        {
+            std::vector<int> smsg{id, comm.rank(), tag};
+            std::vector<int> rmsg(3, -1);
+            auto rf = comm.recv(rmsg, src, tag);
+            auto sf = comm.send(smsg, dst, tag);
+            rf.wait();
+            sf.wait();
+            EXPECT_EQ(rmsg[0], id);
+            EXPECT_EQ(rmsg[1], src);
+            EXPECT_EQ(rmsg[2], tag);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i=0; i<num_threads; ++i)
+        threads.push_back(std::thread(func, i));
+    for (auto& t : threads)
+        t.join();
+}
+
+TEST(transport_layer, ucx_registration_cache)
+{
+    auto context_ptr = gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
+    auto& context = *context_ptr;
+    auto cache = context.get_transport_context().get_registration_cache();
+    const auto threshold = context.get_transport_context().options().m_registration_threshold;
+
+    {
+        // memory obtained through the allocator is registered until it is deallocated
+        using alloc_type = ghex::allocator::ucx_registered_allocator<std::allocator<unsigned char>>;
+        std::vector<unsigned char, alloc_type> buffer(4*threshold, 0, alloc_type{cache});
+        EXPECT_EQ(cache->stats().m_regions, 1u);
+        EXPECT_NE(cache->find(buffer.data(), buffer.size()), nullptr);
+        EXPECT_NE(cache->find(buffer.data() + threshold, threshold), nullptr);
+        EXPECT_EQ(cache->find(buffer.data() + threshold, buffer.size()), nullptr);
+        EXPECT_EQ(cache->find(buffer.data(), threshold/2), nullptr);
+
+        // registered messages are exchanged as usual
+        auto comm = context.get_communicator();
+        const int dst = (comm.rank()+1) % comm.size();
+        const int src = (comm.rank()+comm.size()-1) % comm.size();
+        std::vector<unsigned char, alloc_type> rbuffer(buffer.size(), 0, alloc_type{cache});
+        for (std::size_t i=0; i<buffer.size(); ++i) buffer[i] = static_cast<unsigned char>(comm.rank() + i);
+        auto rf = comm.recv(rbuffer, src, 0);
+        comm.send(buffer, dst, 0).wait();
+        rf.wait();
+        for (std::size_t i=0; i<rbuffer.size(); ++i)
+            EXPECT_EQ(rbuffer[i], static_cast<unsigned char>(src + i));
+    }
+    EXPECT_EQ(cache->stats().m_regions, 0u);
+    EXPECT_EQ(cache->stats().m_bytes, 0u);
+
+    {
+        // lookups from several threads, regions which were found before are forgotten when they are unmapped
+        using alloc_type = ghex::allocator::ucx_registered_allocator<std::allocator<unsigned char>>;
+        std::vector<unsigned char, alloc_type> kept(2*threshold, 0, alloc_type{cache});
+        auto freed = std::make_unique<std::vector<unsigned char, alloc_type>>(2*threshold, 0, alloc_type{cache});
+        const auto freed_ptr = freed->data();
+        const auto memh = cache->find(kept.data(), kept.size());
+        EXPECT_NE(memh, nullptr);
+        EXPECT_NE(cache->find(freed_ptr, threshold), nullptr);
+        std::vector<std::thread> threads;
+        for (int t=0; t<4; ++t)
+            threads.push_back(std::thread([&cache, &kept, memh]() {
+                for (int i=0; i<1000; ++i) EXPECT_EQ(cache->find(kept.data(), kept.size()), memh);
+            }));
+        for (auto& t : threads)
+            t.join();
+        freed.reset();
+        EXPECT_EQ(cache->find(freed_ptr, threshold), nullptr);
+        EXPECT_EQ(cache->find(kept.data(), kept.size()), memh);
+    }
+
+    // allocators made for a communicator register with the cache of its context
+    auto comm = context.get_communicator();
+    EXPECT_EQ(comm.get_registration_cache(), cache);
+    auto alloc = ghex::allocator::make_ucx_registered_allocator<std::allocator<unsigned char>>(comm);
+    EXPECT_EQ(alloc.m_cache, cache);
+    EXPECT_EQ(ghex::allocator::ucx_registered_allocator<std::allocator<unsigned char>>{}.m_cache, nullptr);
+}
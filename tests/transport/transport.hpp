@@ -0,0 +1,112 @@
+/*
+ * GridTools
+ *
+ * Copyright (c) 2014-2020, ETH Zurich
+ * All rights reserved.
+ *
+ * Please, refer to the LICENSE file in the root directory.
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+#ifndef TESTS_TRANSPORT_TRANSPORT_HPP
+#define TESTS_TRANSPORT_TRANSPORT_HPP
+
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(GHEX_TEST_USE_UCX)
+#include <ghex/transport_layer/ucx/context.hpp>
+using transport = gridtools::ghex::tl::ucx_tag;
+#elif defined(GHEX_TEST_USE_INPROC)
+#include <ghex/transport_layer/inproc/context.hpp>
+using transport = gridtools::ghex::tl::inproc_tag;
+#else
+#include <ghex/transport_layer/mpi/context.hpp>
+using transport = gridtools::ghex::tl::mpi_tag;
+#endif
+
+using context_type = typename gridtools::ghex::tl::context_factory<transport>::context_type;
+
+// number of logical ranks of the in-process transport, matching the number of MPI processes of the other transports
+const int num_test_ranks = 4;
+
+/** @brief A rank on which a test runs. Contexts are created collectively: the i-th calls to create_context() of all
+  * ranks return contexts which belong together, as for MPI_COMM_WORLD. */
+class test_rank
+{
+#ifdef GHEX_TEST_USE_INPROC
+public: // member types
+    struct worlds
+    {
+        std::mutex m_mutex;
+        std::vector<std::shared_ptr<gridtools::ghex::tl::inproc::world>> m_worlds;
+    };
+
+private: // members
+    worlds* m_worlds;
+    int m_rank;
+    std::size_t m_count = 0u;
+
+public: // ctors
+    test_rank(worlds* w, int rank) : m_worlds{w}, m_rank{rank} {}
+
+public: // member functions
+    std::unique_ptr<context_type> create_context()
+    {
+        std::shared_ptr<gridtools::ghex::tl::inproc::world> w;
+        {
+            std::lock_guard<std::mutex> lock(m_worlds->m_mutex);
+            if (m_worlds->m_worlds.size() == m_count)
+                m_worlds->m_worlds.push_back(std::make_shared<gridtools::ghex::tl::inproc::world>(num_test_ranks));
+            w = m_worlds->m_worlds[m_count++];
+        }
+        return gridtools::ghex::tl::context_factory<transport>::create(std::move(w), m_rank);
+    }
+#else
+public: // member functions
+    std::unique_ptr<context_type> create_context()
+    {
+        return gridtools::ghex::tl::context_factory<transport>::create(MPI_COMM_WORLD);
+    }
+#endif
+};
+
+/** @brief run a test on all ranks. With the in-process transport, the ranks are threads of this process and the
+  * first exception thrown by any of them is rethrown.
+  * @tparam F function type with the signature void(test_rank&) */
+template<typename F>
+void run_test_ranks(F&& f)
+{
+#ifdef GHEX_TEST_USE_INPROC
+    test_rank::worlds w;
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    std::vector<std::thread> threads;
+    threads.reserve(num_test_ranks);
+    for (int r=0; r<num_test_ranks; ++r)
+    {
+        threads.emplace_back([&f, &w, &error, &error_mutex, r]() {
+            try
+            {
+                test_rank tr(&w, r);
+                f(tr);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) error = std::current_exception();
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    if (error) std::rethrow_exception(error);
+#else
+    test_rank tr;
+    f(tr);
+#endif
+}
+
+#endif /* TESTS_TRANSPORT_TRANSPORT_HPP */